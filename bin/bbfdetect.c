@@ -14,6 +14,8 @@ int main(int argc, char** argv)
 	assert(argc >= 3);
 	int i;
 	ccv_enable_default_cache();
+	if (getenv("CCV_CACHE_STATS"))
+		ccv_enable_cache_source_stats();
 	ccv_dense_matrix_t* image = 0;
 	ccv_bbf_classifier_cascade_t* cascade = ccv_bbf_read_classifier_cascade(argv[2]);
 	ccv_read(argv[1], &image, CCV_IO_GRAY | CCV_IO_ANY_FILE);
@@ -62,6 +64,8 @@ int main(int argc, char** argv)
 		}
 	}
 	ccv_bbf_classifier_cascade_free(cascade);
+	if (getenv("CCV_CACHE_STATS"))
+		ccv_dump_cache_stats(stderr);
 	ccv_disable_cache();
 	return 0;
 }
@@ -0,0 +1,44 @@
+#include "ccv.h"
+#include <sys/time.h>
+
+static uint64_t get_current_time(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static void bench(ccv_bbf_classifier_cascade_t* cascade, const char* file, int accurate, int repeat)
+{
+	ccv_dense_matrix_t* image = 0;
+	ccv_read(file, &image, CCV_IO_GRAY | CCV_IO_ANY_FILE);
+	if (!image)
+		return;
+	ccv_bbf_param_t params = ccv_bbf_default_params;
+	params.accurate = accurate;
+	params.pyramid = ccv_pyramid_new();
+	int i, count = 0;
+	uint64_t elapsed = get_current_time();
+	for (i = 0; i < repeat; i++)
+	{
+		ccv_array_t* seq = ccv_bbf_detect_objects(image, &cascade, 1, params);
+		count = seq->rnum;
+		ccv_array_free(seq);
+	}
+	elapsed = get_current_time() - elapsed;
+	printf("%-32s %4dx%-4d %s %8.3f ms (%d objects)\n", file, image->cols, image->rows, accurate ? "accurate" : "fast    ", elapsed / 1000.0 / repeat, count);
+	ccv_pyramid_free(params.pyramid);
+	ccv_matrix_free(image);
+}
+
+int main(int argc, char** argv)
+{
+	ccv_enable_default_cache();
+	int repeat = argc > 1 ? atoi(argv[1]) : 5;
+	ccv_bbf_classifier_cascade_t* cascade = ccv_bbf_read_classifier_cascade("../../samples/face");
+	bench(cascade, "../../samples/nature.png", 1, repeat);
+	bench(cascade, "../../samples/street.png", 1, repeat);
+	bench(cascade, "../../samples/street.png", 0, repeat);
+	ccv_bbf_classifier_cascade_free(cascade);
+	return 0;
+}
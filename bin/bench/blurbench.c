@@ -0,0 +1,110 @@
+#include "ccv.h"
+#include <sys/time.h>
+
+static uint64_t get_current_time(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static ccv_dense_matrix_t* random_matrix(int rows, int cols, int type)
+{
+	ccv_dense_matrix_t* a = ccv_dense_matrix_new(rows, cols, type, 0, 0);
+	int i, j, ch = CCV_GET_CHANNEL(type);
+	unsigned char* a_ptr = a->data.u8;
+	for (i = 0; i < rows; i++)
+	{
+		for (j = 0; j < cols * ch; j++)
+			if (CCV_GET_DATA_TYPE(type) == CCV_8U)
+				a_ptr[j] = rand() & 0xff;
+			else
+				((float*)a_ptr)[j] = (rand() & 0xffff) / 256.0;
+		a_ptr += a->step;
+	}
+	return a;
+}
+
+// Gaussian in double precision with the border replicated, the kernel goes to 6 sigma
+static void gaussian(ccv_dense_matrix_t* a, double sigma, double* b)
+{
+	int hfz = (int)(sigma * 6) + 1;
+	double* w = (double*)malloc(sizeof(double) * (hfz * 2 + 1));
+	double* t = (double*)malloc(sizeof(double) * a->rows * a->cols);
+	double tw = 0;
+	int i, j, k;
+	for (k = -hfz; k <= hfz; k++)
+		tw += w[k + hfz] = exp(-k * k / (2 * sigma * sigma));
+	for (i = 0; i < a->rows; i++)
+		for (j = 0; j < a->cols; j++)
+		{
+			double sum = 0;
+			for (k = -hfz; k <= hfz; k++)
+				sum += w[k + hfz] * a->data.f32[i * a->cols + ccv_clamp(j + k, 0, a->cols - 1)];
+			t[i * a->cols + j] = sum / tw;
+		}
+	for (i = 0; i < a->rows; i++)
+		for (j = 0; j < a->cols; j++)
+		{
+			double sum = 0;
+			for (k = -hfz; k <= hfz; k++)
+				sum += w[k + hfz] * t[ccv_clamp(i + k, 0, a->rows - 1) * a->cols + j];
+			b[i * a->cols + j] = sum / tw;
+		}
+	free(t);
+	free(w);
+}
+
+static void bench(const char* name, int type, double sigma, int repeat)
+{
+	ccv_dense_matrix_t* a = random_matrix(960, 1280, type);
+	ccv_dense_matrix_t* b = 0;
+	ccv_blur(a, &b, 0, sigma);
+	int i;
+	uint64_t elapsed = get_current_time();
+	for (i = 0; i < repeat; i++)
+		ccv_blur(a, &b, 0, sigma);
+	elapsed = get_current_time() - elapsed;
+	printf("%-10s sigma %5.2f %4dx%-4d %8.3f ms\n", name, sigma, a->cols, a->rows, elapsed / 1000.0 / repeat);
+	ccv_matrix_free(b);
+	ccv_matrix_free(a);
+}
+
+static void accuracy(double sigma)
+{
+	ccv_dense_matrix_t* a = random_matrix(240, 320, CCV_32F | CCV_C1);
+	ccv_dense_matrix_t* b = 0;
+	ccv_blur(a, &b, 0, sigma);
+	double* c = (double*)malloc(sizeof(double) * a->rows * a->cols);
+	gaussian(a, sigma, c);
+	double max = 0, mean = 0;
+	int i, j;
+	for (i = 0; i < a->rows; i++)
+		for (j = 0; j < a->cols; j++)
+		{
+			double d = fabs(b->data.f32[i * b->cols + j] - c[i * a->cols + j]);
+			max = ccv_max(max, d);
+			mean += d;
+		}
+	printf("sigma %5.2f %4dx%-4d max error %.5f mean error %.5f (of 0 to 255)\n", sigma, a->cols, a->rows, max, mean / (a->rows * a->cols));
+	free(c);
+	ccv_matrix_free(b);
+	ccv_matrix_free(a);
+}
+
+int main(int argc, char** argv)
+{
+	ccv_disable_cache();
+	int repeat = argc > 1 ? atoi(argv[1]) : 10;
+	const double sigmas[] = { 1, 1.6, 3, 4, 5, 6, 8, 16, 32 };
+	int i;
+	for (i = 0; i < sizeof(sigmas) / sizeof(sigmas[0]); i++)
+	{
+		bench("8u C1", CCV_8U | CCV_C1, sigmas[i], repeat);
+		bench("8u C3", CCV_8U | CCV_C3, sigmas[i], repeat);
+		bench("32f C1", CCV_32F | CCV_C1, sigmas[i], repeat);
+	}
+	for (i = 0; i < sizeof(sigmas) / sizeof(sigmas[0]); i++)
+		accuracy(sigmas[i]);
+	return 0;
+}
@@ -0,0 +1,87 @@
+#include "ccv.h"
+#include <sys/time.h>
+
+static uint64_t get_current_time(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static uint64_t uniqid(void)
+{
+	union {
+		uint64_t u;
+		uint8_t chr[8];
+	} sign;
+	int i;
+	for (i = 0; i < 8; i++)
+		sign.chr[i] = rand() & 0xff;
+	return sign.u;
+}
+
+/* the cached objects are not real, nothing to free */
+static void noop_free(void* x)
+{
+}
+
+#define OBJECT(i) ((void*)(((uintptr_t)(i) + 1) << 4))
+
+static void bench(size_t up)
+{
+	ccv_cache_t cache;
+	ccv_cache_init(&cache, up, 2, noop_free, noop_free);
+	// objects between 1KiB and 32KiB, close to small pyramids / sats in a detector
+	int i, n = 0;
+	size_t size = 0;
+	while (size < up)
+		size += 1024 + ((uint64_t)n++ * 7919) % (31 * 1024);
+	uint64_t* sigs = (uint64_t*)ccmalloc(sizeof(uint64_t) * n * 2);
+	uint32_t* sizes = (uint32_t*)ccmalloc(sizeof(uint32_t) * n * 2);
+	for (i = 0; i < n * 2; i++)
+	{
+		sigs[i] = uniqid();
+		sizes[i] = 1024 + ((uint64_t)i * 7919) % (31 * 1024);
+	}
+	// fill the cache up to its limit, no eviction
+	uint64_t elapsed = get_current_time();
+	for (i = 0; i < n - 1; i++)
+		ccv_cache_put(&cache, sigs[i], OBJECT(i), sizes[i], i & 1);
+	elapsed = get_current_time() - elapsed;
+	printf("%5zuMiB %7d entries put   %8.3f Mops/s\n", up / (1024 * 1024), n - 1, (double)(n - 1) / elapsed);
+	int gets = n * 8;
+	elapsed = get_current_time();
+	int hits = 0;
+	for (i = 0; i < gets; i++)
+		hits += !!ccv_cache_get(&cache, sigs[(int)(((uint64_t)i * 104729) % (n - 1))], 0);
+	elapsed = get_current_time() - elapsed;
+	printf("%5zuMiB %7d lookups get   %8.3f Mops/s (%d hits)\n", up / (1024 * 1024), gets, (double)gets / elapsed, hits);
+	// take out and put back, this is how ccv_dense_matrix_new / ccv_matrix_free uses the cache
+	elapsed = get_current_time();
+	for (i = 0; i < gets; i++)
+	{
+		const int k = (int)(((uint64_t)i * 104729) % (n - 1));
+		uint8_t type;
+		void* x = ccv_cache_out(&cache, sigs[k], &type);
+		if (x)
+			ccv_cache_put(&cache, sigs[k], x, sizes[k], type);
+	}
+	elapsed = get_current_time() - elapsed;
+	printf("%5zuMiB %7d cycles out/put %7.3f Mops/s\n", up / (1024 * 1024), gets, (double)gets / elapsed);
+	// every put from now on evicts
+	elapsed = get_current_time();
+	for (i = n; i < n * 2; i++)
+		ccv_cache_put(&cache, sigs[i], OBJECT(i), sizes[i], i & 1);
+	elapsed = get_current_time() - elapsed;
+	printf("%5zuMiB %7d entries evict %8.3f Mops/s\n", up / (1024 * 1024), n, (double)n / elapsed);
+	ccv_cache_close(&cache);
+	ccfree(sizes);
+	ccfree(sigs);
+}
+
+int main(int argc, char** argv)
+{
+	bench(CCV_DEFAULT_CACHE_SIZE);
+	bench((size_t)1024 * 1024 * 1024);
+	return 0;
+}
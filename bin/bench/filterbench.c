@@ -0,0 +1,75 @@
+#include "ccv.h"
+#include <sys/time.h>
+
+static uint64_t get_current_time(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static ccv_dense_matrix_t* random_matrix(int rows, int cols, int type)
+{
+	ccv_dense_matrix_t* a = ccv_dense_matrix_new(rows, cols, type, 0, 0);
+	int i, j, ch = CCV_GET_CHANNEL(type);
+	unsigned char* a_ptr = a->data.u8;
+	for (i = 0; i < rows; i++)
+	{
+		for (j = 0; j < cols * ch; j++)
+			((float*)a_ptr)[j] = (rand() & 0xffff) / 65536.0 - 0.5;
+		a_ptr += a->step;
+	}
+	return a;
+}
+
+static void bench(const char* name, int rows, int cols, int ch, int krows, int kcols, int count, int repeat)
+{
+	ccv_dense_matrix_t* a = random_matrix(rows, cols, CCV_32F | ch);
+	ccv_dense_matrix_t** kernels = (ccv_dense_matrix_t**)ccmalloc(sizeof(ccv_dense_matrix_t*) * count * 2);
+	ccv_dense_matrix_t** d = kernels + count;
+	int i, k;
+	for (k = 0; k < count; k++)
+	{
+		kernels[k] = random_matrix(krows, kcols, CCV_32F | ch);
+		d[k] = 0;
+	}
+	uint64_t elapsed = get_current_time();
+	for (i = 0; i < repeat; i++)
+		for (k = 0; k < count; k++)
+		{
+			ccv_filter(a, kernels[k], d + k, 0, CCV_NO_PADDING);
+			ccv_matrix_free(d[k]);
+			d[k] = 0;
+		}
+	uint64_t filter = get_current_time() - elapsed;
+	ccv_filter_bank_t* bank = ccv_filter_bank_new(kernels, count);
+	elapsed = get_current_time();
+	for (i = 0; i < repeat; i++)
+	{
+		ccv_filter_bank(a, bank, d, 0, CCV_NO_PADDING);
+		for (k = 0; k < count; k++)
+		{
+			ccv_matrix_free(d[k]);
+			d[k] = 0;
+		}
+	}
+	elapsed = get_current_time() - elapsed;
+	printf("%-16s %4dx%-4d %2d x %dx%d %8.3f ms (ccv_filter %.3f ms)\n", name, cols, rows, count, kcols, krows, elapsed / 1000.0 / repeat, filter / 1000.0 / repeat);
+	ccv_filter_bank_free(bank);
+	for (k = 0; k < count; k++)
+		ccv_matrix_free(kernels[k]);
+	ccfree(kernels);
+	ccv_matrix_free(a);
+}
+
+int main(int argc, char** argv)
+{
+	ccv_disable_cache();
+	int repeat = argc > 1 ? atoi(argv[1]) : 10;
+	// a dpm model scores the 31-channel hog with one root and its parts on the 2x level
+	bench("dpm root", 60, 80, 31, 8, 10, 1, repeat);
+	bench("dpm parts", 120, 160, 31, 6, 6, 8, repeat);
+	bench("dpm parts", 240, 320, 31, 6, 6, 8, repeat);
+	bench("gray bank", 480, 640, 1, 15, 15, 16, repeat);
+	return 0;
+}
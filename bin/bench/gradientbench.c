@@ -0,0 +1,104 @@
+#include "ccv.h"
+#include <sys/time.h>
+
+static uint64_t get_current_time(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static ccv_dense_matrix_t* random_matrix(int rows, int cols, int type)
+{
+	ccv_dense_matrix_t* a = ccv_dense_matrix_new(rows, cols, type, 0, 0);
+	int i, j, ch = CCV_GET_CHANNEL(type);
+	unsigned char* a_ptr = a->data.u8;
+	for (i = 0; i < rows; i++)
+	{
+		for (j = 0; j < cols * ch; j++)
+			if (CCV_GET_DATA_TYPE(type) == CCV_8U)
+				a_ptr[j] = rand() & 0xff;
+			else
+				((float*)a_ptr)[j] = (rand() & 0xffff) / 256.0;
+		a_ptr += a->step;
+	}
+	return a;
+}
+
+static void bench_sobel(const char* name, int type, int dx, int dy, int repeat)
+{
+	ccv_dense_matrix_t* a = random_matrix(1080, 1920, type);
+	ccv_dense_matrix_t* b = 0;
+	ccv_sobel(a, &b, 0, dx, dy);
+	int i;
+	uint64_t elapsed = get_current_time();
+	for (i = 0; i < repeat; i++)
+		ccv_sobel(a, &b, 0, dx, dy);
+	elapsed = get_current_time() - elapsed;
+	printf("%-16s %4dx%-4d %8.3f ms\n", name, a->cols, a->rows, elapsed / 1000.0 / repeat);
+	ccv_matrix_free(b);
+	ccv_matrix_free(a);
+}
+
+static void bench_gradient(const char* name, int type, int repeat)
+{
+	ccv_dense_matrix_t* a = random_matrix(1080, 1920, type);
+	ccv_dense_matrix_t* theta = 0;
+	ccv_dense_matrix_t* m = 0;
+	ccv_dense_matrix_t* x = 0;
+	ccv_dense_matrix_t* y = 0;
+	ccv_dense_matrix_t* b = 0;
+	int i;
+	uint64_t elapsed = get_current_time();
+	for (i = 0; i < repeat; i++)
+	{
+		// the intermediate matrices the gradient used to have
+		ccv_sobel(a, &x, CCV_32F | CCV_GET_CHANNEL(type), 1, 0);
+		ccv_sobel(a, &y, CCV_32F | CCV_GET_CHANNEL(type), 0, 1);
+	}
+	uint64_t sobel = get_current_time() - elapsed;
+	elapsed = get_current_time();
+	for (i = 0; i < repeat; i++)
+		ccv_gradient(a, &theta, 0, &m, 0, 1, 1);
+	uint64_t gradient = get_current_time() - elapsed;
+	elapsed = get_current_time();
+	for (i = 0; i < repeat; i++)
+		ccv_gradient_bin(a, &b, 18);
+	elapsed = get_current_time() - elapsed;
+	printf("%-16s %4dx%-4d %8.3f ms (gradient %.3f ms, sobel x + y %.3f ms)\n", name, a->cols, a->rows, elapsed / 1000.0 / repeat, gradient / 1000.0 / repeat, sobel / 1000.0 / repeat);
+	ccv_matrix_free(theta);
+	ccv_matrix_free(m);
+	ccv_matrix_free(x);
+	ccv_matrix_free(y);
+	ccv_matrix_free(b);
+	ccv_matrix_free(a);
+}
+
+static void bench_hog(const char* name, int type, int repeat)
+{
+	ccv_dense_matrix_t* a = random_matrix(1080, 1920, type);
+	ccv_dense_matrix_t* b = 0;
+	ccv_hog(a, &b, 0, 9, 8);
+	int i;
+	uint64_t elapsed = get_current_time();
+	for (i = 0; i < repeat; i++)
+		ccv_hog(a, &b, 0, 9, 8);
+	elapsed = get_current_time() - elapsed;
+	printf("%-16s %4dx%-4d %8.3f ms\n", name, a->cols, a->rows, elapsed / 1000.0 / repeat);
+	ccv_matrix_free(b);
+	ccv_matrix_free(a);
+}
+
+int main(int argc, char** argv)
+{
+	ccv_disable_cache();
+	int repeat = argc > 1 ? atoi(argv[1]) : 10;
+	bench_sobel("sobel 3x3 x 8u", CCV_8U | CCV_C1, 3, 0, repeat);
+	bench_sobel("sobel 3x3 y 8u", CCV_8U | CCV_C1, 0, 3, repeat);
+	bench_gradient("bin 8u C1", CCV_8U | CCV_C1, repeat);
+	bench_gradient("bin 8u C3", CCV_8U | CCV_C3, repeat);
+	bench_gradient("bin 32f C1", CCV_32F | CCV_C1, repeat);
+	bench_hog("hog 8u C1", CCV_8U | CCV_C1, repeat);
+	bench_hog("hog 8u C3", CCV_8U | CCV_C3, repeat);
+	return 0;
+}
@@ -0,0 +1,47 @@
+#include "ccv.h"
+#include <sys/time.h>
+
+static uint64_t get_current_time(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static void bench(ccv_icf_classifier_cascade_t** cascades, int count, const char* file, int approximate, int repeat)
+{
+	ccv_dense_matrix_t* image = 0;
+	ccv_read(file, &image, CCV_IO_ANY_FILE | CCV_IO_RGB_COLOR);
+	if (!image)
+		return;
+	ccv_icf_param_t params = ccv_icf_default_params;
+	params.approximate = approximate;
+	int i, objects = 0;
+	uint64_t elapsed = get_current_time();
+	for (i = 0; i < repeat; i++)
+	{
+		ccv_array_t* seq = ccv_icf_detect_objects(image, cascades, count, params);
+		objects = seq->rnum;
+		ccv_array_free(seq);
+	}
+	elapsed = get_current_time() - elapsed;
+	printf("%-32s %4dx%-4d %d cascade(s) %s %8.3f ms (%d objects)\n", file, image->cols, image->rows, count, approximate ? "approximate" : "exact      ", elapsed / 1000.0 / repeat, objects);
+	ccv_matrix_free(image);
+}
+
+int main(int argc, char** argv)
+{
+	// every frame of a video is new, thus, the cache doesn't get to return the channels of the previous run
+	ccv_disable_cache();
+	int repeat = argc > 1 ? atoi(argv[1]) : 5;
+	ccv_icf_classifier_cascade_t* cascade = ccv_icf_read_classifier_cascade("../../samples/pedestrian.icf");
+	ccv_icf_classifier_cascade_t* cascades[] = { cascade, cascade };
+	bench(cascades, 1, "../../samples/pedestrian.png", 0, repeat);
+	bench(cascades, 1, "../../samples/street.png", 0, repeat);
+	// the same cascade twice, as if detecting two classes on one image
+	bench(cascades, 2, "../../samples/street.png", 0, repeat);
+	// channels of the scales in between octaves are approximated with the power law factors of the model
+	bench(cascades, 1, "../../samples/street.png", 1, repeat);
+	ccv_icf_classifier_cascade_free(cascade);
+	return 0;
+}
@@ -0,0 +1,114 @@
+#include "ccv.h"
+#include <sys/time.h>
+
+static uint64_t get_current_time(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static ccv_dense_matrix_t* random_matrix(int rows, int cols, int type)
+{
+	ccv_dense_matrix_t* a = ccv_dense_matrix_new(rows, cols, type, 0, 0);
+	int i, j, ch = CCV_GET_CHANNEL(type);
+	unsigned char* a_ptr = a->data.u8;
+	for (i = 0; i < rows; i++)
+	{
+		for (j = 0; j < cols * ch; j++)
+			if (CCV_GET_DATA_TYPE(type) == CCV_8U)
+				a_ptr[j] = rand() & 0xff;
+			else
+				((float*)a_ptr)[j] = (rand() & 0xffff) / 256.0;
+		a_ptr += a->step;
+	}
+	return a;
+}
+
+static void bench(const char* name, int type, int inter, double scale, int repeat)
+{
+	ccv_dense_matrix_t* a = random_matrix(960, 1280, type);
+	ccv_dense_matrix_t* b = 0;
+	int rows = (int)(a->rows * scale + 0.5), cols = (int)(a->cols * scale + 0.5);
+	ccv_resample(a, &b, 0, rows, cols, inter);
+	int i;
+	uint64_t elapsed = get_current_time();
+	for (i = 0; i < repeat; i++)
+		ccv_resample(a, &b, 0, rows, cols, inter);
+	elapsed = get_current_time() - elapsed;
+	printf("%-16s %4dx%-4d => %4dx%-4d %8.3f ms\n", name, a->cols, a->rows, cols, rows, elapsed / 1000.0 / repeat);
+	ccv_matrix_free(b);
+	ccv_matrix_free(a);
+}
+
+static void bench_sample(const char* name, int type, int up, int repeat)
+{
+	ccv_dense_matrix_t* a = random_matrix(up ? 1080 : 2160, up ? 1920 : 3840, type);
+	ccv_dense_matrix_t* b = 0;
+	if (up)
+		ccv_sample_up(a, &b, 0, 0, 0);
+	else
+		ccv_sample_down(a, &b, 0, 0, 0);
+	int i;
+	uint64_t elapsed = get_current_time();
+	for (i = 0; i < repeat; i++)
+		if (up)
+			ccv_sample_up(a, &b, 0, 0, 0);
+		else
+			ccv_sample_down(a, &b, 0, 0, 0);
+	elapsed = get_current_time() - elapsed;
+	printf("%-16s %4dx%-4d => %4dx%-4d %8.3f ms\n", name, a->cols, a->rows, b->cols, b->rows, elapsed / 1000.0 / repeat);
+	ccv_matrix_free(b);
+	ccv_matrix_free(a);
+}
+
+static void bench_normalize(const char* name, int type, int rows, int cols, int repeat)
+{
+	ccv_dense_matrix_t* a = random_matrix(960, 1280, CCV_8U | CCV_C3);
+	const float mean[] = { 123.68, 116.779, 103.939 };
+	const float std[] = { 58.393, 57.12, 57.375 };
+	float* b = (float*)ccmalloc(sizeof(float) * rows * cols * 3);
+	ccv_dense_matrix_t* x = 0;
+	int i, j, k;
+	uint64_t elapsed = get_current_time();
+	for (i = 0; i < repeat; i++)
+	{
+		// what it takes without the fused kernel
+		ccv_resample(a, &x, CCV_32F | CCV_C3, rows, cols, type);
+		for (j = 0; j < rows * cols; j++)
+			for (k = 0; k < 3; k++)
+				b[k * rows * cols + j] = (x->data.f32[j * 3 + k] - mean[k]) / std[k];
+	}
+	uint64_t chain = get_current_time() - elapsed;
+	elapsed = get_current_time();
+	for (i = 0; i < repeat; i++)
+		ccv_resample_normalize(a, b, rows, cols, type | CCV_RESAMPLE_NCHW, mean, std);
+	elapsed = get_current_time() - elapsed;
+	printf("%-16s %4dx%-4d => %4dx%-4d %8.3f ms (resample + normalize %.3f ms)\n", name, a->cols, a->rows, cols, rows, elapsed / 1000.0 / repeat, chain / 1000.0 / repeat);
+	ccv_matrix_free(x);
+	ccfree(b);
+	ccv_matrix_free(a);
+}
+
+int main(int argc, char** argv)
+{
+	ccv_disable_cache();
+	int repeat = argc > 1 ? atoi(argv[1]) : 20;
+	// the scale between two levels of a bbf pyramid (interval = 5)
+	const double area_scale = 1.0 / pow(2.0, 1.0 / 5);
+	bench("area 8u C1", CCV_8U | CCV_C1, CCV_INTER_AREA, area_scale, repeat);
+	bench("area 8u C3", CCV_8U | CCV_C3, CCV_INTER_AREA, area_scale, repeat);
+	bench("area 32f C1", CCV_32F | CCV_C1, CCV_INTER_AREA, area_scale, repeat);
+	bench("area 32f C3", CCV_32F | CCV_C3, CCV_INTER_AREA, area_scale, repeat);
+	bench("cubic 8u C1", CCV_8U | CCV_C1, CCV_INTER_CUBIC, area_scale, repeat);
+	bench("cubic 8u C3", CCV_8U | CCV_C3, CCV_INTER_CUBIC, area_scale, repeat);
+	bench("cubic 32f C1", CCV_32F | CCV_C1, CCV_INTER_CUBIC, area_scale, repeat);
+	bench("cubic 32f C3", CCV_32F | CCV_C3, CCV_INTER_CUBIC, area_scale, repeat);
+	bench_sample("down 8u C1", CCV_8U | CCV_C1, 0, repeat);
+	bench_sample("down 8u C3", CCV_8U | CCV_C3, 0, repeat);
+	bench_sample("down 32f C1", CCV_32F | CCV_C1, 0, repeat);
+	bench_sample("up 8u C1", CCV_8U | CCV_C1, 1, repeat);
+	bench_normalize("normalize area", CCV_INTER_AREA, 224, 224, repeat);
+	bench_normalize("normalize cubic", CCV_INTER_CUBIC, 1080, 1440, repeat);
+	return 0;
+}
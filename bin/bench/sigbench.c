@@ -0,0 +1,46 @@
+#include "ccv.h"
+#include "ccv_internal.h"
+#include <sys/time.h>
+
+static uint64_t get_current_time(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static void bench(int rows, int cols, int type)
+{
+	ccv_dense_matrix_t* mat = ccv_dense_matrix_new(rows, cols, type, 0, 0);
+	size_t i, size = (size_t)mat->rows * mat->step;
+	for (i = 0; i < size; i++)
+		mat->data.u8[i] = (i * 7 + (i >> 11)) & 0xff;
+	const int repeats = 10;
+	int j;
+	// hash the whole buffer in one go, this is how ccv_make_matrix_immutable used to sign a matrix
+	uint64_t sig = 0;
+	uint64_t elapsed = get_current_time();
+	for (j = 0; j < repeats; j++)
+		sig = ccv_cache_generate_signature((const char*)mat->data.u8, size, (uint64_t)mat->type, CCV_EOF_SIGN);
+	elapsed = get_current_time() - elapsed;
+	printf("%5dx%-5d %4zuMiB flat %8.1f MiB/s (%016llx)\n", rows, cols, size / (1024 * 1024), (double)size * repeats / elapsed * 1000000 / (1024 * 1024), (unsigned long long)sig);
+	elapsed = get_current_time();
+	for (j = 0; j < repeats; j++)
+	{
+		mat->sig = 0;
+		ccv_make_matrix_immutable(mat);
+	}
+	elapsed = get_current_time() - elapsed;
+	printf("%5dx%-5d %4zuMiB tree %8.1f MiB/s (%016llx)\n", rows, cols, size / (1024 * 1024), (double)size * repeats / elapsed * 1000000 / (1024 * 1024), (unsigned long long)mat->sig);
+	ccv_matrix_free(mat);
+}
+
+int main(int argc, char** argv)
+{
+	bench(480, 640, CCV_8U | CCV_C3);
+	bench(1080, 1920, CCV_8U | CCV_C3);
+	// 20MP
+	bench(3648, 5472, CCV_8U | CCV_C3);
+	bench(3648, 5472, CCV_8U | CCV_C1);
+	return 0;
+}
@@ -0,0 +1,86 @@
+#include "ccv.h"
+#include <sys/time.h>
+
+static uint64_t get_current_time(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static ccv_dense_matrix_t* random_matrix(int rows, int cols, int type)
+{
+	ccv_dense_matrix_t* a = ccv_dense_matrix_new(rows, cols, type, 0, 0);
+	int i, j, ch = CCV_GET_CHANNEL(type);
+	unsigned char* a_ptr = a->data.u8;
+	for (i = 0; i < rows; i++)
+	{
+		for (j = 0; j < cols * ch; j++)
+			if (CCV_GET_DATA_TYPE(type) == CCV_8U)
+				a_ptr[j] = rand() & 0xff;
+			else
+				((float*)a_ptr)[j] = (rand() & 0xffff) / 256.0;
+		a_ptr += a->step;
+	}
+	return a;
+}
+
+static void bench(const char* name, int type, float m20, int repeat)
+{
+	ccv_dense_matrix_t* a = random_matrix(1080, 1920, type);
+	const float angle = 0.2;
+	const float m00 = cosf(angle), m01 = sinf(angle), m10 = -sinf(angle), m11 = cosf(angle);
+	ccv_dense_matrix_t* b = 0;
+	ccv_perspective_transform(a, &b, 0, m00, m01, 0, m10, m11, 0, m20, 0, 1);
+	int i;
+	uint64_t elapsed = get_current_time();
+	for (i = 0; i < repeat; i++)
+		ccv_perspective_transform(a, &b, 0, m00, m01, 0, m10, m11, 0, m20, 0, 1);
+	uint64_t transform = get_current_time() - elapsed;
+	ccv_warp_t warp = ccv_perspective_warp(a, 0, 0, 0, a->rows, a->cols, m00, m01, 0, m10, m11, 0, m20, 0, 1);
+	warp.b = b;
+	elapsed = get_current_time();
+	for (i = 0; i < repeat; i++)
+		ccv_warp(&warp, 1);
+	elapsed = get_current_time() - elapsed;
+	printf("%-18s %4dx%-4d %8.3f ms (ccv_perspective_transform %.3f ms)\n", name, a->cols, a->rows, elapsed / 1000.0 / repeat, transform / 1000.0 / repeat);
+	ccv_matrix_free(b);
+	ccv_matrix_free(a);
+}
+
+static void bench_batch(const char* name, int type, int count, int size, int repeat)
+{
+	ccv_dense_matrix_t* a = random_matrix(480, 640, type);
+	ccv_warp_t* warps = (ccv_warp_t*)ccmalloc(sizeof(ccv_warp_t) * count);
+	int i, j;
+	uint64_t elapsed = get_current_time();
+	for (i = 0; i < repeat; i++)
+	{
+		for (j = 0; j < count; j++)
+		{
+			// small deformations around random windows, as when collecting training samples
+			const float angle = (j % 11 - 5) * 0.02;
+			warps[j] = ccv_perspective_warp(a, 0, rand() % (a->rows - size), rand() % (a->cols - size), size, size, cosf(angle), sinf(angle), 0, -sinf(angle), cosf(angle), 0, (j % 5 - 2) * 0.01, 0, 1);
+		}
+		ccv_warp(warps, count);
+		for (j = 0; j < count; j++)
+			ccv_matrix_free(warps[j].b);
+	}
+	elapsed = get_current_time() - elapsed;
+	printf("%-18s %4d x %dx%-4d %8.3f ms\n", name, count, size, size, elapsed / 1000.0 / repeat);
+	ccfree(warps);
+	ccv_matrix_free(a);
+}
+
+int main(int argc, char** argv)
+{
+	ccv_disable_cache();
+	int repeat = argc > 1 ? atoi(argv[1]) : 20;
+	bench("affine 8u C1", CCV_8U | CCV_C1, 0, repeat);
+	bench("perspective 8u C1", CCV_8U | CCV_C1, 0.1, repeat);
+	bench("perspective 8u C3", CCV_8U | CCV_C3, 0.1, repeat);
+	bench("perspective 32f C1", CCV_32F | CCV_C1, 0.1, repeat);
+	bench_batch("batch 8u C1", CCV_8U | CCV_C1, 1024, 32, repeat);
+	bench_batch("batch 8u C3", CCV_8U | CCV_C3, 1024, 32, repeat);
+	return 0;
+}
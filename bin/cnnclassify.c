@@ -15,6 +15,8 @@ int main(int argc, char** argv)
 {
 	assert(argc >= 3);
 	ccv_enable_default_cache();
+	if (getenv("CCV_CACHE_STATS"))
+		ccv_enable_cache_source_stats();
 	ccv_dense_matrix_t* image = 0;
 	ccv_read(argv[1], &image, CCV_IO_ANY_FILE | CCV_IO_RGB_COLOR);
 	if (image != 0)
@@ -116,6 +118,8 @@ int main(int argc, char** argv)
 			fclose(r);
 		}
 	}
+	if (getenv("CCV_CACHE_STATS"))
+		ccv_dump_cache_stats(stderr);
 	ccv_drain_cache();
 	return 0;
 }
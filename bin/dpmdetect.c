@@ -14,6 +14,8 @@ int main(int argc, char** argv)
 	assert(argc >= 3);
 	int i, j;
 	ccv_enable_default_cache();
+	if (getenv("CCV_CACHE_STATS"))
+		ccv_enable_cache_source_stats();
 	ccv_dense_matrix_t* image = 0;
 	ccv_read(argv[1], &image, CCV_IO_ANY_FILE);
 	ccv_dpm_mixture_model_t* model = ccv_dpm_read_mixture_model(argv[2]);
@@ -72,6 +74,8 @@ int main(int argc, char** argv)
 			fclose(r);
 		}
 	}
+	if (getenv("CCV_CACHE_STATS"))
+		ccv_dump_cache_stats(stderr);
 	ccv_drain_cache();
 	ccv_dpm_mixture_model_free(model);
 	return 0;
@@ -0,0 +1,90 @@
+#include "ccv.h"
+#include <ctype.h>
+#include <getopt.h>
+
+static void exit_with_help(void)
+{
+	printf(
+	"\n  \033[1mUSAGE\033[0m\n\n    icfpowerlaw [OPTION...]\n\n"
+	"  \033[1mREQUIRED OPTIONS\033[0m\n\n"
+	"    --image-list : text file contains a list of natural images (the background list works) to estimate on\n"
+	"    --classifier-cascade : the model file that we will estimate the power law factors for, so that it can be\n"
+	"                           detected with the approximate option\n\n"
+	"  \033[1mOTHER OPTIONS\033[0m\n\n"
+	"    --base-dir : change the base directory so that the program can read images from there\n\n"
+	);
+	exit(-1);
+}
+
+int main(int argc, char** argv)
+{
+	static struct option icf_options[] = {
+		/* help */
+		{"help", 0, 0, 0},
+		/* required parameters */
+		{"image-list", 1, 0, 0},
+		{"classifier-cascade", 1, 0, 0},
+		/* optional parameters */
+		{"base-dir", 1, 0, 0},
+		{0, 0, 0, 0}
+	};
+	char* image_list = 0;
+	char* classifier_cascade = 0;
+	char* base_dir = 0;
+	int i, k;
+	while (getopt_long_only(argc, argv, "", icf_options, &k) != -1)
+	{
+		switch (k)
+		{
+			case 0:
+				exit_with_help();
+			case 1:
+				image_list = optarg;
+				break;
+			case 2:
+				classifier_cascade = optarg;
+				break;
+			case 3:
+				base_dir = optarg;
+				break;
+		}
+	}
+	assert(image_list != 0);
+	assert(classifier_cascade != 0);
+	FILE* r0 = fopen(image_list, "r");
+	assert(r0 && "image-list doesn't exists");
+	size_t len = 1024;
+	ssize_t read;
+	char* file = (char*)malloc(len);
+	ccv_array_t* files = ccv_array_new(sizeof(ccv_file_info_t), 32, 0);
+	int dirlen = (base_dir != 0) ? strlen(base_dir) + 1 : 0;
+	while ((read = getline(&file, &len, r0)) != -1)
+	{
+		while(read > 1 && isspace(file[read - 1]))
+			read--;
+		file[read] = 0;
+		ccv_file_info_t file_info;
+		file_info.filename = (char*)ccmalloc(1024);
+		if (base_dir != 0)
+		{
+			strncpy(file_info.filename, base_dir, 1024);
+			file_info.filename[dirlen - 1] = '/';
+		}
+		strncpy(file_info.filename + dirlen, file, 1024 - dirlen);
+		ccv_array_push(files, &file_info);
+	}
+	fclose(r0);
+	free(file);
+	ccv_icf_classifier_cascade_t* cascade = ccv_icf_read_classifier_cascade(classifier_cascade);
+	assert(cascade && "classifier cascade doesn't exists");
+	ccv_icf_classifier_cascade_power_law(cascade, files);
+	ccv_icf_write_classifier_cascade(cascade, classifier_cascade);
+	for (i = 0; i < files->rnum; i++)
+	{
+		ccv_file_info_t* file_info = (ccv_file_info_t*)ccv_array_get(files, i);
+		free(file_info->filename);
+	}
+	ccv_array_free(files);
+	ccv_icf_classifier_cascade_free(cascade);
+	return 0;
+}
@@ -12,6 +12,8 @@ int main(int argc, char** argv)
 {
 	assert(argc == 3);
 	ccv_enable_default_cache();
+	if (getenv("CCV_CACHE_STATS"))
+		ccv_enable_cache_source_stats();
 	ccv_dense_matrix_t* object = 0;
 	ccv_dense_matrix_t* image = 0;
 	ccv_read(argv[1], &object, CCV_IO_GRAY | CCV_IO_ANY_FILE);
@@ -75,6 +77,8 @@ int main(int argc, char** argv)
 	ccv_matrix_free(image_desc);
 	ccv_matrix_free(object);
 	ccv_matrix_free(image);
+	if (getenv("CCV_CACHE_STATS"))
+		ccv_dump_cache_stats(stderr);
 	ccv_disable_cache();
 	return 0;
 }
@@ -12,6 +12,8 @@ static unsigned int get_current_time(void)
 int main(int argc, char** argv)
 {
 	ccv_enable_default_cache();
+	if (getenv("CCV_CACHE_STATS"))
+		ccv_enable_cache_source_stats();
 	ccv_dense_matrix_t* image = 0;
 	ccv_read(argv[1], &image, CCV_IO_GRAY | CCV_IO_ANY_FILE);
 	if (image != 0)
@@ -62,6 +64,8 @@ int main(int argc, char** argv)
 			fclose(r);
 		}
 	}
+	if (getenv("CCV_CACHE_STATS"))
+		ccv_dump_cache_stats(stderr);
 	ccv_drain_cache();
 	return 0;
 }
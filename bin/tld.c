@@ -71,6 +71,8 @@ int main(int argc, char** argv)
 		avcodec_decode_video2(video_st->codec, picture, &got_picture, &packet);
 	}
 	ccv_enable_default_cache();
+	if (getenv("CCV_CACHE_STATS"))
+		ccv_enable_cache_source_stats();
 #if LIBAVUTIL_VERSION_MAJOR > 51
 	struct SwsContext* picture_ctx = sws_getCachedContext(0, video_st->codec->width, video_st->codec->height, video_st->codec->pix_fmt, video_st->codec->width, video_st->codec->height, AV_PIX_FMT_RGB24, SWS_BICUBIC, 0, 0, 0);
 #else
@@ -146,6 +148,8 @@ int main(int argc, char** argv)
 	ccv_matrix_free(x);
 	ccv_tld_free(tld);
 	ccfree(rgb_picture.data[0]);
+	if (getenv("CCV_CACHE_STATS"))
+		ccv_dump_cache_stats(stderr);
 	ccv_disable_cache();
 #endif
 #endif
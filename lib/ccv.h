@@ -143,7 +143,7 @@ typedef void ccv_matrix_t;
 
 /**
  * @defgroup ccv_cache cache mechanism
- * This class implements a trie-based LRU cache that is then used for ccv application-wide cache in [ccv_memory.c](/lib/ccv-memory).
+ * This class implements a trie-based LRU cache that is then used for ccv application-wide cache in [ccv_memory.c](/lib/ccv-memory). Objects are indexed by a radix tree on their signatures, and linked into a LRU list per type, thus, the eviction takes constant time.
  * @{
  */
 
@@ -153,22 +153,45 @@ typedef union {
 	struct {
 		uint64_t bitmap;
 		uint64_t set;
-		uint64_t age;
 	} branch;
 	struct {
 		uint64_t sign;
 		uint64_t off;
-		uint64_t type;
 	} terminal;
 } ccv_cache_index_t;
 
+typedef struct ccv_cache_node_s {
+	struct ccv_cache_node_s* prev;
+	struct ccv_cache_node_s* next;
+	uint64_t sign;
+	void* x;
+	uint64_t age;
+	uint32_t size;
+	uint8_t type;
+} ccv_cache_node_t;
+
+typedef struct {
+	ccv_cache_node_t* head;
+	ccv_cache_node_t* tail;
+	size_t up;
+	size_t size;
+	uint32_t rnum;
+} ccv_cache_lru_t;
+
 typedef struct {
 	ccv_cache_index_t origin;
 	uint32_t rnum;
-	uint32_t age;
+	int types;
+	uint64_t age;
 	size_t up;
 	size_t size;
 	ccv_cache_index_free_f ffree[16];
+	ccv_cache_lru_t lru[16];
+	uint64_t hits; /**< The number of lookups found the object. */
+	uint64_t misses; /**< The number of lookups didn't find the object. */
+	uint64_t evictions; /**< The number of objects freed to make room for others. */
+	uint64_t departures; /**< The number of objects left the cache (taken out, evicted or deleted). */
+	uint64_t lifetime; /**< The total lifetime of departed objects, measured in the number of puts happened while they were in the cache. */
 } ccv_cache_t;
 
 /* I made it as generic as possible */
@@ -181,6 +204,13 @@ typedef struct {
  * @param ffree The function that will be used to free cached object.
  */
 void ccv_cache_init(ccv_cache_t* cache, size_t up, int cache_types, ccv_cache_index_free_f ffree, ...);
+/**
+ * Set a byte budget for objects of the given type. When it is exceeded, the least recently put objects of that type are evicted first, regardless of the other types.
+ * @param cache The cache.
+ * @param type The type of the object.
+ * @param up The upper limit of the objects of that type, in bytes. 0 means only the cache-wide limit applies.
+ */
+void ccv_cache_set_type_limit(ccv_cache_t* cache, uint8_t type, size_t up);
 /**
  * Get an object from cache for its signature. 0 if cannot find the object.
  * @param cache The cache.
@@ -459,6 +489,164 @@ void ccv_enable_default_cache(void);
  * @param size The upper limit of the cache, in bytes.
  */
 void ccv_enable_cache(size_t size);
+/**
+ * Enable a process-wide cache for ccv. Unlike ccv_enable_cache, which keeps one cache per thread, matrices / arrays recycled on one thread can be reused by another thread. The cache is split into lock-striped shards by the signature, thus, different threads rarely contend on the same lock. When enabled, it takes precedence over the thread-local cache. Call ccv_disable_cache to drain up and disable it. Enabling / disabling itself is not thread-safe, do it before / after worker threads start / finish.
+ * @param size The upper limit of the cache, in bytes. It is divided evenly between shards.
+ */
+void ccv_enable_shared_cache(size_t size);
+
+typedef struct {
+	uint64_t hits; /**< The number of matrices / arrays returned from the cache. */
+	uint64_t misses; /**< The number of cache lookups that had to compute the result. */
+	uint64_t evictions; /**< The number of objects freed to make room for others. */
+	uint32_t rnum[2]; /**< The number of objects resident per type, 0 for matrices and 1 for arrays. */
+	size_t size[2]; /**< The bytes resident per type, 0 for matrices and 1 for arrays. */
+	double lifetime; /**< The average lifetime of objects that left the cache, measured in the number of objects put into the cache while they were in it. */
+} ccv_cache_stats_t;
+
+typedef struct {
+	const char* source; /**< The function that derived the signature. */
+	uint64_t hits; /**< The number of results of this function returned from the cache. */
+	uint64_t misses; /**< The number of times this function had to compute its result. */
+} ccv_cache_source_stats_t;
+
+/**
+ * Get the statistics of the application-wide cache. They are accumulated across all threads, for both the thread-local and the process-wide cache.
+ * @param stats The statistics of the cache.
+ */
+void ccv_cache_stats(ccv_cache_stats_t* stats);
+/**
+ * Reset the hits, misses, evictions and lifetime counters of the application-wide cache. The resident objects / bytes are kept.
+ */
+void ccv_reset_cache_stats(void);
+/**
+ * Start to break down hits and misses by the function that derived the signature. It costs a lock per cache lookup, therefore, it is off by default.
+ */
+void ccv_enable_cache_source_stats(void);
+/**
+ * Stop to break down hits and misses by source, and forget the ones collected so far.
+ */
+void ccv_disable_cache_source_stats(void);
+/**
+ * Get the hits and misses per source, ordered by the number of lookups, descending.
+ * @param sources The array to hold the per source statistics.
+ * @param size The size of the array.
+ * @return The number of sources filled in.
+ */
+int ccv_cache_source_stats(ccv_cache_source_stats_t* sources, int size);
+/**
+ * Print the statistics of the application-wide cache, and the per source breakdown if enabled, in a human readable form.
+ * @param stream The stream to print to, e.g. stderr.
+ */
+void ccv_dump_cache_stats(FILE* stream);
+/**
+ * Mark the function that derives the next signature on this thread, the following cache lookup will be attributed to it. ccv_declare_derived_signature calls it for you.
+ * @param source The function name, it has to outlive the statistics (a string literal or __func__).
+ */
+void ccv_set_cache_source(const char* source);
+
+typedef struct {
+	uint64_t alloc_count; /**< The number of matrices allocated from the pool. */
+	uint64_t free_count; /**< The number of matrices returned to the pool. */
+	uint64_t hit_count; /**< The number of allocations served by a recycled block. */
+	size_t allocated; /**< The bytes currently held by live matrices. */
+	size_t allocated_high_water_mark; /**< The peak of allocated bytes. */
+	size_t pooled; /**< The bytes currently held by idle blocks in the pool. */
+	size_t pooled_high_water_mark; /**< The peak of pooled bytes. */
+} ccv_matrix_pool_stats_t;
+
+/**
+ * Enable a process-wide, size-classed pool for dense matrices allocated by ccv_dense_matrix_new. Such matrices are 64-byte aligned (as is their data section), and their memory blocks are recycled on ccv_matrix_free instead of returning to the OS. Matrices allocated from the pool must be freed with ccv_matrix_free / ccv_matrix_free_immediately.
+ * @param size The upper limit of idle bytes the pool holds, in bytes.
+ */
+void ccv_enable_matrix_pool(size_t size);
+/**
+ * Free up all idle blocks held by the matrix pool.
+ */
+void ccv_drain_matrix_pool(void);
+/**
+ * Drain up and disable the matrix pool. Matrices allocated from the pool can still be freed afterwards.
+ */
+void ccv_disable_matrix_pool(void);
+/**
+ * Get the allocation counters and high-water marks of the matrix pool.
+ * @param stats The statistics of the matrix pool.
+ */
+void ccv_matrix_pool_stats(ccv_matrix_pool_stats_t* stats);
+
+typedef struct ccv_arena_chunk_s ccv_arena_chunk_t;
+
+typedef struct ccv_arena_s {
+	size_t chunk_size; /**< The size of each chunk the arena bumps allocations from. */
+	size_t allocated; /**< The bytes allocated from the arena since last reset. */
+	unsigned char* ptr; /**< The next free byte in the current chunk. */
+	unsigned char* end; /**< The end of the current chunk. */
+	ccv_arena_chunk_t* chunk; /**< The chunks in use, the first one is the current chunk. */
+	ccv_arena_chunk_t* large; /**< The allocations that are too large to fit in a chunk. */
+	struct ccv_arena_s* prev; /**< The arena that was current before this one pushed. */
+} ccv_arena_t;
+
+/**
+ * Create a bump arena (a "frame allocator"). While it is pushed as the current arena of a thread, dense matrices and arrays created by ccv_dense_matrix_new / ccv_array_new on that thread are allocated from it, and ccv_matrix_free / ccv_array_free on them do nothing. All of them are released together with ccv_arena_reset / ccv_arena_free.
+ * @param chunk_size The size of each chunk the arena allocates from the OS, 0 for a reasonable default (1MiB).
+ * @return The newly created arena.
+ */
+CCV_WARN_UNUSED(ccv_arena_t*) ccv_arena_new(size_t chunk_size);
+/**
+ * Allocate memory from the arena, the memory is 16-byte aligned.
+ * @param arena The arena.
+ * @param size The size of the memory, in bytes.
+ * @return The pointer to the allocated memory.
+ */
+void* ccv_arena_alloc(ccv_arena_t* arena, size_t size);
+/**
+ * Make the arena the current one for this thread. Arenas are stacked, the previous current arena will be restored on ccv_arena_pop.
+ * @param arena The arena.
+ */
+void ccv_arena_push(ccv_arena_t* arena);
+/**
+ * Restore the previous current arena for this thread.
+ */
+void ccv_arena_pop(void);
+/**
+ * Release everything allocated from the arena in one call. The first chunk is kept to serve following allocations.
+ * @param arena The arena.
+ */
+void ccv_arena_reset(ccv_arena_t* arena);
+/**
+ * Release everything allocated from the arena and free the arena itself. It cannot be current for any thread.
+ * @param arena The arena.
+ */
+void ccv_arena_free(ccv_arena_t* arena);
+
+typedef struct {
+	void* addr; /**< The start of the mapped file. */
+	size_t size; /**< The size of the mapped file, in bytes. */
+	int refcount; /**< The number of owners, the file is unmapped when it drops to 0. */
+} ccv_mmap_t;
+
+/**
+ * Map a file into memory, privately. Writes to the mapped memory are copy-on-write, they are never carried to the file.
+ * @param filename The file name.
+ * @return The mapped file with refcount 1, 0 if cannot map the file (or mmap is not supported on the platform).
+ */
+CCV_WARN_UNUSED(ccv_mmap_t*) ccv_mmap_new(const char* filename);
+/**
+ * Drop one reference of the mapped file, unmap it if it is the last one.
+ * @param mmap The mapped file.
+ */
+void ccv_mmap_free(ccv_mmap_t* mmap);
+/**
+ * Create a dense matrix whose data section points into a mapped file, nothing is copied. The matrix is typed CCV_NO_DATA_ALLOC | CCV_UNMANAGED, and it holds a reference of the mapped file, which is dropped on ccv_matrix_free / ccv_matrix_free_immediately. The data section can be modified in place, the pages written are copied, and the file stays intact.
+ * @param mmap The mapped file.
+ * @param offset The offset of the data section in the file, in bytes.
+ * @param rows Rows of the matrix.
+ * @param cols Columns of the matrix.
+ * @param type Matrix supports 4 data types - CCV_8U, CCV_32S, CCV_64S, CCV_32F, CCV_64F and up to 255 channels. e.g. CCV_32F | 31 will create a matrix with float (32-bit float point) data type with 31 channels (the default type for ccv_hog).
+ * @param step The bytes per row in the file.
+ * @return The newly created matrix, 0 if the data section is out of the mapped file.
+ */
+CCV_WARN_UNUSED(ccv_dense_matrix_t*) ccv_dense_matrix_new_mmap(ccv_mmap_t* mmap, size_t offset, int rows, int cols, int type, int step);
 
 #define ccv_get_dense_matrix_cell_by(type, x, row, col, ch) \
 	(((type) & CCV_32S) ? (void*)((x)->data.i32 + ((row) * (x)->cols + (col)) * CCV_GET_CHANNEL(type) + (ch)) : \
@@ -510,6 +698,13 @@ enum {
 enum {
 	// modifier for not copy the data over when read raw in-memory data
 	CCV_IO_NO_COPY = 0x10000,
+	// modifier for mapping the file into memory instead of reading it, only binary files and raw data files can be mapped
+	CCV_IO_MMAP = 0x20000,
+	// modifier for decoding the luma channel as the grayscale image if the format stores it on its own (JPEG), together with CCV_IO_GRAY.
+	// The luma is not exactly the same as the grayscale converted from RGB, but the chroma is never decoded
+	CCV_IO_LUMA = 0x40000,
+	// modifier for ccv_write of PNG, conf is a ccv_io_png_param_t* rather than an int* of the zlib memory level
+	CCV_IO_PNG_PARAMS = 0x80000,
 };
 
 enum {
@@ -538,6 +733,21 @@ enum {
 	CCV_IO_GRAY_RAW       = 0x047,
 };
 
+enum {
+	// filters for PNG write, the same as PNG_FILTER_* in libpng
+	CCV_IO_PNG_FILTER_NONE  = 0x08,
+	CCV_IO_PNG_FILTER_SUB   = 0x10,
+	CCV_IO_PNG_FILTER_UP    = 0x20,
+	CCV_IO_PNG_FILTER_AVG   = 0x40,
+	CCV_IO_PNG_FILTER_PAETH = 0x80,
+	CCV_IO_PNG_ALL_FILTERS  = 0xf8,
+};
+
+typedef struct {
+	int compression_level; /**< The zlib compression level, from 0 (no compression) to 9 (best compression). */
+	int filters; /**< The row filters libpng can choose from, any combination of CCV_IO_PNG_FILTER_*, 0 for all of them. */
+} ccv_io_png_param_t;
+
 enum {
 	CCV_IO_FINAL = 0x00,
 	CCV_IO_CONTINUE,
@@ -552,7 +762,7 @@ enum {
  * Read image from a file. This function has soft dependencies on [LibJPEG](http://libjpeg.sourceforge.net/) and [LibPNG](http://www.libpng.org/pub/png/libpng.html). No these libraries, no JPEG nor PNG read support. However, ccv does support BMP read natively (it is a simple format after all).
  * @param in The file name.
  * @param x The output image.
- * @param type CCV_IO_ANY_FILE, accept any file format. CCV_IO_GRAY, convert to grayscale image. CCV_IO_RGB_COLOR, convert to color image.
+ * @param type CCV_IO_ANY_FILE, accept any file format. CCV_IO_GRAY, convert to grayscale image. CCV_IO_RGB_COLOR, convert to color image. With CCV_IO_MMAP, a binary file (CCV_IO_BINARY_FILE) is mapped into memory and the returned matrix points into it (see ccv_dense_matrix_new_mmap), other formats are read as usual.
  */
 /**
  * @fn int ccv_read(const void* data, ccv_dense_matrix_t** x, int type, int size)
@@ -567,7 +777,7 @@ enum {
  * Read image from a region of memory that assumes specific layout (RGB, GRAY, BGR, RGBA, ARGB, RGBA, ABGR, BGRA). By default, this method will create a matrix and copy data over to that matrix. With CCV_IO_NO_COPY, it will create a matrix that has data block pointing to the original data memory region. It is your responsibility to release that data memory at an appropriate time after release the matrix.
  * @param data The data memory.
  * @param x The output image.
- * @param type CCV_IO_ANY_RAW, CCV_IO_RGB_RAW, CCV_IO_BGR_RAW, CCV_IO_RGBA_RAW, CCV_IO_ARGB_RAW, CCV_IO_BGRA_RAW, CCV_IO_ABGR_RAW, CCV_IO_GRAY_RAW. These in conjunction can be used with CCV_IO_NO_COPY.
+ * @param type CCV_IO_ANY_RAW, CCV_IO_RGB_RAW, CCV_IO_BGR_RAW, CCV_IO_RGBA_RAW, CCV_IO_ARGB_RAW, CCV_IO_BGRA_RAW, CCV_IO_ABGR_RAW, CCV_IO_GRAY_RAW. These in conjunction can be used with CCV_IO_NO_COPY. With CCV_IO_MMAP, data is the file name of the raw data instead, and the returned matrix points into the mapped file, as if it is read with CCV_IO_NO_COPY, except that you don't need to release the data memory yourself.
  * @param rows How many rows in the given data memory region.
  * @param cols How many columns in the given data memory region.
  * @param scanline The size of a single column in the given data memory region (or known as "bytes per row").
@@ -581,14 +791,94 @@ int ccv_read_impl(const void* in, ccv_dense_matrix_t** x, int type, int rows, in
 // ccv_read(in, x, type) or ccv_read(in, x, type, rows, cols, scanline)
 // notice that you can implement this with va_* functions, but that is not type-safe
 /**
- * Write image to a file. This function has soft dependencies on [LibJPEG](http://libjpeg.sourceforge.net/) and [LibPNG](http://www.libpng.org/pub/png/libpng.html). No these libraries, no JPEG nor PNG write support.
+ * Read image from a file or a region of memory at a reduced size. The image is decoded as small as the format allows for free while its larger side is still no smaller than max_dimension. For JPEG, this uses the scaled inverse DCT (1/2, 1/4 or 1/8) of libjpeg, and with CCV_IO_GRAY | CCV_IO_LUMA, only the luma channel is decoded. Other formats are decoded at full size. Thus, the result is still needed to be resampled if you want the exact size.
+ * @param in The file name or the data memory.
+ * @param x The output image.
+ * @param type CCV_IO_ANY_FILE or CCV_IO_ANY_STREAM, accept any file format. CCV_IO_GRAY, convert to grayscale image. CCV_IO_RGB_COLOR, convert to color image. CCV_IO_LUMA, use the luma of a JPEG as the grayscale image.
+ * @param size The size of that data memory region (for CCV_IO_ANY_STREAM), 0 for file.
+ * @param max_dimension The minimal size of the larger side of the decoded image, 0 to decode at full size.
+ */
+int ccv_read_scaled(const void* in, ccv_dense_matrix_t** x, int type, int size, int max_dimension);
+/**
+ * Write image to a file or a region of memory. This function has soft dependencies on [LibJPEG](http://libjpeg.sourceforge.net/) and [LibPNG](http://www.libpng.org/pub/png/libpng.html). No these libraries, no JPEG nor PNG write support.
  * @param mat The input image.
- * @param out The file name.
- * @param len The output bytes.
- * @param type CCV_IO_PNG_FILE, save to PNG format. CCV_IO_JPEG_FILE, save to JPEG format.
- * @param conf configuration.
+ * @param out The file name, or the data memory for streams.
+ * @param len The output bytes. For streams, it is the size of the data memory on input, and the bytes written on output.
+ * @param type CCV_IO_PNG_FILE, save to PNG format. CCV_IO_JPEG_FILE, save to JPEG format. CCV_IO_BINARY_FILE, save to ccv's binary format. CCV_IO_PNG_STREAM, CCV_IO_JPEG_STREAM, save to the data memory in PNG or JPEG format, it returns CCV_IO_ERROR if the data memory is not large enough. For PNG, add CCV_IO_PNG_PARAMS to pass a ccv_io_png_param_t* as conf.
+ * @param conf configuration. For JPEG, it is an int* of the quality (95 by default). For PNG, it is an int* of the zlib memory level (1 to 9), or with CCV_IO_PNG_PARAMS, a ccv_io_png_param_t* of the compression level and the row filters. Either way, 0 (or a memory level of 0) favors speed over size.
+ * @return CCV_IO_FINAL if succeed.
  */
 int ccv_write(ccv_dense_matrix_t* mat, char* out, int* len, int type, void* conf);
+/**
+ * Write a batch of images concurrently, each of them is written as if with ccv_write.
+ * @param mats The input images.
+ * @param outs The file names, or the data memory for streams.
+ * @param lens The output bytes of each image, see ccv_write. It can be 0 for files.
+ * @param count The number of images.
+ * @param type The same as ccv_write, all images are written in the same format.
+ * @param conf The same as ccv_write, shared by all images.
+ * @return CCV_IO_FINAL if all succeed, otherwise CCV_IO_ERROR.
+ */
+int ccv_write_batch(ccv_dense_matrix_t** mats, char** outs, int* lens, int count, int type, void* conf);
+
+typedef struct {
+	int type; /**< The type of the matrix. */
+	int rows; /**< The rows of the matrix. */
+	int cols; /**< The columns of the matrix. */
+	int tile_rows; /**< The rows of each tile, the matrix is stored as bands of rows (tiles) compressed individually. */
+} ccv_container_info_t;
+
+typedef struct ccv_container_s ccv_container_t;
+
+/**
+ * Create a container file to write dense matrices to. A container holds many matrices, each matrix is cut into tiles of rows that are compressed individually (with a built-in LZ codec), thus, any band of rows can be read later without reading the whole matrix.
+ * @param filename The file name.
+ * @return The container, 0 if the file cannot be created.
+ */
+CCV_WARN_UNUSED(ccv_container_t*) ccv_container_new(const char* filename);
+/**
+ * Open a container file to read dense matrices from.
+ * @param filename The file name.
+ * @return The container, 0 if the file cannot be opened, is not a container, or its index is not valid (a negative count, an unknown type, or a tile too big).
+ */
+CCV_WARN_UNUSED(ccv_container_t*) ccv_container_open(const char* filename);
+/**
+ * Append a dense matrix to a container created with ccv_container_new.
+ * @param container The container.
+ * @param mat The dense matrix.
+ * @param tile_rows The rows of each tile, 0 for tiles of about 256KiB. It is capped at the rows of the matrix.
+ * @return The index of the matrix in the container, -1 if failed (including a tile that doesn't fit in 2GiB / 3).
+ */
+int ccv_container_write(ccv_container_t* container, ccv_dense_matrix_t* mat, int tile_rows);
+/**
+ * The number of matrices in the container.
+ * @param container The container.
+ * @return The number of matrices.
+ */
+int ccv_container_count(ccv_container_t* container);
+/**
+ * Get the type and size of a matrix in the container without reading it.
+ * @param container The container.
+ * @param index The index of the matrix.
+ * @param info The output information.
+ * @return 0 if succeed, -1 if the index is out of range.
+ */
+int ccv_container_info(ccv_container_t* container, int index, ccv_container_info_t* info);
+/**
+ * Read a band of rows of a matrix from a container opened with ccv_container_open, only the tiles that contain these rows are read. A container is not meant to be read from multiple threads at the same time.
+ * @param container The container.
+ * @param index The index of the matrix.
+ * @param row The first row to read.
+ * @param rows The number of rows to read, 0 to read till the end.
+ * @param x The output matrix.
+ * @return CCV_IO_FINAL if succeed, CCV_IO_ERROR otherwise.
+ */
+int ccv_container_read(ccv_container_t* container, int index, int row, int rows, ccv_dense_matrix_t** x);
+/**
+ * Close the container, for a container created with ccv_container_new, the index is written out at this point, thus, the file is not readable until it is closed.
+ * @param container The container.
+ */
+void ccv_container_close(ccv_container_t* container);
 /** @} */
 
 /**
@@ -631,7 +921,7 @@ double ccv_norm(ccv_matrix_t* mat, int type);
  */
 double ccv_normalize(ccv_matrix_t* a, ccv_matrix_t** b, int btype, int flag);
 /**
- * Generate the [Summed Area Table](https://en.wikipedia.org/wiki/Summed_area_table).
+ * Generate the [Summed Area Table](https://en.wikipedia.org/wiki/Summed_area_table). The output matrix can be a header (from ccv_dense_matrix) on a buffer you reuse, or with CCV_NO_PADDING and the same type, the input matrix itself, which computes it in place.
  * @param a The input matrix.
  * @param b The output matrix.
  * @param type The type of output matrix, if 0, ccv will try to match the input matrix for appropriate type.
@@ -1104,6 +1394,35 @@ typedef double(*ccv_filter_kernel_f)(double x, double y, void*);
  * @param data Any extra user data.
  */
 void ccv_filter_kernel(ccv_dense_matrix_t* x, ccv_filter_kernel_f func, void* data);
+/**
+ * A bank of kernels to convolve the same image with. It keeps the kernels in frequency domain, as well as the FFT plans, for each FFT size it has seen, and transforms each tile of the image once for all the kernels of the same size. The bank is not thread-safe, don't use one bank from multiple threads at the same time.
+ */
+typedef struct {
+	int count; /**< The number of kernels. */
+	ccv_dense_matrix_t** kernels; /**< The kernels, the bank doesn't own them. */
+	ccv_array_t* plans; /**< The cached FFT plans and kernels in frequency domain. */
+} ccv_filter_bank_t;
+/**
+ * Create a bank of kernels. The kernels have to outlive the bank.
+ * @param kernels The kernels.
+ * @param count The number of kernels.
+ * @return A filter bank.
+ */
+CCV_WARN_UNUSED(ccv_filter_bank_t*) ccv_filter_bank_new(ccv_dense_matrix_t** kernels, int count);
+/**
+ * Convolve the input matrix with every kernel of the bank, the same as ccv_filter with each kernel.
+ * @param a The input matrix.
+ * @param bank The filter bank.
+ * @param d The array of output matrices, one for each kernel.
+ * @param type The type of output matrices, if 0, ccv will try to match the input matrix for appropriate type.
+ * @param padding_pattern ccv doesn't support padding pattern for now.
+ */
+void ccv_filter_bank(ccv_dense_matrix_t* a, ccv_filter_bank_t* bank, ccv_dense_matrix_t** d, int type, int padding_pattern);
+/**
+ * Free the filter bank, along with its cached plans.
+ * @param bank The filter bank.
+ */
+void ccv_filter_bank_free(ccv_filter_bank_t* bank);
 
 /* modern numerical algorithms */
 /**
@@ -1152,6 +1471,13 @@ void ccv_sobel(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type, int dx,
  * @param dy The window size of the underlying Sobel operator used on y-axis, specially optimized for 1, 3
  */
 void ccv_gradient(ccv_dense_matrix_t* a, ccv_dense_matrix_t** theta, int ttype, ccv_dense_matrix_t** m, int mtype, int dx, int dy);
+/**
+ * Compute the gradient at each pixel in one pass, with orientation already quantized into bins. It uses the same 1x3 / 3x1 Sobel operator and the same arctan as ccv_gradient with dx = 1, dy = 1. For a multi-channel matrix, only the channel with the largest magnitude is kept (as HOG does), thus, the output always has 2 channels: the orientation in bin unit (from 0 to nbin over 360 degree, its integral part is the bin index) and the magnitude.
+ * @param a The input matrix.
+ * @param b The output matrix, CCV_32F | CCV_C2.
+ * @param nbin The number of orientation bins over 360 degree.
+ */
+void ccv_gradient_bin(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int nbin);
 
 enum {
 	CCV_FLIP_X = 0x01,
@@ -1166,7 +1492,7 @@ enum {
  */
 void ccv_flip(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int btype, int type);
 /**
- * Using [Gaussian blur](https://en.wikipedia.org/wiki/Gaussian_blur) on a given matrix. It implements a O(n * sqrt(m)) algorithm, n is the size of input matrix, m is the size of Gaussian filtering kernel.
+ * Using [Gaussian blur](https://en.wikipedia.org/wiki/Gaussian_blur) on a given matrix. It implements a O(n * sqrt(m)) algorithm, n is the size of input matrix, m is the size of Gaussian filtering kernel. For sigma larger than 6, it switches to Deriche's recursive Gaussian, which costs O(n) regardless of sigma, and is within 0.05% of the Gaussian filter.
  * @param a The input matrix.
  * @param b The output matrix.
  * @param type The type of output matrix, if 0, ccv will try to match the input matrix for appropriate type.
@@ -1225,6 +1551,7 @@ enum {
 
 /**
  * Resample a given matrix to different size, as for now, ccv only supports either downsampling (with CCV_INTER_AREA) or upsampling (with CCV_INTER_CUBIC).
+ * The 8u and 32f paths are vectorized with SSE2 / NEON when available. The 8u output is bit-exact to the scalar code, the 32f output is within float rounding of it.
  * @param a The input matrix.
  * @param b The output matrix.
  * @param btype The type of output matrix, if 0, ccv will try to match the input matrix for appropriate type.
@@ -1233,6 +1560,24 @@ enum {
  * @param type For now, ccv supports CCV_INTER_AREA, which is an extension to [bilinear resampling](https://en.wikipedia.org/wiki/Bilinear_filtering) for downsampling and CCV_INTER_CUBIC [bicubic resampling](https://en.wikipedia.org/wiki/Bicubic_interpolation) for upsampling.
  */
 void ccv_resample(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int btype, int rows, int cols, int type);
+
+enum {
+	CCV_RESAMPLE_NCHW = 0x10, /**< Write the channels as planes, the default is interleaved (NHWC). */
+	CCV_RESAMPLE_GRAY = 0x20, /**< Convert RGB input to grayscale. */
+	CCV_RESAMPLE_RGB  = 0x40, /**< Convert grayscale input to RGB. */
+};
+
+/**
+ * Resample an 8-bit grayscale or RGB image into a normalized float tensor in one pass, without intermediate matrices. It fuses color conversion, resampling and (pixel - mean) / std, which otherwise take ccv_color_transform / ccv_resample / ccv_shift and a normalization loop.
+ * @param a The input matrix, 8-bit with 1 or 3 channels.
+ * @param b The output tensor, rows * cols * channels floats.
+ * @param rows The new row.
+ * @param cols The new column.
+ * @param type CCV_INTER_AREA or CCV_INTER_CUBIC, if 0, it uses CCV_INTER_AREA to downsample and CCV_INTER_CUBIC to upsample. It can be combined with CCV_RESAMPLE_NCHW, CCV_RESAMPLE_GRAY or CCV_RESAMPLE_RGB.
+ * @param mean The mean for each output channel, 0 for no mean.
+ * @param std The standard deviation for each output channel, 0 for no std.
+ */
+void ccv_resample_normalize(ccv_dense_matrix_t* a, float* b, int rows, int cols, int type, const float* mean, const float* std);
 /**
  * Downsample a given matrix to exactly half size with a [Gaussian filter](https://en.wikipedia.org/wiki/Gaussian_filter). The half size is approximated by floor(rows * 0.5) x floor(cols * 0.5).
  * @param a The input matrix.
@@ -1251,6 +1596,47 @@ void ccv_sample_down(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type, in
  * @param src_y Shift the start point by src_y.
  */
 void ccv_sample_up(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type, int src_x, int src_y);
+
+enum {
+	CCV_PYRAMID_ACCURATE = 0x01, /**< Also build the levels down sampled from source offset (1, 0), (0, 1) and (1, 1), from the second octave on. */
+};
+
+typedef struct {
+	int type; /**< The type of the levels, the same as the source. */
+	int rows; /**< The rows of the source. */
+	int cols; /**< The columns of the source. */
+	int interval; /**< Interval images between an octave and the next. */
+	int count; /**< The number of levels. */
+	int flags; /**< CCV_PYRAMID_ACCURATE if the offset levels are built. */
+	uint64_t sig; /**< The signature of the source, 0 if the pyramid cannot be shared. */
+	size_t size; /**< The size of the allocation that holds all levels but the first one. */
+	unsigned char* data; /**< The allocation that holds all levels but the first one. */
+	ccv_dense_matrix_t* levels; /**< The levels, the first one is the source itself. */
+	ccv_dense_matrix_t* offsets; /**< The offset levels, 3 for each level from the second octave on. */
+} ccv_pyramid_t;
+
+/**
+ * Create an empty image pyramid, it can be filled and refilled with ccv_pyramid.
+ * @return The newly created pyramid.
+ */
+CCV_WARN_UNUSED(ccv_pyramid_t*) ccv_pyramid_new(void);
+/**
+ * Build an image pyramid in one go. Level i (0 < i <= interval) is the source resampled by 2^(-i / (interval + 1)) with CCV_INTER_AREA, every other level is ccv_sample_down of the level one octave above it. All levels live in a single allocation that is kept to build the next pyramid of the same size (such as the next frame of a video), and the levels in the same octave are built in parallel. If the source has a signature and the pyramid already holds at least as many levels of it with the same interval and flags, nothing will be built, thus, multiple detectors can share the pyramid of one image.
+ * @param a The source matrix, the first level refers to its data, therefore, it has to outlive the use of the pyramid.
+ * @param pyramid The pyramid to fill.
+ * @param interval Interval images between an octave and the next.
+ * @param count The number of levels.
+ * @param flags CCV_PYRAMID_ACCURATE to also build the offset levels.
+ */
+void ccv_pyramid(ccv_dense_matrix_t* a, ccv_pyramid_t* pyramid, int interval, int count, int flags);
+/**
+ * Free the pyramid and its levels.
+ * @param pyramid The pyramid.
+ */
+void ccv_pyramid_free(ccv_pyramid_t* pyramid);
+#define ccv_pyramid_level(pyramid, i) ((pyramid)->levels + (i))
+/* q is 1 for the offset (1, 0), 2 for (0, 1), and 3 for (1, 1) */
+#define ccv_pyramid_offset_level(pyramid, i, q) ((pyramid)->offsets + ((i) - ((pyramid)->interval + 1) * 2) * 3 + (q) - 1)
 /** @} */
 
 /**
@@ -1284,6 +1670,34 @@ ccv_decimal_point_t ccv_perspective_transform_apply(ccv_decimal_point_t point, c
  * @param m00, m01, m02, m10, m11, m12, m20, m21, m22 The transformation matrix
  */
 void ccv_perspective_transform(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type, float m00, float m01, float m02, float m10, float m11, float m12, float m20, float m21, float m22);
+
+typedef struct {
+	ccv_dense_matrix_t* a; /**< The input matrix. */
+	ccv_dense_matrix_t* b; /**< The output matrix, if it is 0, one will be allocated. */
+	int type; /**< The type of output matrix, if 0, it matches the input matrix. */
+	int rows; /**< The rows of output matrix. */
+	int cols; /**< The cols of output matrix. */
+	float m[9]; /**< The 3x3 matrix (row major) maps (x, y, 1) in the output matrix to homogeneous coordinates in the input matrix, in pixels. */
+} ccv_warp_t;
+
+/**
+ * Build a warp that is the same as ccv_perspective_transform on a given matrix and then ccv_slice of the result, but only computes the slice.
+ * @param a The given matrix to be transformed
+ * @param type The type of output matrix
+ * @param y The top point of the slice
+ * @param x The left point of the slice
+ * @param rows The number of rows of the slice
+ * @param cols The number of cols of the slice
+ * @param m00, m01, m02, m10, m11, m12, m20, m21, m22 The transformation matrix, as in ccv_perspective_transform
+ * @return The warp, to be run with ccv_warp.
+ */
+ccv_warp_t ccv_perspective_warp(ccv_dense_matrix_t* a, int type, int y, int x, int rows, int cols, float m00, float m01, float m02, float m10, float m11, float m12, float m20, float m21, float m22);
+/**
+ * Run a batch of warps with bilinear interpolation, in parallel. The source coordinates are computed once per output row into a fixed-point remap table (1/128 of a pixel), and pixels that map out of the input are 0. Affine warps (m20 = m21 = 0, m22 = 1) skip the division.
+ * @param warps The warps, the output matrices are written back to their b.
+ * @param count The number of warps.
+ */
+void ccv_warp(ccv_warp_t* warps, int count);
 /** @} */
 
 /* classic computer vision algorithms ccv_classic.c */
@@ -1586,6 +2000,7 @@ typedef struct {
 	int min_neighbors; /**< 0: no grouping afterwards. 1: group objects that intersects each other. > 1: group objects that intersects each other, and only passes these that have at least **min_neighbors** intersected objects. */
 	int flags; /**< CCV_DPM_NO_NESTED, if one class of object is inside another class of object, this flag will reject the first object. */
 	float threshold; /**< The threshold the determines the acceptance of an object. */
+	ccv_pyramid_t* pyramid; /**< If not 0, the image pyramid is built into it, thus, it can be reused for the next frame, or shared with other detectors on the same image. */
 } ccv_dpm_param_t;
 
 typedef struct {
@@ -1679,10 +2094,25 @@ typedef struct {
 	float* alpha;
 } ccv_bbf_stage_classifier_t;
 
+/* the cascade flattened into one block of memory, features are laid out one after another in the order they run */
+typedef struct {
+	int count; /**< The number of stages. */
+	int feature_count; /**< The number of features in all stages. */
+	int point_count; /**< The number of point pairs in all features. */
+	int* stage_size; /**< The number of features of each stage. */
+	float* threshold; /**< The threshold of each stage. */
+	float* alpha; /**< The two weights of each feature, for when it fails and passes. */
+	unsigned char* size; /**< The number of point pairs of each feature. */
+	short* x; /**< The point pairs of each feature, a point in P followed by a point in N. A missing point repeats the first one of its kind. */
+	short* y;
+	unsigned char* z; /**< Which plane the point is on: 0 for the full size, 1 for the half size, 2 for the quarter size. */
+} ccv_bbf_compiled_cascade_t;
+
 typedef struct {
 	int count;
 	ccv_size_t size;
 	ccv_bbf_stage_classifier_t* stage_classifier;
+	ccv_bbf_compiled_cascade_t* compiled; /**< The flattened cascade that detection runs on, 0 if it is not compiled yet. */
 } ccv_bbf_classifier_cascade_t;
 
 enum {
@@ -1696,6 +2126,7 @@ typedef struct {
 	int flags; /**< CCV_BBF_NO_NESTED, if one class of object is inside another class of object, this flag will reject the first object. */
 	int accurate; /**< BBF will generates 4 spatial scale variations for better accuracy. Set this parameter to 0 will reduce to 1 scale variation, and thus 3 times faster but lower the general accuracy of the detector. */
 	ccv_size_t size; /**< The smallest object size that will be interesting to us. */
+	ccv_pyramid_t* pyramid; /**< If not 0, the image pyramid is built into it, thus, it can be reused for the next frame, or shared with other detectors on the same image. */
 } ccv_bbf_param_t;
 
 typedef struct {
@@ -1741,6 +2172,13 @@ CCV_WARN_UNUSED(ccv_array_t*) ccv_bbf_detect_objects(ccv_dense_matrix_t* a, ccv_
  * @return A classifier cascade, 0 if no valid classifier cascade available.
  */
 CCV_WARN_UNUSED(ccv_bbf_classifier_cascade_t*) ccv_bbf_read_classifier_cascade(const char* directory);
+/**
+ * Flatten a BBF classifier cascade into the compact layout that detection runs on. The cascades from
+ * **ccv_bbf_read_classifier_cascade** and **ccv_bbf_classifier_cascade_read_binary** are compiled already, call it again
+ * after changing the stages. A cascade that is not compiled still works, but is flattened on every detection.
+ * @param cascade The BBF classifier cascade.
+ */
+void ccv_bbf_classifier_cascade_compile(ccv_bbf_classifier_cascade_t* cascade);
 /**
  * Free up the memory of BBF classifier cascade.
  * @param cascade The BBF classifier cascade.
@@ -1928,6 +2366,7 @@ void ccv_tld_free(ccv_tld_t* tld);
  */
 
 #define CCV_ICF_SAT_MAX (2)
+#define CCV_ICF_CHANNEL_MAX (10)
 
 typedef struct {
 	int count;
@@ -1957,6 +2396,7 @@ typedef struct {
 	ccv_margin_t margin;
 	ccv_size_t size; // this is the size includes the margin
 	ccv_icf_decision_tree_t* weak_classifiers;
+	float lambda[CCV_ICF_CHANNEL_MAX]; // the power law factor of each channel when the image scales, 0 if not estimated
 } ccv_icf_classifier_cascade_t; // Type A, scale image
 
 typedef struct {
@@ -1973,6 +2413,7 @@ typedef struct {
 	int step_through; /**< The step size for detection. */
 	int interval; /**< Interval images between the full size image and the half size one. e.g. 2 will generate 2 images in between full size image and half size one: image with full size, image with 5/6 size, image with 2/3 size, image with 1/2 size. */
 	float threshold;
+	int approximate; /**< 0: compute the channels on every interval image. 1: compute the channels once per octave, and approximate the interval images in between by scaling the channels with the power law factors of the first classifier cascade (Type A only). It saves most of the channel computation at a small accuracy loss. A cascade without the power law factors (all zero) computes every interval image, as with 0. */
 } ccv_icf_param_t;
 
 extern const ccv_icf_param_t ccv_icf_default_params;
@@ -2014,6 +2455,12 @@ CCV_WARN_UNUSED(ccv_icf_classifier_cascade_t*) ccv_icf_classifier_cascade_new(cc
  * @param acceptance The percentage of positive examples will be accepted when optimizing the soft cascade thresholds.
  */
 void ccv_icf_classifier_cascade_soft(ccv_icf_classifier_cascade_t* cascade, ccv_array_t* posfiles, double acceptance);
+/**
+ * Estimate the power law factors that approximate the channels of a scaled image from the channels of the original one, for the **approximate** option of the detector. The factors are kept in the classifier cascade, and persisted with it.
+ * @param cascade The classifier cascade that we want to estimate the power law factors for.
+ * @param files An array of **ccv_file_info_t** that gives the images to estimate on, natural images like the background images work.
+ */
+void ccv_icf_classifier_cascade_power_law(ccv_icf_classifier_cascade_t* cascade, ccv_array_t* files);
 /**
  * Read a ICF classifier from a file.
  * @param filename The file path that contains the trained ICF classifier.
@@ -5,6 +5,11 @@
 #elif HAVE_CBLAS
 #include <cblas.h>
 #endif
+#if defined(HAVE_SSE2)
+#include <emmintrin.h>
+#elif defined(HAVE_NEON)
+#include <arm_neon.h>
+#endif
 
 double ccv_trace(ccv_matrix_t* mat)
 {
@@ -76,6 +81,336 @@ double ccv_normalize(ccv_matrix_t* a, ccv_matrix_t** b, int btype, int flag)
 	return db->tb.f64 = sum;
 }
 
+#define CCV_SAT_BAND_SIZE (64)
+
+/* the summed area table is computed as a prefix sum along each row, then added to the row above while
+ * it is still in cache. Row bands are computed independently in parallel, and the second pass adds the
+ * last row of the previous band to every row of the band. Within a row, the prefix sum for single
+ * channel is done in registers with shift-and-add, for multiple channels, the row is walked once per 16
+ * channels, and every 4 channels keep their running sums in one register. */
+static void _ccv_sat_32f_row(const float* a, float* b, int cols, int ch)
+{
+	int j = 0;
+	if (ch == 1)
+	{
+#if defined(HAVE_SSE2)
+		__m128 carry = _mm_setzero_ps();
+		for (; j < cols - 3; j += 4)
+		{
+			__m128 x = _mm_loadu_ps(a + j);
+			x = _mm_add_ps(x, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(x), 4)));
+			x = _mm_add_ps(x, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(x), 8)));
+			x = _mm_add_ps(x, carry);
+			_mm_storeu_ps(b + j, x);
+			carry = _mm_shuffle_ps(x, x, 0xff);
+		}
+#elif defined(HAVE_NEON)
+		float32x4_t zero = vdupq_n_f32(0);
+		float32x4_t carry = zero;
+		for (; j < cols - 3; j += 4)
+		{
+			float32x4_t x = vld1q_f32(a + j);
+			x = vaddq_f32(x, vextq_f32(zero, x, 3));
+			x = vaddq_f32(x, vextq_f32(zero, x, 2));
+			x = vaddq_f32(x, carry);
+			vst1q_f32(b + j, x);
+			carry = vdupq_n_f32(vgetq_lane_f32(x, 3));
+		}
+#endif
+		float sum = j > 0 ? b[j - 1] : 0;
+		for (; j < cols; j++)
+			b[j] = sum = sum + a[j];
+		return;
+	}
+	int c, k;
+	for (c = 0; c < ch; c += 16)
+	{
+		const int cn = ccv_min(16, ch - c);
+		float tail[16] = {0};
+#if defined(HAVE_SSE2)
+		const int groups = cn >> 2;
+		__m128 sum[4] = { _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps() };
+#elif defined(HAVE_NEON)
+		const int groups = cn >> 2;
+		float32x4_t sum[4] = { vdupq_n_f32(0), vdupq_n_f32(0), vdupq_n_f32(0), vdupq_n_f32(0) };
+#else
+		const int groups = 0;
+#endif
+		for (j = 0; j < cols; j++)
+		{
+			const float* ap = a + j * ch + c;
+			float* bp = b + j * ch + c;
+#if defined(HAVE_SSE2)
+			for (k = 0; k < groups; k++)
+			{
+				sum[k] = _mm_add_ps(sum[k], _mm_loadu_ps(ap + k * 4));
+				_mm_storeu_ps(bp + k * 4, sum[k]);
+			}
+#elif defined(HAVE_NEON)
+			for (k = 0; k < groups; k++)
+			{
+				sum[k] = vaddq_f32(sum[k], vld1q_f32(ap + k * 4));
+				vst1q_f32(bp + k * 4, sum[k]);
+			}
+#endif
+			for (k = 0; k < cn - groups * 4; k++)
+				bp[groups * 4 + k] = tail[k] = tail[k] + ap[groups * 4 + k];
+		}
+	}
+}
+
+static void _ccv_sat_64f_row(const double* a, double* b, int cols, int ch)
+{
+	int j = 0;
+	if (ch == 1)
+	{
+#if defined(HAVE_SSE2)
+		__m128d zero = _mm_setzero_pd();
+		__m128d carry = zero;
+		for (; j < cols - 1; j += 2)
+		{
+			__m128d x = _mm_loadu_pd(a + j);
+			x = _mm_add_pd(_mm_add_pd(x, _mm_unpacklo_pd(zero, x)), carry);
+			_mm_storeu_pd(b + j, x);
+			carry = _mm_unpackhi_pd(x, x);
+		}
+#endif
+		double sum = j > 0 ? b[j - 1] : 0;
+		for (; j < cols; j++)
+			b[j] = sum = sum + a[j];
+		return;
+	}
+	int c, k;
+	for (c = 0; c < ch; c += 8)
+	{
+		const int cn = ccv_min(8, ch - c);
+		double tail[8] = {0};
+#if defined(HAVE_SSE2)
+		const int groups = cn >> 1;
+		__m128d sum[4] = { _mm_setzero_pd(), _mm_setzero_pd(), _mm_setzero_pd(), _mm_setzero_pd() };
+#else
+		const int groups = 0;
+#endif
+		for (j = 0; j < cols; j++)
+		{
+			const double* ap = a + j * ch + c;
+			double* bp = b + j * ch + c;
+#if defined(HAVE_SSE2)
+			for (k = 0; k < groups; k++)
+			{
+				sum[k] = _mm_add_pd(sum[k], _mm_loadu_pd(ap + k * 2));
+				_mm_storeu_pd(bp + k * 2, sum[k]);
+			}
+#endif
+			for (k = 0; k < cn - groups * 2; k++)
+				bp[groups * 2 + k] = tail[k] = tail[k] + ap[groups * 2 + k];
+		}
+	}
+}
+
+static void _ccv_sat_8u_row(const unsigned char* a, int* b, int cols, int ch)
+{
+	int j = 0;
+	if (ch == 1)
+	{
+		/* 8 pixels of 8-bit sum up to at most 2040, thus, the in-register prefix sum can be done in 16-bit */
+#if defined(HAVE_SSE2)
+		__m128i zero = _mm_setzero_si128();
+		__m128i carry = zero;
+		for (; j < cols - 15; j += 16)
+		{
+			__m128i x8 = _mm_loadu_si128((const __m128i*)(a + j));
+			__m128i x16[2] = {
+				_mm_unpacklo_epi8(x8, zero),
+				_mm_unpackhi_epi8(x8, zero),
+			};
+			int k;
+			for (k = 0; k < 2; k++)
+			{
+				__m128i x = x16[k];
+				x = _mm_add_epi16(x, _mm_slli_si128(x, 2));
+				x = _mm_add_epi16(x, _mm_slli_si128(x, 4));
+				x = _mm_add_epi16(x, _mm_slli_si128(x, 8));
+				__m128i lo = _mm_add_epi32(_mm_unpacklo_epi16(x, zero), carry);
+				__m128i hi = _mm_add_epi32(_mm_unpackhi_epi16(x, zero), carry);
+				_mm_storeu_si128((__m128i*)(b + j + k * 8), lo);
+				_mm_storeu_si128((__m128i*)(b + j + k * 8 + 4), hi);
+				carry = _mm_shuffle_epi32(hi, 0xff);
+			}
+		}
+#elif defined(HAVE_NEON)
+		uint16x8_t zero = vdupq_n_u16(0);
+		uint32x4_t carry = vdupq_n_u32(0);
+		for (; j < cols - 7; j += 8)
+		{
+			uint16x8_t x = vmovl_u8(vld1_u8(a + j));
+			x = vaddq_u16(x, vextq_u16(zero, x, 7));
+			x = vaddq_u16(x, vextq_u16(zero, x, 6));
+			x = vaddq_u16(x, vextq_u16(zero, x, 4));
+			uint32x4_t lo = vaddq_u32(vmovl_u16(vget_low_u16(x)), carry);
+			uint32x4_t hi = vaddq_u32(vmovl_u16(vget_high_u16(x)), carry);
+			vst1q_s32(b + j, vreinterpretq_s32_u32(lo));
+			vst1q_s32(b + j + 4, vreinterpretq_s32_u32(hi));
+			carry = vdupq_n_u32(vgetq_lane_u32(hi, 3));
+		}
+#endif
+		int sum = j > 0 ? b[j - 1] : 0;
+		for (; j < cols; j++)
+			b[j] = sum = sum + a[j];
+		return;
+	}
+	int c, k;
+	for (c = 0; c < ch; c += 16)
+	{
+		const int cn = ccv_min(16, ch - c);
+		int tail[16] = {0};
+#if defined(HAVE_SSE2)
+		const int groups = cn >> 2;
+		__m128i zero = _mm_setzero_si128();
+		__m128i sum[4] = { zero, zero, zero, zero };
+#elif defined(HAVE_NEON)
+		const int groups = cn >> 2;
+		uint32x4_t sum[4] = { vdupq_n_u32(0), vdupq_n_u32(0), vdupq_n_u32(0), vdupq_n_u32(0) };
+#else
+		const int groups = 0;
+#endif
+		for (j = 0; j < cols; j++)
+		{
+			const unsigned char* ap = a + j * ch + c;
+			int* bp = b + j * ch + c;
+#if defined(HAVE_SSE2)
+			for (k = 0; k < groups; k++)
+			{
+				int x;
+				memcpy(&x, ap + k * 4, sizeof(x));
+				sum[k] = _mm_add_epi32(sum[k], _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(x), zero), zero));
+				_mm_storeu_si128((__m128i*)(bp + k * 4), sum[k]);
+			}
+#elif defined(HAVE_NEON)
+			for (k = 0; k < groups; k++)
+			{
+				uint32_t x;
+				memcpy(&x, ap + k * 4, sizeof(x));
+				sum[k] = vaddq_u32(sum[k], vmovl_u16(vget_low_u16(vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(x))))));
+				vst1q_s32(bp + k * 4, vreinterpretq_s32_u32(sum[k]));
+			}
+#endif
+			for (k = 0; k < cn - groups * 4; k++)
+				bp[groups * 4 + k] = tail[k] = tail[k] + ap[groups * 4 + k];
+		}
+	}
+}
+
+static void _ccv_sat_add_row(const unsigned char* p_ptr, unsigned char* b_ptr, int n, int type)
+{
+	int j = 0;
+	switch (CCV_GET_DATA_TYPE(type))
+	{
+		case CCV_32F:
+		{
+			const float* p = (const float*)p_ptr;
+			float* b = (float*)b_ptr;
+#if defined(HAVE_SSE2)
+			for (; j < n - 3; j += 4)
+				_mm_storeu_ps(b + j, _mm_add_ps(_mm_loadu_ps(b + j), _mm_loadu_ps(p + j)));
+#elif defined(HAVE_NEON)
+			for (; j < n - 3; j += 4)
+				vst1q_f32(b + j, vaddq_f32(vld1q_f32(b + j), vld1q_f32(p + j)));
+#endif
+			for (; j < n; j++)
+				b[j] += p[j];
+			break;
+		}
+		case CCV_64F:
+		{
+			const double* p = (const double*)p_ptr;
+			double* b = (double*)b_ptr;
+#if defined(HAVE_SSE2)
+			for (; j < n - 1; j += 2)
+				_mm_storeu_pd(b + j, _mm_add_pd(_mm_loadu_pd(b + j), _mm_loadu_pd(p + j)));
+#endif
+			for (; j < n; j++)
+				b[j] += p[j];
+			break;
+		}
+		case CCV_32S:
+		{
+			const int* p = (const int*)p_ptr;
+			int* b = (int*)b_ptr;
+#if defined(HAVE_SSE2)
+			for (; j < n - 3; j += 4)
+				_mm_storeu_si128((__m128i*)(b + j), _mm_add_epi32(_mm_loadu_si128((const __m128i*)(b + j)), _mm_loadu_si128((const __m128i*)(p + j))));
+#elif defined(HAVE_NEON)
+			for (; j < n - 3; j += 4)
+				vst1q_s32(b + j, vaddq_s32(vld1q_s32(b + j), vld1q_s32(p + j)));
+#endif
+			for (; j < n; j++)
+				b[j] += p[j];
+			break;
+		}
+	}
+}
+
+static int _ccv_sat(ccv_dense_matrix_t* a, ccv_dense_matrix_t* db, int padding_pattern)
+{
+	if (!((a->type & CCV_32F) && (db->type & CCV_32F)) &&
+		!((a->type & CCV_64F) && (db->type & CCV_64F)) &&
+		!((a->type & CCV_8U) && (db->type & CCV_32S)))
+		return 0;
+	int ch = CCV_GET_CHANNEL(a->type);
+	size_t bsize = CCV_GET_DATA_TYPE_SIZE(db->type);
+	unsigned char* b_ptr = db->data.u8;
+	if (padding_pattern == CCV_PADDING_ZERO)
+	{
+		memset(b_ptr, 0, db->step);
+		b_ptr += db->step + ch * bsize;
+	}
+	const int n = a->cols * ch;
+	const int band_count = FOR_IS_PARALLEL ? (a->rows + CCV_SAT_BAND_SIZE - 1) / CCV_SAT_BAND_SIZE : 1;
+	parallel_for(i, band_count) {
+		int y;
+		int y0 = band_count > 1 ? i * CCV_SAT_BAND_SIZE : 0;
+		int y1 = band_count > 1 ? ccv_min(y0 + CCV_SAT_BAND_SIZE, a->rows) : a->rows;
+		for (y = y0; y < y1; y++)
+		{
+			unsigned char* a_row = a->data.u8 + y * a->step;
+			unsigned char* b_row = b_ptr + y * db->step;
+			if (padding_pattern == CCV_PADDING_ZERO)
+				memset(b_row - ch * bsize, 0, ch * bsize);
+			switch (CCV_GET_DATA_TYPE(a->type))
+			{
+				case CCV_32F:
+					_ccv_sat_32f_row((const float*)a_row, (float*)b_row, a->cols, ch);
+					break;
+				case CCV_64F:
+					_ccv_sat_64f_row((const double*)a_row, (double*)b_row, a->cols, ch);
+					break;
+				case CCV_8U:
+					_ccv_sat_8u_row(a_row, (int*)b_row, a->cols, ch);
+					break;
+			}
+			if (y > y0)
+				_ccv_sat_add_row(b_row - db->step, b_row, n, db->type);
+		}
+	} parallel_endfor
+	if (band_count > 1)
+	{
+		int i;
+		// carry the last row of each band over, it is sequential but only touches one row per band
+		for (i = 1; i < band_count; i++)
+			_ccv_sat_add_row(b_ptr + ((i * CCV_SAT_BAND_SIZE) - 1) * db->step, b_ptr + (ccv_min((i + 1) * CCV_SAT_BAND_SIZE, a->rows) - 1) * db->step, n, db->type);
+		parallel_for(i, band_count - 1) {
+			int y;
+			int y0 = (i + 1) * CCV_SAT_BAND_SIZE;
+			int y1 = ccv_min(y0 + CCV_SAT_BAND_SIZE, a->rows) - 1;
+			unsigned char* p_row = b_ptr + (y0 - 1) * db->step;
+			for (y = y0; y < y1; y++)
+				_ccv_sat_add_row(p_row, b_ptr + y * db->step, n, db->type);
+		} parallel_endfor
+	}
+	return 1;
+}
+
 void ccv_sat(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type, int padding_pattern)
 {
 	ccv_declare_derived_signature(sig, a->sig != 0, ccv_sign_with_format(20, "ccv_sat(%d)", padding_pattern), a->sig, CCV_EOF_SIGN);
@@ -91,6 +426,8 @@ void ccv_sat(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type, int paddin
 		case CCV_NO_PADDING:
 			db = *b = ccv_dense_matrix_renew(*b, a->rows, a->cols, CCV_ALL_DATA_TYPE | CCV_GET_CHANNEL(a->type), type, sig);
 			ccv_object_return_if_cached(, db);
+			if (_ccv_sat(a, db, padding_pattern))
+				break;
 			b_ptr = db->data.u8;
 #define for_block(_for_set_b, _for_get_b, _for_get) \
 			for (j = 0; j < ch; j++) \
@@ -114,6 +451,8 @@ void ccv_sat(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type, int paddin
 		case CCV_PADDING_ZERO:
 			db = *b = ccv_dense_matrix_renew(*b, a->rows + 1, a->cols + 1, CCV_ALL_DATA_TYPE | CCV_GET_CHANNEL(a->type), type, sig);
 			ccv_object_return_if_cached(, db);
+			if (_ccv_sat(a, db, padding_pattern))
+				break;
 			b_ptr = db->data.u8;
 #define for_block(_for_set_b, _for_get_b, _for_get) \
 			for (j = 0; j < db->cols * ch; j++) \
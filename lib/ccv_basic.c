@@ -1,11 +1,115 @@
 #include "ccv.h"
 #include "ccv_internal.h"
 #if defined(HAVE_SSE2)
-#include <xmmintrin.h>
+#include <emmintrin.h>
 #elif defined(HAVE_NEON)
 #include <arm_neon.h>
 #endif
 
+/* the number of rows a band has when the gradient runs in parallel */
+#define CCV_GRADIENT_BAND_SIZE (32)
+
+/* 3x3 sobel of an 8-bit matrix into 32-bit integers: it does the vertical pass into a 16-bit row, and then the
+ * horizontal pass from it, one row at a time. Every intermediate fits in 16-bit (at most 4 * 255 in magnitude) */
+static void _ccv_sobel_3x3_8u_32s(ccv_dense_matrix_t* a, ccv_dense_matrix_t* db, int dx)
+{
+	const int ch = CCV_GET_CHANNEL(a->type);
+	const int n = a->cols * ch;
+	const int band_count = FOR_IS_PARALLEL ? (a->rows + CCV_GRADIENT_BAND_SIZE - 1) / CCV_GRADIENT_BAND_SIZE : 1;
+	const int band_size = (a->rows + band_count - 1) / band_count;
+	parallel_for(t, band_count) {
+		int i, j;
+		short* const v = (short*)ccmalloc(sizeof(short) * n);
+		const int end = ccv_min((int)(t + 1) * band_size, a->rows);
+		for (i = t * band_size; i < end; i++)
+		{
+			const unsigned char* const c = a->data.u8 + i * a->step;
+			const unsigned char* const p = i > 0 ? c - a->step : c;
+			const unsigned char* const q = i < a->rows - 1 ? c + a->step : c;
+			int* const b = (int*)(db->data.u8 + i * db->step);
+			// at the first (last) row, the missing neighbor is the row itself, which is the same as 3 * c + q (p + 3 * c) for smoothing, and q - c (c - p) for difference
+			j = 0;
+			if (dx)
+			{
+#if defined(HAVE_SSE2)
+				const __m128i zero = _mm_setzero_si128();
+				for (; j < n - 7; j += 8)
+				{
+					const __m128i c8 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(c + j)), zero);
+					const __m128i p8 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(p + j)), zero);
+					const __m128i q8 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(q + j)), zero);
+					_mm_storeu_si128((__m128i*)(v + j), _mm_add_epi16(_mm_add_epi16(p8, q8), _mm_add_epi16(c8, c8)));
+				}
+#elif defined(HAVE_NEON)
+				for (; j < n - 7; j += 8)
+				{
+					const uint16x8_t c8 = vmovl_u8(vld1_u8(c + j));
+					vst1q_s16(v + j, vreinterpretq_s16_u16(vaddq_u16(vaddl_u8(vld1_u8(p + j), vld1_u8(q + j)), vaddq_u16(c8, c8))));
+				}
+#endif
+				for (; j < n; j++)
+					v[j] = p[j] + 2 * c[j] + q[j];
+			} else {
+#if defined(HAVE_SSE2)
+				const __m128i zero = _mm_setzero_si128();
+				for (; j < n - 7; j += 8)
+				{
+					const __m128i p8 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(p + j)), zero);
+					const __m128i q8 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(q + j)), zero);
+					_mm_storeu_si128((__m128i*)(v + j), _mm_sub_epi16(q8, p8));
+				}
+#elif defined(HAVE_NEON)
+				for (; j < n - 7; j += 8)
+					vst1q_s16(v + j, vreinterpretq_s16_u16(vsubl_u8(vld1_u8(q + j), vld1_u8(p + j))));
+#endif
+				for (; j < n; j++)
+					v[j] = q[j] - p[j];
+			}
+			// the horizontal pass, the first (last) column is the same as the vertical pass at the first (last) row
+			for (j = 0; j < ch; j++)
+				b[j] = dx ? v[ch + j] - v[j] : v[ch + j] + 3 * v[j];
+			j = ch;
+#if defined(HAVE_SSE2)
+			for (; j < n - ch - 7; j += 8)
+			{
+				const __m128i v0 = _mm_loadu_si128((const __m128i*)(v + j - ch));
+				const __m128i v2 = _mm_loadu_si128((const __m128i*)(v + j + ch));
+				__m128i h;
+				if (dx)
+					h = _mm_sub_epi16(v2, v0);
+				else {
+					const __m128i v1 = _mm_loadu_si128((const __m128i*)(v + j));
+					h = _mm_add_epi16(_mm_add_epi16(v0, v2), _mm_add_epi16(v1, v1));
+				}
+				// sign extend to 32-bit
+				_mm_storeu_si128((__m128i*)(b + j), _mm_srai_epi32(_mm_unpacklo_epi16(h, h), 16));
+				_mm_storeu_si128((__m128i*)(b + j + 4), _mm_srai_epi32(_mm_unpackhi_epi16(h, h), 16));
+			}
+#elif defined(HAVE_NEON)
+			for (; j < n - ch - 7; j += 8)
+			{
+				const int16x8_t v0 = vld1q_s16(v + j - ch);
+				const int16x8_t v2 = vld1q_s16(v + j + ch);
+				int16x8_t h;
+				if (dx)
+					h = vsubq_s16(v2, v0);
+				else {
+					const int16x8_t v1 = vld1q_s16(v + j);
+					h = vaddq_s16(vaddq_s16(v0, v2), vaddq_s16(v1, v1));
+				}
+				vst1q_s32(b + j, vmovl_s16(vget_low_s16(h)));
+				vst1q_s32(b + j + 4, vmovl_s16(vget_high_s16(h)));
+			}
+#endif
+			for (; j < n - ch; j++)
+				b[j] = dx ? v[j + ch] - v[j - ch] : v[j - ch] + 2 * v[j] + v[j + ch];
+			for (j = n - ch; j < n; j++)
+				b[j] = dx ? v[j] - v[j - ch] : v[j - ch] + 3 * v[j];
+		}
+		ccfree(v);
+	} parallel_endfor
+}
+
 /* sobel filter is fundamental to many other high-level algorithms,
  * here includes 2 special case impl (for 1x3/3x1, 3x3) and one general impl */
 void ccv_sobel(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type, int dx, int dy)
@@ -121,6 +225,11 @@ void ccv_sobel(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type, int dx,
 	} else if (dx == 3 && dy == 0) {
 		assert(a->rows >= 3 && a->cols >= 3);
 		/* special case 3: 3x3 window, corresponding sigma = 0.85 */
+		if (CCV_GET_DATA_TYPE(a->type) == CCV_8U && CCV_GET_DATA_TYPE(db->type) == CCV_32S)
+		{
+			_ccv_sobel_3x3_8u_32s(a, db, 1);
+			return;
+		}
 		unsigned char* buf = (unsigned char*)alloca(db->step);
 #define for_block(_for_get, _for_set_b, _for_get_b) \
 		for (j = 0; j < a->cols; j++) \
@@ -157,6 +266,11 @@ void ccv_sobel(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type, int dx,
 	} else if (dx == 0 && dy == 3) {
 		assert(a->rows >= 3 && a->cols >= 3);
 		/* special case 3: 3x3 window, corresponding sigma = 0.85 */
+		if (CCV_GET_DATA_TYPE(a->type) == CCV_8U && CCV_GET_DATA_TYPE(db->type) == CCV_32S)
+		{
+			_ccv_sobel_3x3_8u_32s(a, db, 0);
+			return;
+		}
 		unsigned char* buf = (unsigned char*)alloca(db->step);
 #define for_block(_for_get, _for_set_b, _for_get_b) \
 		for (j = 0; j < a->cols; j++) \
@@ -317,6 +431,34 @@ static void _ccv_atan2(float* x, float* y, float* angle, float* mag, int len)
 		_mm_storeu_ps(mag + i, m4);
 	}
 #endif
+#elif defined(HAVE_NEON)
+	const float32x4_t eps = vdupq_n_f32((float)1e-6);
+	const float32x4_t _90 = vdupq_n_f32((float)(3.141592654 * 0.5)), _180 = vdupq_n_f32((float)3.141592654), _360 = vdupq_n_f32((float)(3.141592654 * 2));
+	const float32x4_t zero = vdupq_n_f32(0), _0_28 = vdupq_n_f32(0.28f), scale4 = vdupq_n_f32(scale);
+	for(; i <= len - 4; i += 4)
+	{
+		float32x4_t x4 = vld1q_f32(x + i), y4 = vld1q_f32(y + i);
+		float32x4_t xq4 = vmulq_f32(x4, x4), yq4 = vmulq_f32(y4, y4);
+		uint32x4_t xly = vcltq_f32(xq4, yq4);
+		float32x4_t d4 = vaddq_f32(vaddq_f32(vmaxq_f32(xq4, yq4), vmulq_f32(vminq_f32(xq4, yq4), _0_28)), eps);
+		// no division on NEON, reciprocal estimate refined with two Newton-Raphson steps
+		float32x4_t r4 = vrecpeq_f32(d4);
+		r4 = vmulq_f32(vrecpsq_f32(d4, r4), r4);
+		r4 = vmulq_f32(vrecpsq_f32(d4, r4), r4);
+		float32x4_t z4 = vmulq_f32(vmulq_f32(x4, y4), r4);
+		float32x4_t a4 = vbslq_f32(xly, _90, zero);
+		a4 = vbslq_f32(vcltq_f32(y4, zero), vsubq_f32(_360, a4), a4);
+		a4 = vbslq_f32(vbicq_u32(vcltq_f32(x4, zero), xly), _180, a4);
+		a4 = vmulq_f32(vbslq_f32(xly, vsubq_f32(a4, z4), vaddq_f32(a4, z4)), scale4);
+		// the same goes for square root, and take care of 0 * inf
+		float32x4_t s4 = vaddq_f32(xq4, yq4);
+		float32x4_t rs4 = vrsqrteq_f32(s4);
+		rs4 = vmulq_f32(vrsqrtsq_f32(vmulq_f32(s4, rs4), rs4), rs4);
+		rs4 = vmulq_f32(vrsqrtsq_f32(vmulq_f32(s4, rs4), rs4), rs4);
+		float32x4_t m4 = vbslq_f32(vceqq_f32(s4, zero), zero, vmulq_f32(s4, rs4));
+		vst1q_f32(angle + i, a4);
+		vst1q_f32(mag + i, m4);
+	}
 #endif
 	for(; i < len; i++)
 	{
@@ -331,6 +473,132 @@ static void _ccv_atan2(float* x, float* y, float* angle, float* mag, int len)
 	}
 }
 
+/* the 1x3 and 3x1 sobel of row i into x and y (as float), with the same borders as ccv_sobel does for dx = 1, dy = 1 */
+static void _ccv_gradient_row(ccv_dense_matrix_t* a, int i, float* x, float* y)
+{
+	const int ch = CCV_GET_CHANNEL(a->type);
+	const int n = a->cols * ch;
+	const unsigned char* const c = a->data.u8 + i * a->step;
+	// at the first (last) row, the difference is taken against the row itself, and doubled
+	const unsigned char* const p = i > 0 ? c - a->step : c;
+	const unsigned char* const q = i < a->rows - 1 ? c + a->step : c;
+	const float ys = (i > 0 && i < a->rows - 1) ? 1 : 2;
+	int j, k;
+	switch (CCV_GET_DATA_TYPE(a->type))
+	{
+		case CCV_8U:
+			j = ch;
+#if defined(HAVE_SSE2)
+			{
+				const __m128i zero = _mm_setzero_si128();
+				for (; j < n - ch - 7; j += 8)
+				{
+					const __m128i l8 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(c + j - ch)), zero);
+					const __m128i r8 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(c + j + ch)), zero);
+					const __m128i d8 = _mm_sub_epi16(r8, l8);
+					_mm_storeu_ps(x + j, _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(d8, d8), 16)));
+					_mm_storeu_ps(x + j + 4, _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(d8, d8), 16)));
+				}
+			}
+#elif defined(HAVE_NEON)
+			for (; j < n - ch - 7; j += 8)
+			{
+				const int16x8_t d8 = vreinterpretq_s16_u16(vsubl_u8(vld1_u8(c + j + ch), vld1_u8(c + j - ch)));
+				vst1q_f32(x + j, vcvtq_f32_s32(vmovl_s16(vget_low_s16(d8))));
+				vst1q_f32(x + j + 4, vcvtq_f32_s32(vmovl_s16(vget_high_s16(d8))));
+			}
+#endif
+			for (; j < n - ch; j++)
+				x[j] = (int)c[j + ch] - (int)c[j - ch];
+			for (k = 0; k < ch; k++)
+			{
+				x[k] = 2 * ((int)c[ch + k] - (int)c[k]);
+				x[n - ch + k] = 2 * ((int)c[n - ch + k] - (int)c[n - 2 * ch + k]);
+			}
+			j = 0;
+#if defined(HAVE_SSE2)
+			{
+				const __m128i zero = _mm_setzero_si128();
+				const __m128 ys4 = _mm_set1_ps(ys);
+				for (; j < n - 7; j += 8)
+				{
+					const __m128i p8 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(p + j)), zero);
+					const __m128i q8 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(q + j)), zero);
+					const __m128i d8 = _mm_sub_epi16(q8, p8);
+					_mm_storeu_ps(y + j, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(d8, d8), 16)), ys4));
+					_mm_storeu_ps(y + j + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(d8, d8), 16)), ys4));
+				}
+			}
+#elif defined(HAVE_NEON)
+			{
+				const float32x4_t ys4 = vdupq_n_f32(ys);
+				for (; j < n - 7; j += 8)
+				{
+					const int16x8_t d8 = vreinterpretq_s16_u16(vsubl_u8(vld1_u8(q + j), vld1_u8(p + j)));
+					vst1q_f32(y + j, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(d8))), ys4));
+					vst1q_f32(y + j + 4, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(d8))), ys4));
+				}
+			}
+#endif
+			for (; j < n; j++)
+				y[j] = ((int)q[j] - (int)p[j]) * ys;
+			break;
+		case CCV_32F:
+		{
+			const float* const cf = (const float*)c;
+			const float* const pf = (const float*)p;
+			const float* const qf = (const float*)q;
+			j = ch;
+#if defined(HAVE_SSE2)
+			for (; j < n - ch - 3; j += 4)
+				_mm_storeu_ps(x + j, _mm_sub_ps(_mm_loadu_ps(cf + j + ch), _mm_loadu_ps(cf + j - ch)));
+#elif defined(HAVE_NEON)
+			for (; j < n - ch - 3; j += 4)
+				vst1q_f32(x + j, vsubq_f32(vld1q_f32(cf + j + ch), vld1q_f32(cf + j - ch)));
+#endif
+			for (; j < n - ch; j++)
+				x[j] = cf[j + ch] - cf[j - ch];
+			for (k = 0; k < ch; k++)
+			{
+				x[k] = 2 * (cf[ch + k] - cf[k]);
+				x[n - ch + k] = 2 * (cf[n - ch + k] - cf[n - 2 * ch + k]);
+			}
+			j = 0;
+#if defined(HAVE_SSE2)
+			{
+				const __m128 ys4 = _mm_set1_ps(ys);
+				for (; j < n - 3; j += 4)
+					_mm_storeu_ps(y + j, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(qf + j), _mm_loadu_ps(pf + j)), ys4));
+			}
+#elif defined(HAVE_NEON)
+			{
+				const float32x4_t ys4 = vdupq_n_f32(ys);
+				for (; j < n - 3; j += 4)
+					vst1q_f32(y + j, vmulq_f32(vsubq_f32(vld1q_f32(qf + j), vld1q_f32(pf + j)), ys4));
+			}
+#endif
+			for (; j < n; j++)
+				y[j] = (qf[j] - pf[j]) * ys;
+			break;
+		}
+		default:
+		{
+#define for_block(_, _for_get) \
+			for (j = ch; j < n - ch; j++) \
+				x[j] = _for_get(c, j + ch, 0) - _for_get(c, j - ch, 0); \
+			for (k = 0; k < ch; k++) \
+			{ \
+				x[k] = 2 * (_for_get(c, ch + k, 0) - _for_get(c, k, 0)); \
+				x[n - ch + k] = 2 * (_for_get(c, n - ch + k, 0) - _for_get(c, n - 2 * ch + k, 0)); \
+			} \
+			for (j = 0; j < n; j++) \
+				y[j] = (_for_get(q, j, 0) - _for_get(p, j, 0)) * ys;
+			ccv_matrix_getter(a->type, for_block);
+#undef for_block
+		}
+	}
+}
+
 void ccv_gradient(ccv_dense_matrix_t* a, ccv_dense_matrix_t** theta, int ttype, ccv_dense_matrix_t** m, int mtype, int dx, int dy)
 {
 	ccv_declare_derived_signature(tsig, a->sig != 0, ccv_sign_with_format(64, "ccv_gradient(theta,%d,%d)", dx, dy), a->sig, CCV_EOF_SIGN);
@@ -341,6 +609,27 @@ void ccv_gradient(ccv_dense_matrix_t* a, ccv_dense_matrix_t** theta, int ttype,
 	assert(dtheta && dm);
 	ccv_object_return_if_cached(, dtheta, dm);
 	ccv_revive_object_if_cached(dtheta, dm);
+	if (dx == 1 && dy == 1)
+	{
+		assert(a->rows >= 3 && a->cols >= 3);
+		/* fused 1x3 / 3x1 sobel and arctan, one row at a time, without the intermediate matrices */
+		const int n = a->cols * ch;
+		const int band_count = FOR_IS_PARALLEL ? (a->rows + CCV_GRADIENT_BAND_SIZE - 1) / CCV_GRADIENT_BAND_SIZE : 1;
+		const int band_size = (a->rows + band_count - 1) / band_count;
+		parallel_for(t, band_count) {
+			int i;
+			float* const x = (float*)ccmalloc(sizeof(float) * n * 2);
+			float* const y = x + n;
+			const int end = ccv_min((int)(t + 1) * band_size, a->rows);
+			for (i = t * band_size; i < end; i++)
+			{
+				_ccv_gradient_row(a, i, x, y);
+				_ccv_atan2(x, y, (float*)(dtheta->data.u8 + i * dtheta->step), (float*)(dm->data.u8 + i * dm->step), n);
+			}
+			ccfree(x);
+		} parallel_endfor
+		return;
+	}
 	ccv_dense_matrix_t* tx = 0;
 	ccv_dense_matrix_t* ty = 0;
 	ccv_sobel(a, &tx, CCV_32F | ch, dx, 0);
@@ -350,6 +639,63 @@ void ccv_gradient(ccv_dense_matrix_t* a, ccv_dense_matrix_t** theta, int ttype,
 	ccv_matrix_free(ty);
 }
 
+void ccv_gradient_bin(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int nbin)
+{
+	assert(a->rows >= 3 && a->cols >= 3 && nbin > 0);
+	ccv_declare_derived_signature(sig, a->sig != 0, ccv_sign_with_format(64, "ccv_gradient_bin(%d)", nbin), a->sig, CCV_EOF_SIGN);
+	ccv_dense_matrix_t* db = *b = ccv_dense_matrix_renew(*b, a->rows, a->cols, CCV_32F | CCV_C2, CCV_32F | CCV_C2, sig);
+	ccv_object_return_if_cached(, db);
+	const int ch = CCV_GET_CHANNEL(a->type);
+	const int n = a->cols * ch;
+	const int band_count = FOR_IS_PARALLEL ? (a->rows + CCV_GRADIENT_BAND_SIZE - 1) / CCV_GRADIENT_BAND_SIZE : 1;
+	const int band_size = (a->rows + band_count - 1) / band_count;
+	parallel_for(t, band_count) {
+		int i, j, k;
+		float* const x = (float*)ccmalloc(sizeof(float) * (n * 2 + a->cols * 4));
+		float* const y = x + n;
+		float* const angle = y + n;
+		float* const mag = angle + a->cols;
+		// only used for multi-channel, keeps the gradient of the channel with the largest magnitude
+		float* const gx = mag + a->cols;
+		float* const gy = gx + a->cols;
+		const int end = ccv_min((int)(t + 1) * band_size, a->rows);
+		for (i = t * band_size; i < end; i++)
+		{
+			_ccv_gradient_row(a, i, x, y);
+			if (ch > 1)
+			{
+				for (j = 0; j < a->cols; j++)
+				{
+					float bx = x[j * ch], by = y[j * ch];
+					float bm = bx * bx + by * by;
+					for (k = 1; k < ch; k++)
+					{
+						const float kx = x[j * ch + k], ky = y[j * ch + k];
+						const float km = kx * kx + ky * ky;
+						// written as selects rather than a branch, the comparison is hard to predict
+						const int larger = km > bm;
+						bx = larger ? kx : bx;
+						by = larger ? ky : by;
+						bm = larger ? km : bm;
+					}
+					gx[j] = bx;
+					gy[j] = by;
+				}
+				_ccv_atan2(gx, gy, angle, mag, a->cols);
+			} else
+				_ccv_atan2(x, y, angle, mag, a->cols);
+			float* const bp = (float*)(db->data.u8 + i * db->step);
+			for (j = 0; j < a->cols; j++)
+			{
+				// in double precision, thus, an angle right on a bin boundary (180 degree, for example) lands on it exactly
+				bp[j * 2] = (ccv_clamp(angle[j], 0, 359.99) / 360.0) * nbin;
+				bp[j * 2 + 1] = mag[j];
+			}
+		}
+		ccfree(x);
+	} parallel_endfor
+}
+
 static void _ccv_flip_y_self(ccv_dense_matrix_t* a)
 {
 	int i;
@@ -415,12 +761,338 @@ void ccv_flip(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int btype, int type
 		_ccv_flip_x_self(db);
 }
 
+/* blur with a larger sigma than this runs the recursive filter, its cost doesn't grow with sigma */
+#define CCV_BLUR_IIR_SIGMA (6.0)
+/* the width of the column strips the vertical pass of the separable filter works on */
+#define CCV_BLUR_TILE_SIZE (128)
+
+/* dst[i] = sum(src[i + k * tap] * filter[k]) >> 8, wpair has the filter 2 taps a time for _mm_madd_epi16, thus src is read 1 tap beyond fsz */
+static void _ccv_blur_8u_fir(const short* src, int tap, int n, const int* filter, const int* wpair, int fsz, unsigned char* dst)
+{
+	int i = 0, k;
+#if defined(HAVE_SSE2)
+	for (; i <= n - 8; i += 8)
+	{
+		__m128i sum0 = _mm_setzero_si128();
+		__m128i sum1 = _mm_setzero_si128();
+		const short* s = src + i;
+		for (k = 0; k < fsz; k += 2, s += tap * 2)
+		{
+			__m128i x0 = _mm_loadu_si128((const __m128i*)s);
+			__m128i x1 = _mm_loadu_si128((const __m128i*)(s + tap));
+			__m128i w = _mm_set1_epi32(wpair[k >> 1]);
+			sum0 = _mm_add_epi32(sum0, _mm_madd_epi16(_mm_unpacklo_epi16(x0, x1), w));
+			sum1 = _mm_add_epi32(sum1, _mm_madd_epi16(_mm_unpackhi_epi16(x0, x1), w));
+		}
+		_mm_storel_epi64((__m128i*)(dst + i), _mm_packus_epi16(_mm_packs_epi32(_mm_srai_epi32(sum0, 8), _mm_srai_epi32(sum1, 8)), _mm_setzero_si128()));
+	}
+#elif defined(HAVE_NEON)
+	for (; i <= n - 8; i += 8)
+	{
+		int32x4_t sum0 = vdupq_n_s32(0);
+		int32x4_t sum1 = vdupq_n_s32(0);
+		const short* s = src + i;
+		for (k = 0; k < fsz; k++, s += tap)
+		{
+			int16x8_t x = vld1q_s16(s);
+			sum0 = vmlal_n_s16(sum0, vget_low_s16(x), filter[k]);
+			sum1 = vmlal_n_s16(sum1, vget_high_s16(x), filter[k]);
+		}
+		vst1_u8(dst + i, vqmovun_s16(vcombine_s16(vqshrn_n_s32(sum0, 8), vqshrn_n_s32(sum1, 8))));
+	}
+#endif
+	for (; i < n; i++)
+	{
+		int sum = 0;
+		const short* s = src + i;
+		for (k = 0; k < fsz; k++, s += tap)
+			sum += s[0] * filter[k];
+		dst[i] = ccv_clamp(sum >> 8, 0, 255);
+	}
+}
+
+static void _ccv_blur_32f_fir(const float* src, int tap, int n, const float* filter, int fsz, float* dst)
+{
+	int i = 0, k;
+#if defined(HAVE_SSE2)
+	for (; i <= n - 8; i += 8)
+	{
+		__m128 sum0 = _mm_setzero_ps();
+		__m128 sum1 = _mm_setzero_ps();
+		const float* s = src + i;
+		for (k = 0; k < fsz; k++, s += tap)
+		{
+			__m128 w = _mm_set1_ps(filter[k]);
+			sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(s), w));
+			sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(s + 4), w));
+		}
+		_mm_storeu_ps(dst + i, sum0);
+		_mm_storeu_ps(dst + i + 4, sum1);
+	}
+#elif defined(HAVE_NEON)
+	for (; i <= n - 8; i += 8)
+	{
+		float32x4_t sum0 = vdupq_n_f32(0);
+		float32x4_t sum1 = vdupq_n_f32(0);
+		const float* s = src + i;
+		for (k = 0; k < fsz; k++, s += tap)
+		{
+			sum0 = vmlaq_n_f32(sum0, vld1q_f32(s), filter[k]);
+			sum1 = vmlaq_n_f32(sum1, vld1q_f32(s + 4), filter[k]);
+		}
+		vst1q_f32(dst + i, sum0);
+		vst1q_f32(dst + i + 4, sum1);
+	}
+#endif
+	for (; i < n; i++)
+	{
+		float sum = 0;
+		const float* s = src + i;
+		for (k = 0; k < fsz; k++, s += tap)
+			sum += s[0] * filter[k];
+		dst[i] = sum;
+	}
+}
+
+/* the separable filter for 8u to 8u, the horizontal pass goes row by row, and the vertical pass goes strip by strip,
+ * each strip is a copy of CCV_BLUR_TILE_SIZE columns padded with border rows, thus the fsz rows a output row needs stay in cache */
+static void _ccv_blur_8u(ccv_dense_matrix_t* a, ccv_dense_matrix_t* db, const int* filter, int fsz)
+{
+	int i, j, k, x, ch = CCV_GET_CHANNEL(a->type);
+	int hfz = fsz / 2, n = a->cols * ch;
+	int* wpair = (int*)alloca(sizeof(int) * ((fsz + 1) / 2));
+	for (k = 0; k < fsz; k += 2)
+		wpair[k >> 1] = (filter[k] & 0xffff) | ((k + 1 < fsz ? filter[k + 1] : 0) << 16);
+	short* buf = (short*)alloca(sizeof(short) * (a->cols + fsz) * ch);
+	unsigned char* a_ptr = a->data.u8;
+	unsigned char* b_ptr = db->data.u8;
+	for (i = 0; i < a->rows; i++)
+	{
+		for (j = 0; j < hfz; j++)
+			for (k = 0; k < ch; k++)
+				buf[j * ch + k] = a_ptr[k];
+		for (j = 0; j < n; j++)
+			buf[j + hfz * ch] = a_ptr[j];
+		for (j = a->cols; j < hfz + a->cols; j++)
+			for (k = 0; k < ch; k++)
+				buf[j * ch + hfz * ch + k] = a_ptr[(a->cols - 1) * ch + k];
+		for (k = 0; k < ch; k++)
+			buf[(a->cols + fsz - 1) * ch + k] = 0;
+		_ccv_blur_8u_fir(buf, ch, n, filter, wpair, fsz, b_ptr);
+		a_ptr += a->step;
+		b_ptr += db->step;
+	}
+	short* strip = (short*)ccmalloc(sizeof(short) * (a->rows + fsz) * CCV_BLUR_TILE_SIZE);
+	for (x = 0; x < n; x += CCV_BLUR_TILE_SIZE)
+	{
+		int w = ccv_min(CCV_BLUR_TILE_SIZE, n - x);
+		for (i = 0; i < a->rows + fsz; i++)
+		{
+			b_ptr = db->data.u8 + db->step * ccv_clamp(i - hfz, 0, a->rows - 1) + x;
+			for (j = 0; j < w; j++)
+				strip[i * CCV_BLUR_TILE_SIZE + j] = b_ptr[j];
+		}
+		b_ptr = db->data.u8 + x;
+		for (i = 0; i < a->rows; i++)
+		{
+			_ccv_blur_8u_fir(strip + i * CCV_BLUR_TILE_SIZE, CCV_BLUR_TILE_SIZE, w, filter, wpair, fsz, b_ptr);
+			b_ptr += db->step;
+		}
+	}
+	ccfree(strip);
+}
+
+static void _ccv_blur_32f(ccv_dense_matrix_t* a, ccv_dense_matrix_t* db, const float* filter, int fsz)
+{
+	int i, j, k, x, ch = CCV_GET_CHANNEL(a->type);
+	int hfz = fsz / 2, n = a->cols * ch;
+	float* buf = (float*)alloca(sizeof(float) * (a->cols + fsz - 1) * ch);
+	unsigned char* a_ptr = a->data.u8;
+	unsigned char* b_ptr = db->data.u8;
+	for (i = 0; i < a->rows; i++)
+	{
+		for (j = 0; j < hfz; j++)
+			for (k = 0; k < ch; k++)
+				buf[j * ch + k] = ((float*)a_ptr)[k];
+		memcpy(buf + hfz * ch, a_ptr, sizeof(float) * n);
+		for (j = a->cols; j < hfz + a->cols; j++)
+			for (k = 0; k < ch; k++)
+				buf[j * ch + hfz * ch + k] = ((float*)a_ptr)[(a->cols - 1) * ch + k];
+		_ccv_blur_32f_fir(buf, ch, n, filter, fsz, (float*)b_ptr);
+		a_ptr += a->step;
+		b_ptr += db->step;
+	}
+	float* strip = (float*)ccmalloc(sizeof(float) * (a->rows + fsz - 1) * CCV_BLUR_TILE_SIZE);
+	for (x = 0; x < n; x += CCV_BLUR_TILE_SIZE)
+	{
+		int w = ccv_min(CCV_BLUR_TILE_SIZE, n - x);
+		for (i = 0; i < a->rows + fsz - 1; i++)
+			memcpy(strip + i * CCV_BLUR_TILE_SIZE, db->data.f32 + (db->step >> 2) * ccv_clamp(i - hfz, 0, a->rows - 1) + x, sizeof(float) * w);
+		b_ptr = db->data.u8 + x * sizeof(float);
+		for (i = 0; i < a->rows; i++)
+		{
+			_ccv_blur_32f_fir(strip + i * CCV_BLUR_TILE_SIZE, CCV_BLUR_TILE_SIZE, w, filter, fsz, (float*)b_ptr);
+			b_ptr += db->step;
+		}
+	}
+	ccfree(strip);
+}
+
+/* Deriche's 4th order recursive Gaussian, coeff has the causal feedforward n0 - n3, the anti-causal feedforward m1 - m4
+ * and the feedback d1 - d4 that both share, normalized to unit gain. The output is the sum of the causal and the anti-causal
+ * pass, both run off the input, thus a replicated border is the steady state of either pass */
+static void _ccv_blur_iir_coefficients(double sigma, double* coeff)
+{
+	const double a0 = 1.6797292232361107, a1 = 3.7348298269103580;
+	const double b0 = 1.7831906544515104, b1 = 1.7228297663338028;
+	const double w0 = 0.6318113174569493, w1 = 1.9969276832487770;
+	const double c0 = -0.6802783501806897, c1 = -0.2598300478959625;
+	double cw0 = cos(w0 / sigma), sw0 = sin(w0 / sigma), cw1 = cos(w1 / sigma), sw1 = sin(w1 / sigma);
+	double e0 = exp(-b0 / sigma), e1 = exp(-b1 / sigma);
+	double* n = coeff;
+	double* m = coeff + 4;
+	double* d = coeff + 8;
+	n[0] = a0 + c0;
+	n[1] = e1 * (c1 * sw1 - (c0 + 2 * a0) * cw1) + e0 * (a1 * sw0 - (2 * c0 + a0) * cw0);
+	n[2] = 2 * e0 * e1 * ((a0 + c0) * cw1 * cw0 - a1 * cw1 * sw0 - c1 * cw0 * sw1) + c0 * e0 * e0 + a0 * e1 * e1;
+	n[3] = e1 * e0 * e0 * (c1 * sw1 - c0 * cw1) + e0 * e1 * e1 * (a1 * sw0 - a0 * cw0);
+	d[0] = -2 * e1 * cw1 - 2 * e0 * cw0;
+	d[1] = 4 * cw1 * cw0 * e0 * e1 + e1 * e1 + e0 * e0;
+	d[2] = -2 * cw0 * e0 * e1 * e1 - 2 * cw1 * e1 * e0 * e0;
+	d[3] = e0 * e0 * e1 * e1;
+	m[0] = n[1] - d[0] * n[0];
+	m[1] = n[2] - d[1] * n[0];
+	m[2] = n[3] - d[2] * n[0];
+	m[3] = -d[3] * n[0];
+	double g = (n[0] + n[1] + n[2] + n[3] + m[0] + m[1] + m[2] + m[3]) / (1 + d[0] + d[1] + d[2] + d[3]);
+	int i;
+	for (i = 0; i < 8; i++)
+		coeff[i] /= g;
+}
+
+/* the recursion runs along len and across lanes, the lanes are next to each other in x and y, thus they are independent
+ * of each other and the loop over lanes vectorizes. The 4 states of each lane are in p, in double, otherwise a large
+ * sigma doesn't hold in float precision */
+static void _ccv_blur_iir_lines(const float* x, int xstep, float* y, int ystep, int len, int lanes, double* p, const double* coeff)
+{
+	const double* n = coeff;
+	const double* m = coeff + 4;
+	const double* d = coeff + 8;
+	double sd = 1 + d[0] + d[1] + d[2] + d[3];
+	double gn = (n[0] + n[1] + n[2] + n[3]) / sd;
+	double gm = (m[0] + m[1] + m[2] + m[3]) / sd;
+	double* y1 = p;
+	double* y2 = p + lanes;
+	double* y3 = p + lanes * 2;
+	double* y4 = p + lanes * 3;
+	double* pt;
+	int i, k;
+	for (k = 0; k < lanes; k++)
+		y1[k] = y2[k] = y3[k] = y4[k] = gn * x[k];
+	for (i = 0; i < len; i++)
+	{
+		const float* x0 = x + xstep * i;
+		const float* x1 = x + xstep * ccv_max(i - 1, 0);
+		const float* x2 = x + xstep * ccv_max(i - 2, 0);
+		const float* x3 = x + xstep * ccv_max(i - 3, 0);
+		float* y0 = y + ystep * i;
+		for (k = 0; k < lanes; k++)
+			y0[k] = y4[k] = n[0] * x0[k] + n[1] * x1[k] + n[2] * x2[k] + n[3] * x3[k] - d[0] * y1[k] - d[1] * y2[k] - d[2] * y3[k] - d[3] * y4[k];
+		pt = y4, y4 = y3, y3 = y2, y2 = y1, y1 = pt;
+	}
+	const float* xl = x + xstep * (len - 1);
+	for (k = 0; k < lanes; k++)
+		y1[k] = y2[k] = y3[k] = y4[k] = gm * xl[k];
+	for (i = len - 1; i >= 0; i--)
+	{
+		const float* x1 = x + xstep * ccv_min(i + 1, len - 1);
+		const float* x2 = x + xstep * ccv_min(i + 2, len - 1);
+		const float* x3 = x + xstep * ccv_min(i + 3, len - 1);
+		const float* x4 = x + xstep * ccv_min(i + 4, len - 1);
+		float* y0 = y + ystep * i;
+		for (k = 0; k < lanes; k++)
+		{
+			y4[k] = m[0] * x1[k] + m[1] * x2[k] + m[2] * x3[k] + m[3] * x4[k] - d[0] * y1[k] - d[1] * y2[k] - d[2] * y3[k] - d[3] * y4[k];
+			y0[k] += y4[k];
+		}
+		pt = y4, y4 = y3, y3 = y2, y2 = y1, y1 = pt;
+	}
+}
+
+/* the number of rows the horizontal pass runs at once, as lanes */
+#define CCV_BLUR_IIR_ROWS (8)
+
+static void _ccv_blur_iir(ccv_dense_matrix_t* a, ccv_dense_matrix_t* db, double sigma)
+{
+	double coeff[12];
+	_ccv_blur_iir_coefficients(sigma, coeff);
+	int i, j, k, c, ch = CCV_GET_CHANNEL(a->type), cols = a->cols * ch;
+	/* the horizontal pass goes to t, the vertical pass goes to o, which is the output if it is in 32f already */
+	float* t = (float*)ccmalloc(sizeof(float) * a->rows * cols);
+	int ostep = (CCV_GET_DATA_TYPE(db->type) == CCV_32F) ? db->step / sizeof(float) : cols;
+	float* o = (CCV_GET_DATA_TYPE(db->type) == CCV_32F) ? db->data.f32 : (float*)ccmalloc(sizeof(float) * a->rows * cols);
+	double* p = (double*)ccmalloc(sizeof(double) * ccv_max(CCV_BLUR_IIR_ROWS * ch, cols) * 4);
+	/* horizontal, CCV_BLUR_IIR_ROWS rows a time, each pixel of a row takes the ch lanes of that row */
+	float* x = (float*)ccmalloc(sizeof(float) * a->cols * CCV_BLUR_IIR_ROWS * ch * 2);
+	float* y = x + a->cols * CCV_BLUR_IIR_ROWS * ch;
+#define for_block(_, _for_get) \
+	for (i = 0; i < a->rows; i += CCV_BLUR_IIR_ROWS) \
+	{ \
+		int rows = ccv_min(CCV_BLUR_IIR_ROWS, a->rows - i); \
+		int lanes = rows * ch; \
+		for (k = 0; k < rows; k++) \
+		{ \
+			unsigned char* a_ptr = a->data.u8 + a->step * (i + k); \
+			for (j = 0; j < a->cols; j++) \
+				for (c = 0; c < ch; c++) \
+					x[j * lanes + k * ch + c] = _for_get(a_ptr, j * ch + c, 0); \
+		} \
+		_ccv_blur_iir_lines(x, lanes, y, lanes, a->cols, lanes, p, coeff); \
+		for (k = 0; k < rows; k++) \
+		{ \
+			float* t_ptr = t + cols * (i + k); \
+			for (j = 0; j < a->cols; j++) \
+				for (c = 0; c < ch; c++) \
+					t_ptr[j * ch + c] = y[j * lanes + k * ch + c]; \
+		} \
+	}
+	ccv_matrix_getter(a->type, for_block);
+#undef for_block
+	ccfree(x);
+	/* vertical, every column is a lane */
+	_ccv_blur_iir_lines(t, cols, o, ostep, a->rows, cols, p, coeff);
+	ccfree(p);
+	ccfree(t);
+	if (CCV_GET_DATA_TYPE(db->type) == CCV_32F)
+		return;
+	/* round to the nearest for 8u, as the output isn't in fixed point */
+	double rounding = (CCV_GET_DATA_TYPE(db->type) == CCV_8U) ? 0.5 : 0;
+	unsigned char* b_ptr = db->data.u8;
+	float* o_ptr = o;
+#define for_block(_, _for_set) \
+	for (i = 0; i < a->rows; i++) \
+	{ \
+		for (j = 0; j < cols; j++) \
+			_for_set(b_ptr, j, o_ptr[j] + rounding, 0); \
+		b_ptr += db->step; \
+		o_ptr += ostep; \
+	}
+	ccv_matrix_setter(db->type, for_block);
+#undef for_block
+	ccfree(o);
+}
+
 void ccv_blur(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type, double sigma)
 {
 	ccv_declare_derived_signature(sig, a->sig != 0, ccv_sign_with_format(64, "ccv_blur(%la)", sigma), a->sig, CCV_EOF_SIGN);
 	type = (type == 0) ? CCV_GET_DATA_TYPE(a->type) | CCV_GET_CHANNEL(a->type) : CCV_GET_DATA_TYPE(type) | CCV_GET_CHANNEL(a->type);
 	ccv_dense_matrix_t* db = *b = ccv_dense_matrix_renew(*b, a->rows, a->cols, CCV_ALL_DATA_TYPE | CCV_GET_CHANNEL(a->type), type, sig);
 	ccv_object_return_if_cached(, db);
+	if (sigma > CCV_BLUR_IIR_SIGMA)
+	{
+		_ccv_blur_iir(a, db, sigma);
+		return;
+	}
 	int fsz = ccv_max(1, (int)(4.0 * sigma + 1.0 - 1e-8)) * 2 + 1;
 	int hfz = fsz / 2;
 	assert(hfz > 0);
@@ -442,6 +1114,14 @@ void ccv_blur(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type, double si
 		for (i = 0; i < fsz; i++)
 			ccv_set_value(no_8u_type, filter, i, ((double*)filter)[i] * tw, 0);
 	}
+	if (CCV_GET_DATA_TYPE(a->type) == CCV_8U && CCV_GET_DATA_TYPE(db->type) == CCV_8U)
+	{
+		_ccv_blur_8u(a, db, (int*)filter, fsz);
+		return;
+	} else if (CCV_GET_DATA_TYPE(a->type) == CCV_32F && CCV_GET_DATA_TYPE(db->type) == CCV_32F) {
+		_ccv_blur_32f(a, db, (float*)filter, fsz);
+		return;
+	}
 	/* horizontal */
 	unsigned char* a_ptr = a->data.u8;
 	unsigned char* b_ptr = db->data.u8;
@@ -1,6 +1,11 @@
 #include "ccv.h"
 #include "ccv_internal.h"
 #include <sys/time.h>
+#if defined(HAVE_SSE2)
+#include <emmintrin.h>
+#elif defined(HAVE_NEON)
+#include <arm_neon.h>
+#endif
 #ifdef HAVE_GSL
 #include <gsl/gsl_rng.h>
 #include <gsl/gsl_randist.h>
@@ -948,6 +953,8 @@ void ccv_bbf_classifier_cascade_new(ccv_dense_matrix_t** posimg, int posnum, cha
 	cascade->count = 0;
 	cascade->size = size;
 	cascade->stage_classifier = (ccv_bbf_stage_classifier_t*)ccmalloc(sizeof(ccv_bbf_stage_classifier_t));
+	/* stages are added as it goes, thus, the detection flattens it every time */
+	cascade->compiled = 0;
 	unsigned char** posdata = (unsigned char**)ccmalloc(posnum * sizeof(unsigned char*));
 	unsigned char** negdata = (unsigned char**)ccmalloc(negnum * sizeof(unsigned char*));
 	double* pw = (double*)ccmalloc(posnum * sizeof(double));
@@ -1188,6 +1195,343 @@ static int _ccv_is_equal_same_class(const void* _r1, const void* _r2, void* data
 		   (int)(r2->rect.width * 1.5 + 0.5) >= r1->rect.width;
 }
 
+/* the number of rows (on the quarter size plane) a band has when the sliding window scan runs in parallel */
+#define CCV_BBF_BAND_SIZE (8)
+
+typedef struct {
+	int i; // the pyramid level
+	int q; // the spatial offset
+	int start;
+	int end;
+} ccv_bbf_scan_band_t;
+
+/* flatten the stages into one block that is read front to back when a window runs the cascade */
+static ccv_bbf_compiled_cascade_t* _ccv_bbf_compile(ccv_bbf_classifier_cascade_t* cascade)
+{
+	int i, j, k;
+	int feature_count = 0, point_count = 0;
+	for (i = 0; i < cascade->count; i++)
+	{
+		feature_count += cascade->stage_classifier[i].count;
+		for (j = 0; j < cascade->stage_classifier[i].count; j++)
+			point_count += cascade->stage_classifier[i].feature[j].size;
+	}
+	/* one block holds everything, from the widest type to the narrowest one, thus, every array stays aligned */
+	ccv_bbf_compiled_cascade_t* compiled = (ccv_bbf_compiled_cascade_t*)ccmalloc(sizeof(ccv_bbf_compiled_cascade_t) + (sizeof(int) + sizeof(float)) * cascade->count + (sizeof(float) * 2 + sizeof(unsigned char)) * feature_count + (sizeof(short) * 2 + sizeof(unsigned char)) * 2 * point_count);
+	compiled->count = cascade->count;
+	compiled->feature_count = feature_count;
+	compiled->point_count = point_count;
+	compiled->stage_size = (int*)(compiled + 1);
+	compiled->threshold = (float*)(compiled->stage_size + cascade->count);
+	compiled->alpha = compiled->threshold + cascade->count;
+	compiled->x = (short*)(compiled->alpha + feature_count * 2);
+	compiled->y = compiled->x + point_count * 2;
+	compiled->size = (unsigned char*)(compiled->y + point_count * 2);
+	compiled->z = compiled->size + feature_count;
+	float* alpha = compiled->alpha;
+	unsigned char* size = compiled->size;
+	short* x = compiled->x;
+	short* y = compiled->y;
+	unsigned char* z = compiled->z;
+	for (i = 0; i < cascade->count; i++)
+	{
+		ccv_bbf_stage_classifier_t* classifier = cascade->stage_classifier + i;
+		compiled->stage_size[i] = classifier->count;
+		compiled->threshold[i] = classifier->threshold;
+		for (j = 0; j < classifier->count; j++, alpha += 2, size++)
+		{
+			ccv_bbf_feature_t* feature = classifier->feature + j;
+			alpha[0] = classifier->alpha[j * 2];
+			alpha[1] = classifier->alpha[j * 2 + 1];
+			size[0] = feature->size;
+			/* the minimum of P and the maximum of N don't change if a point shows up twice, thus, the missing ones repeat the
+			 * first point and the feature runs without checking them */
+			for (k = 0; k < feature->size; k++, x += 2, y += 2, z += 2)
+			{
+				const int p = feature->pz[k] >= 0 ? k : 0;
+				const int n = feature->nz[k] >= 0 ? k : 0;
+				x[0] = feature->px[p];
+				y[0] = feature->py[p];
+				z[0] = feature->pz[p];
+				x[1] = feature->nx[n];
+				y[1] = feature->ny[n];
+				z[1] = feature->nz[n];
+			}
+		}
+	}
+	return compiled;
+}
+
+void ccv_bbf_classifier_cascade_compile(ccv_bbf_classifier_cascade_t* cascade)
+{
+	if (cascade->compiled)
+		ccfree(cascade->compiled);
+	cascade->compiled = _ccv_bbf_compile(cascade);
+}
+
+/* resolve the points of the compiled cascade into offsets on the planes of one pyramid level */
+static void _ccv_bbf_resolve_offsets(ccv_bbf_compiled_cascade_t* compiled, int* steps, int* offset)
+{
+	int i;
+	for (i = 0; i < compiled->point_count * 2; i++)
+		offset[i] = compiled->x[i] + compiled->y[i] * steps[compiled->z[i]];
+}
+
+/* the same test as _ccv_run_bbf_feature on the resolved offsets */
+static inline int _ccv_bbf_run_compiled_feature(int size, const int* offset, const unsigned char* z, unsigned char** u8)
+{
+	unsigned char pmin = u8[z[0]][offset[0]], nmax = u8[z[1]][offset[1]];
+	/* check if every point in P > every point in N, and take a shortcut */
+	if (pmin <= nmax)
+		return 0;
+	int i;
+	for (i = 1; i < size; i++)
+	{
+		int p = u8[z[i * 2]][offset[i * 2]];
+		if (p < pmin)
+		{
+			if (p <= nmax)
+				return 0;
+			pmin = p;
+		}
+		int n = u8[z[i * 2 + 1]][offset[i * 2 + 1]];
+		if (n > nmax)
+		{
+			if (pmin <= n)
+				return 0;
+			nmax = n;
+		}
+	}
+	return 1;
+}
+
+/* run the compiled cascade on one window, and returns 1 if it passes all the stages */
+static inline int _ccv_bbf_run_cascade(ccv_bbf_compiled_cascade_t* compiled, const int* offset, unsigned char** u8, float* confidence)
+{
+	int i, j;
+	float sum = 0;
+	const float* alpha = compiled->alpha;
+	const unsigned char* size = compiled->size;
+	const unsigned char* z = compiled->z;
+	for (i = 0; i < compiled->count; i++)
+	{
+		sum = 0;
+		for (j = 0; j < compiled->stage_size[i]; j++, alpha += 2, size++)
+		{
+			sum += alpha[_ccv_bbf_run_compiled_feature(size[0], offset, z, u8)];
+			offset += size[0] * 2;
+			z += size[0] * 2;
+		}
+		if (sum < compiled->threshold[i])
+			return 0;
+	}
+	*confidence = sum;
+	return 1;
+}
+
+#if defined(HAVE_SSE2) || defined(HAVE_NEON)
+/* 16 consecutive windows run the cascade together, the windows move 4, 2, 1 pixels apart on the three planes, and the
+ * cascade stops once every one of them is rejected. Finishing the few survivors one by one turns out to be slower */
+#define CCV_BBF_LANES (16)
+#endif
+
+#if defined(HAVE_SSE2)
+static inline __m128i _ccv_bbf_load_lanes(const unsigned char* ptr, int z)
+{
+	if (z == 2)
+		return _mm_loadu_si128((const __m128i*)ptr);
+	if (z == 1)
+	{
+		const __m128i mask = _mm_set1_epi16(0xff);
+		return _mm_packus_epi16(_mm_and_si128(_mm_loadu_si128((const __m128i*)ptr), mask), _mm_and_si128(_mm_loadu_si128((const __m128i*)(ptr + 16)), mask));
+	}
+	const __m128i mask = _mm_set1_epi32(0xff);
+	return _mm_packus_epi16(_mm_packs_epi32(_mm_and_si128(_mm_loadu_si128((const __m128i*)ptr), mask), _mm_and_si128(_mm_loadu_si128((const __m128i*)(ptr + 16)), mask)),
+							_mm_packs_epi32(_mm_and_si128(_mm_loadu_si128((const __m128i*)(ptr + 32)), mask), _mm_and_si128(_mm_loadu_si128((const __m128i*)(ptr + 48)), mask)));
+}
+
+/* the same test as _ccv_bbf_run_compiled_feature, every point in P > every point in N, returns 0xff on the lanes that fail */
+static inline __m128i _ccv_bbf_feature_lanes(int size, const int* offset, const unsigned char* z, unsigned char** u8)
+{
+	const __m128i zero = _mm_setzero_si128();
+	__m128i pmin = _ccv_bbf_load_lanes(u8[z[0]] + offset[0], z[0]), nmax = _ccv_bbf_load_lanes(u8[z[1]] + offset[1], z[1]);
+	/* take a shortcut if it fails on every lane already */
+	if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_subs_epu8(pmin, nmax), zero)) == 0xffff)
+		return _mm_cmpeq_epi8(zero, zero);
+	int i;
+	for (i = 1; i < size; i++)
+	{
+		pmin = _mm_min_epu8(pmin, _ccv_bbf_load_lanes(u8[z[i * 2]] + offset[i * 2], z[i * 2]));
+		nmax = _mm_max_epu8(nmax, _ccv_bbf_load_lanes(u8[z[i * 2 + 1]] + offset[i * 2 + 1], z[i * 2 + 1]));
+	}
+	return _mm_cmpeq_epi8(_mm_subs_epu8(pmin, nmax), zero);
+}
+
+/* returns the lanes that pass all the stages, with their confidence */
+static int _ccv_bbf_run_cascade_lanes(ccv_bbf_compiled_cascade_t* compiled, const int* offset, unsigned char** u8, float* confidence)
+{
+	int i, j, k, lanes = 0xffff;
+	__m128 sum[4] = { _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps() };
+	const float* alpha = compiled->alpha;
+	const unsigned char* size = compiled->size;
+	const unsigned char* z = compiled->z;
+	for (i = 0; i < compiled->count; i++)
+	{
+		sum[0] = sum[1] = sum[2] = sum[3] = _mm_setzero_ps();
+		for (j = 0; j < compiled->stage_size[i]; j++, alpha += 2, size++)
+		{
+			const __m128i fail = _ccv_bbf_feature_lanes(size[0], offset, z, u8);
+			offset += size[0] * 2;
+			z += size[0] * 2;
+			const __m128 alpha0 = _mm_set1_ps(alpha[0]);
+			const __m128 alpha1 = _mm_set1_ps(alpha[1]);
+			const __m128i lo = _mm_unpacklo_epi8(fail, fail);
+			const __m128i hi = _mm_unpackhi_epi8(fail, fail);
+			const __m128 m0 = _mm_castsi128_ps(_mm_unpacklo_epi16(lo, lo));
+			const __m128 m1 = _mm_castsi128_ps(_mm_unpackhi_epi16(lo, lo));
+			const __m128 m2 = _mm_castsi128_ps(_mm_unpacklo_epi16(hi, hi));
+			const __m128 m3 = _mm_castsi128_ps(_mm_unpackhi_epi16(hi, hi));
+			sum[0] = _mm_add_ps(sum[0], _mm_or_ps(_mm_and_ps(m0, alpha0), _mm_andnot_ps(m0, alpha1)));
+			sum[1] = _mm_add_ps(sum[1], _mm_or_ps(_mm_and_ps(m1, alpha0), _mm_andnot_ps(m1, alpha1)));
+			sum[2] = _mm_add_ps(sum[2], _mm_or_ps(_mm_and_ps(m2, alpha0), _mm_andnot_ps(m2, alpha1)));
+			sum[3] = _mm_add_ps(sum[3], _mm_or_ps(_mm_and_ps(m3, alpha0), _mm_andnot_ps(m3, alpha1)));
+		}
+		const __m128 threshold = _mm_set1_ps(compiled->threshold[i]);
+		const __m128i reject = _mm_packs_epi16(_mm_packs_epi32(_mm_castps_si128(_mm_cmplt_ps(sum[0], threshold)), _mm_castps_si128(_mm_cmplt_ps(sum[1], threshold))),
+											   _mm_packs_epi32(_mm_castps_si128(_mm_cmplt_ps(sum[2], threshold)), _mm_castps_si128(_mm_cmplt_ps(sum[3], threshold))));
+		lanes &= ~_mm_movemask_epi8(reject);
+		if (!lanes)
+			return 0;
+	}
+	for (k = 0; k < 4; k++)
+		_mm_storeu_ps(confidence + k * 4, sum[k]);
+	return lanes;
+}
+#elif defined(HAVE_NEON)
+static inline uint8x16_t _ccv_bbf_load_lanes(const unsigned char* ptr, int z)
+{
+	if (z == 2)
+		return vld1q_u8(ptr);
+	if (z == 1)
+		return vld2q_u8(ptr).val[0];
+	return vld4q_u8(ptr).val[0];
+}
+
+/* the same test as _ccv_bbf_run_compiled_feature, every point in P > every point in N, returns 0xff on the lanes that fail */
+static inline uint8x16_t _ccv_bbf_feature_lanes(int size, const int* offset, const unsigned char* z, unsigned char** u8)
+{
+	uint8x16_t pmin = _ccv_bbf_load_lanes(u8[z[0]] + offset[0], z[0]), nmax = _ccv_bbf_load_lanes(u8[z[1]] + offset[1], z[1]);
+	int i;
+	for (i = 1; i < size; i++)
+	{
+		pmin = vminq_u8(pmin, _ccv_bbf_load_lanes(u8[z[i * 2]] + offset[i * 2], z[i * 2]));
+		nmax = vmaxq_u8(nmax, _ccv_bbf_load_lanes(u8[z[i * 2 + 1]] + offset[i * 2 + 1], z[i * 2 + 1]));
+	}
+	return vcleq_u8(pmin, nmax);
+}
+
+/* returns the lanes that pass all the stages, with their confidence */
+static int _ccv_bbf_run_cascade_lanes(ccv_bbf_compiled_cascade_t* compiled, const int* offset, unsigned char** u8, float* confidence)
+{
+	int i, j, k, lanes = 0xffff;
+	float32x4_t sum[4] = { vdupq_n_f32(0), vdupq_n_f32(0), vdupq_n_f32(0), vdupq_n_f32(0) };
+	uint8_t reject[CCV_BBF_LANES];
+	const float* alpha = compiled->alpha;
+	const unsigned char* size = compiled->size;
+	const unsigned char* z = compiled->z;
+	for (i = 0; i < compiled->count; i++)
+	{
+		sum[0] = sum[1] = sum[2] = sum[3] = vdupq_n_f32(0);
+		for (j = 0; j < compiled->stage_size[i]; j++, alpha += 2, size++)
+		{
+			const int8x16_t fail = vreinterpretq_s8_u8(_ccv_bbf_feature_lanes(size[0], offset, z, u8));
+			offset += size[0] * 2;
+			z += size[0] * 2;
+			const float32x4_t alpha0 = vdupq_n_f32(alpha[0]);
+			const float32x4_t alpha1 = vdupq_n_f32(alpha[1]);
+			const int16x8_t lo = vmovl_s8(vget_low_s8(fail));
+			const int16x8_t hi = vmovl_s8(vget_high_s8(fail));
+			sum[0] = vaddq_f32(sum[0], vbslq_f32(vreinterpretq_u32_s32(vmovl_s16(vget_low_s16(lo))), alpha0, alpha1));
+			sum[1] = vaddq_f32(sum[1], vbslq_f32(vreinterpretq_u32_s32(vmovl_s16(vget_high_s16(lo))), alpha0, alpha1));
+			sum[2] = vaddq_f32(sum[2], vbslq_f32(vreinterpretq_u32_s32(vmovl_s16(vget_low_s16(hi))), alpha0, alpha1));
+			sum[3] = vaddq_f32(sum[3], vbslq_f32(vreinterpretq_u32_s32(vmovl_s16(vget_high_s16(hi))), alpha0, alpha1));
+		}
+		const float32x4_t threshold = vdupq_n_f32(compiled->threshold[i]);
+		vst1q_u8(reject, vcombine_u8(vmovn_u16(vcombine_u16(vmovn_u32(vcltq_f32(sum[0], threshold)), vmovn_u32(vcltq_f32(sum[1], threshold)))),
+									 vmovn_u16(vcombine_u16(vmovn_u32(vcltq_f32(sum[2], threshold)), vmovn_u32(vcltq_f32(sum[3], threshold))))));
+		for (k = 0; k < CCV_BBF_LANES; k++)
+			if (reject[k])
+				lanes &= ~(1 << k);
+		if (!lanes)
+			return 0;
+	}
+	for (k = 0; k < 4; k++)
+		vst1q_f32(confidence + k * 4, sum[k]);
+	return lanes;
+}
+#endif
+
+static inline void _ccv_bbf_push_comp(ccv_array_t** seq, ccv_bbf_classifier_cascade_t* cascade, int x, int y, int q, float scale_x, float scale_y, int id, float confidence)
+{
+	static const int dx[] = {0, 1, 0, 1};
+	static const int dy[] = {0, 0, 1, 1};
+	ccv_comp_t comp;
+	comp.rect = ccv_rect((int)((x * 4 + dx[q] * 2) * scale_x + 0.5), (int)((y * 4 + dy[q] * 2) * scale_y + 0.5), (int)(cascade->size.width * scale_x + 0.5), (int)(cascade->size.height * scale_y + 0.5));
+	comp.neighbors = 1;
+	comp.classification.id = id;
+	comp.classification.confidence = confidence;
+	if (!*seq)
+		*seq = ccv_array_new(sizeof(ccv_comp_t), 16, 0);
+	ccv_array_push(*seq, &comp);
+}
+
+/* scan rows [start, end) of level i with offset q, and push the windows that pass all the stages into seq */
+static void _ccv_bbf_scan(ccv_bbf_classifier_cascade_t* cascade, ccv_bbf_compiled_cascade_t* compiled, const int* offset, ccv_dense_matrix_t** pyr, int next, ccv_bbf_scan_band_t* band, float scale_x, float scale_y, int id, ccv_array_t** seq)
+{
+	static const int dx[] = {0, 1, 0, 1};
+	static const int dy[] = {0, 0, 1, 1};
+	const int i = band->i, q = band->q;
+	int x, y;
+	int steps[] = { pyr[i * 4]->step, pyr[i * 4 + next * 4]->step, pyr[i * 4 + next * 8]->step };
+	int i_cols = pyr[i * 4 + next * 8]->cols - (cascade->size.width >> 2);
+	int paddings[] = { pyr[i * 4]->step * 4 - i_cols * 4,
+					   pyr[i * 4 + next * 4]->step * 2 - i_cols * 2,
+					   pyr[i * 4 + next * 8]->step - i_cols };
+	unsigned char* u8[] = { pyr[i * 4]->data.u8 + dx[q] * 2 + dy[q] * pyr[i * 4]->step * 2 + band->start * steps[0] * 4, pyr[i * 4 + next * 4]->data.u8 + dx[q] + dy[q] * pyr[i * 4 + next * 4]->step + band->start * steps[1] * 2, pyr[i * 4 + next * 8 + q]->data.u8 + band->start * steps[2] };
+	for (y = band->start; y < band->end; y++)
+	{
+		x = 0;
+#if defined(HAVE_SSE2) || defined(HAVE_NEON)
+		/* the lanes load up to the same point of the window right after them, thus, it needs one more window to stay
+		 * within the image */
+		const int lanes_end = _ccv_simd_enabled ? i_cols - CCV_BBF_LANES : 0;
+		for (; x < lanes_end; x += CCV_BBF_LANES)
+		{
+			float confidence[CCV_BBF_LANES];
+			int l, lanes = _ccv_bbf_run_cascade_lanes(compiled, offset, u8, confidence);
+			for (l = 0; lanes; l++, lanes >>= 1)
+				if (lanes & 1)
+					_ccv_bbf_push_comp(seq, cascade, x + l, y, q, scale_x, scale_y, id, confidence[l]);
+			u8[0] += 4 * CCV_BBF_LANES;
+			u8[1] += 2 * CCV_BBF_LANES;
+			u8[2] += CCV_BBF_LANES;
+		}
+#endif
+		for (; x < i_cols; x++)
+		{
+			float confidence;
+			if (_ccv_bbf_run_cascade(compiled, offset, u8, &confidence))
+				_ccv_bbf_push_comp(seq, cascade, x, y, q, scale_x, scale_y, id, confidence);
+			u8[0] += 4;
+			u8[1] += 2;
+			u8[2] += 1;
+		}
+		u8[0] += paddings[0];
+		u8[1] += paddings[1];
+		u8[2] += paddings[2];
+	}
+}
+
 ccv_array_t* ccv_bbf_detect_objects(ccv_dense_matrix_t* a, ccv_bbf_classifier_cascade_t** _cascade, int count, ccv_bbf_param_t params)
 {
 	int hr = a->rows / params.size.height;
@@ -1201,18 +1545,15 @@ ccv_array_t* ccv_bbf_detect_objects(ccv_dense_matrix_t* a, ccv_bbf_classifier_ca
 		ccv_resample(a, &pyr[0], 0, a->rows * _cascade[0]->size.height / params.size.height, a->cols * _cascade[0]->size.width / params.size.width, CCV_INTER_AREA);
 	else
 		pyr[0] = a;
-	int i, j, k, t, x, y, q;
-	for (i = 1; i < ccv_min(params.interval + 1, scale_upto + next * 2); i++)
-		ccv_resample(pyr[0], &pyr[i * 4], 0, (int)(pyr[0]->rows / pow(scale, i)), (int)(pyr[0]->cols / pow(scale, i)), CCV_INTER_AREA);
-	for (i = next; i < scale_upto + next * 2; i++)
-		ccv_sample_down(pyr[i * 4 - next * 4], &pyr[i * 4], 0, 0, 0);
+	int i, j, k, t, y, q;
+	ccv_pyramid_t* pyramid = params.pyramid ? params.pyramid : ccv_pyramid_new();
+	ccv_pyramid(pyr[0], pyramid, params.interval, scale_upto + next * 2, params.accurate ? CCV_PYRAMID_ACCURATE : 0);
+	for (i = 1; i < scale_upto + next * 2; i++)
+		pyr[i * 4] = ccv_pyramid_level(pyramid, i);
 	if (params.accurate)
 		for (i = next * 2; i < scale_upto + next * 2; i++)
-		{
-			ccv_sample_down(pyr[i * 4 - next * 4], &pyr[i * 4 + 1], 0, 1, 0);
-			ccv_sample_down(pyr[i * 4 - next * 4], &pyr[i * 4 + 2], 0, 0, 1);
-			ccv_sample_down(pyr[i * 4 - next * 4], &pyr[i * 4 + 3], 0, 1, 1);
-		}
+			for (q = 1; q < 4; q++)
+				pyr[i * 4 + q] = ccv_pyramid_offset_level(pyramid, i, q);
 	ccv_array_t* idx_seq;
 	ccv_array_t* seq = ccv_array_new(sizeof(ccv_comp_t), 64, 0);
 	ccv_array_t* seq2 = ccv_array_new(sizeof(ccv_comp_t), 64, 0);
@@ -1224,60 +1565,66 @@ ccv_array_t* ccv_bbf_detect_objects(ccv_dense_matrix_t* a, ccv_bbf_classifier_ca
 		float scale_x = (float) params.size.width / (float) cascade->size.width;
 		float scale_y = (float) params.size.height / (float) cascade->size.height;
 		ccv_array_clear(seq);
+		/* the work splits into bands of rows for each level and offset, the scale of a level is accumulated the same way
+		 * as the serial scan, and the results of bands are merged in order, thus, the output is the same either way */
+		float* scales = (float*)alloca(sizeof(float) * 2 * scale_upto);
+		const int band_rows = ccv_band_rows(CCV_BBF_BAND_SIZE);
+		int band_count = 0;
+		for (i = 0; i < scale_upto; i++)
+		{
+			scales[i * 2] = scale_x;
+			scales[i * 2 + 1] = scale_y;
+			/* a level always has one band at least, even if it has no rows to scan, the same as the loop that fills them */
+			int i_rows = ccv_max(pyr[i * 4 + next * 8]->rows - (cascade->size.height >> 2), 1);
+			band_count += (params.accurate ? 4 : 1) * (band_rows > 0 ? (i_rows + band_rows - 1) / band_rows : 1);
+			scale_x *= scale;
+			scale_y *= scale;
+		}
+		/* the points of the cascade are resolved against the steps of each level once, and shared by its bands */
+		ccv_bbf_compiled_cascade_t* compiled = cascade->compiled ? cascade->compiled : _ccv_bbf_compile(cascade);
+		const int point_count = compiled->point_count * 2;
+		ccv_bbf_scan_band_t* bands = (ccv_bbf_scan_band_t*)ccmalloc(sizeof(ccv_bbf_scan_band_t) * band_count + (band_rows > 0 ? sizeof(ccv_array_t*) * band_count : 0) + sizeof(int) * point_count * scale_upto);
+		ccv_array_t** seqs = (ccv_array_t**)(bands + band_count);
+		int* offsets = (int*)(seqs + (band_rows > 0 ? band_count : 0));
+		k = 0;
 		for (i = 0; i < scale_upto; i++)
 		{
-			int dx[] = {0, 1, 0, 1};
-			int dy[] = {0, 0, 1, 1};
-			int i_rows = pyr[i * 4 + next * 8]->rows - (cascade->size.height >> 2);
 			int steps[] = { pyr[i * 4]->step, pyr[i * 4 + next * 4]->step, pyr[i * 4 + next * 8]->step };
-			int i_cols = pyr[i * 4 + next * 8]->cols - (cascade->size.width >> 2);
-			int paddings[] = { pyr[i * 4]->step * 4 - i_cols * 4,
-							   pyr[i * 4 + next * 4]->step * 2 - i_cols * 2,
-							   pyr[i * 4 + next * 8]->step - i_cols };
+			_ccv_bbf_resolve_offsets(compiled, steps, offsets + point_count * i);
+			int i_rows = pyr[i * 4 + next * 8]->rows - (cascade->size.height >> 2);
+			int band_size = band_rows > 0 ? band_rows : ccv_max(i_rows, 1);
 			for (q = 0; q < (params.accurate ? 4 : 1); q++)
-			{
-				unsigned char* u8[] = { pyr[i * 4]->data.u8 + dx[q] * 2 + dy[q] * pyr[i * 4]->step * 2, pyr[i * 4 + next * 4]->data.u8 + dx[q] + dy[q] * pyr[i * 4 + next * 4]->step, pyr[i * 4 + next * 8 + q]->data.u8 };
-				for (y = 0; y < i_rows; y++)
+				for (y = 0; y < ccv_max(i_rows, 1); y += band_size)
 				{
-					for (x = 0; x < i_cols; x++)
-					{
-						float sum;
-						int flag = 1;
-						ccv_bbf_stage_classifier_t* classifier = cascade->stage_classifier;
-						for (j = 0; j < cascade->count; ++j, ++classifier)
-						{
-							sum = 0;
-							float* alpha = classifier->alpha;
-							ccv_bbf_feature_t* feature = classifier->feature;
-							for (k = 0; k < classifier->count; ++k, alpha += 2, ++feature)
-								sum += alpha[_ccv_run_bbf_feature(feature, steps, u8)];
-							if (sum < classifier->threshold)
-							{
-								flag = 0;
-								break;
-							}
-						}
-						if (flag)
-						{
-							ccv_comp_t comp;
-							comp.rect = ccv_rect((int)((x * 4 + dx[q] * 2) * scale_x + 0.5), (int)((y * 4 + dy[q] * 2) * scale_y + 0.5), (int)(cascade->size.width * scale_x + 0.5), (int)(cascade->size.height * scale_y + 0.5));
-							comp.neighbors = 1;
-							comp.classification.id = t;
-							comp.classification.confidence = sum;
-							ccv_array_push(seq, &comp);
-						}
-						u8[0] += 4;
-						u8[1] += 2;
-						u8[2] += 1;
-					}
-					u8[0] += paddings[0];
-					u8[1] += paddings[1];
-					u8[2] += paddings[2];
+					bands[k].i = i;
+					bands[k].q = q;
+					bands[k].start = y;
+					bands[k].end = ccv_min(y + band_size, i_rows);
+					++k;
 				}
-			}
-			scale_x *= scale;
-			scale_y *= scale;
 		}
+		assert(k == band_count);
+		parallel_for(b, band_rows > 0 ? band_count : 1) {
+			int s;
+			const int end = band_rows > 0 ? b + 1 : band_count;
+			for (s = b; s < end; s++)
+			{
+				if (band_rows > 0)
+					seqs[s] = 0;
+				_ccv_bbf_scan(cascade, compiled, offsets + point_count * bands[s].i, pyr, next, bands + s, scales[bands[s].i * 2], scales[bands[s].i * 2 + 1], t, band_rows > 0 ? seqs + s : &seq);
+			}
+		} parallel_endfor
+		if (band_rows > 0)
+			for (i = 0; i < band_count; i++)
+				if (seqs[i])
+				{
+					for (j = 0; j < seqs[i]->rnum; j++)
+						ccv_array_push(seq, ccv_array_get(seqs[i], j));
+					ccv_array_free(seqs[i]);
+				}
+		ccfree(bands);
+		if (compiled != cascade->compiled)
+			ccfree(compiled);
 
 		/* the following code from OpenCV's haar feature implementation */
 		if(params.min_neighbors == 0)
@@ -1404,15 +1751,8 @@ ccv_array_t* ccv_bbf_detect_objects(ccv_dense_matrix_t* a, ccv_bbf_classifier_ca
 		result_seq2 = result_seq;
 	}
 
-	for (i = 1; i < scale_upto + next * 2; i++)
-		ccv_matrix_free(pyr[i * 4]);
-	if (params.accurate)
-		for (i = next * 2; i < scale_upto + next * 2; i++)
-		{
-			ccv_matrix_free(pyr[i * 4 + 1]);
-			ccv_matrix_free(pyr[i * 4 + 2]);
-			ccv_matrix_free(pyr[i * 4 + 3]);
-		}
+	if (!params.pyramid)
+		ccv_pyramid_free(pyramid);
 	if (params.size.height != _cascade[0]->size.height || params.size.width != _cascade[0]->size.width)
 		ccv_matrix_free(pyr[0]);
 
@@ -1441,6 +1781,7 @@ ccv_bbf_classifier_cascade_t* ccv_bbf_read_classifier_cascade(const char* direct
 		}
 	}
 	fclose(r);
+	cascade->compiled = _ccv_bbf_compile(cascade);
 	return cascade;
 }
 
@@ -1461,8 +1802,9 @@ ccv_bbf_classifier_cascade_t* ccv_bbf_classifier_cascade_read_binary(char* s)
 		memcpy(classifier->feature, s, classifier->count * sizeof(ccv_bbf_feature_t)); s += classifier->count * sizeof(ccv_bbf_feature_t);
 		memcpy(classifier->alpha, s, classifier->count * 2 * sizeof(float)); s += classifier->count * 2 * sizeof(float);
 	}
+	/* the binary is flattened right away, thus, the cascade is ready to detect once it is loaded */
+	cascade->compiled = _ccv_bbf_compile(cascade);
 	return cascade;
-
 }
 
 int ccv_bbf_classifier_cascade_write_binary(ccv_bbf_classifier_cascade_t* cascade, char* s, int slen)
@@ -1498,5 +1840,7 @@ void ccv_bbf_classifier_cascade_free(ccv_bbf_classifier_cascade_t* cascade)
 		ccfree(cascade->stage_classifier[i].alpha);
 	}
 	ccfree(cascade->stage_classifier);
+	if (cascade->compiled)
+		ccfree(cascade->compiled);
 	ccfree(cascade);
 }
@@ -1,10 +1,36 @@
 #include "ccv.h"
 #include "ccv_internal.h"
 
-#define CCV_GET_CACHE_TYPE(x) ((x) >> 60)
-#define CCV_GET_TERMINAL_AGE(x) (((x) >> 32) & 0x0FFFFFFF)
-#define CCV_GET_TERMINAL_SIZE(x) ((x) & 0xFFFFFFFF)
-#define CCV_SET_TERMINAL_TYPE(x, y, z) (((uint64_t)(x) << 60) | ((uint64_t)(y) << 32) | (z))
+#define compute_bits(m) ((uint32_t)__builtin_popcountll(m))
+
+/* every cached object has a node, it is linked into the lru list of its type,
+ * the most recently put is at the head, and the least recently put is at the tail */
+static void _ccv_cache_lru_unlink(ccv_cache_lru_t* lru, ccv_cache_node_t* node)
+{
+	if (node->prev)
+		node->prev->next = node->next;
+	else
+		lru->head = node->next;
+	if (node->next)
+		node->next->prev = node->prev;
+	else
+		lru->tail = node->prev;
+	lru->size -= node->size;
+	lru->rnum--;
+}
+
+static void _ccv_cache_lru_push(ccv_cache_lru_t* lru, ccv_cache_node_t* node)
+{
+	node->prev = 0;
+	node->next = lru->head;
+	if (lru->head)
+		lru->head->prev = node;
+	else
+		lru->tail = node;
+	lru->head = node;
+	lru->size += node->size;
+	lru->rnum++;
+}
 
 void ccv_cache_init(ccv_cache_t* cache, size_t up, int cache_types, ccv_cache_index_free_f ffree, ...)
 {
@@ -13,6 +39,7 @@ void ccv_cache_init(ccv_cache_t* cache, size_t up, int cache_types, ccv_cache_in
 	cache->up = up;
 	cache->size = 0;
 	assert(cache_types > 0 && cache_types <= 16);
+	cache->types = cache_types;
 	va_list arguments;
 	va_start(arguments, ffree);
 	int i;
@@ -20,93 +47,19 @@ void ccv_cache_init(ccv_cache_t* cache, size_t up, int cache_types, ccv_cache_in
 	for (i = 1; i < cache_types; i++)
 		cache->ffree[i] = va_arg(arguments, ccv_cache_index_free_f);
 	va_end(arguments);
+	memset(cache->lru, 0, sizeof(cache->lru));
 	memset(&cache->origin, 0, sizeof(ccv_cache_index_t));
+	cache->hits = cache->misses = cache->evictions = cache->departures = cache->lifetime = 0;
 }
 
-static int bits_in_16bits[0x1u << 16];
-static int bits_in_16bits_init = 0;
-
-static int sparse_bitcount(unsigned int n) {
-	int count = 0;
-	while (n) {
-		count++;
-		n &= (n - 1);
-	}
-	return count;
-}
-
-static void precomputed_16bits() {
-	int i;
-	for (i = 0; i < (0x1u << 16); i++)
-		bits_in_16bits[i] = sparse_bitcount(i);
-	bits_in_16bits_init = 1;
-}
-
-static uint32_t compute_bits(uint64_t m) {
-	return (bits_in_16bits[m & 0xffff] + bits_in_16bits[(m >> 16) & 0xffff] +
-			bits_in_16bits[(m >> 32) & 0xffff] + bits_in_16bits[(m >> 48) & 0xffff]);
-}
-
-/* update age along a path in the radix tree */
-static void _ccv_cache_aging(ccv_cache_index_t* branch, uint64_t sign)
+void ccv_cache_set_type_limit(ccv_cache_t* cache, uint8_t type, size_t up)
 {
-	if (!bits_in_16bits_init)
-		precomputed_16bits();
-	int i;
-	uint64_t j = 63;
-	ccv_cache_index_t* breadcrumb[10];
-	for (i = 0; i < 10; i++)
-	{
-		breadcrumb[i] = branch;
-		int leaf = branch->terminal.off & 0x1;
-		int full = branch->terminal.off & 0x2;
-		if (leaf)
-		{
-			break;
-		} else {
-			ccv_cache_index_t* set = (ccv_cache_index_t*)(branch->branch.set - (branch->branch.set & 0x3));
-			int dice = (sign & j) >> (i * 6);
-			if (full)
-			{
-				branch = set + dice;
-			} else {
-				uint64_t k = 1;
-				k = k << dice;
-				if (k & branch->branch.bitmap) {
-					uint64_t m = (k - 1) & branch->branch.bitmap;
-					branch = set + compute_bits(m);
-				} else {
-					break;
-				}
-			}
-			j <<= 6;
-		}
-	}
-	assert(i < 10);
-	for (; i >= 0; i--)
-	{
-		branch = breadcrumb[i];
-		int leaf = branch->terminal.off & 0x1;
-		if (!leaf)
-		{
-			ccv_cache_index_t* set = (ccv_cache_index_t*)(branch->branch.set - (branch->branch.set & 0x3));
-			uint32_t total = compute_bits(branch->branch.bitmap);
-			uint32_t min_age = (set[0].terminal.off & 0x1) ? CCV_GET_TERMINAL_AGE(set[0].terminal.type) : set[0].branch.age;
-			for (j = 1; j < total; j++)
-			{
-				uint32_t age = (set[j].terminal.off & 0x1) ? CCV_GET_TERMINAL_AGE(set[j].terminal.type) : set[j].branch.age;
-				if (age < min_age)
-					min_age = age;
-			}
-			branch->branch.age = min_age;
-		}
-	}
+	assert(type < cache->types);
+	cache->lru[type].up = up;
 }
 
 static ccv_cache_index_t* _ccv_cache_seek(ccv_cache_index_t* branch, uint64_t sign, int* depth)
 {
-	if (!bits_in_16bits_init)
-		precomputed_16bits();
 	int i;
 	uint64_t j = 63;
 	for (i = 0; i < 10; i++)
@@ -142,7 +95,7 @@ static ccv_cache_index_t* _ccv_cache_seek(ccv_cache_index_t* branch, uint64_t si
 	return 0;
 }
 
-void* ccv_cache_get(ccv_cache_t* cache, uint64_t sign, uint8_t* type)
+static ccv_cache_node_t* _ccv_cache_find(ccv_cache_t* cache, uint64_t sign)
 {
 	if (cache->rnum == 0)
 		return 0;
@@ -154,56 +107,34 @@ void* ccv_cache_get(ccv_cache_t* cache, uint64_t sign, uint8_t* type)
 		return 0;
 	if (branch->terminal.sign != sign)
 		return 0;
-	if (type)
-		*type = CCV_GET_CACHE_TYPE(branch->terminal.type);
-	return (void*)(branch->terminal.off - (branch->terminal.off & 0x3));
+	return (ccv_cache_node_t*)(branch->terminal.off - (branch->terminal.off & 0x3));
 }
 
-// only call this function when the cache space is delpeted
-static void _ccv_cache_lru(ccv_cache_t* cache)
+void* ccv_cache_get(ccv_cache_t* cache, uint64_t sign, uint8_t* type)
 {
-	ccv_cache_index_t* branch = &cache->origin;
-	int leaf = branch->terminal.off & 0x1;
-	if (leaf)
+	ccv_cache_node_t* node = _ccv_cache_find(cache, sign);
+	if (!node)
 	{
-		void* result = (void*)(branch->terminal.off - (branch->terminal.off & 0x3));
-		uint8_t type = CCV_GET_CACHE_TYPE(branch->terminal.type);
-		if (result != 0)
-		{
-			assert(type >= 0 && type < 16);
-			cache->ffree[type](result);
-		}
-		cache->rnum = 0;
-		cache->size = 0;
-		return;
-	}
-	uint32_t min_age = branch->branch.age;
-	int i, j;
-	for (i = 0; i < 10; i++)
-	{
-		ccv_cache_index_t* old_branch = branch;
-		int leaf = branch->terminal.off & 0x1;
-		if (leaf)
-		{
-			ccv_cache_delete(cache, branch->terminal.sign);
-			break;
-		} else {
-			ccv_cache_index_t* set = (ccv_cache_index_t*)(branch->branch.set - (branch->branch.set & 0x3));
-			uint32_t total = compute_bits(branch->branch.bitmap);
-			for (j = 0; j < total; j++)
-			{
-				uint32_t age = (set[j].terminal.off & 0x1) ? CCV_GET_TERMINAL_AGE(set[j].terminal.type) : set[j].branch.age;
-				assert(age >= min_age);
-				if (age == min_age)
-				{
-					branch = set + j;
-					break;
-				}
-			}
-			assert(old_branch != branch);
-		}
+		++cache->misses;
+		return 0;
 	}
-	assert(i < 10);
+	++cache->hits;
+	if (type)
+		*type = node->type;
+	return node->x;
+}
+
+// only call this function when the cache space is delpeted, evict the least recently put object of any type
+static void _ccv_cache_lru(ccv_cache_t* cache)
+{
+	ccv_cache_node_t* oldest = 0;
+	int i;
+	for (i = 0; i < cache->types; i++)
+		if (cache->lru[i].tail && (!oldest || cache->lru[i].tail->age < oldest->age))
+			oldest = cache->lru[i].tail;
+	assert(oldest);
+	++cache->evictions;
+	ccv_cache_delete(cache, oldest->sign);
 }
 
 static void _ccv_cache_depleted(ccv_cache_t* cache, size_t size)
@@ -212,24 +143,42 @@ static void _ccv_cache_depleted(ccv_cache_t* cache, size_t size)
 		_ccv_cache_lru(cache);
 }
 
+// evict the least recently put objects of the given type until it fits in the type limit
+static void _ccv_cache_type_depleted(ccv_cache_t* cache, uint8_t type, size_t size)
+{
+	while (cache->lru[type].size > size)
+	{
+		++cache->evictions;
+		ccv_cache_delete(cache, cache->lru[type].tail->sign);
+	}
+}
+
 int ccv_cache_put(ccv_cache_t* cache, uint64_t sign, void* x, uint32_t size, uint8_t type)
 {
 	assert(((uint64_t)x & 0x3) == 0);
-	if (size > cache->up)
+	assert(type < cache->types);
+	if (size > cache->up || (cache->lru[type].up > 0 && size > cache->lru[type].up))
 		return -1;
+	if (cache->lru[type].up > 0 && size + cache->lru[type].size > cache->lru[type].up)
+		_ccv_cache_type_depleted(cache, type, cache->lru[type].up - size);
 	if (size + cache->size > cache->up)
 		_ccv_cache_depleted(cache, cache->up - size);
+	++cache->age;
 	if (cache->rnum == 0)
 	{
-		cache->age = 1;
-		cache->origin.terminal.off = (uint64_t)x | 0x1;
+		ccv_cache_node_t* node = (ccv_cache_node_t*)ccmalloc(sizeof(ccv_cache_node_t));
+		node->sign = sign;
+		node->x = x;
+		node->age = cache->age;
+		node->size = size;
+		node->type = type;
+		_ccv_cache_lru_push(cache->lru + type, node);
+		cache->origin.terminal.off = (uint64_t)node | 0x1;
 		cache->origin.terminal.sign = sign;
-		cache->origin.terminal.type = CCV_SET_TERMINAL_TYPE(type, cache->age, size);
 		cache->size = size;
 		cache->rnum = 1;
 		return 0;
 	}
-	++cache->age;
 	int i, depth = -1;
 	ccv_cache_index_t* branch = _ccv_cache_seek(&cache->origin, sign, &depth);
 	if (!branch)
@@ -241,16 +190,22 @@ int ccv_cache_put(ccv_cache_t* cache, uint64_t sign, void* x, uint32_t size, uin
 	{
 		if (sign == branch->terminal.sign)
 		{
-			cache->ffree[CCV_GET_CACHE_TYPE(branch->terminal.type)]((void*)(branch->terminal.off - (branch->terminal.off & 0x3)));
-			branch->terminal.off = (uint64_t)x | 0x1;
-			uint32_t old_size = CCV_GET_TERMINAL_SIZE(branch->terminal.type);
-			cache->size = cache->size + size - old_size;
-			branch->terminal.type = CCV_SET_TERMINAL_TYPE(type, cache->age, size);
-			_ccv_cache_aging(&cache->origin, sign);
+			ccv_cache_node_t* node = (ccv_cache_node_t*)(branch->terminal.off - (branch->terminal.off & 0x3));
+			// the old object is replaced, it departs the cache
+			++cache->evictions;
+			++cache->departures;
+			cache->lifetime += cache->age - node->age;
+			cache->ffree[node->type](node->x);
+			_ccv_cache_lru_unlink(cache->lru + node->type, node);
+			cache->size = cache->size + size - node->size;
+			node->x = x;
+			node->age = cache->age;
+			node->size = size;
+			node->type = type;
+			_ccv_cache_lru_push(cache->lru + type, node);
 			return 1;
 		} else {
 			ccv_cache_index_t t = *branch;
-			uint32_t age = CCV_GET_TERMINAL_AGE(branch->terminal.type);
 			uint64_t j = 63;
 			j = j << (depth * 6);
 			int dice, udice;
@@ -265,7 +220,6 @@ int ccv_cache_put(ccv_cache_t* cache, uint64_t sign, void* x, uint32_t size, uin
 					ccv_cache_index_t* set = (ccv_cache_index_t*)ccmalloc(sizeof(ccv_cache_index_t));
 					assert(((uint64_t)set & 0x3) == 0);
 					branch->branch.set = (uint64_t)set;
-					branch->branch.age = age;
 					branch = set;
 				} else {
 					break;
@@ -276,11 +230,8 @@ int ccv_cache_put(ccv_cache_t* cache, uint64_t sign, void* x, uint32_t size, uin
 			ccv_cache_index_t* set = (ccv_cache_index_t*)ccmalloc(sizeof(ccv_cache_index_t) * 2);
 			assert(((uint64_t)set & 0x3) == 0);
 			branch->branch.set = (uint64_t)set;
-			branch->branch.age = age;
 			int u = dice < udice;
-			set[u].terminal.sign = sign;
-			set[u].terminal.off = (uint64_t)x | 0x1;
-			set[u].terminal.type = CCV_SET_TERMINAL_TYPE(type, cache->age, size);
+			branch = set + u;
 			set[1 - u] = t;
 		}
 	} else {
@@ -294,14 +245,22 @@ int ccv_cache_put(ccv_cache_t* cache, uint64_t sign, void* x, uint32_t size, uin
 		assert(((uint64_t)set & 0x3) == 0);
 		for (i = total; i > start; i--)
 			set[i] = set[i - 1];
-		set[start].terminal.off = (uint64_t)x | 0x1;
-		set[start].terminal.sign = sign;
-		set[start].terminal.type = CCV_SET_TERMINAL_TYPE(type, cache->age, size);
 		branch->branch.set = (uint64_t)set;
 		branch->branch.bitmap |= k;
 		if (total == 63)
 			branch->branch.set |= 0x2;
+		branch = set + start;
 	}
+	ccv_cache_node_t* node = (ccv_cache_node_t*)ccmalloc(sizeof(ccv_cache_node_t));
+	assert(((uint64_t)node & 0x3) == 0);
+	node->sign = sign;
+	node->x = x;
+	node->age = cache->age;
+	node->size = size;
+	node->type = type;
+	_ccv_cache_lru_push(cache->lru + type, node);
+	branch->terminal.off = (uint64_t)node | 0x1;
+	branch->terminal.sign = sign;
 	cache->rnum++;
 	cache->size += size;
 	return 0;
@@ -324,27 +283,8 @@ static void _ccv_cache_cleanup(ccv_cache_index_t* branch)
 	}
 }
 
-static void _ccv_cache_cleanup_and_free(ccv_cache_index_t* branch, ccv_cache_index_free_f ffree[])
+static void* _ccv_cache_remove(ccv_cache_t* cache, uint64_t sign, uint8_t* type)
 {
-	int leaf = branch->terminal.off & 0x1;
-	if (!leaf)
-	{
-		int i;
-		uint64_t total = compute_bits(branch->branch.bitmap);
-		ccv_cache_index_t* set = (ccv_cache_index_t*)(branch->branch.set - (branch->branch.set & 0x3));
-		for (i = 0; i < total; i++)
-			_ccv_cache_cleanup_and_free(set + i, ffree);
-		ccfree(set);
-	} else {
-		assert(CCV_GET_CACHE_TYPE(branch->terminal.type) >= 0 && CCV_GET_CACHE_TYPE(branch->terminal.type) < 16);
-		ffree[CCV_GET_CACHE_TYPE(branch->terminal.type)]((void*)(branch->terminal.off - (branch->terminal.off & 0x3)));
-	}
-}
-
-void* ccv_cache_out(ccv_cache_t* cache, uint64_t sign, uint8_t* type)
-{
-	if (!bits_in_16bits_init)
-		precomputed_16bits();
 	if (cache->rnum == 0)
 		return 0;
 	int i, found = 0, depth = -1;
@@ -390,10 +330,15 @@ void* ccv_cache_out(ccv_cache_t* cache, uint64_t sign, uint8_t* type)
 		return 0;
 	if (branch->terminal.sign != sign)
 		return 0;
-	void* result = (void*)(branch->terminal.off - (branch->terminal.off & 0x3));
+	ccv_cache_node_t* node = (ccv_cache_node_t*)(branch->terminal.off - (branch->terminal.off & 0x3));
+	void* result = node->x;
 	if (type)
-		*type = CCV_GET_CACHE_TYPE(branch->terminal.type);
-	uint32_t size = CCV_GET_TERMINAL_SIZE(branch->terminal.type);
+		*type = node->type;
+	uint32_t size = node->size;
+	++cache->departures;
+	cache->lifetime += cache->age - node->age;
+	_ccv_cache_lru_unlink(cache->lru + node->type, node);
+	ccfree(node);
 	if (branch != &cache->origin)
 	{
 		uint64_t k = 1, j = 63;
@@ -416,20 +361,30 @@ void* ccv_cache_out(ccv_cache_t* cache, uint64_t sign, uint8_t* type)
 			_ccv_cache_cleanup(uncle);
 			*uncle = t;
 		}
-		_ccv_cache_aging(&cache->origin, sign);
 	} else {
-		// if I only have one item, reset age to 1
-		cache->age = 1;
+		// if I only have one item, reset age to 0
+		cache->age = 0;
+		memset(&cache->origin, 0, sizeof(ccv_cache_index_t));
 	}
 	cache->rnum--;
 	cache->size -= size;
 	return result;
 }
 
+void* ccv_cache_out(ccv_cache_t* cache, uint64_t sign, uint8_t* type)
+{
+	void* result = _ccv_cache_remove(cache, sign, type);
+	if (result)
+		++cache->hits;
+	else
+		++cache->misses;
+	return result;
+}
+
 int ccv_cache_delete(ccv_cache_t* cache, uint64_t sign)
 {
 	uint8_t type = 0;
-	void* result = ccv_cache_out(cache, sign, &type);
+	void* result = _ccv_cache_remove(cache, sign, &type);
 	if (result != 0)
 	{
 		assert(type >= 0 && type < 16);
@@ -443,7 +398,22 @@ void ccv_cache_cleanup(ccv_cache_t* cache)
 {
 	if (cache->rnum > 0)
 	{
-		_ccv_cache_cleanup_and_free(&cache->origin, cache->ffree);
+		int i;
+		for (i = 0; i < cache->types; i++)
+		{
+			ccv_cache_node_t* node = cache->lru[i].head;
+			while (node)
+			{
+				ccv_cache_node_t* next = node->next;
+				cache->ffree[i](node->x);
+				ccfree(node);
+				node = next;
+			}
+			cache->lru[i].head = cache->lru[i].tail = 0;
+			cache->lru[i].size = 0;
+			cache->lru[i].rnum = 0;
+		}
+		_ccv_cache_cleanup(&cache->origin);
 		cache->size = 0;
 		cache->age = 0;
 		cache->rnum = 0;
@@ -10,12 +10,11 @@ void ccv_hog(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int b_type, int sbin
 	ccv_declare_derived_signature(sig, a->sig != 0, ccv_sign_with_format(64, "ccv_hog(%d,%d)", sbin, size), a->sig, CCV_EOF_SIGN);
 	ccv_dense_matrix_t* db = *b = ccv_dense_matrix_renew(*b, rows, cols, CCV_64F | CCV_32F | (4 + sbin * 3), b_type, sig);
 	ccv_object_return_if_cached(, db);
-	ccv_dense_matrix_t* ag = 0;
-	ccv_dense_matrix_t* mg = 0;
-	ccv_gradient(a, &ag, 0, &mg, 0, 1, 1);
-	float* agp = ag->data.f32;
-	float* mgp = mg->data.f32;
-	int i, j, k, ch = CCV_GET_CHANNEL(a->type);
+	// orientation (in bins) and magnitude of the strongest channel at each pixel, in one pass
+	ccv_dense_matrix_t* gb = 0;
+	ccv_gradient_bin(a, &gb, sbin * 2);
+	float* gbp = gb->data.f32;
+	int i, j, k;
 	ccv_dense_matrix_t* cn = ccv_dense_matrix_new(rows, cols, CCV_GET_DATA_TYPE(db->type) | (sbin * 2), 0, 0);
 	ccv_dense_matrix_t* ca = ccv_dense_matrix_new(rows, cols, CCV_GET_DATA_TYPE(db->type) | CCV_C1, 0, 0);
 	ccv_zero(cn);
@@ -44,15 +43,8 @@ void ccv_hog(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int b_type, int sbin
 	{ \
 		for (j = 0; j < cols * size; j++) \
 		{ \
-			_for_type agv = agp[j * ch]; \
-			_for_type mgv = mgp[j * ch]; \
-			for (k = 1; k < ch; k++) \
-				if (mgp[j * ch + k] > mgv) \
-				{ \
-					mgv = mgp[j * ch + k]; \
-					agv = agp[j * ch + k]; \
-				} \
-			_for_type agr0 = (ccv_clamp(agv, 0, 359.99) / 360.0) * (sbin * 2); \
+			_for_type agr0 = gbp[j * 2]; \
+			_for_type mgv = gbp[j * 2 + 1]; \
 			int ag0 = (int)agr0; \
 			int ag1 = (ag0 + 1 < sbin * 2) ? ag0 + 1 : 0; \
 			agr0 = agr0 - ag0; \
@@ -89,11 +81,9 @@ void ccv_hog(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int b_type, int sbin
 				cnp[(iyp + 1) * cn->cols * sbin * 2 + (ixp + 1) * sbin * 2 + ag1] += agr0 * vx0 * vy0 * mgv; \
 			} \
 		} \
-		agp += a->cols * ch; \
-		mgp += a->cols * ch; \
+		gbp += gb->cols * 2; \
 	} \
-	ccv_matrix_free(ag); \
-	ccv_matrix_free(mg); \
+	ccv_matrix_free(gb); \
 	cnp = (_for_type*)ccv_get_dense_matrix_cell(cn, 0, 0, 0); \
 	_for_type* cap = (_for_type*)ccv_get_dense_matrix_cell(ca, 0, 0, 0); \
 	for (i = 0; i < rows; i++) \
@@ -1684,6 +1684,21 @@ ccv_convnet_t* ccv_convnet_read(int use_cwc_accel, const char* filename)
 
 void ccv_convnet_input_formation(ccv_size_t input, ccv_dense_matrix_t* a, ccv_dense_matrix_t** b)
 {
+	if (CCV_GET_DATA_TYPE(a->type) == CCV_8U)
+	{
+		// convert and resample in one pass
+		int type = CCV_INTER_AREA;
+		int rows = a->rows, cols = a->cols;
+		if ((a->rows > input.height && a->cols > input.width) || a->rows < input.height || a->cols < input.width)
+		{
+			rows = ccv_max(input.height, (int)(a->rows * (float)input.height / a->cols + 0.5));
+			cols = ccv_max(input.width, (int)(a->cols * (float)input.width / a->rows + 0.5));
+			type = (a->rows > input.height && a->cols > input.width) ? CCV_INTER_AREA : CCV_INTER_CUBIC;
+		}
+		ccv_dense_matrix_t* db = *b = ccv_dense_matrix_renew(*b, rows, cols, CCV_32F | CCV_GET_CHANNEL(a->type), CCV_32F | CCV_GET_CHANNEL(a->type), 0);
+		ccv_resample_normalize(a, db->data.f32, rows, cols, type, 0, 0);
+		return;
+	}
 	if (a->rows > input.height && a->cols > input.width)
 		ccv_resample(a, b, CCV_32F, ccv_max(input.height, (int)(a->rows * (float)input.height / a->cols + 0.5)), ccv_max(input.width, (int)(a->cols * (float)input.width / a->rows + 0.5)), CCV_INTER_AREA);
 	else if (a->rows < input.height || a->cols < input.width)
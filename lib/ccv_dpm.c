@@ -42,41 +42,52 @@ static int _ccv_dpm_scale_upto(ccv_dense_matrix_t* a, ccv_dpm_mixture_model_t**
 	return (int)(log((double)ccv_min(hr, wr)) / log(scale)) - next;
 }
 
-static void _ccv_dpm_feature_pyramid(ccv_dense_matrix_t* a, ccv_dense_matrix_t** pyr, int scale_upto, int interval)
+static void _ccv_dpm_feature_pyramid(ccv_dense_matrix_t* a, ccv_pyramid_t* pyramid, ccv_dense_matrix_t** pyr, int scale_upto, int interval)
 {
 	int next = interval + 1;
-	double scale = pow(2.0, 1.0 / (interval + 1.0));
-	memset(pyr, 0, (scale_upto + next * 2) * sizeof(ccv_dense_matrix_t*));
-	pyr[next] = a;
-	int i;
-	for (i = 1; i <= interval; i++)
-		ccv_resample(pyr[next], &pyr[next + i], 0, (int)(pyr[next]->rows / pow(scale, i)), (int)(pyr[next]->cols / pow(scale, i)), CCV_INTER_AREA);
-	for (i = next; i < scale_upto + next; i++)
-		ccv_sample_down(pyr[i], &pyr[i + next], 0, 0, 0);
+	ccv_pyramid_t* image_pyramid = pyramid ? pyramid : ccv_pyramid_new();
+	ccv_pyramid(a, image_pyramid, interval, scale_upto + next, 0);
 	ccv_dense_matrix_t* hog;
+	int i;
 	/* a more efficient way to generate up-scaled hog (using smaller size) */
 	for (i = 0; i < next; i++)
 	{
 		hog = 0;
-		ccv_hog(pyr[i + next], &hog, 0, 9, CCV_DPM_WINDOW_SIZE / 2 /* this is */);
+		ccv_hog(ccv_pyramid_level(image_pyramid, i), &hog, 0, 9, CCV_DPM_WINDOW_SIZE / 2 /* this is */);
 		pyr[i] = hog;
 	}
-	hog = 0;
-	ccv_hog(pyr[next], &hog, 0, 9, CCV_DPM_WINDOW_SIZE);
-	pyr[next] = hog;
-	for (i = next + 1; i < scale_upto + next * 2; i++)
+	for (i = next; i < scale_upto + next * 2; i++)
 	{
 		hog = 0;
-		ccv_hog(pyr[i], &hog, 0, 9, CCV_DPM_WINDOW_SIZE);
-		ccv_matrix_free(pyr[i]);
+		ccv_hog(ccv_pyramid_level(image_pyramid, i - next), &hog, 0, 9, CCV_DPM_WINDOW_SIZE);
 		pyr[i] = hog;
 	}
+	if (!pyramid)
+		ccv_pyramid_free(image_pyramid);
+}
+
+/* filter banks for the root filter and the part filters, thus, their plans and transforms are reused across the pyramid */
+static void _ccv_dpm_filter_banks_new(ccv_dpm_root_classifier_t* root_classifier, ccv_filter_bank_t** banks)
+{
+	int i;
+	ccv_dense_matrix_t* w[CCV_DPM_PART_MAX];
+	for (i = 0; i < root_classifier->count; i++)
+		w[i] = root_classifier->part[i].w;
+	banks[0] = ccv_filter_bank_new(&root_classifier->root.w, 1);
+	banks[1] = root_classifier->count > 0 ? ccv_filter_bank_new(w, root_classifier->count) : 0;
+}
+
+static void _ccv_dpm_filter_banks_free(ccv_filter_bank_t** banks)
+{
+	ccv_filter_bank_free(banks[0]);
+	if (banks[1])
+		ccv_filter_bank_free(banks[1]);
 }
 
-static void _ccv_dpm_compute_score(ccv_dpm_root_classifier_t* root_classifier, ccv_dense_matrix_t* hog, ccv_dense_matrix_t* hog2x, ccv_dense_matrix_t** _response, ccv_dense_matrix_t** part_feature, ccv_dense_matrix_t** dx, ccv_dense_matrix_t** dy)
+static void _ccv_dpm_compute_score(ccv_dpm_root_classifier_t* root_classifier, ccv_filter_bank_t** banks, ccv_dense_matrix_t* hog, ccv_dense_matrix_t* hog2x, ccv_dense_matrix_t** _response, ccv_dense_matrix_t** part_feature, ccv_dense_matrix_t** dx, ccv_dense_matrix_t** dy)
 {
 	ccv_dense_matrix_t* response = 0;
-	ccv_filter(hog, root_classifier->root.w, &response, 0, CCV_NO_PADDING);
+	ccv_filter_bank(hog, banks[0], &response, 0, CCV_NO_PADDING);
 	ccv_dense_matrix_t* root_feature = 0;
 	ccv_flatten(response, (ccv_matrix_t**)&root_feature, 0, 0);
 	ccv_matrix_free(response);
@@ -87,17 +98,31 @@ static void _ccv_dpm_compute_score(ccv_dpm_root_classifier_t* root_classifier, c
 	int rwh = (root_classifier->root.w->rows - 1) / 2, rww = (root_classifier->root.w->cols - 1) / 2;
 	int rwh_1 = root_classifier->root.w->rows / 2, rww_1 = root_classifier->root.w->cols / 2;
 	int i, x, y;
+	// all the part filters are of the same size usually, thus, hog2x is transformed only once for all of them
+	ccv_dense_matrix_t* responses[CCV_DPM_PART_MAX];
+	for (i = 0; i < root_classifier->count; i++)
+		responses[i] = 0;
+	if (root_classifier->count > 0)
+		ccv_filter_bank(hog2x, banks[1], responses, 0, CCV_NO_PADDING);
+	ccv_dense_matrix_t* features[CCV_DPM_PART_MAX];
+	for (i = 0; i < root_classifier->count; i++)
+	{
+		features[i] = 0;
+		ccv_flatten(responses[i], (ccv_matrix_t**)&features[i], 0, 0);
+		ccv_matrix_free(responses[i]);
+		/* allocated upfront, thus, the distance transforms of all the parts can run at once without touching the cache */
+		part_feature[i] = ccv_dense_matrix_new(features[i]->rows, features[i]->cols, CCV_32F | CCV_C1, 0, 0);
+		dx[i] = ccv_dense_matrix_new(features[i]->rows, features[i]->cols, CCV_32S | CCV_C1, 0, 0);
+		dy[i] = ccv_dense_matrix_new(features[i]->rows, features[i]->cols, CCV_32S | CCV_C1, 0, 0);
+	}
+	parallel_for(k, root_classifier->count) {
+		ccv_dpm_part_classifier_t* part = root_classifier->part + k;
+		ccv_distance_transform(features[k], &part_feature[k], 0, &dx[k], 0, &dy[k], 0, part->dx, part->dy, part->dxx, part->dyy, CCV_NEGATIVE | CCV_GSEDT);
+	} parallel_endfor
 	for (i = 0; i < root_classifier->count; i++)
 	{
 		ccv_dpm_part_classifier_t* part = root_classifier->part + i;
-		ccv_dense_matrix_t* response = 0;
-		ccv_filter(hog2x, part->w, &response, 0, CCV_NO_PADDING);
-		ccv_dense_matrix_t* feature = 0;
-		ccv_flatten(response, (ccv_matrix_t**)&feature, 0, 0);
-		ccv_matrix_free(response);
-		part_feature[i] = dx[i] = dy[i] = 0;
-		ccv_distance_transform(feature, &part_feature[i], 0, &dx[i], 0, &dy[i], 0, part->dx, part->dy, part->dxx, part->dyy, CCV_NEGATIVE | CCV_GSEDT);
-		ccv_matrix_free(feature);
+		ccv_matrix_free(features[i]);
 		int pwh = (part->w->rows - 1) / 2, pww = (part->w->cols - 1) / 2;
 		int offy = part->y + pwh - rwh * 2;
 		int miny = pwh, maxy = part_feature[i]->rows - part->w->rows + pwh;
@@ -849,12 +874,14 @@ static ccv_dpm_feature_vector_t* _ccv_dpm_collect_best(ccv_dense_matrix_t* image
 	if (scale_upto < 0)
 		return 0;
 	ccv_dense_matrix_t** pyr = (ccv_dense_matrix_t**)alloca((scale_upto + next * 2) * sizeof(ccv_dense_matrix_t*));
-	_ccv_dpm_feature_pyramid(image, pyr, scale_upto, params.interval);
+	_ccv_dpm_feature_pyramid(image, params.pyramid, pyr, scale_upto, params.interval);
 	float best = -FLT_MAX;
 	ccv_dpm_feature_vector_t* v = 0;
 	for (i = 0; i < model->count; i++)
 	{
 		ccv_dpm_root_classifier_t* root_classifier = model->root + i;
+		ccv_filter_bank_t* banks[2];
+		_ccv_dpm_filter_banks_new(root_classifier, banks);
 		double scale_x = 1.0;
 		double scale_y = 1.0;
 		for (j = next; j < scale_upto + next * 2; j++)
@@ -871,7 +898,7 @@ static ccv_dpm_feature_vector_t* _ccv_dpm_collect_best(ccv_dense_matrix_t* image
 			ccv_dense_matrix_t* part_feature[CCV_DPM_PART_MAX];
 			ccv_dense_matrix_t* dx[CCV_DPM_PART_MAX];
 			ccv_dense_matrix_t* dy[CCV_DPM_PART_MAX];
-			_ccv_dpm_compute_score(root_classifier, pyr[j], pyr[j - next], &root_feature, part_feature, dx, dy);
+			_ccv_dpm_compute_score(root_classifier, banks, pyr[j], pyr[j - next], &root_feature, part_feature, dx, dy);
 			int rwh = (root_classifier->root.w->rows - 1) / 2, rww = (root_classifier->root.w->cols - 1) / 2;
 			int rwh_1 = root_classifier->root.w->rows / 2, rww_1 = root_classifier->root.w->cols / 2;
 			float* f_ptr = (float*)ccv_get_dense_matrix_cell_by(CCV_32F | CCV_C1, root_feature, rwh, 0, 0);
@@ -914,6 +941,7 @@ static ccv_dpm_feature_vector_t* _ccv_dpm_collect_best(ccv_dense_matrix_t* image
 			scale_x *= scale;
 			scale_y *= scale;
 		}
+		_ccv_dpm_filter_banks_free(banks);
 	}
 	for (i = 0; i < scale_upto + next * 2; i++)
 		ccv_matrix_free(pyr[i]);
@@ -929,7 +957,7 @@ static ccv_array_t* _ccv_dpm_collect_all(gsl_rng* rng, ccv_dense_matrix_t* image
 	if (scale_upto < 0)
 		return 0;
 	ccv_dense_matrix_t** pyr = (ccv_dense_matrix_t**)alloca((scale_upto + next * 2) * sizeof(ccv_dense_matrix_t*));
-	_ccv_dpm_feature_pyramid(image, pyr, scale_upto, params.interval);
+	_ccv_dpm_feature_pyramid(image, params.pyramid, pyr, scale_upto, params.interval);
 	ccv_array_t* av = ccv_array_new(sizeof(ccv_dpm_feature_vector_t*), 64, 0);
 	int enough = 64 / model->count;
 	int* order = (int*)alloca(sizeof(int) * model->count);
@@ -939,6 +967,8 @@ static ccv_array_t* _ccv_dpm_collect_all(gsl_rng* rng, ccv_dense_matrix_t* image
 	for (i = 0; i < model->count; i++)
 	{
 		ccv_dpm_root_classifier_t* root_classifier = model->root + order[i];
+		ccv_filter_bank_t* banks[2];
+		_ccv_dpm_filter_banks_new(root_classifier, banks);
 		double scale_x = 1.0;
 		double scale_y = 1.0;
 		for (j = next; j < scale_upto + next * 2; j++)
@@ -947,7 +977,7 @@ static ccv_array_t* _ccv_dpm_collect_all(gsl_rng* rng, ccv_dense_matrix_t* image
 			ccv_dense_matrix_t* part_feature[CCV_DPM_PART_MAX];
 			ccv_dense_matrix_t* dx[CCV_DPM_PART_MAX];
 			ccv_dense_matrix_t* dy[CCV_DPM_PART_MAX];
-			_ccv_dpm_compute_score(root_classifier, pyr[j], pyr[j - next], &root_feature, part_feature, dx, dy);
+			_ccv_dpm_compute_score(root_classifier, banks, pyr[j], pyr[j - next], &root_feature, part_feature, dx, dy);
 			int rwh = (root_classifier->root.w->rows - 1) / 2, rww = (root_classifier->root.w->cols - 1) / 2;
 			int rwh_1 = root_classifier->root.w->rows / 2, rww_1 = root_classifier->root.w->cols / 2;
 			float* f_ptr = (float*)ccv_get_dense_matrix_cell_by(CCV_32F | CCV_C1, root_feature, rwh, 0, 0);
@@ -982,6 +1012,7 @@ static ccv_array_t* _ccv_dpm_collect_all(gsl_rng* rng, ccv_dense_matrix_t* image
 			if (av->rnum >= enough * (i + 1))
 				break;
 		}
+		_ccv_dpm_filter_banks_free(banks);
 	}
 	for (i = 0; i < scale_upto + next * 2; i++)
 		ccv_matrix_free(pyr[i]);
@@ -2051,7 +2082,7 @@ ccv_array_t* ccv_dpm_detect_objects(ccv_dense_matrix_t* a, ccv_dpm_mixture_model
 	if (scale_upto < 0) // image is too small to be interesting
 		return 0;
 	ccv_dense_matrix_t** pyr = (ccv_dense_matrix_t**)alloca((scale_upto + next * 2) * sizeof(ccv_dense_matrix_t*));
-	_ccv_dpm_feature_pyramid(a, pyr, scale_upto, params.interval);
+	_ccv_dpm_feature_pyramid(a, params.pyramid, pyr, scale_upto, params.interval);
 	ccv_array_t* idx_seq;
 	ccv_array_t* seq = ccv_array_new(sizeof(ccv_root_comp_t), 64, 0);
 	ccv_array_t* seq2 = ccv_array_new(sizeof(ccv_root_comp_t), 64, 0);
@@ -2059,6 +2090,9 @@ ccv_array_t* ccv_dpm_detect_objects(ccv_dense_matrix_t* a, ccv_dpm_mixture_model
 	for (c = 0; c < count; c++)
 	{
 		ccv_dpm_mixture_model_t* model = _model[c];
+		ccv_filter_bank_t** banks = (ccv_filter_bank_t**)ccmalloc(sizeof(ccv_filter_bank_t*) * 2 * model->count);
+		for (j = 0; j < model->count; j++)
+			_ccv_dpm_filter_banks_new(model->root + j, banks + j * 2);
 		double scale_x = 1.0;
 		double scale_y = 1.0;
 		for (i = next; i < scale_upto + next * 2; i++)
@@ -2070,7 +2104,7 @@ ccv_array_t* ccv_dpm_detect_objects(ccv_dense_matrix_t* a, ccv_dpm_mixture_model
 				ccv_dense_matrix_t* part_feature[CCV_DPM_PART_MAX];
 				ccv_dense_matrix_t* dx[CCV_DPM_PART_MAX];
 				ccv_dense_matrix_t* dy[CCV_DPM_PART_MAX];
-				_ccv_dpm_compute_score(root, pyr[i], pyr[i - next], &root_feature, part_feature, dx, dy);
+				_ccv_dpm_compute_score(root, banks + j * 2, pyr[i], pyr[i - next], &root_feature, part_feature, dx, dy);
 				int rwh = (root->root.w->rows - 1) / 2, rww = (root->root.w->cols - 1) / 2;
 				int rwh_1 = root->root.w->rows / 2, rww_1 = root->root.w->cols / 2;
 				/* these values are designed to make sure works with odd/even number of rows/cols
@@ -2128,6 +2162,9 @@ ccv_array_t* ccv_dpm_detect_objects(ccv_dense_matrix_t* a, ccv_dpm_mixture_model
 			scale_x *= scale;
 			scale_y *= scale;
 		}
+		for (j = 0; j < model->count; j++)
+			_ccv_dpm_filter_banks_free(banks + j * 2);
+		ccfree(banks);
 		/* the following code from OpenCV's haar feature implementation */
 		if (params.min_neighbors == 0)
 		{
@@ -17,6 +17,7 @@ const ccv_icf_param_t ccv_icf_default_params = {
 	.step_through = 2,
 	.flags = 0,
 	.interval = 8,
+	.approximate = 0,
 };
 
 // this uses a look up table for cubic root computation because rgb to luv only requires data within range of 0~1
@@ -321,14 +322,13 @@ void ccv_icf(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type)
 	ccv_declare_derived_signature(sig, a->sig != 0, ccv_sign_with_literal("ccv_icf"), a->sig, CCV_EOF_SIGN);
 	ccv_dense_matrix_t* db = *b = ccv_dense_matrix_renew(*b, a->rows, a->cols, CCV_32F | nchr, CCV_32F | nchr, sig);
 	ccv_object_return_if_cached(, db);
-	ccv_dense_matrix_t* ag = 0;
-	ccv_dense_matrix_t* mg = 0;
-	ccv_gradient(a, &ag, 0, &mg, 0, 1, 1);
-	float* agp = ag->data.f32;
-	float* mgp = mg->data.f32;
+	// 12 bins over 360 degree, thus, the direction-insensitive 6 bins are the bin modulo 6
+	ccv_dense_matrix_t* gb = 0;
+	ccv_gradient_bin(a, &gb, 12);
+	float* gbp = gb->data.f32;
 	float* dbp = db->data.f32;
 	ccv_zero(db);
-	int i, j, k;
+	int i, j;
 	unsigned char* a_ptr = a->data.u8;
 	float magnitude_scaling = 1 / sqrtf(2); // regularize it to 0~1
 	if (ch == 1)
@@ -339,8 +339,8 @@ void ccv_icf(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type)
 			for (j = 0; j < a->cols; j++) \
 			{ \
 				dbp[0] = _for_get(a_ptr, j, 0); \
-				dbp[1] = mgp[j] * magnitude_scaling; \
-				float agr = (ccv_clamp(agp[j] <= 180 ? agp[j] : agp[j] - 180, 0, 179.99) / 180.0) * 6; \
+				dbp[1] = gbp[j * 2 + 1] * magnitude_scaling; \
+				float agr = ccv_min(gbp[j * 2] <= 6 ? gbp[j * 2] : gbp[j * 2] - 6, 179.99 / 30); \
 				int ag0 = (int)agr; \
 				int ag1 = ag0 < 5 ? ag0 + 1 : 0; \
 				agr = agr - ag0; \
@@ -349,8 +349,7 @@ void ccv_icf(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type)
 				dbp += 8; \
 			} \
 			a_ptr += a->step; \
-			agp += a->cols; \
-			mgp += a->cols; \
+			gbp += a->cols * 2; \
 		}
 		ccv_matrix_getter(a->type, for_block);
 #undef for_block
@@ -365,18 +364,8 @@ void ccv_icf(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type)
 								_for_get(a_ptr, j * ch + 1, 0) / 255.0, \
 								_for_get(a_ptr, j * ch + 2, 0) / 255.0, \
 								dbp, dbp + 1, dbp + 2); \
-				float agv = agp[j * ch]; \
-				float mgv = mgp[j * ch]; \
-				for (k = 1; k < ch; k++) \
-				{ \
-					if (mgp[j * ch + k] > mgv) \
-					{ \
-						mgv = mgp[j * ch + k]; \
-						agv = agp[j * ch + k]; \
-					} \
-				} \
-				dbp[3] = mgv * magnitude_scaling; \
-				float agr = (ccv_clamp(agv <= 180 ? agv : agv - 180, 0, 179.99) / 180.0) * 6; \
+				dbp[3] = gbp[j * 2 + 1] * magnitude_scaling; \
+				float agr = ccv_min(gbp[j * 2] <= 6 ? gbp[j * 2] : gbp[j * 2] - 6, 179.99 / 30); \
 				int ag0 = (int)agr; \
 				int ag1 = ag0 < 5 ? ag0 + 1 : 0; \
 				agr = agr - ag0; \
@@ -385,14 +374,12 @@ void ccv_icf(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type)
 				dbp += 10; \
 			} \
 			a_ptr += a->step; \
-			agp += a->cols * ch; \
-			mgp += a->cols * ch; \
+			gbp += a->cols * 2; \
 		}
 		ccv_matrix_getter(a->type, for_block);
 #undef for_block
 	}
-	ccv_matrix_free(ag);
-	ccv_matrix_free(mg);
+	ccv_matrix_free(gb);
 }
 
 static inline float _ccv_icf_run_feature(ccv_icf_feature_t* feature, float* ptr, int cols, int ch, int x, int y)
@@ -457,7 +444,7 @@ static void _ccv_icf_check_params(ccv_icf_new_param_t params)
 	assert(params.acceptance > 0 && params.acceptance < 1.0);
 }
 
-static ccv_dense_matrix_t* _ccv_icf_capture_feature(gsl_rng* rng, ccv_dense_matrix_t* image, ccv_decimal_pose_t pose, ccv_size_t size, ccv_margin_t margin, float deform_angle, float deform_scale, float deform_shift)
+static ccv_warp_t _ccv_icf_capture_warp(gsl_rng* rng, ccv_dense_matrix_t* image, ccv_decimal_pose_t pose, ccv_size_t size, ccv_margin_t margin, float deform_angle, float deform_scale, float deform_shift)
 {
 	float rotate_x = (deform_angle * 2 * gsl_rng_uniform(rng) - deform_angle) * CCV_PI / 180 + pose.pitch;
 	float rotate_y = (deform_angle * 2 * gsl_rng_uniform(rng) - deform_angle) * CCV_PI / 180 + pose.yaw;
@@ -475,24 +462,30 @@ static ccv_dense_matrix_t* _ccv_icf_capture_feature(gsl_rng* rng, ccv_dense_matr
 	float m20 = (sinf(rotate_y) * cosf(rotate_z) + sinf(rotate_x) * sinf(rotate_z)) * scale;
 	float m21 = (sinf(rotate_y) * sinf(rotate_z) - sinf(rotate_x) * cosf(rotate_z)) * scale;
 	float m22 = cosf(rotate_x) * cosf(rotate_y);
-	ccv_dense_matrix_t* b = 0;
-	ccv_perspective_transform(image, &b, 0, m00, m01, m02, m10, m11, m12, m20, m21, m22);
-	ccv_dense_matrix_t* resize = 0;
 	// have 1px border around the grayscale image because we need these to compute correct gradient feature
 	ccv_size_t scale_size = {
 		.width = (int)((size.width + margin.left + margin.right + 2) / scale_ratio + 0.5),
 		.height = (int)((size.height + margin.top + margin.bottom + 2) / scale_ratio + 0.5),
 	};
 	assert(scale_size.width > 0 && scale_size.height > 0);
-	ccv_slice(b, (ccv_matrix_t**)&resize, 0, (int)(b->rows * 0.5 - (size.height + margin.top + margin.bottom + 2) / scale_ratio * 0.5 + 0.5), (int)(b->cols * 0.5 - (size.width + margin.left + margin.right + 2) / scale_ratio * 0.5 + 0.5), scale_size.height, scale_size.width);
-	ccv_matrix_free(b);
-	b = 0;
-	if (scale_ratio > 1)
-		ccv_resample(resize, &b, 0, size.height + margin.top + margin.bottom + 2, size.width + margin.left + margin.right + 2, CCV_INTER_CUBIC);
-	else
-		ccv_resample(resize, &b, 0, size.height + margin.top + margin.bottom + 2, size.width + margin.left + margin.right + 2, CCV_INTER_AREA);
-	ccv_matrix_free(resize);
-	return b;
+	// only warp the window around the pose, rather than the whole image
+	return ccv_perspective_warp(image, 0, (int)(image->rows * 0.5 - (size.height + margin.top + margin.bottom + 2) / scale_ratio * 0.5 + 0.5), (int)(image->cols * 0.5 - (size.width + margin.left + margin.right + 2) / scale_ratio * 0.5 + 0.5), scale_size.height, scale_size.width, m00, m01, m02, m10, m11, m12, m20, m21, m22);
+}
+
+static void _ccv_icf_capture_features(ccv_warp_t* warps, int count, ccv_size_t size, ccv_margin_t margin, ccv_array_t* features)
+{
+	ccv_warp(warps, count);
+	int i;
+	for (i = 0; i < count; i++)
+	{
+		ccv_dense_matrix_t* b = 0;
+		// area to downsample, cubic to upsample
+		ccv_resample(warps[i].b, &b, 0, size.height + margin.top + margin.bottom + 2, size.width + margin.left + margin.right + 2, CCV_INTER_AREA | CCV_INTER_CUBIC);
+		ccv_matrix_free(warps[i].b);
+		b->sig = 0;
+		ccv_array_push(features, b);
+		ccv_matrix_free(b);
+	}
 }
 
 typedef struct {
@@ -713,6 +706,7 @@ static void _ccv_icf_read_classifier_cascade_state(const char* directory, ccv_ic
 		state->classifier = (ccv_icf_classifier_cascade_t*)ccmalloc(sizeof(ccv_icf_classifier_cascade_t));
 		state->classifier->count = 0;
 		state->classifier->grayscale = state->params.grayscale;
+		memset(state->classifier->lambda, 0, sizeof(state->classifier->lambda));
 		state->classifier->weak_classifiers = (ccv_icf_decision_tree_t*)ccmalloc(sizeof(ccv_icf_decision_tree_t) * state->params.weak_classifier);
 	} else {
 		if (state->classifier->count < state->params.weak_classifier)
@@ -1107,10 +1101,8 @@ static ccv_array_t* _ccv_icf_collect_validates(gsl_rng* rng, ccv_size_t size, cc
 			PRINT(CCV_CLI_ERROR, "\n - %s: cannot be open, possibly corrupted\n", file_info->filename);
 			continue;
 		}
-		ccv_dense_matrix_t* feature = _ccv_icf_capture_feature(rng, image, file_info->pose, size, margin, 0, 0, 0);
-		feature->sig = 0;
-		ccv_array_push(validates, feature);
-		ccv_matrix_free(feature);
+		ccv_warp_t warp = _ccv_icf_capture_warp(rng, image, file_info->pose, size, margin, 0, 0, 0);
+		_ccv_icf_capture_features(&warp, 1, size, margin, validates);
 		ccv_matrix_free(image);
 	}
 	return validates;
@@ -1135,18 +1127,20 @@ static ccv_array_t* _ccv_icf_collect_positives(gsl_rng* rng, ccv_size_t size, cc
 				PRINT(CCV_CLI_ERROR, "\n - %s: cannot be open, possibly corrupted\n", file_info->filename);
 				continue;
 			}
+			// draw all the deformations of this image first, and warp them in one batch
+			ccv_warp_t* warps = (ccv_warp_t*)ccmalloc(sizeof(ccv_warp_t) * ((int)ratio + 1));
+			int count = 0;
 			for (q = 0; q < ratio; q++)
 				if (q < (int)ratio || gsl_rng_uniform(rng) <= ratio - (int)ratio)
 				{
 					FLUSH(CCV_CLI_INFO, " - collect positives %d%% (%d / %d)", (i + 1) * 100 / posnum, i + 1, posnum);
-					ccv_dense_matrix_t* feature = _ccv_icf_capture_feature(rng, image, file_info->pose, size, margin, deform_angle, deform_scale, deform_shift);
-					feature->sig = 0;
-					ccv_array_push(positives, feature);
-					ccv_matrix_free(feature);
+					warps[count++] = _ccv_icf_capture_warp(rng, image, file_info->pose, size, margin, deform_angle, deform_scale, deform_shift);
 					++i;
 					if (i >= posnum)
 						break;
 				}
+			_ccv_icf_capture_features(warps, count, size, margin, positives);
+			ccfree(warps);
 			ccv_matrix_free(image);
 		}
 	}
@@ -1521,6 +1515,8 @@ static ccv_array_t* _ccv_icf_collect_negatives(gsl_rng* rng, ccv_size_t size, cc
 			double max_scale_ratio = ccv_min((double)image->rows / size.height, (double)image->cols / size.width);
 			if (max_scale_ratio <= 0.5) // too small to be interesting
 				continue;
+			ccv_warp_t* warps = (ccv_warp_t*)ccmalloc(sizeof(ccv_warp_t) * ((int)ratio + 1));
+			int count = 0;
 			for (q = 0; q < ratio; q++)
 				if (q < (int)ratio || gsl_rng_uniform(rng) <= ratio - (int)ratio)
 				{
@@ -1532,14 +1528,13 @@ static ccv_array_t* _ccv_icf_collect_negatives(gsl_rng* rng, ccv_size_t size, cc
 					pose.x = gsl_rng_uniform_int(rng, ccv_max((int)(image->cols - pose.a * 2 + 1.5), 1)) + pose.a;
 					pose.y = gsl_rng_uniform_int(rng, ccv_max((int)(image->rows - pose.b * 2 + 1.5), 1)) + pose.b;
 					pose.roll = pose.pitch = pose.yaw = 0;
-					ccv_dense_matrix_t* feature = _ccv_icf_capture_feature(rng, image, pose, size, margin, deform_angle, deform_scale, deform_shift);
-					feature->sig = 0;
-					ccv_array_push(negatives, feature);
-					ccv_matrix_free(feature);
+					warps[count++] = _ccv_icf_capture_warp(rng, image, pose, size, margin, deform_angle, deform_scale, deform_shift);
 					++i;
 					if (i >= negnum)
 						break;
 				}
+			_ccv_icf_capture_features(warps, count, size, margin, negatives);
+			ccfree(warps);
 			ccv_matrix_free(image);
 		}
 	}
@@ -1805,6 +1800,82 @@ void ccv_icf_classifier_cascade_soft(ccv_icf_classifier_cascade_t* cascade, ccv_
 #endif
 }
 
+static int _ccv_icf_channel_mean(ccv_dense_matrix_t* a, double* mean)
+{
+	ccv_dense_matrix_t* icf = 0;
+	ccv_icf(a, &icf, 0);
+	int i, c, ch = CCV_GET_CHANNEL(icf->type);
+	for (c = 0; c < ch; c++)
+		mean[c] = 0;
+	float* ptr = icf->data.f32;
+	for (i = 0; i < icf->rows * icf->cols; i++, ptr += ch)
+		for (c = 0; c < ch; c++)
+			mean[c] += ptr[c];
+	for (c = 0; c < ch; c++)
+		mean[c] /= icf->rows * icf->cols;
+	ccv_matrix_free(icf);
+	return ch;
+}
+
+void ccv_icf_classifier_cascade_power_law(ccv_icf_classifier_cascade_t* cascade, ccv_array_t* files)
+{
+	/* see: Fast Feature Pyramids for Object Detection, Piotr Dollar et al. The mean of a channel on an image scaled down
+	 * by s is about s ^ lambda of the mean on the original one, thus, lambda is the least squares slope of the log ratio
+	 * of the means over log s, fitted on the scales within an octave */
+	const int scale_count = 8;
+	double xy[CCV_ICF_CHANNEL_MAX] = {0}, xx[CCV_ICF_CHANNEL_MAX] = {0};
+	double mean[CCV_ICF_CHANNEL_MAX], scaled[CCV_ICF_CHANNEL_MAX];
+	int i, j, c;
+	for (i = 0; i < files->rnum; i++)
+	{
+		FLUSH(CCV_CLI_INFO, " - estimate power law factors %d%% (%d / %d)", (i + 1) * 100 / files->rnum, i + 1, files->rnum);
+		ccv_file_info_t* file_info = (ccv_file_info_t*)ccv_array_get(files, i);
+		ccv_dense_matrix_t* image = 0;
+		ccv_read(file_info->filename, &image, CCV_IO_ANY_FILE | (cascade->grayscale ? CCV_IO_GRAY : CCV_IO_RGB_COLOR));
+		if (image == 0)
+		{
+			PRINT(CCV_CLI_ERROR, "\n - %s: cannot be open, possibly corrupted\n", file_info->filename);
+			continue;
+		}
+		int ch = _ccv_icf_channel_mean(image, mean);
+		for (j = 1; j <= scale_count; j++)
+		{
+			double s = pow(2., (double)j / scale_count);
+			int rows = (int)(image->rows / s + 0.5);
+			int cols = (int)(image->cols / s + 0.5);
+			if (rows < cascade->size.height || cols < cascade->size.width)
+				break;
+			ccv_dense_matrix_t* resampled = 0;
+			ccv_resample(image, &resampled, 0, rows, cols, CCV_INTER_AREA);
+			_ccv_icf_channel_mean(resampled, scaled);
+			ccv_matrix_free(resampled);
+			for (c = 0; c < ch; c++)
+				if (mean[c] > FLT_EPSILON && scaled[c] > FLT_EPSILON)
+				{
+					xy[c] += log(s) * log(scaled[c] / mean[c]);
+					xx[c] += log(s) * log(s);
+				}
+		}
+		ccv_matrix_free(image);
+	}
+	PRINT(CCV_CLI_INFO, "\n - power law factors:");
+	for (c = 0; c < CCV_ICF_CHANNEL_MAX; c++)
+	{
+		cascade->lambda[c] = xx[c] > 0 ? xy[c] / xx[c] : 0;
+		PRINT(CCV_CLI_INFO, " %f", cascade->lambda[c]);
+	}
+	PRINT(CCV_CLI_INFO, "\n");
+}
+
+static int _ccv_icf_has_power_law(ccv_icf_classifier_cascade_t* cascade)
+{
+	int i;
+	for (i = 0; i < CCV_ICF_CHANNEL_MAX; i++)
+		if (cascade->lambda[i] != 0)
+			return 1;
+	return 0;
+}
+
 static void _ccv_icf_read_classifier_cascade_with_fd(FILE* r, ccv_icf_classifier_cascade_t* cascade)
 {
 	cascade->type = CCV_ICF_CLASSIFIER_TYPE_A;
@@ -1832,6 +1903,12 @@ static void _ccv_icf_read_classifier_cascade_with_fd(FILE* r, ccv_icf_classifier
 				fscanf(r, "%d %a %d %d %d %d", &weak_classifier->features[2].channel[q], &weak_classifier->features[2].alpha[q], &weak_classifier->features[2].sat[q * 2].x, &weak_classifier->features[2].sat[q * 2].y, &weak_classifier->features[2].sat[q * 2 + 1].x, &weak_classifier->features[2].sat[q * 2 + 1].y);
 		}
 	}
+	// the power law factors come last, and only if they are estimated
+	for (i = 0; i < CCV_ICF_CHANNEL_MAX; i++)
+		if (fscanf(r, "%a", &cascade->lambda[i]) != 1)
+			break;
+	for (; i < CCV_ICF_CHANNEL_MAX; i++)
+		cascade->lambda[i] = 0;
 }
 
 static void _ccv_icf_write_classifier_cascade_with_fd(ccv_icf_classifier_cascade_t* cascade, FILE* w)
@@ -1859,6 +1936,9 @@ static void _ccv_icf_write_classifier_cascade_with_fd(ccv_icf_classifier_cascade
 				fprintf(w, "%d %a\n%d %d %d %d\n", weak_classifier->features[2].channel[q], weak_classifier->features[2].alpha[q], weak_classifier->features[2].sat[q * 2].x, weak_classifier->features[2].sat[q * 2].y, weak_classifier->features[2].sat[q * 2 + 1].x, weak_classifier->features[2].sat[q * 2 + 1].y);
 		}
 	}
+	if (_ccv_icf_has_power_law(cascade))
+		for (i = 0; i < CCV_ICF_CHANNEL_MAX; i++)
+			fprintf(w, i < CCV_ICF_CHANNEL_MAX - 1 ? "%a " : "%a\n", cascade->lambda[i]);
 }
 
 ccv_icf_classifier_cascade_t* ccv_icf_read_classifier_cascade(const char* filename)
@@ -1965,9 +2045,49 @@ static int _ccv_is_equal_same_class(const void* _r1, const void* _r2, void* data
 		(int)(r2->rect.height * 1.5 + 0.5) >= r1->rect.height;
 }
 
+/* run the cascade on every window of one scale, the border of the cascade starts at top, left of the summed area table,
+ * and it has rows, cols as if the image is bordered with the margin of the cascade alone */
+static void _ccv_icf_scan(ccv_icf_classifier_cascade_t* cascade, ccv_dense_matrix_t* sat, int top, int left, int rows, int cols, double scale, int octave, int id, int step_through, ccv_array_t** seq)
+{
+	int q, x, y;
+	int ch = CCV_GET_CHANNEL(sat->type);
+	float* ptr = sat->data.f32 + (top * sat->cols + left) * ch;
+	for (y = 0; y < rows - cascade->size.height; y += step_through)
+	{
+		for (x = 0; x < cols - cascade->size.width; x += step_through)
+		{
+			int pass = 1;
+			float sum = 0;
+			for (q = 0; q < cascade->count; q++)
+			{
+				ccv_icf_decision_tree_t* weak_classifier = cascade->weak_classifiers + q;
+				int c = _ccv_icf_run_weak_classifier(weak_classifier, ptr, sat->cols, ch, x, 0);
+				sum += weak_classifier->weigh[c];
+				if (sum < weak_classifier->threshold)
+				{
+					pass = 0;
+					break;
+				}
+			}
+			if (pass)
+			{
+				ccv_comp_t comp;
+				comp.rect = ccv_rect((int)((x + 0.5) * scale * (1 << octave) - 0.5), (int)((y + 0.5) * scale * (1 << octave) - 0.5), (cascade->size.width - cascade->margin.left - cascade->margin.right) * scale * (1 << octave), (cascade->size.height - cascade->margin.top - cascade->margin.bottom) * scale * (1 << octave));
+				comp.neighbors = 1;
+				comp.classification.id = id;
+				comp.classification.confidence = sum;
+				if (!*seq)
+					*seq = ccv_array_new(sizeof(ccv_comp_t), 64, 0);
+				ccv_array_push(*seq, &comp);
+			}
+		}
+		ptr += sat->cols * ch * step_through;
+	}
+}
+
 static void _ccv_icf_detect_objects_with_classifier_cascade(ccv_dense_matrix_t* a, ccv_icf_classifier_cascade_t** cascades, int count, ccv_icf_param_t params, ccv_array_t* seq[])
 {
-	int i, j, k, q, x, y;
+	int i, j, k;
 	int scale_upto = 1;
 	for (i = 0; i < count; i++)
 		scale_upto = ccv_max(scale_upto, (int)(log(ccv_min((double)a->rows / (cascades[i]->size.height - cascades[i]->margin.top - cascades[i]->margin.bottom), (double)a->cols / (cascades[i]->size.width - cascades[i]->margin.left - cascades[i]->margin.right))) / log(2.) - DBL_MIN) + 1);
@@ -1978,76 +2098,141 @@ static void _ccv_icf_detect_objects_with_classifier_cascade(ccv_dense_matrix_t*
 		pyr[i] = 0;
 		ccv_sample_down(pyr[i - 1], &pyr[i], 0, 0, 0);
 	}
-	for (i = 0; i < scale_upto; i++)
+	/* the channels only depend on the scale, thus, they are computed once per scale with a border that fits every cascade,
+	 * and each cascade starts from its own margin inside it */
+	ccv_margin_t margin = cascades[0]->margin;
+	for (j = 1; j < count; j++)
 	{
-		// run it
-		for (j = 0; j < count; j++)
-		{
-			double scale_ratio = pow(2., 1. / (params.interval + 1));
-			double scale = 1;
-			ccv_icf_classifier_cascade_t* cascade = cascades[j];
-			for (k = 0; k <= params.interval; k++)
+		margin.top = ccv_max(margin.top, cascades[j]->margin.top);
+		margin.right = ccv_max(margin.right, cascades[j]->margin.right);
+		margin.bottom = ccv_max(margin.bottom, cascades[j]->margin.bottom);
+		margin.left = ccv_max(margin.left, cascades[j]->margin.left);
+	}
+	const int interval = params.interval + 1;
+	double* scales = (double*)alloca(sizeof(double) * interval);
+	double scale_ratio = pow(2., 1. / interval);
+	scales[0] = 1;
+	for (k = 1; k < interval; k++)
+		scales[k] = scales[k - 1] * scale_ratio;
+	/* every scale of every octave is a job, the windows of a job are collected on their own and merged in the order of
+	 * scales, thus, the output is the same either way. To approximate, the octaves run first and keep their channels,
+	 * and the scales in between are resampled from these */
+	const int scale_count = scale_upto * interval;
+	/* a cascade without the power law factors (estimated by ccv_icf_classifier_cascade_power_law) has nothing to
+	 * approximate with, thus, every scale is computed */
+	const int approximate = params.approximate && interval > 1 && _ccv_icf_has_power_law(cascades[0]);
+	ccv_dense_matrix_t** octaves = approximate ? (ccv_dense_matrix_t**)cccalloc(scale_upto, sizeof(ccv_dense_matrix_t*)) : 0;
+	float* lambda = cascades[0]->lambda;
+	/* the octaves run ahead of the scales in between when approximating, thus, these are collected on their own too */
+	const int collect = FOR_IS_PARALLEL || approximate;
+	ccv_array_t** seqs = collect ? (ccv_array_t**)cccalloc(scale_count * count, sizeof(ccv_array_t*)) : 0;
+	/* the scratch matrices are kept per worker, and reused by every scale the worker runs, in both passes */
+#ifdef USE_OPENMP
+	const int worker_count = omp_get_max_threads();
+#else
+	const int worker_count = 1;
+#endif
+	ccv_dense_matrix_t** buffers = (ccv_dense_matrix_t**)cccalloc(worker_count * 4, sizeof(ccv_dense_matrix_t*));
+	int pass;
+	for (pass = 0; pass < (approximate ? 2 : 1); pass++)
+	{
+		const int job_count = !approximate ? scale_count : (pass == 0 ? scale_upto : scale_upto * (interval - 1));
+		parallel_for(v, job_count) {
+			int c, u, x;
+#ifdef USE_OPENMP
+			ccv_dense_matrix_t** buffer = buffers + omp_get_thread_num() * 4;
+#else
+			ccv_dense_matrix_t** buffer = buffers;
+#endif
+			ccv_dense_matrix_t header[4];
+			const int t = !approximate ? v : (pass == 0 ? v * interval : (v / (interval - 1)) * interval + v % (interval - 1) + 1);
+			const int octave = t / interval;
+			const double scale = scales[t % interval];
+			int rows = (int)(pyr[octave]->rows / scale + 0.5);
+			int cols = (int)(pyr[octave]->cols / scale + 0.5);
+			int fit = 0;
+			for (u = 0; u < count; u++)
+				fit |= (rows >= cascades[u]->size.height && cols >= cascades[u]->size.width);
+			if (!fit)
+				continue;
+			/* the scratch matrices have no signature, thus, nothing here goes through the cache */
+			ccv_dense_matrix_t* icf;
+			if (approximate && pass > 0)
 			{
-				int rows = (int)(pyr[i]->rows / scale + 0.5);
-				int cols = (int)(pyr[i]->cols / scale + 0.5);
-				if (rows < cascade->size.height || cols < cascade->size.width)
-					break;
-				ccv_dense_matrix_t* image = k == 0 ? pyr[i] : 0;
-				if (k > 0)
-					ccv_resample(pyr[i], &image, 0, rows, cols, CCV_INTER_AREA);
-				ccv_dense_matrix_t* bordered = 0;
-				ccv_border(image, (ccv_matrix_t**)&bordered, 0, cascade->margin);
-				if (k > 0)
-					ccv_matrix_free(image);
-				rows = bordered->rows;
-				cols = bordered->cols;
-				ccv_dense_matrix_t* icf = 0;
-				ccv_icf(bordered, &icf, 0);
-				ccv_matrix_free(bordered);
-				ccv_dense_matrix_t* sat = 0;
-				ccv_sat(icf, &sat, 0, CCV_PADDING_ZERO);
-				ccv_matrix_free(icf);
-				int ch = CCV_GET_CHANNEL(sat->type);
-				float* ptr = sat->data.f32;
-				for (y = 0; y < rows; y += params.step_through)
+				if (!octaves[octave])
+					continue;
+				/* resampled right into the bordered channels, the border of these is zero */
+				icf = ccv_dense_matrix_scratch(buffer + 2, header + 2, rows + margin.top + margin.bottom, cols + margin.left + margin.right, CCV_32F | CCV_GET_CHANNEL(octaves[octave]->type));
+				const int ch = CCV_GET_CHANNEL(icf->type);
+				const int stride = icf->step / sizeof(float);
+				memset(icf->data.u8, 0, icf->step * margin.top);
+				memset(icf->data.u8 + icf->step * (margin.top + rows), 0, icf->step * margin.bottom);
+				float* ptr = icf->data.f32 + stride * margin.top;
+				for (u = 0; u < rows; u++, ptr += stride)
 				{
-					if (y >= sat->rows - cascade->size.height - 1)
-						break;
-					for (x = 0; x < cols; x += params.step_through)
-					{
-						if (x >= sat->cols - cascade->size.width - 1)
-							break;
-						int pass = 1;
-						float sum = 0;
-						for (q = 0; q < cascade->count; q++)
-						{
-							ccv_icf_decision_tree_t* weak_classifier = cascade->weak_classifiers + q;
-							int c = _ccv_icf_run_weak_classifier(weak_classifier, ptr, sat->cols, ch, x, 0);
-							sum += weak_classifier->weigh[c];
-							if (sum < weak_classifier->threshold)
-							{
-								pass = 0;
-								break;
-							}
-						}
-						if (pass)
-						{
-							ccv_comp_t comp;
-							comp.rect = ccv_rect((int)((x + 0.5) * scale * (1 << i) - 0.5), (int)((y + 0.5) * scale * (1 << i) - 0.5), (cascade->size.width - cascade->margin.left - cascade->margin.right) * scale * (1 << i), (cascade->size.height - cascade->margin.top - cascade->margin.bottom) * scale * (1 << i));
-							comp.neighbors = 1;
-							comp.classification.id = j + 1;
-							comp.classification.confidence = sum;
-							ccv_array_push(seq[j], &comp);
-						}
-					}
-					ptr += sat->cols * ch * params.step_through;
+					memset(ptr, 0, sizeof(float) * ch * margin.left);
+					memset(ptr + (margin.left + cols) * ch, 0, sizeof(float) * ch * margin.right);
 				}
-				ccv_matrix_free(sat);
-				scale *= scale_ratio;
+				ccv_dense_matrix_t interior = ccv_reshape(icf, margin.top, margin.left, rows, cols);
+				ccv_dense_matrix_t* resampled = &interior;
+				ccv_resample(octaves[octave], &resampled, 0, rows, cols, CCV_INTER_AREA);
+				float factor[CCV_ICF_CHANNEL_MAX];
+				for (c = 0; c < ch; c++)
+					factor[c] = pow(scale, lambda[c]);
+				ptr = interior.data.f32;
+				for (u = 0; u < rows; u++, ptr += stride)
+					for (x = 0; x < cols * ch; x += ch)
+						for (c = 0; c < ch; c++)
+							ptr[x + c] *= factor[c];
+			} else {
+				ccv_dense_matrix_t* image = pyr[octave];
+				if (t % interval > 0)
+				{
+					image = ccv_dense_matrix_scratch(buffer, header, rows, cols, CCV_GET_DATA_TYPE(pyr[octave]->type) | CCV_GET_CHANNEL(pyr[octave]->type));
+					ccv_resample(pyr[octave], &image, 0, rows, cols, CCV_INTER_AREA);
+					image->sig = 0;
+				}
+				ccv_dense_matrix_t* bordered = ccv_dense_matrix_scratch(buffer + 1, header + 1, rows + margin.top + margin.bottom, cols + margin.left + margin.right, CCV_GET_DATA_TYPE(image->type) | CCV_GET_CHANNEL(image->type));
+				ccv_border(image, (ccv_matrix_t**)&bordered, 0, margin);
+				bordered->sig = 0;
+				icf = ccv_dense_matrix_scratch(buffer + 2, header + 2, bordered->rows, bordered->cols, CCV_32F | (CCV_GET_CHANNEL(bordered->type) == 1 ? 8 : 10));
+				ccv_icf(bordered, &icf, 0);
+				if (approximate)
+					ccv_slice(icf, (ccv_matrix_t**)(octaves + octave), 0, margin.top, margin.left, rows, cols);
 			}
-		}
+			ccv_dense_matrix_t* sat = ccv_sat_scratch(icf, buffer + 3, header + 3);
+			for (u = 0; u < count; u++)
+			{
+				ccv_icf_classifier_cascade_t* cascade = cascades[u];
+				if (rows < cascade->size.height || cols < cascade->size.width)
+					continue;
+				_ccv_icf_scan(cascade, sat, margin.top - cascade->margin.top, margin.left - cascade->margin.left, rows + cascade->margin.top + cascade->margin.bottom, cols + cascade->margin.left + cascade->margin.right, scale, octave, u + 1, params.step_through, collect ? seqs + t * count + u : seq + u);
+			}
+		} parallel_endfor
+	}
+	for (i = 0; i < worker_count * 4; i++)
+		if (buffers[i])
+			ccv_matrix_free(buffers[i]);
+	ccfree(buffers);
+	if (approximate)
+	{
+		for (i = 0; i < scale_upto; i++)
+			if (octaves[i])
+				ccv_matrix_free(octaves[i]);
+		ccfree(octaves);
+	}
+	if (collect)
+	{
+		for (i = 0; i < scale_count; i++)
+			for (j = 0; j < count; j++)
+				if (seqs[i * count + j])
+				{
+					for (k = 0; k < seqs[i * count + j]->rnum; k++)
+						ccv_array_push(seq[j], ccv_array_get(seqs[i * count + j], k));
+					ccv_array_free(seqs[i * count + j]);
+				}
+		ccfree(seqs);
 	}
-
 	for (i = 1; i < scale_upto; i++)
 		ccv_matrix_free(pyr[i]);
 }
@@ -2079,6 +2264,8 @@ static void _ccv_icf_detect_objects_with_multiscale_classifier_cascade(ccv_dense
 		pyr[i] = 0;
 		ccv_sample_down(pyr[i - 1], &pyr[i], 0, 0, 0);
 	}
+	ccv_dense_matrix_t* sat_buffer = 0;
+	ccv_dense_matrix_t sat_header;
 	for (i = 0; i < scale_upto; i++)
 	{
 		ccv_dense_matrix_t* bordered = 0;
@@ -2086,8 +2273,7 @@ static void _ccv_icf_detect_objects_with_multiscale_classifier_cascade(ccv_dense
 		ccv_dense_matrix_t* icf = 0;
 		ccv_icf(bordered, &icf, 0);
 		ccv_matrix_free(bordered);
-		ccv_dense_matrix_t* sat = 0;
-		ccv_sat(icf, &sat, 0, CCV_PADDING_ZERO);
+		ccv_dense_matrix_t* sat = ccv_sat_scratch(icf, &sat_buffer, &sat_header);
 		ccv_matrix_free(icf);
 		int ch = CCV_GET_CHANNEL(sat->type);
 		assert(CCV_GET_DATA_TYPE(sat->type) == CCV_32F);
@@ -2151,9 +2337,10 @@ static void _ccv_icf_detect_objects_with_multiscale_classifier_cascade(ccv_dense
 				scale *= scale_ratio;
 			}
 		}
-		ccv_matrix_free(sat);
 	}
 
+	if (sat_buffer)
+		ccv_matrix_free(sat_buffer);
 	for (i = 1; i < scale_upto; i++)
 		ccv_matrix_free(pyr[i]);
 }
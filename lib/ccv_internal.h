@@ -28,7 +28,7 @@ static int _CCV_PRINT_LOOP __attribute__ ((unused)) = 0;
 
 #ifdef USE_OPENMP
 #define OMP_PRAGMA0(x) MACRO_STRINGIFY(omp parallel for private(x) schedule(dynamic))
-#define parallel_for(x, n) { int x; _Pragma(OMP_PRAGMA0(x)) for ((x) = 0; (x) < (n); (x)++) {
+#define parallel_for(x, n) { int x; _Pragma(OMP_PRAGMA0(x)) for (x = 0; x < (n); x++) {
 #define parallel_endfor } }
 #define FOR_IS_PARALLEL (1)
 #else
@@ -37,6 +37,43 @@ static int _CCV_PRINT_LOOP __attribute__ ((unused)) = 0;
 #define FOR_IS_PARALLEL (0)
 #endif
 
+/* the number of rows each band covers when a function splits its output into bands for parallel_for,
+ * 0 means a single band. tests use ccv_set_band_rows to force a band size (> 0) or a single band (< 0),
+ * such that the banded path runs in a serial build too, 0 restores the default */
+extern int _ccv_band_rows;
+void ccv_set_band_rows(int rows);
+#define ccv_band_rows(default_rows) (_ccv_band_rows > 0 ? _ccv_band_rows : (_ccv_band_rows == 0 && FOR_IS_PARALLEL ? (default_rows) : 0))
+
+/* whether the SIMD paths run, tests turn them off with ccv_set_simd(0) to check them against the scalar code they replace */
+extern int _ccv_simd_enabled;
+void ccv_set_simd(int enabled);
+
+/* arrays allocated in an arena are marked with CCV_UNMANAGED, and keep the pointer to their arena right before the array header */
+#define ccv_array_arena(array) (((ccv_arena_t**)(array))[-1])
+
+/* a matrix that is computed into the same buffer over and over (e.g. once per scale), the buffer only grows when
+ * the requested size doesn't fit, and the returned header points into it, thus, the loop doesn't allocate */
+static inline ccv_dense_matrix_t* ccv_dense_matrix_scratch(ccv_dense_matrix_t** buffer, ccv_dense_matrix_t* header, int rows, int cols, int type)
+{
+	if (*buffer && (size_t)(*buffer)->rows * (*buffer)->step < (size_t)rows * CCV_GET_STEP(cols, type))
+	{
+		ccv_matrix_free(*buffer);
+		*buffer = 0;
+	}
+	if (!*buffer)
+		*buffer = ccv_dense_matrix_new(rows, cols, type, 0, 0);
+	*header = ccv_dense_matrix(rows, cols, type, (*buffer)->data.u8, 0);
+	return header;
+}
+
+/* the 32f summed area table of a computed into a scratch buffer */
+static inline ccv_dense_matrix_t* ccv_sat_scratch(ccv_dense_matrix_t* a, ccv_dense_matrix_t** buffer, ccv_dense_matrix_t* header)
+{
+	ccv_dense_matrix_t* sat = ccv_dense_matrix_scratch(buffer, header, a->rows + 1, a->cols + 1, CCV_32F | CCV_GET_CHANNEL(a->type));
+	ccv_sat(a, &sat, 0, CCV_PADDING_ZERO);
+	return sat;
+}
+
 /* macro printf utilities */
 
 #define PRINT(l, a, ...) \
@@ -134,6 +171,7 @@ static int _CCV_PRINT_LOOP __attribute__ ((unused)) = 0;
 
 #define ccv_declare_derived_signature(var, cond, submacro, ...) \
 	submacro; \
+	ccv_set_cache_source(__func__); \
 	uint64_t var = (cond) ? ccv_cache_generate_signature(INTERNAL_CATCH_UNIQUE_NAME(_ccv_identifier_), INTERNAL_CATCH_UNIQUE_NAME(_ccv_string_size_), __VA_ARGS__) : 0;
 
 /* the following macro enables more finer-control of ccv_declare_derived_signature, notably, it supports much more complex conditions:
@@ -157,6 +195,7 @@ static int _CCV_PRINT_LOOP __attribute__ ((unused)) = 0;
 
 #define ccv_declare_derived_signature_case(var, submacro, ...) \
 	submacro; \
+	ccv_set_cache_source(__func__); \
 	uint64_t INTERNAL_CATCH_UNIQUE_NAME(_ccv_temp_sig_) = 0; \
 	INTERNAL_EXPAND_MACRO_ARGUMENT_TO_LINE(__VA_ARGS__, INTERNAL_SEQ_PADDING_LINE()); \
 	uint64_t var = INTERNAL_CATCH_UNIQUE_NAME(_ccv_temp_sig_);
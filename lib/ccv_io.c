@@ -1,5 +1,10 @@
 #include "ccv.h"
 #include "ccv_internal.h"
+typedef struct {
+	int max_dimension; // decode no smaller than this on the larger side if the format can scale down for free, 0 for full size
+	int luma; // decode luma only if grayscale is requested with CCV_IO_LUMA and the format stores it separately
+} ccv_io_read_param_t;
+
 #ifdef HAVE_LIBPNG
 #ifdef __APPLE__
 #include "TargetConditionals.h"
@@ -29,8 +34,9 @@
 #include "io/_ccv_io_bmp.inc"
 #include "io/_ccv_io_binary.inc"
 #include "io/_ccv_io_raw.inc"
+#include "io/_ccv_io_container.inc"
 
-static int _ccv_read_and_close_fd(FILE* fd, ccv_dense_matrix_t** x, int type)
+static int _ccv_read_and_close_fd(FILE* fd, ccv_dense_matrix_t** x, int type, const ccv_io_read_param_t* params)
 {
 	int ctype = (type & 0xF00) ? CCV_8U | ((type & 0xF00) >> 8) : 0;
 	if ((type & 0XFF) == CCV_IO_ANY_FILE)
@@ -51,7 +57,7 @@ static int _ccv_read_and_close_fd(FILE* fd, ccv_dense_matrix_t** x, int type)
 	{
 #ifdef HAVE_LIBJPEG
 		case CCV_IO_JPEG_FILE:
-			_ccv_read_jpeg_fd(fd, x, ctype);
+			_ccv_read_jpeg_fd(fd, x, ctype, params);
 			break;
 #endif
 #ifdef HAVE_LIBPNG
@@ -72,6 +78,25 @@ static int _ccv_read_and_close_fd(FILE* fd, ccv_dense_matrix_t** x, int type)
 	return CCV_IO_FINAL;
 }
 
+static int _ccv_raw_ctype(int type)
+{
+	switch (type & 0xFF)
+	{
+		case CCV_IO_RGB_RAW:
+		case CCV_IO_BGR_RAW:
+			return CCV_8U | CCV_C3;
+		case CCV_IO_RGBA_RAW:
+		case CCV_IO_ARGB_RAW:
+		case CCV_IO_BGRA_RAW:
+		case CCV_IO_ABGR_RAW:
+			return CCV_8U | CCV_C4;
+		case CCV_IO_GRAY_RAW:
+		default:
+			/* default one */
+			return CCV_8U | CCV_C1;
+	}
+}
+
 static int _ccv_read_raw(ccv_dense_matrix_t** x, void* data, int type, int rows, int cols, int scanline)
 {
 	assert(rows > 0 && cols > 0 && scanline > 0);
@@ -81,25 +106,7 @@ static int _ccv_read_raw(ccv_dense_matrix_t** x, void* data, int type, int rows,
 		// NO_COPY mode generate an "unreusable" matrix, which requires you to
 		// manually release its data block (which is, in fact the same data
 		// block you passed in)
-		int ctype = CCV_8U | CCV_C1;
-		switch (type & 0xFF)
-		{
-			case CCV_IO_RGB_RAW:
-			case CCV_IO_BGR_RAW:
-				ctype = CCV_8U | CCV_C3;
-				break;
-			case CCV_IO_RGBA_RAW:
-			case CCV_IO_ARGB_RAW:
-			case CCV_IO_BGRA_RAW:
-			case CCV_IO_ABGR_RAW:
-				ctype = CCV_8U | CCV_C4;
-				break;
-			case CCV_IO_GRAY_RAW:
-			default:
-				/* default one */
-				break;
-		}
-		*x = ccv_dense_matrix_new(rows, cols, ctype | CCV_NO_DATA_ALLOC, data, 0);
+		*x = ccv_dense_matrix_new(rows, cols, _ccv_raw_ctype(type) | CCV_NO_DATA_ALLOC, data, 0);
 		(*x)->step = scanline;
 	} else {
 		switch (type & 0xFF)
@@ -149,6 +156,16 @@ static int readfn(void* context, char* buf, int size)
 	return size;
 }
 
+static int writefn(void* context, const char* buf, int size)
+{
+	ccv_io_mem_t* mem = (ccv_io_mem_t*)context;
+	if (size + mem->pos > mem->size)
+		return -1;
+	memcpy(mem->buffer + mem->pos, buf, size);
+	mem->pos += size;
+	return size;
+}
+
 static fpos_t seekfn(void* context, fpos_t off, int whence)
 {
 	ccv_io_mem_t* mem = (ccv_io_mem_t*)context;
@@ -172,16 +189,47 @@ static fpos_t seekfn(void* context, fpos_t off, int whence)
 }
 #endif
 
-int ccv_read_impl(const void* in, ccv_dense_matrix_t** x, int type, int rows, int cols, int scanline)
+/* the mapped file is not copied, thus, no conversion can be applied. It only works for the formats that store matrix data as is,
+ * returns CCV_IO_ATTEMPTED if the file cannot be mapped this way and should be read as usual */
+static int _ccv_read_mmap(const char* filename, ccv_dense_matrix_t** x, int type, int rows, int cols, int scanline)
+{
+	if ((type & CCV_IO_ANY_FILE) && (type & 0xFF) != CCV_IO_ANY_FILE && (type & 0xFF) != CCV_IO_BINARY_FILE)
+		return CCV_IO_ATTEMPTED;
+	ccv_mmap_t* mmap = ccv_mmap_new(filename);
+	if (!mmap) // raw data cannot be read as usual, the file name is not the data
+		return (type & CCV_IO_ANY_FILE) ? CCV_IO_ATTEMPTED : CCV_IO_ERROR;
+	*x = 0;
+	int result;
+	if (type & CCV_IO_ANY_FILE)
+		result = _ccv_read_binary_mmap(mmap, x);
+	else {
+		assert(rows > 0 && cols > 0 && scanline > 0);
+		*x = ccv_dense_matrix_new_mmap(mmap, 0, rows, cols, _ccv_raw_ctype(type), scanline);
+		result = *x ? CCV_IO_FINAL : CCV_IO_ERROR;
+	}
+	// the matrix holds its own reference of the mapped file
+	ccv_mmap_free(mmap);
+	if (*x != 0)
+		ccv_make_matrix_immutable(*x);
+	return result;
+}
+
+static int _ccv_read_impl(const void* in, ccv_dense_matrix_t** x, int type, int rows, int cols, int scanline, const ccv_io_read_param_t* params)
 {
 	FILE* fd = 0;
+	if ((type & CCV_IO_MMAP) && (type & (CCV_IO_ANY_FILE | CCV_IO_ANY_RAW)))
+	{
+		int result = _ccv_read_mmap((const char*)in, x, type, rows, cols, scanline);
+		if (result != CCV_IO_ATTEMPTED)
+			return result;
+	}
 	if (type & CCV_IO_ANY_FILE)
 	{
 		assert(rows == 0 && cols == 0 && scanline == 0);
 		fd = fopen((const char*)in, "rb");
 		if (!fd)
 			return CCV_IO_ERROR;
-		return _ccv_read_and_close_fd(fd, x, type);
+		return _ccv_read_and_close_fd(fd, x, type, params);
 	} else if (type & CCV_IO_ANY_STREAM) {
 		assert(rows > 8 && cols == 0 && scanline == 0);
 		assert((type & 0xFF) != CCV_IO_DEFLATE_STREAM); // deflate stream (compressed stream) is not supported yet
@@ -201,7 +249,7 @@ int ccv_read_impl(const void* in, ccv_dense_matrix_t** x, int type, int rows, in
 			return CCV_IO_ERROR;
 		// mimicking itself as a "file"
 		type = (type & ~0x10) | 0x20;
-		return _ccv_read_and_close_fd(fd, x, type);
+		return _ccv_read_and_close_fd(fd, x, type, params);
 #endif
 	} else if (type & CCV_IO_ANY_RAW) {
 		return _ccv_read_raw(x, (void*)in /* it can be modifiable if it is NO_COPY mode */, type, rows, cols, scanline);
@@ -209,42 +257,102 @@ int ccv_read_impl(const void* in, ccv_dense_matrix_t** x, int type, int rows, in
 	return CCV_IO_UNKNOWN;
 }
 
+int ccv_read_impl(const void* in, ccv_dense_matrix_t** x, int type, int rows, int cols, int scanline)
+{
+	ccv_io_read_param_t params = {
+		.max_dimension = 0,
+		.luma = !!(type & CCV_IO_LUMA),
+	};
+	return _ccv_read_impl(in, x, type, rows, cols, scanline, &params);
+}
+
+int ccv_read_scaled(const void* in, ccv_dense_matrix_t** x, int type, int size, int max_dimension)
+{
+	assert(type & (CCV_IO_ANY_FILE | CCV_IO_ANY_STREAM));
+	ccv_io_read_param_t params = {
+		.max_dimension = max_dimension,
+		.luma = !!(type & CCV_IO_LUMA),
+	};
+	return _ccv_read_impl(in, x, type, size, 0, 0, &params);
+}
+
 int ccv_write(ccv_dense_matrix_t* mat, char* out, int* len, int type, void* conf)
 {
 	FILE* fd = 0;
+	int stream = 0;
+	const int png_params = !!(type & CCV_IO_PNG_PARAMS);
+	type &= ~CCV_IO_PNG_PARAMS;
 	if (type & CCV_IO_ANY_FILE)
 	{
 		fd = fopen(out, "wb");
 		if (!fd)
 			return CCV_IO_ERROR;
+	} else if (type & CCV_IO_ANY_STREAM) {
+		assert(len != 0 && *len > 0);
+#if _XOPEN_SOURCE >= 700 || _POSIX_C_SOURCE >= 200809L || defined(__APPLE__) || defined(BSD)
+#if _XOPEN_SOURCE >= 700 || _POSIX_C_SOURCE >= 200809L
+		fd = fmemopen(out, (size_t)*len, "wb");
+#else
+		ccv_io_mem_t mem = {
+			.size = *len,
+			.pos = 0,
+			.buffer = out,
+		};
+		fd = funopen(&mem, 0, writefn, seekfn, 0);
+#endif
+		if (!fd)
+			return CCV_IO_ERROR;
+		// mimicking itself as a "file"
+		type = (type & ~0x10) | 0x20;
+		stream = 1;
+#else
+		return CCV_IO_UNKNOWN;
+#endif
 	}
 	switch (type)
 	{
 		case CCV_IO_JPEG_FILE:
 #ifdef HAVE_LIBJPEG
 			_ccv_write_jpeg_fd(mat, fd, conf);
-			if (len != 0)
-				*len = 0;
 #else
 			assert(0 && "ccv_write requires libjpeg support for JPEG format");
 #endif
 			break;
 		case CCV_IO_PNG_FILE:
 #ifdef HAVE_LIBPNG
-			_ccv_write_png_fd(mat, fd, conf);
-			if (len != 0)
-				*len = 0;
+			_ccv_write_png_fd(mat, fd, conf, png_params);
 #else
 			assert(0 && "ccv_write requires libpng support for PNG format");
 #endif
 			break;
 		case CCV_IO_BINARY_FILE:
 			_ccv_write_binary_fd(mat, fd, conf);
-			if (len != 0)
-				*len = 0;
 			break;
 	}
+	if (stream)
+	{
+		// the data memory is exhausted if anything failed to flush into it
+		int error = (fflush(fd) != 0 || ferror(fd));
+		long written = ftell(fd);
+		fclose(fd);
+		if (error || written <= 0 || written > *len)
+			return CCV_IO_ERROR;
+		*len = (int)written;
+		return CCV_IO_FINAL;
+	}
+	if (len != 0)
+		*len = 0;
 	if (type & CCV_IO_ANY_FILE)
 		fclose(fd);
 	return CCV_IO_FINAL;
 }
+
+int ccv_write_batch(ccv_dense_matrix_t** mats, char** outs, int* lens, int count, int type, void* conf)
+{
+	int failed = 0;
+	parallel_for(i, count) {
+		if (ccv_write(mats[i], outs[i], lens ? lens + i : 0, type, conf) != CCV_IO_FINAL)
+			failed = 1;
+	} parallel_endfor
+	return failed ? CCV_IO_ERROR : CCV_IO_FINAL;
+}
@@ -1,6 +1,16 @@
 #include "ccv.h"
 #include "ccv_internal.h"
 #include "3rdparty/siphash/siphash24.h"
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+#if defined(__unix__) || (defined(__APPLE__) && defined(__MACH__))
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define HAVE_MMAP
+#endif
 
 static __thread ccv_cache_t ccv_cache;
 
@@ -13,13 +23,521 @@ static __thread ccv_cache_t ccv_cache;
 /* option to enable/disable cache */
 static __thread int ccv_cache_opt = 0;
 
+#ifdef HAVE_PTHREAD
+/* the process-wide cache is split into shards, each one is guarded by its own lock,
+ * the shard is picked by the top bits of the signature (the radix tree consumes the signature from the bottom bits) */
+#define CCV_SHARED_CACHE_SHARDS (16)
+
+typedef struct {
+	pthread_mutex_t mutex;
+	ccv_cache_t cache;
+} ccv_cache_shard_t;
+
+static ccv_cache_shard_t ccv_shared_cache[CCV_SHARED_CACHE_SHARDS] = {
+	[0 ... CCV_SHARED_CACHE_SHARDS - 1] = {
+		.mutex = PTHREAD_MUTEX_INITIALIZER,
+	},
+};
+
+/* option to enable/disable process-wide cache, it takes precedence over the thread-local one */
+static int ccv_shared_cache_opt = 0;
+
+#define ccv_shared_cache_shard(sig) (ccv_shared_cache + ((sig) >> 60) % CCV_SHARED_CACHE_SHARDS)
+#endif
+
+static int _ccv_cache_enabled(void)
+{
+#ifdef HAVE_PTHREAD
+	if (ccv_shared_cache_opt)
+		return 1;
+#endif
+	return ccv_cache_opt;
+}
+
+/* the statistics are accumulated across all caches (the thread-local ones and the shards of the process-wide one),
+ * every cache operation adds the deltas of its cache's counters to them */
+typedef struct {
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t evictions;
+	uint64_t departures;
+	uint64_t lifetime;
+	uint32_t rnum[2];
+	size_t size[2];
+} ccv_cache_counter_t;
+
+static ccv_cache_counter_t ccv_cache_stat;
+
+static void _ccv_cache_counter(const ccv_cache_t* cache, ccv_cache_counter_t* counter)
+{
+	counter->hits = cache->hits;
+	counter->misses = cache->misses;
+	counter->evictions = cache->evictions;
+	counter->departures = cache->departures;
+	counter->lifetime = cache->lifetime;
+	int i;
+	for (i = 0; i < 2; i++)
+	{
+		counter->rnum[i] = cache->lru[i].rnum;
+		counter->size[i] = cache->lru[i].size;
+	}
+}
+
+#define ccv_cache_stat_add(counter, before, field) \
+	if ((counter).field != (before)->field) \
+		__sync_fetch_and_add(&ccv_cache_stat.field, (counter).field - (before)->field);
+
+static void _ccv_cache_account(const ccv_cache_t* cache, const ccv_cache_counter_t* before)
+{
+	ccv_cache_counter_t counter;
+	_ccv_cache_counter(cache, &counter);
+	ccv_cache_stat_add(counter, before, hits);
+	ccv_cache_stat_add(counter, before, misses);
+	ccv_cache_stat_add(counter, before, evictions);
+	ccv_cache_stat_add(counter, before, departures);
+	ccv_cache_stat_add(counter, before, lifetime);
+	int i;
+	for (i = 0; i < 2; i++)
+	{
+		ccv_cache_stat_add(counter, before, rnum[i]);
+		ccv_cache_stat_add(counter, before, size[i]);
+	}
+}
+
+#undef ccv_cache_stat_add
+
+/* the per source breakdown, the source is set by ccv_declare_derived_signature and consumed by the following lookup,
+ * sources are keyed by the address of their names in an open addressing table */
+#define CCV_CACHE_SOURCES (256)
+
+static __thread const char* ccv_cache_source = 0;
+static int ccv_cache_source_opt = 0;
+static ccv_cache_source_stats_t ccv_cache_source_stat[CCV_CACHE_SOURCES];
+#ifdef HAVE_PTHREAD
+static pthread_mutex_t ccv_cache_source_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+void ccv_set_cache_source(const char* source)
+{
+	ccv_cache_source = source;
+}
+
+static void _ccv_cache_source_account(int hit)
+{
+	const char* source = ccv_cache_source ? ccv_cache_source : "(unknown)";
+	ccv_cache_source = 0;
+	if (!ccv_cache_source_opt)
+		return;
+	uint64_t h = ((uint64_t)(uintptr_t)source >> 3) * 0x9E3779B97F4A7C15ULL;
+	int i;
+#ifdef HAVE_PTHREAD
+	pthread_mutex_lock(&ccv_cache_source_mutex);
+#endif
+	for (i = 0; i < CCV_CACHE_SOURCES; i++)
+	{
+		ccv_cache_source_stats_t* stat = ccv_cache_source_stat + (h + i) % CCV_CACHE_SOURCES;
+		if (stat->source == source || !stat->source)
+		{
+			stat->source = source;
+			if (hit)
+				++stat->hits;
+			else
+				++stat->misses;
+			break;
+		}
+	}
+	// if the table is full, the lookup is not broken down
+#ifdef HAVE_PTHREAD
+	pthread_mutex_unlock(&ccv_cache_source_mutex);
+#endif
+}
+
+static void* _ccv_cache_out(uint64_t sig, uint8_t* type)
+{
+	void* x;
+	ccv_cache_counter_t before;
+#ifdef HAVE_PTHREAD
+	if (ccv_shared_cache_opt)
+	{
+		ccv_cache_shard_t* shard = ccv_shared_cache_shard(sig);
+		pthread_mutex_lock(&shard->mutex);
+		_ccv_cache_counter(&shard->cache, &before);
+		x = ccv_cache_out(&shard->cache, sig, type);
+		_ccv_cache_account(&shard->cache, &before);
+		pthread_mutex_unlock(&shard->mutex);
+		_ccv_cache_source_account(x != 0);
+		return x;
+	}
+#endif
+	_ccv_cache_counter(&ccv_cache, &before);
+	x = ccv_cache_out(&ccv_cache, sig, type);
+	_ccv_cache_account(&ccv_cache, &before);
+	_ccv_cache_source_account(x != 0);
+	return x;
+}
+
+static int _ccv_cache_put(uint64_t sig, void* x, uint32_t size, uint8_t type)
+{
+	int result;
+	ccv_cache_counter_t before;
+#ifdef HAVE_PTHREAD
+	if (ccv_shared_cache_opt)
+	{
+		ccv_cache_shard_t* shard = ccv_shared_cache_shard(sig);
+		pthread_mutex_lock(&shard->mutex);
+		_ccv_cache_counter(&shard->cache, &before);
+		result = ccv_cache_put(&shard->cache, sig, x, size, type);
+		_ccv_cache_account(&shard->cache, &before);
+		pthread_mutex_unlock(&shard->mutex);
+		return result;
+	}
+#endif
+	_ccv_cache_counter(&ccv_cache, &before);
+	result = ccv_cache_put(&ccv_cache, sig, x, size, type);
+	_ccv_cache_account(&ccv_cache, &before);
+	return result;
+}
+
+static void _ccv_cache_close(ccv_cache_t* cache, int close)
+{
+	ccv_cache_counter_t before;
+	_ccv_cache_counter(cache, &before);
+	if (close)
+		ccv_cache_close(cache);
+	else if (cache->rnum > 0)
+		ccv_cache_cleanup(cache);
+	_ccv_cache_account(cache, &before);
+}
+
+/* The matrix pool recycles the memory blocks of dense matrices by size classes. A pooled matrix lives in a 64-byte
+ * aligned block, with its data section starts at CCV_MATRIX_BLOCK_HDR_SIZE rather than right after the matrix header.
+ * The offset is always different from the one used by plain allocated matrix, this is how ccv_matrix_free tells them
+ * apart. Between the matrix header and the data section, a ccv_matrix_block_t records where the block should go. */
+typedef struct {
+	size_t size; // the size of the whole block
+	int size_class; // CCV_MATRIX_BLOCK_LARGE if it is too large to be pooled, CCV_MATRIX_BLOCK_ARENA if it is allocated in an arena
+} ccv_matrix_block_t;
+
+#define CCV_MATRIX_BLOCK_LARGE (-1)
+#define CCV_MATRIX_BLOCK_ARENA (-2)
+
+#define CCV_MATRIX_BLOCK_HDR_SIZE ((sizeof(ccv_dense_matrix_t) + sizeof(ccv_matrix_block_t) + 63) & -64)
+#define ccv_matrix_block(x) ((ccv_matrix_block_t*)((unsigned char*)(x) + sizeof(ccv_dense_matrix_t)))
+#define ccv_dense_matrix_in_block(x) (!((x)->type & (CCV_NO_DATA_ALLOC | CCV_UNMANAGED)) && (x)->data.u8 == (unsigned char*)(x) + CCV_MATRIX_BLOCK_HDR_SIZE)
+
+/* 4 size classes for every power of 2, from 256 bytes up to 1GiB */
+#define CCV_MATRIX_POOL_MIN_CLASS_SIZE (256)
+#define CCV_MATRIX_POOL_SIZE_CLASSES (4 * (30 - 8) + 1)
+
+typedef struct {
+#ifdef HAVE_PTHREAD
+	pthread_mutex_t mutex;
+#endif
+	void* head; // idle blocks, linked through their first pointer
+} ccv_matrix_pool_bin_t;
+
+static ccv_matrix_pool_bin_t ccv_matrix_pool[CCV_MATRIX_POOL_SIZE_CLASSES] = {
+#ifdef HAVE_PTHREAD
+	[0 ... CCV_MATRIX_POOL_SIZE_CLASSES - 1] = {
+		.mutex = PTHREAD_MUTEX_INITIALIZER,
+	},
+#endif
+};
+
+/* option to enable/disable the matrix pool, and the upper limit of idle bytes it holds */
+static int ccv_matrix_pool_opt = 0;
+static size_t ccv_matrix_pool_up = 0;
+static ccv_matrix_pool_stats_t ccv_matrix_pool_stat;
+
+static int _ccv_matrix_pool_size_class(size_t size)
+{
+	if (size <= CCV_MATRIX_POOL_MIN_CLASS_SIZE)
+		return 0;
+	const int p = 63 - __builtin_clzll(size - 1);
+	if (p >= 30)
+		return CCV_MATRIX_BLOCK_LARGE;
+	return (p - 8) * 4 + (int)(((size - 1) >> (p - 2)) & 3) + 1;
+}
+
+static size_t _ccv_matrix_pool_class_size(int size_class)
+{
+	if (size_class == 0)
+		return CCV_MATRIX_POOL_MIN_CLASS_SIZE;
+	const int p = (size_class - 1) / 4 + 8;
+	return (size_t)(4 + (size_class - 1) % 4 + 1) << (p - 2);
+}
+
+static void _ccv_matrix_pool_high_water_mark(size_t* hwm, size_t size)
+{
+	size_t old = *hwm;
+	while (size > old && !__sync_bool_compare_and_swap(hwm, old, size))
+		old = *hwm;
+}
+
+static ccv_dense_matrix_t* _ccv_matrix_pool_alloc(size_t size)
+{
+	const int size_class = _ccv_matrix_pool_size_class(size);
+	void* ptr = 0;
+	if (size_class >= 0)
+	{
+		size = _ccv_matrix_pool_class_size(size_class);
+		ccv_matrix_pool_bin_t* bin = ccv_matrix_pool + size_class;
+#ifdef HAVE_PTHREAD
+		pthread_mutex_lock(&bin->mutex);
+#endif
+		ptr = bin->head;
+		if (ptr)
+			bin->head = *(void**)ptr;
+#ifdef HAVE_PTHREAD
+		pthread_mutex_unlock(&bin->mutex);
+#endif
+	}
+	if (ptr)
+	{
+		__sync_fetch_and_add(&ccv_matrix_pool_stat.hit_count, 1);
+		__sync_fetch_and_sub(&ccv_matrix_pool_stat.pooled, size);
+	} else
+		ccmemalign(&ptr, 64, size);
+	__sync_fetch_and_add(&ccv_matrix_pool_stat.alloc_count, 1);
+	_ccv_matrix_pool_high_water_mark(&ccv_matrix_pool_stat.allocated_high_water_mark, __sync_add_and_fetch(&ccv_matrix_pool_stat.allocated, size));
+	ccv_matrix_block_t* block = ccv_matrix_block(ptr);
+	block->size = size;
+	block->size_class = size_class;
+	return (ccv_dense_matrix_t*)ptr;
+}
+
+static void _ccv_matrix_pool_free(ccv_dense_matrix_t* mat)
+{
+	const ccv_matrix_block_t block = *ccv_matrix_block(mat);
+	__sync_fetch_and_add(&ccv_matrix_pool_stat.free_count, 1);
+	__sync_fetch_and_sub(&ccv_matrix_pool_stat.allocated, block.size);
+	// even the pool is disabled, the block has to be recognized, but we don't need to keep it any more
+	if (!ccv_matrix_pool_opt || block.size_class < 0 ||
+		__sync_add_and_fetch(&ccv_matrix_pool_stat.pooled, block.size) > ccv_matrix_pool_up)
+	{
+		if (ccv_matrix_pool_opt && block.size_class >= 0)
+			__sync_fetch_and_sub(&ccv_matrix_pool_stat.pooled, block.size);
+		ccfree(mat);
+		return;
+	}
+	_ccv_matrix_pool_high_water_mark(&ccv_matrix_pool_stat.pooled_high_water_mark, ccv_matrix_pool_stat.pooled);
+	ccv_matrix_pool_bin_t* bin = ccv_matrix_pool + block.size_class;
+#ifdef HAVE_PTHREAD
+	pthread_mutex_lock(&bin->mutex);
+#endif
+	*(void**)mat = bin->head;
+	bin->head = mat;
+#ifdef HAVE_PTHREAD
+	pthread_mutex_unlock(&bin->mutex);
+#endif
+}
+
+/* the arena that is current for this thread, arenas pushed earlier are linked through prev */
+static __thread ccv_arena_t* ccv_arena_current = 0;
+
+struct ccv_arena_chunk_s {
+	ccv_arena_chunk_t* next;
+	size_t size;
+};
+
+#define CCV_ARENA_CHUNK_HDR_SIZE ((sizeof(ccv_arena_chunk_t) + 63) & -64)
+#define CCV_DEFAULT_ARENA_CHUNK_SIZE (1024 * 1024)
+
+static ccv_arena_chunk_t* _ccv_arena_chunk_new(size_t size, ccv_arena_chunk_t* next)
+{
+	ccv_arena_chunk_t* chunk = 0;
+	ccmemalign((void**)&chunk, 64, CCV_ARENA_CHUNK_HDR_SIZE + size);
+	chunk->next = next;
+	chunk->size = size;
+	return chunk;
+}
+
+static void* _ccv_arena_alloc(ccv_arena_t* arena, size_t size, size_t align)
+{
+	unsigned char* ptr = (unsigned char*)(((uintptr_t)arena->ptr + align - 1) & -align);
+	if (ptr + size > arena->end)
+	{
+		if (size + align > arena->chunk_size / 4)
+		{
+			// it is too large, it will waste too much of a chunk, allocate separately
+			arena->large = _ccv_arena_chunk_new(size, arena->large);
+			arena->allocated += size;
+			return (unsigned char*)arena->large + CCV_ARENA_CHUNK_HDR_SIZE;
+		}
+		arena->chunk = _ccv_arena_chunk_new(arena->chunk_size, arena->chunk);
+		ptr = (unsigned char*)arena->chunk + CCV_ARENA_CHUNK_HDR_SIZE;
+		arena->end = ptr + arena->chunk_size;
+	}
+	arena->ptr = ptr + size;
+	arena->allocated += size;
+	return ptr;
+}
+
+ccv_arena_t* ccv_arena_new(size_t chunk_size)
+{
+	ccv_arena_t* arena = (ccv_arena_t*)ccmalloc(sizeof(ccv_arena_t));
+	arena->chunk_size = chunk_size > 0 ? (chunk_size + 63) & -64 : CCV_DEFAULT_ARENA_CHUNK_SIZE;
+	arena->allocated = 0;
+	arena->chunk = _ccv_arena_chunk_new(arena->chunk_size, 0);
+	arena->large = 0;
+	arena->ptr = (unsigned char*)arena->chunk + CCV_ARENA_CHUNK_HDR_SIZE;
+	arena->end = arena->ptr + arena->chunk_size;
+	arena->prev = 0;
+	return arena;
+}
+
+void* ccv_arena_alloc(ccv_arena_t* arena, size_t size)
+{
+	return _ccv_arena_alloc(arena, size, 16);
+}
+
+void ccv_arena_push(ccv_arena_t* arena)
+{
+	arena->prev = ccv_arena_current;
+	ccv_arena_current = arena;
+}
+
+void ccv_arena_pop(void)
+{
+	assert(ccv_arena_current);
+	ccv_arena_t* arena = ccv_arena_current;
+	ccv_arena_current = arena->prev;
+	arena->prev = 0;
+}
+
+static void _ccv_arena_chunk_free(ccv_arena_chunk_t* chunk)
+{
+	while (chunk)
+	{
+		ccv_arena_chunk_t* next = chunk->next;
+		ccfree(chunk);
+		chunk = next;
+	}
+}
+
+void ccv_arena_reset(ccv_arena_t* arena)
+{
+	// keep the oldest chunk, it is always a regular one
+	ccv_arena_chunk_t* chunk = arena->chunk;
+	while (chunk->next)
+	{
+		ccv_arena_chunk_t* next = chunk->next;
+		ccfree(chunk);
+		chunk = next;
+	}
+	arena->chunk = chunk;
+	_ccv_arena_chunk_free(arena->large);
+	arena->large = 0;
+	arena->ptr = (unsigned char*)chunk + CCV_ARENA_CHUNK_HDR_SIZE;
+	arena->end = arena->ptr + arena->chunk_size;
+	arena->allocated = 0;
+}
+
+void ccv_arena_free(ccv_arena_t* arena)
+{
+	assert(arena != ccv_arena_current);
+	_ccv_arena_chunk_free(arena->chunk);
+	_ccv_arena_chunk_free(arena->large);
+	ccfree(arena);
+}
+
+/* a dense matrix points into a mapped file is header-only and unmanaged (there is nothing for ccv to free in its data section),
+ * its header is allocated with a prefix block in front of it, which holds the mapped file and a tag. Headers from
+ * ccv_dense_matrix, ccv_reshape or a tensor share the same type, the tag is what tells a mapped matrix apart from these, thus,
+ * freeing any of these still trips the assertion on CCV_UNMANAGED */
+typedef struct {
+	ccv_mmap_t* mmap;
+	uintptr_t tag; // the address of the matrix header, xor'ed with CCV_DENSE_MATRIX_MMAP_TAG
+} ccv_dense_matrix_mmap_prefix_t;
+
+#define CCV_DENSE_MATRIX_MMAP_TAG ((uintptr_t)0x6363766d6d6170ULL) // "ccvmmap"
+#define ccv_dense_matrix_mmap_prefix(x) ((ccv_dense_matrix_mmap_prefix_t*)(x) - 1)
+
+static inline int ccv_dense_matrix_is_mapped(const ccv_dense_matrix_t* x)
+{
+	return ((x->type & (CCV_NO_DATA_ALLOC | CCV_UNMANAGED)) == (CCV_NO_DATA_ALLOC | CCV_UNMANAGED)) &&
+		ccv_dense_matrix_mmap_prefix(x)->tag == ((uintptr_t)x ^ CCV_DENSE_MATRIX_MMAP_TAG);
+}
+
+ccv_mmap_t* ccv_mmap_new(const char* filename)
+{
+#ifdef HAVE_MMAP
+	int fd = open(filename, O_RDONLY);
+	if (fd < 0)
+		return 0;
+	struct stat st;
+	if (fstat(fd, &st) < 0 || st.st_size == 0)
+	{
+		close(fd);
+		return 0;
+	}
+	// copy-on-write, in-place operations on a mapped matrix modify its own pages, but never the file
+	void* addr = mmap(0, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	// the mapping stays valid after the file descriptor is closed
+	close(fd);
+	if (addr == MAP_FAILED)
+		return 0;
+	ccv_mmap_t* map = (ccv_mmap_t*)ccmalloc(sizeof(ccv_mmap_t));
+	map->addr = addr;
+	map->size = st.st_size;
+	map->refcount = 1;
+	return map;
+#else
+	return 0;
+#endif
+}
+
+void ccv_mmap_free(ccv_mmap_t* mmap)
+{
+	if (__sync_sub_and_fetch(&mmap->refcount, 1) > 0)
+		return;
+#ifdef HAVE_MMAP
+	munmap(mmap->addr, mmap->size);
+#endif
+	ccfree(mmap);
+}
+
+ccv_dense_matrix_t* ccv_dense_matrix_new_mmap(ccv_mmap_t* mmap, size_t offset, int rows, int cols, int type, int step)
+{
+	assert(rows > 0 && cols > 0 && step >= CCV_GET_DATA_TYPE_SIZE(type) * CCV_GET_CHANNEL(type) * cols);
+	if (offset > mmap->size || (size_t)rows * step > mmap->size - offset)
+		return 0;
+	ccv_dense_matrix_mmap_prefix_t* prefix = (ccv_dense_matrix_mmap_prefix_t*)ccmalloc(sizeof(ccv_dense_matrix_mmap_prefix_t) + sizeof(ccv_dense_matrix_t));
+	ccv_dense_matrix_t* mat = (ccv_dense_matrix_t*)(prefix + 1);
+	prefix->mmap = mmap;
+	prefix->tag = (uintptr_t)mat ^ CCV_DENSE_MATRIX_MMAP_TAG;
+	__sync_fetch_and_add(&mmap->refcount, 1);
+	*mat = ccv_dense_matrix(rows, cols, type, (unsigned char*)mmap->addr + offset, 0);
+	mat->step = step;
+	mat->refcount = 1;
+	return mat;
+}
+
+/* free the memory of a dense matrix that is managed by ccv */
+static void _ccv_dense_matrix_free(ccv_dense_matrix_t* mat)
+{
+	if (ccv_dense_matrix_is_mapped(mat))
+	{
+		ccv_dense_matrix_mmap_prefix_t* prefix = ccv_dense_matrix_mmap_prefix(mat);
+		ccv_mmap_free(prefix->mmap);
+		prefix->tag = 0;
+		ccfree(prefix);
+	} else if (ccv_dense_matrix_in_block(mat))
+	{
+		// matrices in an arena are released altogether with the arena
+		if (ccv_matrix_block(mat)->size_class != CCV_MATRIX_BLOCK_ARENA)
+			_ccv_matrix_pool_free(mat);
+	} else
+		ccfree(mat);
+}
+
 ccv_dense_matrix_t* ccv_dense_matrix_new(int rows, int cols, int type, void* data, uint64_t sig)
 {
 	ccv_dense_matrix_t* mat;
-	if (ccv_cache_opt && sig != 0 && !data && !(type & CCV_NO_DATA_ALLOC))
+	if (_ccv_cache_enabled() && sig != 0 && !data && !(type & CCV_NO_DATA_ALLOC))
 	{
 		uint8_t type;
-		mat = (ccv_dense_matrix_t*)ccv_cache_out(&ccv_cache, sig, &type);
+		mat = (ccv_dense_matrix_t*)_ccv_cache_out(sig, &type);
 		if (mat)
 		{
 			assert(type == 0);
@@ -33,6 +551,19 @@ ccv_dense_matrix_t* ccv_dense_matrix_new(int rows, int cols, int type, void* dat
 		mat = (ccv_dense_matrix_t*)ccmalloc(sizeof(ccv_dense_matrix_t));
 		mat->type = (CCV_GET_CHANNEL(type) | CCV_GET_DATA_TYPE(type) | CCV_MATRIX_DENSE | CCV_NO_DATA_ALLOC) & ~CCV_GARBAGE;
 		mat->data.u8 = data;
+	} else if (!data && ccv_arena_current) {
+		const size_t size = CCV_MATRIX_BLOCK_HDR_SIZE + (size_t)CCV_GET_STEP(cols, type) * rows;
+		mat = (ccv_dense_matrix_t*)_ccv_arena_alloc(ccv_arena_current, size, 64);
+		ccv_matrix_block_t* block = ccv_matrix_block(mat);
+		block->size = size;
+		block->size_class = CCV_MATRIX_BLOCK_ARENA;
+		// not reusable, it cannot outlive the arena in the cache
+		mat->type = (CCV_GET_CHANNEL(type) | CCV_GET_DATA_TYPE(type) | CCV_MATRIX_DENSE) & ~CCV_GARBAGE;
+		mat->data.u8 = (unsigned char*)mat + CCV_MATRIX_BLOCK_HDR_SIZE;
+	} else if (!data && ccv_matrix_pool_opt) {
+		mat = _ccv_matrix_pool_alloc(CCV_MATRIX_BLOCK_HDR_SIZE + (size_t)CCV_GET_STEP(cols, type) * rows);
+		mat->type = (CCV_GET_CHANNEL(type) | CCV_GET_DATA_TYPE(type) | CCV_MATRIX_DENSE | CCV_REUSABLE) & ~CCV_GARBAGE;
+		mat->data.u8 = (unsigned char*)mat + CCV_MATRIX_BLOCK_HDR_SIZE;
 	} else {
 		const size_t hdr_size = (sizeof(ccv_dense_matrix_t) + 15) & -16;
 		mat = (ccv_dense_matrix_t*)(data ? data : ccmalloc(ccv_compute_dense_matrix_size(rows, cols, type)));
@@ -85,6 +616,29 @@ void ccv_make_matrix_mutable(ccv_matrix_t* mat)
 	}
 }
 
+static uint8_t key_siphash[16] = "libccvky4siphash";
+
+/* large matrices / arrays are signed by a hash tree: the data is split into chunks of fixed size, each chunk is hashed
+ * independently (in parallel), and the signature is derived from the chunk digests. The chunk size doesn't depend on
+ * the number of threads, thus, the signature is stable across runs and machines. Smaller ones are hashed directly. */
+#define CCV_SIGNATURE_CHUNK_SIZE (256 * 1024)
+#define CCV_SIGNATURE_TREE_THRESHOLD (4 * CCV_SIGNATURE_CHUNK_SIZE)
+
+static uint64_t _ccv_content_signature(const unsigned char* data, size_t size, uint64_t sig_start)
+{
+	if (size < CCV_SIGNATURE_TREE_THRESHOLD)
+		return ccv_cache_generate_signature((const char*)data, size, sig_start, CCV_EOF_SIGN);
+	const int chunks = (size + CCV_SIGNATURE_CHUNK_SIZE - 1) / CCV_SIGNATURE_CHUNK_SIZE;
+	uint8_t* digests = (uint8_t*)ccmalloc(sizeof(uint64_t) * chunks);
+	parallel_for(i, chunks) {
+		const size_t offset = (size_t)i * CCV_SIGNATURE_CHUNK_SIZE;
+		siphash(digests + i * sizeof(uint64_t), data + offset, ccv_min(CCV_SIGNATURE_CHUNK_SIZE, size - offset), key_siphash);
+	} parallel_endfor
+	uint64_t sig = ccv_cache_generate_signature((const char*)digests, sizeof(uint64_t) * chunks, sig_start, CCV_EOF_SIGN);
+	ccfree(digests);
+	return sig;
+}
+
 void ccv_make_matrix_immutable(ccv_matrix_t* mat)
 {
 	int type = *(int*)mat;
@@ -95,7 +649,8 @@ void ccv_make_matrix_immutable(ccv_matrix_t* mat)
 		/* immutable matrix made this way is not reusable (collected), because its signature
 		 * only depends on the content, not the operation to generate it */
 		dmt->type &= ~CCV_REUSABLE;
-		dmt->sig = ccv_cache_generate_signature((char*)dmt->data.u8, dmt->rows * dmt->step, (uint64_t)dmt->type, CCV_EOF_SIGN);
+		// only the data type / channels matter, how the data section is allocated doesn't
+		dmt->sig = _ccv_content_signature(dmt->data.u8, (size_t)dmt->rows * dmt->step, (uint64_t)(CCV_GET_DATA_TYPE(dmt->type) | CCV_GET_CHANNEL(dmt->type) | CCV_MATRIX_DENSE));
 	}
 }
 
@@ -140,12 +695,12 @@ ccv_sparse_matrix_t* ccv_sparse_matrix_new(int rows, int cols, int type, int maj
 void ccv_matrix_free_immediately(ccv_matrix_t* mat)
 {
 	int type = *(int*)mat;
-	assert(!(type & CCV_UNMANAGED));
+	assert(!(type & CCV_UNMANAGED) || ccv_dense_matrix_is_mapped((ccv_dense_matrix_t*)mat));
 	if (type & CCV_MATRIX_DENSE)
 	{
 		ccv_dense_matrix_t* dmt = (ccv_dense_matrix_t*)mat;
 		dmt->refcount = 0;
-		ccfree(dmt);
+		_ccv_dense_matrix_free(dmt);
 	} else if (type & CCV_MATRIX_SPARSE) {
 		ccv_sparse_matrix_t* smt = (ccv_sparse_matrix_t*)mat;
 		int i;
@@ -164,16 +719,16 @@ void ccv_matrix_free_immediately(ccv_matrix_t* mat)
 void ccv_matrix_free(ccv_matrix_t* mat)
 {
 	int type = *(int*)mat;
-	assert(!(type & CCV_UNMANAGED));
+	assert(!(type & CCV_UNMANAGED) || ccv_dense_matrix_is_mapped((ccv_dense_matrix_t*)mat));
 	if (type & CCV_MATRIX_DENSE)
 	{
 		ccv_dense_matrix_t* dmt = (ccv_dense_matrix_t*)mat;
 		dmt->refcount = 0;
-		if (!ccv_cache_opt || // e don't enable cache
+		if (!_ccv_cache_enabled() || // e don't enable cache
 			!(dmt->type & CCV_REUSABLE) || // or this is not a reusable piece
 			dmt->sig == 0 || // or this doesn't have valid signature
 			(dmt->type & CCV_NO_DATA_ALLOC)) // or this matrix is allocated as header-only, therefore we cannot cache it
-			ccfree(dmt);
+			_ccv_dense_matrix_free(dmt);
 		else {
 			assert(CCV_GET_DATA_TYPE(dmt->type) == CCV_8U ||
 				   CCV_GET_DATA_TYPE(dmt->type) == CCV_32S ||
@@ -181,7 +736,8 @@ void ccv_matrix_free(ccv_matrix_t* mat)
 				   CCV_GET_DATA_TYPE(dmt->type) == CCV_64S ||
 				   CCV_GET_DATA_TYPE(dmt->type) == CCV_64F);
 			size_t size = ccv_compute_dense_matrix_size(dmt->rows, dmt->cols, dmt->type);
-			ccv_cache_put(&ccv_cache, dmt->sig, dmt, size, 0 /* type 0 */);
+			if (_ccv_cache_put(dmt->sig, dmt, size, 0 /* type 0 */) < 0) // the matrix is too large to fit in the cache
+				_ccv_dense_matrix_free(dmt);
 		}
 	} else if (type & CCV_MATRIX_SPARSE) {
 		ccv_sparse_matrix_t* smt = (ccv_sparse_matrix_t*)mat;
@@ -204,10 +760,10 @@ void ccv_matrix_free(ccv_matrix_t* mat)
 ccv_array_t* ccv_array_new(int rsize, int rnum, uint64_t sig)
 {
 	ccv_array_t* array;
-	if (ccv_cache_opt && sig != 0)
+	if (_ccv_cache_enabled() && sig != 0)
 	{
 		uint8_t type;
-		array = (ccv_array_t*)ccv_cache_out(&ccv_cache, sig, &type);
+		array = (ccv_array_t*)_ccv_cache_out(sig, &type);
 		if (array)
 		{
 			assert(type == 1);
@@ -216,13 +772,24 @@ ccv_array_t* ccv_array_new(int rsize, int rnum, uint64_t sig)
 			return array;
 		}
 	}
-	array = (ccv_array_t*)ccmalloc(sizeof(ccv_array_t));
+	if (ccv_arena_current)
+	{
+		// not reusable, it cannot outlive the arena in the cache
+		ccv_arena_t** arena = (ccv_arena_t**)_ccv_arena_alloc(ccv_arena_current, sizeof(ccv_arena_t*) + sizeof(ccv_array_t), 16);
+		arena[0] = ccv_arena_current;
+		array = (ccv_array_t*)(arena + 1);
+		array->type = CCV_UNMANAGED & ~CCV_GARBAGE;
+		array->size = ccv_max(rnum, 2 /* allocate memory for at least 2 items */);
+		array->data = _ccv_arena_alloc(ccv_arena_current, (size_t)array->size * (size_t)rsize, 16);
+	} else {
+		array = (ccv_array_t*)ccmalloc(sizeof(ccv_array_t));
+		array->type = CCV_REUSABLE & ~CCV_GARBAGE;
+		array->size = ccv_max(rnum, 2 /* allocate memory for at least 2 items */);
+		array->data = ccmalloc((size_t)array->size * (size_t)rsize);
+	}
 	array->sig = sig;
-	array->type = CCV_REUSABLE & ~CCV_GARBAGE;
 	array->rnum = 0;
 	array->rsize = rsize;
-	array->size = ccv_max(rnum, 2 /* allocate memory for at least 2 items */);
-	array->data = ccmalloc((size_t)array->size * (size_t)rsize);
 	return array;
 }
 
@@ -237,39 +804,68 @@ void ccv_make_array_immutable(ccv_array_t* array)
 	assert(array->sig == 0);
 	array->type &= ~CCV_REUSABLE;
 	/* TODO: trim the array */
-	array->sig = ccv_cache_generate_signature(array->data, array->size * array->rsize, (uint64_t)array->rsize, CCV_EOF_SIGN);
+	array->sig = _ccv_content_signature((unsigned char*)array->data, (size_t)array->size * array->rsize, (uint64_t)array->rsize);
 }
 
 void ccv_array_free_immediately(ccv_array_t* array)
 {
 	array->refcount = 0;
+	if (array->type & CCV_UNMANAGED) // arrays in an arena are released altogether with the arena
+		return;
 	ccfree(array->data);
 	ccfree(array);
 }
 
 void ccv_array_free(ccv_array_t* array)
 {
-	if (!ccv_cache_opt || !(array->type & CCV_REUSABLE) || array->sig == 0)
+	if (array->type & CCV_UNMANAGED)
+	{
+		array->refcount = 0;
+		return;
+	}
+	if (!_ccv_cache_enabled() || !(array->type & CCV_REUSABLE) || array->sig == 0)
 	{
 		array->refcount = 0;
 		ccfree(array->data);
 		ccfree(array);
 	} else {
 		size_t size = sizeof(ccv_array_t) + array->size * array->rsize;
-		ccv_cache_put(&ccv_cache, array->sig, array, size, 1 /* type 1 */);
+		if (_ccv_cache_put(array->sig, array, size, 1 /* type 1 */) < 0)
+			ccv_array_free_immediately(array);
 	}
 }
 
 void ccv_drain_cache(void)
 {
-	if (ccv_cache.rnum > 0)
-		ccv_cache_cleanup(&ccv_cache);
+	_ccv_cache_close(&ccv_cache, 0);
+#ifdef HAVE_PTHREAD
+	int i;
+	for (i = 0; i < CCV_SHARED_CACHE_SHARDS; i++)
+	{
+		pthread_mutex_lock(&ccv_shared_cache[i].mutex);
+		_ccv_cache_close(&ccv_shared_cache[i].cache, 0);
+		pthread_mutex_unlock(&ccv_shared_cache[i].mutex);
+	}
+#endif
 }
 
 void ccv_disable_cache(void)
 {
 	ccv_cache_opt = 0;
-	ccv_cache_close(&ccv_cache);
+	_ccv_cache_close(&ccv_cache, 1);
+#ifdef HAVE_PTHREAD
+	if (ccv_shared_cache_opt)
+	{
+		ccv_shared_cache_opt = 0;
+		int i;
+		for (i = 0; i < CCV_SHARED_CACHE_SHARDS; i++)
+		{
+			pthread_mutex_lock(&ccv_shared_cache[i].mutex);
+			_ccv_cache_close(&ccv_shared_cache[i].cache, 1);
+			pthread_mutex_unlock(&ccv_shared_cache[i].mutex);
+		}
+	}
+#endif
 }
 
 void ccv_enable_cache(size_t size)
@@ -278,12 +874,145 @@ void ccv_enable_cache(size_t size)
 	ccv_cache_init(&ccv_cache, size, 2, ccv_matrix_free_immediately, ccv_array_free_immediately);
 }
 
+void ccv_enable_shared_cache(size_t size)
+{
+#ifdef HAVE_PTHREAD
+	int i;
+	for (i = 0; i < CCV_SHARED_CACHE_SHARDS; i++)
+	{
+		pthread_mutex_lock(&ccv_shared_cache[i].mutex);
+		ccv_cache_init(&ccv_shared_cache[i].cache, size / CCV_SHARED_CACHE_SHARDS, 2, ccv_matrix_free_immediately, ccv_array_free_immediately);
+		pthread_mutex_unlock(&ccv_shared_cache[i].mutex);
+	}
+	ccv_shared_cache_opt = 1;
+#else
+	// without pthread, there is no way to share the cache safely, fallback to the thread-local one
+	ccv_enable_cache(size);
+#endif
+}
+
 void ccv_enable_default_cache(void)
 {
 	ccv_enable_cache(CCV_DEFAULT_CACHE_SIZE);
 }
 
-static uint8_t key_siphash[16] = "libccvky4siphash";
+void ccv_cache_stats(ccv_cache_stats_t* stats)
+{
+	stats->hits = ccv_cache_stat.hits;
+	stats->misses = ccv_cache_stat.misses;
+	stats->evictions = ccv_cache_stat.evictions;
+	int i;
+	for (i = 0; i < 2; i++)
+	{
+		stats->rnum[i] = ccv_cache_stat.rnum[i];
+		stats->size[i] = ccv_cache_stat.size[i];
+	}
+	uint64_t departures = ccv_cache_stat.departures;
+	stats->lifetime = departures > 0 ? (double)ccv_cache_stat.lifetime / departures : 0;
+}
+
+void ccv_reset_cache_stats(void)
+{
+	ccv_cache_stat.hits = 0;
+	ccv_cache_stat.misses = 0;
+	ccv_cache_stat.evictions = 0;
+	ccv_cache_stat.departures = 0;
+	ccv_cache_stat.lifetime = 0;
+}
+
+void ccv_enable_cache_source_stats(void)
+{
+	ccv_cache_source_opt = 1;
+}
+
+void ccv_disable_cache_source_stats(void)
+{
+	ccv_cache_source_opt = 0;
+#ifdef HAVE_PTHREAD
+	pthread_mutex_lock(&ccv_cache_source_mutex);
+#endif
+	memset(ccv_cache_source_stat, 0, sizeof(ccv_cache_source_stat));
+#ifdef HAVE_PTHREAD
+	pthread_mutex_unlock(&ccv_cache_source_mutex);
+#endif
+}
+
+#define less_than(s1, s2, aux) ((s1).hits + (s1).misses > (s2).hits + (s2).misses)
+static CCV_IMPLEMENT_QSORT(_ccv_cache_source_qsort, ccv_cache_source_stats_t, less_than)
+#undef less_than
+
+int ccv_cache_source_stats(ccv_cache_source_stats_t* sources, int size)
+{
+	ccv_cache_source_stats_t stats[CCV_CACHE_SOURCES];
+	int i, rnum = 0;
+#ifdef HAVE_PTHREAD
+	pthread_mutex_lock(&ccv_cache_source_mutex);
+#endif
+	for (i = 0; i < CCV_CACHE_SOURCES; i++)
+		if (ccv_cache_source_stat[i].source)
+			stats[rnum++] = ccv_cache_source_stat[i];
+#ifdef HAVE_PTHREAD
+	pthread_mutex_unlock(&ccv_cache_source_mutex);
+#endif
+	_ccv_cache_source_qsort(stats, rnum, 0);
+	rnum = ccv_min(rnum, size);
+	memcpy(sources, stats, sizeof(ccv_cache_source_stats_t) * rnum);
+	return rnum;
+}
+
+void ccv_dump_cache_stats(FILE* stream)
+{
+	ccv_cache_stats_t stats;
+	ccv_cache_stats(&stats);
+	uint64_t lookups = stats.hits + stats.misses;
+	fprintf(stream, "cache: %llu hits, %llu misses (%.2f%% hit rate), %llu evictions, average lifetime %.2f puts\n", (unsigned long long)stats.hits, (unsigned long long)stats.misses, lookups > 0 ? stats.hits * 100.0 / lookups : 0, (unsigned long long)stats.evictions, stats.lifetime);
+	fprintf(stream, "cache: %u matrices in %zu bytes, %u arrays in %zu bytes\n", stats.rnum[0], stats.size[0], stats.rnum[1], stats.size[1]);
+	ccv_cache_source_stats_t sources[CCV_CACHE_SOURCES];
+	int i, rnum = ccv_cache_source_stats(sources, CCV_CACHE_SOURCES);
+	for (i = 0; i < rnum; i++)
+		fprintf(stream, "cache: %-40s %10llu hits %10llu misses\n", sources[i].source, (unsigned long long)sources[i].hits, (unsigned long long)sources[i].misses);
+}
+
+void ccv_enable_matrix_pool(size_t size)
+{
+	ccv_matrix_pool_up = size;
+	ccv_matrix_pool_opt = 1;
+}
+
+void ccv_drain_matrix_pool(void)
+{
+	int i;
+	for (i = 0; i < CCV_MATRIX_POOL_SIZE_CLASSES; i++)
+	{
+		ccv_matrix_pool_bin_t* bin = ccv_matrix_pool + i;
+#ifdef HAVE_PTHREAD
+		pthread_mutex_lock(&bin->mutex);
+#endif
+		void* head = bin->head;
+		bin->head = 0;
+#ifdef HAVE_PTHREAD
+		pthread_mutex_unlock(&bin->mutex);
+#endif
+		while (head)
+		{
+			void* next = *(void**)head;
+			__sync_fetch_and_sub(&ccv_matrix_pool_stat.pooled, ccv_matrix_block(head)->size);
+			ccfree(head);
+			head = next;
+		}
+	}
+}
+
+void ccv_disable_matrix_pool(void)
+{
+	ccv_matrix_pool_opt = 0;
+	ccv_drain_matrix_pool();
+}
+
+void ccv_matrix_pool_stats(ccv_matrix_pool_stats_t* stats)
+{
+	*stats = ccv_matrix_pool_stat;
+}
 
 uint64_t ccv_cache_generate_signature(const char* msg, int len, uint64_t sig_start, ...)
 {
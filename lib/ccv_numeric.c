@@ -1,6 +1,11 @@
 #include "ccv.h"
 #include "ccv_internal.h"
 #include <complex.h>
+#if defined(HAVE_SSE2)
+#include <emmintrin.h>
+#elif defined(HAVE_NEON)
+#include <arm_neon.h>
+#endif
 #ifdef HAVE_FFTW3
 #include <pthread.h>
 #include <fftw3.h>
@@ -580,382 +585,384 @@ static int _ccv_get_optimal_fft_size(int size)
     return _ccv_optimal_fft_size[b];
 }
 
+/* the planner of FFTW is not thread-safe, plans are created and destroyed with this lock held, executing them doesn't need it */
 static pthread_mutex_t fftw_plan_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/* FFT plan for a given kernel size and FFT size, with the kernels of that size in frequency domain */
+typedef struct {
+	int krows; // the kernel size
+	int kcols;
+	int rows; // the FFT size
+	int cols;
+	int ch;
+	int fft_type;
+	int ystride; // the strides of the real buffer
+	int xstride;
+	int kstride;
+	size_t real_size; // the size of the real buffer
+	size_t cpx_size; // the size of the complex buffer
+	void* forward;
+	void* inverse;
+	int count;
+	int* idx; // for a filter bank, which kernels are of this size
+	void** spectra;
+} ccv_filter_plan_t;
+
+static int _ccv_filter_fft_size(int size, int ksize)
+{
+#ifdef HAVE_FFTW3
+	return ccv_min(size + ksize - 1, _ccv_get_optimal_fft_size(ksize * 3));
+#else
+	return ((ccv_min(size + ksize - 1, kiss_fftr_next_fast_size_real(ksize * 3)) + 1) >> 1) << 1;
+#endif
+}
+
+static int _ccv_filter_fft_type(int type)
+{
+	return (CCV_GET_DATA_TYPE(type) == CCV_8U || CCV_GET_DATA_TYPE(type) == CCV_32F) ? CCV_32F : CCV_64F;
+}
+
+static void* _ccv_filter_fft_malloc(size_t size)
+{
+#ifdef HAVE_FFTW3
+	return fftw_malloc(size);
+#else
+	return ccmalloc(size);
+#endif
+}
 
-static void _ccv_filter_fftw(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b, ccv_dense_matrix_t* d, int padding_pattern)
+static void _ccv_filter_fft_free(void* ptr)
 {
-	int ch = CCV_GET_CHANNEL(a->type);
-	int fft_type = (CCV_GET_DATA_TYPE(d->type) == CCV_8U || CCV_GET_DATA_TYPE(d->type) == CCV_32F) ? CCV_32F : CCV_64F;
-	int rows = ccv_min(a->rows + b->rows - 1, _ccv_get_optimal_fft_size(b->rows * 3));
-	int cols = ccv_min(a->cols + b->cols - 1, _ccv_get_optimal_fft_size(b->cols * 3));
-	int cols_2c = 2 * (cols / 2 + 1);
-	void* fftw_a;
-	void* fftw_b;
-	void* fftw_d;
-	fftw_plan p, pinv;
-	fftwf_plan pf, pinvf;
-	if (fft_type == CCV_32F)
+#ifdef HAVE_FFTW3
+	fftw_free(ptr);
+#else
+	ccfree(ptr);
+#endif
+}
+
+static void* _ccv_filter_fft_cfg_new(ccv_filter_plan_t* plan, int inverse)
+{
+	int ndim[] = {plan->rows, plan->cols};
+#ifdef HAVE_FFTW3
+	void* cfg;
+	pthread_mutex_lock(&fftw_plan_mutex);
+	if (plan->fft_type == CCV_32F)
 	{
-		fftw_a = fftwf_malloc(rows * cols_2c * ch * sizeof(float));
-		fftw_b = fftwf_malloc(rows * cols_2c * ch * sizeof(float));
-		fftw_d = fftwf_malloc(rows * cols_2c * ch * sizeof(float));
-		pthread_mutex_lock(&fftw_plan_mutex);
-		if (ch == 1)
-		{
-			pf = fftwf_plan_dft_r2c_2d(rows, cols, 0, 0, FFTW_ESTIMATE);
-			pinvf = fftwf_plan_dft_c2r_2d(rows, cols, 0, 0, FFTW_ESTIMATE);
-		} else {
-			int ndim[] = {rows, cols};
-			pf = fftwf_plan_many_dft_r2c(2, ndim, ch, 0, 0, ch, 1, 0, 0, ch, 1, FFTW_ESTIMATE);
-			pinvf = fftwf_plan_many_dft_c2r(2, ndim, ch, 0, 0, ch, 1, 0, 0, ch, 1, FFTW_ESTIMATE);
-		}
-		pthread_mutex_unlock(&fftw_plan_mutex);
+		if (plan->ch == 1)
+			cfg = inverse ? (void*)fftwf_plan_dft_c2r_2d(plan->rows, plan->cols, 0, 0, FFTW_ESTIMATE) : (void*)fftwf_plan_dft_r2c_2d(plan->rows, plan->cols, 0, 0, FFTW_ESTIMATE);
+		else
+			cfg = inverse ? (void*)fftwf_plan_many_dft_c2r(2, ndim, plan->ch, 0, 0, plan->ch, 1, 0, 0, plan->ch, 1, FFTW_ESTIMATE) : (void*)fftwf_plan_many_dft_r2c(2, ndim, plan->ch, 0, 0, plan->ch, 1, 0, 0, plan->ch, 1, FFTW_ESTIMATE);
 	} else {
-		fftw_a = fftw_malloc(rows * cols_2c * ch * sizeof(double));
-		fftw_b = fftw_malloc(rows * cols_2c * ch * sizeof(double));
-		fftw_d = fftw_malloc(rows * cols_2c * ch * sizeof(double));
-		pthread_mutex_lock(&fftw_plan_mutex);
-		if (ch == 1)
-		{
-			p = fftw_plan_dft_r2c_2d(rows, cols, 0, 0, FFTW_ESTIMATE);
-			pinv = fftw_plan_dft_c2r_2d(rows, cols, 0, 0, FFTW_ESTIMATE);
-		} else {
-			int ndim[] = {rows, cols};
-			p = fftw_plan_many_dft_r2c(2, ndim, ch, 0, 0, ch, 1, 0, 0, ch, 1, FFTW_ESTIMATE);
-			pinv = fftw_plan_many_dft_c2r(2, ndim, ch, 0, 0, ch, 1, 0, 0, ch, 1, FFTW_ESTIMATE);
-		}
-		pthread_mutex_unlock(&fftw_plan_mutex);
+		if (plan->ch == 1)
+			cfg = inverse ? (void*)fftw_plan_dft_c2r_2d(plan->rows, plan->cols, 0, 0, FFTW_ESTIMATE) : (void*)fftw_plan_dft_r2c_2d(plan->rows, plan->cols, 0, 0, FFTW_ESTIMATE);
+		else
+			cfg = inverse ? (void*)fftw_plan_many_dft_c2r(2, ndim, plan->ch, 0, 0, plan->ch, 1, 0, 0, plan->ch, 1, FFTW_ESTIMATE) : (void*)fftw_plan_many_dft_r2c(2, ndim, plan->ch, 0, 0, plan->ch, 1, 0, 0, plan->ch, 1, FFTW_ESTIMATE);
 	}
-	memset(fftw_b, 0, rows * cols_2c * ch * CCV_GET_DATA_TYPE_SIZE(fft_type));
+	pthread_mutex_unlock(&fftw_plan_mutex);
+	return cfg;
+#else
+	if (plan->fft_type == CCV_32F)
+		return kissf_fftndr_alloc(ndim, 2, inverse, 0, 0);
+	return kiss_fftndr_alloc(ndim, 2, inverse, 0, 0);
+#endif
+}
 
-	int i, j, k;
-	unsigned char* m_ptr = b->data.u8;
-	// to flip matrix b is crucial, this problem only shows when I changed to a more sophisticated test case
-#define for_block(_for_type, _for_get) \
-	_for_type* fftw_ptr = (_for_type*)fftw_b + (b->rows - 1) * cols_2c * ch; \
-	for (i = 0; i < b->rows; i++) \
+static void _ccv_filter_fft_cfg_free(ccv_filter_plan_t* plan, void* cfg)
+{
+#ifdef HAVE_FFTW3
+	pthread_mutex_lock(&fftw_plan_mutex);
+	if (plan->fft_type == CCV_32F)
+		fftwf_destroy_plan((fftwf_plan)cfg);
+	else
+		fftw_destroy_plan((fftw_plan)cfg);
+	pthread_mutex_unlock(&fftw_plan_mutex);
+#else
+	if (plan->fft_type == CCV_32F)
+		kissf_fft_free(cfg);
+	else
+		kiss_fft_free(cfg);
+#endif
+}
+
+static void _ccv_filter_fft_r2c(ccv_filter_plan_t* plan, void* cfg, void* real, void* cpx)
+{
+#ifdef HAVE_FFTW3
+	if (plan->fft_type == CCV_32F)
+		fftwf_execute_dft_r2c((fftwf_plan)cfg, (float*)real, (fftwf_complex*)cpx);
+	else
+		fftw_execute_dft_r2c((fftw_plan)cfg, (double*)real, (fftw_complex*)cpx);
+#else
+	int k;
+	const int nch = plan->rows * plan->cols, nchc = plan->rows * (plan->cols / 2 + 1);
+	if (plan->fft_type == CCV_32F)
+		for (k = 0; k < plan->ch; k++)
+			kissf_fftndr((kissf_fftndr_cfg)cfg, (kissf_fft_scalar*)real + nch * k, (kissf_fft_cpx*)cpx + nchc * k);
+	else
+		for (k = 0; k < plan->ch; k++)
+			kiss_fftndr((kiss_fftndr_cfg)cfg, (kiss_fft_scalar*)real + nch * k, (kiss_fft_cpx*)cpx + nchc * k);
+#endif
+}
+
+static void _ccv_filter_fft_c2r(ccv_filter_plan_t* plan, void* cfg, void* cpx, void* real)
+{
+#ifdef HAVE_FFTW3
+	if (plan->fft_type == CCV_32F)
+		fftwf_execute_dft_c2r((fftwf_plan)cfg, (fftwf_complex*)cpx, (float*)real);
+	else
+		fftw_execute_dft_c2r((fftw_plan)cfg, (fftw_complex*)cpx, (double*)real);
+#else
+	int k;
+	const int nch = plan->rows * plan->cols, nchc = plan->rows * (plan->cols / 2 + 1);
+	if (plan->fft_type == CCV_32F)
+		for (k = 0; k < plan->ch; k++)
+			kissf_fftndri((kissf_fftndr_cfg)cfg, (kissf_fft_cpx*)cpx + nchc * k, (kissf_fft_scalar*)real + nch * k);
+	else
+		for (k = 0; k < plan->ch; k++)
+			kiss_fftndri((kiss_fftndr_cfg)cfg, (kiss_fft_cpx*)cpx + nchc * k, (kiss_fft_scalar*)real + nch * k);
+#endif
+}
+
+/* dc = ac * bc / (rows * cols), element-wise */
+static void _ccv_filter_fft_mul(ccv_filter_plan_t* plan, void* ac, void* bc, void* dc)
+{
+	int x;
+	const int n = plan->rows * (plan->cols / 2 + 1) * plan->ch;
+#ifdef HAVE_FFTW3
+#define for_block(_for_type, _cpx_type) \
+	_for_type scale = 1.0 / (plan->rows * plan->cols); \
+	_cpx_type* fft_ac = (_cpx_type*)ac; \
+	_cpx_type* fft_bc = (_cpx_type*)bc; \
+	_cpx_type* fft_dc = (_cpx_type*)dc; \
+	for (x = 0; x < n; x++) \
+		fft_dc[x] = (fft_ac[x] * fft_bc[x]) * scale;
+	if (plan->fft_type == CCV_32F)
+		{ for_block(float, fftwf_complex); }
+	else
+		{ for_block(double, fftw_complex); }
+#else
+#define for_block(_for_type, _cpx_type) \
+	_for_type scale = 1.0 / (plan->rows * plan->cols); \
+	_cpx_type* fft_ac = (_cpx_type*)ac; \
+	_cpx_type* fft_bc = (_cpx_type*)bc; \
+	_cpx_type* fft_dc = (_cpx_type*)dc; \
+	for (x = 0; x < n; x++) \
 	{ \
-		for (j = 0; j < b->cols; j++) \
-			for (k = 0; k < ch; k++) \
-				fftw_ptr[(b->cols - 1 - j) * ch + k] = _for_get(m_ptr, j * ch + k, 0); \
-		fftw_ptr -= cols_2c * ch; \
-		m_ptr += b->step; \
+		fft_dc[x].r = (fft_ac[x].r * fft_bc[x].r - fft_ac[x].i * fft_bc[x].i) * scale; \
+		fft_dc[x].i = (fft_ac[x].i * fft_bc[x].r + fft_ac[x].r * fft_bc[x].i) * scale; \
 	}
-	ccv_matrix_typeof(fft_type, ccv_matrix_getter, b->type, for_block);
-#undef for_block
-	if (fft_type == CCV_32F)
-		fftwf_execute_dft_r2c(pf, (float*)fftw_b, (fftwf_complex*)fftw_b);
+	if (plan->fft_type == CCV_32F)
+		{ for_block(kissf_fft_scalar, kissf_fft_cpx); }
 	else
-		fftw_execute_dft_r2c(p, (double*)fftw_b, (fftw_complex*)fftw_b);
-	/* why a->cols + cols - 2 * (b->cols & ~1) ?
-	 * what we really want is ceiling((a->cols - (b->cols & ~1)) / (cols - (b->cols & ~1)))
-	 * in this case, we strip out paddings on the left/right, and compute how many tiles
-	 * we need. It then be interpreted in the above integer division form */
-	int tile_x = ccv_max(1, (a->cols + cols - 2 * (b->cols & ~1)) / (cols - (b->cols & ~1)));
-	int tile_y = ccv_max(1, (a->rows + rows - 2 * (b->rows & ~1)) / (rows - (b->rows & ~1)));
-	int brows2 = b->rows / 2;
-	int bcols2 = b->cols / 2;
-#define for_block(_for_type, _cpx_type, _for_set, _for_get) \
-	_for_type scale = 1.0 / (rows * cols); \
-	for (i = 0; i < tile_y; i++) \
-		for (j = 0; j < tile_x; j++) \
-		{ \
-			int x, y; \
-			memset(fftw_a, 0, rows * cols_2c * ch * sizeof(_for_type)); \
-			int iy = ccv_min(i * (rows - (b->rows & ~1)), ccv_max(a->rows - rows, 0)); \
-			int ix = ccv_min(j * (cols - (b->cols & ~1)), ccv_max(a->cols - cols, 0)); \
-			_for_type* fftw_ptr = (_for_type*)fftw_a; \
-			int end_y = ccv_min(rows, a->rows - iy); \
-			int end_x = ccv_min(cols, a->cols - ix); \
-			m_ptr = (unsigned char*)ccv_get_dense_matrix_cell(a, iy, ix, 0); \
-			for (y = 0; y < end_y; y++) \
-			{ \
-				for (x = 0; x < end_x * ch; x++) \
-					fftw_ptr[x] = _for_get(m_ptr, x, 0); \
-				fftw_ptr += cols_2c * ch; \
-				m_ptr += a->step; \
-			} \
-			_cpx_type* fftw_ac = (_cpx_type*)fftw_a; \
-			_cpx_type* fftw_bc = (_cpx_type*)fftw_b; \
-			_cpx_type* fftw_dc = (_cpx_type*)fftw_d; \
-			fft_execute_dft_r2c((_for_type*)fftw_a, (_cpx_type*)fftw_ac); \
-			for (x = 0; x < rows * ch * (cols / 2 + 1); x++) \
-				fftw_dc[x] = (fftw_ac[x] * fftw_bc[x]) * scale; \
-			fft_execute_dft_c2r((_cpx_type*)fftw_dc, (_for_type*)fftw_d); \
-			fftw_ptr = (_for_type*)fftw_d + ((1 + (i > 0)) * brows2 * cols_2c + (1 + (j > 0)) * bcols2) * ch; \
-			end_y = ccv_min(d->rows - (iy + (i > 0) * brows2), \
-							(rows - (b->rows & ~1)) + (i == 0) * brows2); \
-			end_x = ccv_min(d->cols - (ix + (j > 0) * bcols2), \
-							(cols - (b->cols & ~1)) + (j == 0) * bcols2); \
-			m_ptr = (unsigned char*)ccv_get_dense_matrix_cell(d, iy + (i > 0) * brows2, ix + (j > 0) * bcols2, 0); \
-			for (y = 0; y < end_y; y++) \
-			{ \
-				for (x = 0; x < end_x * ch; x++) \
-					_for_set(m_ptr, x, fftw_ptr[x], 0); \
-				m_ptr += d->step; \
-				fftw_ptr += cols_2c * ch; \
-			} \
-			int end_tile_y, end_tile_x; \
-			/* handle edge cases: */ \
-			if (i + 1 == tile_y && end_y + iy + (i > 0) * brows2 < d->rows) \
-			{ \
-				end_tile_y = ccv_min(brows2, d->rows - (iy + (i > 0) * brows2 + end_y)); \
-				fftw_ptr = (_for_type*)fftw_d + (1 + (j > 0)) * bcols2 * ch; \
-				m_ptr = (unsigned char*)ccv_get_dense_matrix_cell(d, iy + (i > 0) * brows2 + end_y, ix + (j > 0) * bcols2, 0); \
-				for (y = 0; y < end_tile_y; y++) \
-				{ \
-					for (x = 0; x < end_x * ch; x++) \
-						_for_set(m_ptr, x, fftw_ptr[x], 0); \
-					m_ptr += d->step; \
-					fftw_ptr += cols_2c * ch; \
-				} \
-			} \
-			if (j + 1 == tile_x && end_x + ix + (j > 0) * bcols2 < d->cols) \
-			{ \
-				end_tile_x = ccv_min(bcols2, d->cols - (ix + (j > 0) * bcols2 + end_x)); \
-				fftw_ptr = (_for_type*)fftw_d + (1 + (i > 0)) * brows2 * cols_2c * ch; \
-				m_ptr = (unsigned char*)ccv_get_dense_matrix_cell(d, iy + (i > 0) * brows2, ix + (j > 0) * bcols2 + end_x, 0); \
-				for (y = 0; y < end_y; y++) \
-				{ \
-					for (x = 0; x < end_tile_x * ch; x++) \
-						_for_set(m_ptr, x, fftw_ptr[x], 0); \
-					m_ptr += d->step; \
-					fftw_ptr += cols_2c * ch; \
-				} \
-			} \
-			if (i + 1 == tile_y && end_y + iy + (i > 0) * brows2 < d->rows && \
-				j + 1 == tile_x && end_x + ix + (j > 0) * bcols2 < d->cols) \
-			{ \
-				fftw_ptr = (_for_type*)fftw_d; \
-				m_ptr = (unsigned char*)ccv_get_dense_matrix_cell(d, iy + (i > 0) * brows2 + end_y, ix + (j > 0) * bcols2 + end_x, 0); \
-				for (y = 0; y < end_tile_y; y++) \
-				{ \
-					for (x = 0; x < end_tile_x * ch; x++) \
-						_for_set(m_ptr, x, fftw_ptr[x], 0); \
-					m_ptr += d->step; \
-					fftw_ptr += cols_2c * ch; \
-				} \
-			} \
-		}
-	if (fft_type == CCV_32F)
-	{
-#define fft_execute_dft_r2c(r, c) fftwf_execute_dft_r2c(pf, r, c)
-#define fft_execute_dft_c2r(c, r) fftwf_execute_dft_c2r(pinvf, c, r)
-		ccv_matrix_setter(d->type, ccv_matrix_getter, a->type, for_block, float, fftwf_complex);
-#undef fft_execute_dft_r2c
-#undef fft_execute_dft_c2r
-		pthread_mutex_lock(&fftw_plan_mutex);
-		fftwf_destroy_plan(pf);
-		fftwf_destroy_plan(pinvf);
-		pthread_mutex_unlock(&fftw_plan_mutex);
-		fftwf_free(fftw_a);
-		fftwf_free(fftw_b);
-		fftwf_free(fftw_d);
-	} else {
-#define fft_execute_dft_r2c(r, c) fftw_execute_dft_r2c(p, r, c)
-#define fft_execute_dft_c2r(c, r) fftw_execute_dft_c2r(pinv, c, r)
-		ccv_matrix_setter(d->type, ccv_matrix_getter, a->type, for_block, double, fftw_complex);
-#undef fft_execute_dft_r2c
-#undef fft_execute_dft_c2r
-		pthread_mutex_lock(&fftw_plan_mutex);
-		fftw_destroy_plan(p);
-		fftw_destroy_plan(pinv);
-		pthread_mutex_unlock(&fftw_plan_mutex);
-		fftw_free(fftw_a);
-		fftw_free(fftw_b);
-		fftw_free(fftw_d);
-	}
+		{ for_block(kiss_fft_scalar, kiss_fft_cpx); }
+#endif
 #undef for_block
 }
-#else
-static void _ccv_filter_kissfft(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b, ccv_dense_matrix_t* d, int padding_pattern)
+
+static void _ccv_filter_plan_init(ccv_filter_plan_t* plan, ccv_dense_matrix_t* a, ccv_dense_matrix_t** kernels, int count, int fft_type)
 {
-	int ch = CCV_GET_CHANNEL(a->type);
-	int fft_type = (CCV_GET_DATA_TYPE(d->type) == CCV_8U || CCV_GET_DATA_TYPE(d->type) == CCV_32F) ? CCV_32F : CCV_64F;
-	int rows = ((ccv_min(a->rows + b->rows - 1, kiss_fftr_next_fast_size_real(b->rows * 3)) + 1) >> 1) << 1;
-	int cols = ((ccv_min(a->cols + b->cols - 1, kiss_fftr_next_fast_size_real(b->cols * 3)) + 1) >> 1) << 1;
-	int ndim[] = {rows, cols};
-	void* kiss_a;
-	void* kiss_b;
-	void* kiss_d;
-	void* kiss_ac;
-	void* kiss_bc;
-	void* kiss_dc;
-	kiss_fftndr_cfg p;
-	kiss_fftndr_cfg pinv;
-	kissf_fftndr_cfg pf;
-	kissf_fftndr_cfg pinvf;
-	if (fft_type == CCV_32F)
+	plan->krows = kernels[0]->rows;
+	plan->kcols = kernels[0]->cols;
+	plan->rows = _ccv_filter_fft_size(a->rows, plan->krows);
+	plan->cols = _ccv_filter_fft_size(a->cols, plan->kcols);
+	plan->ch = CCV_GET_CHANNEL(a->type);
+	plan->fft_type = fft_type;
+#ifdef HAVE_FFTW3
+	// FFTW transforms in-place with channels interleaved, thus, a row is padded to hold (cols / 2 + 1) complex numbers
+	plan->ystride = 2 * (plan->cols / 2 + 1) * plan->ch;
+	plan->xstride = plan->ch;
+	plan->kstride = 1;
+	plan->real_size = plan->rows * plan->ystride * CCV_GET_DATA_TYPE_SIZE(fft_type);
+	plan->cpx_size = 0;
+#else
+	// kissfft transforms one channel at a time, thus, channels are planar
+	plan->ystride = plan->cols;
+	plan->xstride = 1;
+	plan->kstride = plan->rows * plan->cols;
+	plan->real_size = plan->rows * plan->cols * plan->ch * CCV_GET_DATA_TYPE_SIZE(fft_type);
+	plan->cpx_size = plan->rows * (plan->cols / 2 + 1) * plan->ch * 2 * CCV_GET_DATA_TYPE_SIZE(fft_type);
+#endif
+	plan->forward = _ccv_filter_fft_cfg_new(plan, 0);
+	plan->inverse = _ccv_filter_fft_cfg_new(plan, 1);
+	plan->count = count;
+	plan->idx = 0;
+	plan->spectra = (void**)ccmalloc(sizeof(void*) * count);
+#ifndef HAVE_FFTW3
+	void* real = ccmalloc(plan->real_size);
+#endif
+	int i, j, k, q;
+	for (q = 0; q < count; q++)
 	{
-		pf = kissf_fftndr_alloc(ndim, 2, 0, 0, 0);
-		pinvf = kissf_fftndr_alloc(ndim, 2, 1, 0, 0);
-		kiss_a = ccmalloc(rows * cols * ch * sizeof(kissf_fft_scalar));
-		kiss_b = ccmalloc(rows * cols * ch * sizeof(kissf_fft_scalar));
-		kiss_d = ccmalloc(rows * cols * ch * sizeof(kissf_fft_scalar));
-		kiss_ac = ccmalloc(rows * (cols / 2 + 1) * ch * sizeof(kissf_fft_cpx));
-		kiss_bc = ccmalloc(rows * (cols / 2 + 1) * ch * sizeof(kissf_fft_cpx));
-		kiss_dc = ccmalloc(rows * (cols / 2 + 1) * ch * sizeof(kissf_fft_cpx));
-		memset(kiss_b, 0, rows * cols * ch * sizeof(kissf_fft_scalar));
-	} else {
-		p = kiss_fftndr_alloc(ndim, 2, 0, 0, 0);
-		pinv = kiss_fftndr_alloc(ndim, 2, 1, 0, 0);
-		kiss_a = ccmalloc(rows * cols * ch * sizeof(kiss_fft_scalar));
-		kiss_b = ccmalloc(rows * cols * ch * sizeof(kiss_fft_scalar));
-		kiss_d = ccmalloc(rows * cols * ch * sizeof(kiss_fft_scalar));
-		kiss_ac = ccmalloc(rows * (cols / 2 + 1) * ch * sizeof(kiss_fft_cpx));
-		kiss_bc = ccmalloc(rows * (cols / 2 + 1) * ch * sizeof(kiss_fft_cpx));
-		kiss_dc = ccmalloc(rows * (cols / 2 + 1) * ch * sizeof(kiss_fft_cpx));
-		memset(kiss_b, 0, rows * cols * ch * sizeof(kiss_fft_scalar));
+		ccv_dense_matrix_t* b = kernels[q];
+		assert(b->rows == plan->krows && b->cols == plan->kcols && CCV_GET_CHANNEL(b->type) == plan->ch);
+#ifdef HAVE_FFTW3
+		void* real = plan->spectra[q] = _ccv_filter_fft_malloc(plan->real_size);
+#else
+		plan->spectra[q] = _ccv_filter_fft_malloc(plan->cpx_size);
+#endif
+		memset(real, 0, plan->real_size);
+		unsigned char* m_ptr = b->data.u8;
+		// to flip matrix b is crucial, this problem only shows when I changed to a more sophisticated test case
+#define for_block(_for_type, _for_get) \
+		_for_type* fft_ptr = (_for_type*)real + (b->rows - 1) * plan->ystride; \
+		for (i = 0; i < b->rows; i++) \
+		{ \
+			for (j = 0; j < b->cols; j++) \
+				for (k = 0; k < plan->ch; k++) \
+					fft_ptr[(b->cols - 1 - j) * plan->xstride + k * plan->kstride] = _for_get(m_ptr, j * plan->ch + k, 0); \
+			fft_ptr -= plan->ystride; \
+			m_ptr += b->step; \
+		}
+		ccv_matrix_typeof(fft_type, ccv_matrix_getter, b->type, for_block);
+#undef for_block
+		_ccv_filter_fft_r2c(plan, plan->forward, real, plan->spectra[q]);
 	}
-	int nch = rows * cols, nchc = rows * (cols / 2 + 1);
-	int i, j, k;
-	unsigned char* m_ptr = b->data.u8;
-	// to flip matrix b is crucial, this problem only shows when I changed to a more sophisticated test case
+#ifndef HAVE_FFTW3
+	ccfree(real);
+#endif
+}
+
+static void _ccv_filter_plan_free(ccv_filter_plan_t* plan)
+{
+	int q;
+	for (q = 0; q < plan->count; q++)
+		_ccv_filter_fft_free(plan->spectra[q]);
+	ccfree(plan->spectra);
+	if (plan->idx)
+		ccfree(plan->idx);
+	_ccv_filter_fft_cfg_free(plan, plan->forward);
+	_ccv_filter_fft_cfg_free(plan, plan->inverse);
+}
+
+/* copy a tile of a into the real buffer, zero padded */
+static void _ccv_filter_fft_load(ccv_filter_plan_t* plan, ccv_dense_matrix_t* a, int iy, int ix, void* real)
+{
+	int x, y, k;
+	memset(real, 0, plan->real_size);
+	const int end_y = ccv_min(plan->rows, a->rows - iy);
+	const int end_x = ccv_min(plan->cols, a->cols - ix);
+	unsigned char* m_ptr = (unsigned char*)ccv_get_dense_matrix_cell(a, iy, ix, 0);
 #define for_block(_for_type, _for_get) \
-	_for_type* kiss_ptr = (_for_type*)kiss_b + (b->rows - 1) * cols; \
-	for (i = 0; i < b->rows; i++) \
+	_for_type* fft_ptr = (_for_type*)real; \
+	for (y = 0; y < end_y; y++) \
 	{ \
-		for (j = 0; j < b->cols; j++) \
-			for (k = 0; k < ch; k++) \
-				kiss_ptr[k * nch + b->cols - 1 - j] = _for_get(m_ptr, j * ch + k, 0); \
-		kiss_ptr -= cols; \
-		m_ptr += b->step; \
+		for (x = 0; x < end_x; x++) \
+			for (k = 0; k < plan->ch; k++) \
+				fft_ptr[x * plan->xstride + k * plan->kstride] = _for_get(m_ptr, x * plan->ch + k, 0); \
+		fft_ptr += plan->ystride; \
+		m_ptr += a->step; \
 	}
-	ccv_matrix_typeof(fft_type, ccv_matrix_getter, b->type, for_block);
+	ccv_matrix_typeof(plan->fft_type, ccv_matrix_getter, a->type, for_block);
 #undef for_block
-	if (fft_type == CCV_32F)
-		for (k = 0; k < ch; k++)
-			kissf_fftndr(pf, (kissf_fft_scalar*)kiss_b + nch * k, (kissf_fft_cpx*)kiss_bc + nchc * k);
-	else
-		for (k = 0; k < ch; k++)
-			kiss_fftndr(p, (kiss_fft_scalar*)kiss_b + nch * k, (kiss_fft_cpx*)kiss_bc + nchc * k);
+}
+
+/* copy rows x cols from (ry, rx) of the real buffer to (dy, dx) of d */
+static void _ccv_filter_fft_store(ccv_filter_plan_t* plan, void* real, int ry, int rx, ccv_dense_matrix_t* d, int dy, int dx, int rows, int cols)
+{
+	if (rows <= 0 || cols <= 0)
+		return;
+	int x, y, k;
+	unsigned char* m_ptr = (unsigned char*)ccv_get_dense_matrix_cell(d, dy, dx, 0);
+#define for_block(_for_type, _for_set) \
+	_for_type* fft_ptr = (_for_type*)real + ry * plan->ystride + rx * plan->xstride; \
+	for (y = 0; y < rows; y++) \
+	{ \
+		for (x = 0; x < cols; x++) \
+			for (k = 0; k < plan->ch; k++) \
+				_for_set(m_ptr, x * plan->ch + k, fft_ptr[x * plan->xstride + k * plan->kstride], 0); \
+		m_ptr += d->step; \
+		fft_ptr += plan->ystride; \
+	}
+	ccv_matrix_typeof(plan->fft_type, ccv_matrix_setter, d->type, for_block);
+#undef for_block
+}
+
+/* convolve a with all the kernels of the plan, the image tile is transformed once for all of them, and tiles run in parallel.
+ * d[i] can be 0, in which case the kernel is skipped */
+static void _ccv_filter_fft(ccv_dense_matrix_t* a, ccv_filter_plan_t* plan, ccv_dense_matrix_t** d)
+{
+	const int rows = plan->rows;
+	const int cols = plan->cols;
+	const int brows2 = plan->krows / 2;
+	const int bcols2 = plan->kcols / 2;
+	const int stride_y = rows - (plan->krows & ~1);
+	const int stride_x = cols - (plan->kcols & ~1);
 	/* why a->cols + cols - 2 * (b->cols & ~1) ?
 	 * what we really want is ceiling((a->cols - (b->cols & ~1)) / (cols - (b->cols & ~1)))
 	 * in this case, we strip out paddings on the left/right, and compute how many tiles
 	 * we need. It then be interpreted in the above integer division form */
-	int tile_x = ccv_max(1, (a->cols + cols - 2 * (b->cols & ~1)) / (cols - (b->cols & ~1)));
-	int tile_y = ccv_max(1, (a->rows + rows - 2 * (b->rows & ~1)) / (rows - (b->rows & ~1)));
-	int brows2 = b->rows / 2;
-	int bcols2 = b->cols / 2;
-#define for_block(_for_type, _cpx_type, _for_set, _for_get) \
-	_for_type scale = 1.0 / (rows * cols); \
-	for (i = 0; i < tile_y; i++) \
-		for (j = 0; j < tile_x; j++) \
-		{ \
-			int x, y; \
-			memset(kiss_a, 0, rows * cols * ch * sizeof(_for_type)); \
-			int iy = ccv_min(i * (rows - (b->rows & ~1)), ccv_max(a->rows - rows, 0)); \
-			int ix = ccv_min(j * (cols - (b->cols & ~1)), ccv_max(a->cols - cols, 0)); \
-			_for_type* kiss_ptr = (_for_type*)kiss_a; \
-			int end_y = ccv_min(rows, a->rows - iy); \
-			int end_x = ccv_min(cols, a->cols - ix); \
-			m_ptr = (unsigned char*)ccv_get_dense_matrix_cell(a, iy, ix, 0); \
-			for (y = 0; y < end_y; y++) \
-			{ \
-				for (x = 0; x < end_x; x++) \
-					for (k = 0; k < ch; k++) \
-						kiss_ptr[k * nch + x] = _for_get(m_ptr, x * ch + k, 0); \
-				kiss_ptr += cols; \
-				m_ptr += a->step; \
-			} \
-			for (k = 0; k < ch; k++) \
-				fft_ndr((_for_type*)kiss_a + nch * k, (_cpx_type*)kiss_ac + nchc * k); \
-			_cpx_type* fft_ac = (_cpx_type*)kiss_ac; \
-			_cpx_type* fft_bc = (_cpx_type*)kiss_bc; \
-			_cpx_type* fft_dc = (_cpx_type*)kiss_dc; \
-			for (x = 0; x < rows * ch * (cols / 2 + 1); x++) \
-			{ \
-				fft_dc[x].r = (fft_ac[x].r * fft_bc[x].r - fft_ac[x].i * fft_bc[x].i) * scale; \
-				fft_dc[x].i = (fft_ac[x].i * fft_bc[x].r + fft_ac[x].r * fft_bc[x].i) * scale; \
-			} \
-			for (k = 0; k < ch; k++) \
-				fft_ndri((_cpx_type*)kiss_dc + nchc * k, (_for_type*)kiss_d + nch * k); \
-			kiss_ptr = (_for_type*)kiss_d + (1 + (i > 0)) * brows2 * cols + (1 + (j > 0)) * bcols2; \
-			end_y = ccv_min(d->rows - (iy + (i > 0) * brows2), \
-							(rows - (b->rows & ~1)) + (i == 0) * brows2); \
-			end_x = ccv_min(d->cols - (ix + (j > 0) * bcols2), \
-							(cols - (b->cols & ~1)) + (j == 0) * bcols2); \
-			m_ptr = (unsigned char*)ccv_get_dense_matrix_cell(d, iy + (i > 0) * brows2, ix + (j > 0) * bcols2, 0); \
-			for (y = 0; y < end_y; y++) \
-			{ \
-				for (x = 0; x < end_x; x++) \
-					for (k = 0; k < ch; k++) \
-						_for_set(m_ptr, x * ch + k, kiss_ptr[k * nch + x], 0); \
-				m_ptr += d->step; \
-				kiss_ptr += cols; \
-			} \
-			int end_tile_y, end_tile_x; \
-			/* handle edge cases: */ \
-			if (i + 1 == tile_y && end_y + iy + (i > 0) * brows2 < d->rows) \
-			{ \
-				end_tile_y = ccv_min(brows2, d->rows - (iy + (i > 0) * brows2 + end_y)); \
-				kiss_ptr = (_for_type*)kiss_d + (1 + (j > 0)) * bcols2; \
-				m_ptr = (unsigned char*)ccv_get_dense_matrix_cell(d, iy + (i > 0) * brows2 + end_y, ix + (j > 0) * bcols2, 0); \
-				for (y = 0; y < end_tile_y; y++) \
-				{ \
-					for (x = 0; x < end_x; x++) \
-						for (k = 0; k < ch; k++) \
-							_for_set(m_ptr, x * ch + k, kiss_ptr[k * nch + x], 0); \
-					m_ptr += d->step; \
-					kiss_ptr += cols; \
-				} \
-			} \
-			if (j + 1 == tile_x && end_x + ix + (j > 0) * bcols2 < d->cols) \
-			{ \
-				end_tile_x = ccv_min(bcols2, d->cols - (ix + (j > 0) * bcols2 + end_x)); \
-				kiss_ptr = (_for_type*)kiss_d + (1 + (i > 0)) * brows2 * cols; \
-				m_ptr = (unsigned char*)ccv_get_dense_matrix_cell(d, iy + (i > 0) * brows2, ix + (j > 0) * bcols2 + end_x, 0); \
-				for (y = 0; y < end_y; y++) \
-				{ \
-					for (x = 0; x < end_tile_x; x++) \
-						for (k = 0; k < ch; k++) \
-							_for_set(m_ptr, x * ch + k, kiss_ptr[k * nch + x], 0); \
-					m_ptr += d->step; \
-					kiss_ptr += cols; \
-				} \
-			} \
-			if (i + 1 == tile_y && end_y + iy + (i > 0) * brows2 < d->rows && \
-				j + 1 == tile_x && end_x + ix + (j > 0) * bcols2 < d->cols) \
-			{ \
-				kiss_ptr = (_for_type*)kiss_d; \
-				m_ptr = (unsigned char*)ccv_get_dense_matrix_cell(d, iy + (i > 0) * brows2 + end_y, ix + (j > 0) * bcols2 + end_x, 0); \
-				for (y = 0; y < end_tile_y; y++) \
-				{ \
-					for (x = 0; x < end_tile_x; x++) \
-						for (k = 0; k < ch; k++) \
-							_for_set(m_ptr, x * ch + k, kiss_ptr[k * nch + x], 0); \
-					m_ptr += d->step; \
-					kiss_ptr += cols; \
-				} \
-			} \
+	const int tile_x = ccv_max(1, (a->cols + cols - 2 * (plan->kcols & ~1)) / stride_x);
+	const int tile_y = ccv_max(1, (a->rows + rows - 2 * (plan->krows & ~1)) / stride_y);
+	const int tile_count = tile_x * tile_y;
+	parallel_for(t, FOR_IS_PARALLEL ? tile_count : 1) {
+		void* forward = plan->forward;
+		void* inverse = plan->inverse;
+#ifndef HAVE_FFTW3
+		// kissfft keeps its scratch space in the plan, thus, one plan cannot be shared between threads
+		if (FOR_IS_PARALLEL)
+		{
+			forward = _ccv_filter_fft_cfg_new(plan, 0);
+			inverse = _ccv_filter_fft_cfg_new(plan, 1);
 		}
-	if (fft_type == CCV_32F)
-	{
-#define fft_ndr(r, c) kissf_fftndr(pf, r, c)
-#define fft_ndri(c, r) kissf_fftndri(pinvf, c, r)
-		ccv_matrix_setter(d->type, ccv_matrix_getter, a->type, for_block, kissf_fft_scalar, kissf_fft_cpx);
-#undef fft_ndr
-#undef fft_ndri
-		kissf_fft_free(pf);
-		kissf_fft_free(pinvf);
-	} else {
-#define fft_ndr(r, c) kiss_fftndr(p, r, c)
-#define fft_ndri(c, r) kiss_fftndri(pinv, c, r)
-		ccv_matrix_setter(d->type, ccv_matrix_getter, a->type, for_block, kiss_fft_scalar, kiss_fft_cpx);
-#undef fft_ndr
-#undef fft_ndri
-		kiss_fft_free(p);
-		kiss_fft_free(pinv);
-	}
-#undef for_block
-	ccfree(kiss_dc);
-	ccfree(kiss_bc);
-	ccfree(kiss_ac);
-	ccfree(kiss_d);
-	ccfree(kiss_b);
-	ccfree(kiss_a);
-}
+		void* ra = _ccv_filter_fft_malloc(plan->real_size);
+		void* rd = _ccv_filter_fft_malloc(plan->real_size);
+		void* ca = _ccv_filter_fft_malloc(plan->cpx_size);
+		void* cd = _ccv_filter_fft_malloc(plan->cpx_size);
+#else
+		void* ra = _ccv_filter_fft_malloc(plan->real_size);
+		void* rd = _ccv_filter_fft_malloc(plan->real_size);
+		void* ca = ra;
+		void* cd = rd;
+#endif
+		int s, q;
+		const int end = FOR_IS_PARALLEL ? t + 1 : tile_count;
+		for (s = FOR_IS_PARALLEL ? t : 0; s < end; s++)
+		{
+			const int i = s / tile_x;
+			const int j = s % tile_x;
+			const int iy = ccv_min(i * stride_y, ccv_max(a->rows - rows, 0));
+			const int ix = ccv_min(j * stride_x, ccv_max(a->cols - cols, 0));
+			_ccv_filter_fft_load(plan, a, iy, ix, ra);
+			_ccv_filter_fft_r2c(plan, forward, ra, ca);
+			for (q = 0; q < plan->count; q++)
+			{
+				ccv_dense_matrix_t* dd = d[q];
+				if (!dd)
+					continue;
+				_ccv_filter_fft_mul(plan, ca, plan->spectra[q], cd);
+				_ccv_filter_fft_c2r(plan, inverse, cd, rd);
+				const int dy = iy + (i > 0) * brows2;
+				const int dx = ix + (j > 0) * bcols2;
+				int end_y = ccv_min(dd->rows - dy, stride_y + (i == 0) * brows2);
+				int end_x = ccv_min(dd->cols - dx, stride_x + (j == 0) * bcols2);
+				/* the last tile can be moved back to stay within a, and overlaps with the one before it, leave the overlap to the
+				 * later tile, thus, the result is the same whether tiles run in order or in parallel */
+				if (i + 1 < tile_y)
+					end_y = ccv_min(end_y, ccv_min((i + 1) * stride_y, ccv_max(a->rows - rows, 0)) + brows2 - dy);
+				if (j + 1 < tile_x)
+					end_x = ccv_min(end_x, ccv_min((j + 1) * stride_x, ccv_max(a->cols - cols, 0)) + bcols2 - dx);
+				_ccv_filter_fft_store(plan, rd, (1 + (i > 0)) * brows2, (1 + (j > 0)) * bcols2, dd, dy, dx, end_y, end_x);
+				/* handle edge cases: */
+				const int edge_y = (i + 1 == tile_y && end_y + dy < dd->rows) ? ccv_min(brows2, dd->rows - (dy + end_y)) : 0;
+				const int edge_x = (j + 1 == tile_x && end_x + dx < dd->cols) ? ccv_min(bcols2, dd->cols - (dx + end_x)) : 0;
+				_ccv_filter_fft_store(plan, rd, 0, (1 + (j > 0)) * bcols2, dd, dy + end_y, dx, edge_y, end_x);
+				_ccv_filter_fft_store(plan, rd, (1 + (i > 0)) * brows2, 0, dd, dy, dx + end_x, end_y, edge_x);
+				_ccv_filter_fft_store(plan, rd, 0, 0, dd, dy + end_y, dx + end_x, edge_y, edge_x);
+			}
+		}
+#ifndef HAVE_FFTW3
+		if (FOR_IS_PARALLEL)
+		{
+			_ccv_filter_fft_cfg_free(plan, forward);
+			_ccv_filter_fft_cfg_free(plan, inverse);
+		}
+		_ccv_filter_fft_free(ca);
+		_ccv_filter_fft_free(cd);
 #endif
+		_ccv_filter_fft_free(ra);
+		_ccv_filter_fft_free(rd);
+	} parallel_endfor
+}
 
 static void _ccv_filter_direct_8u(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b, ccv_dense_matrix_t* d, int padding_pattern)
 {
@@ -1052,14 +1059,97 @@ void ccv_filter(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b, ccv_dense_matrix_t
 	{
 		_ccv_filter_direct_8u(a, b, dd, padding_pattern);
 	} else {
-#ifdef HAVE_FFTW3
-		_ccv_filter_fftw(a, b, dd, padding_pattern);
-#else
-		_ccv_filter_kissfft(a, b, dd, padding_pattern);
-#endif
+		ccv_filter_plan_t plan;
+		_ccv_filter_plan_init(&plan, a, &b, 1, _ccv_filter_fft_type(dd->type));
+		_ccv_filter_fft(a, &plan, &dd);
+		_ccv_filter_plan_free(&plan);
+	}
+}
+
+ccv_filter_bank_t* ccv_filter_bank_new(ccv_dense_matrix_t** kernels, int count)
+{
+	assert(count > 0);
+	ccv_filter_bank_t* bank = (ccv_filter_bank_t*)ccmalloc(sizeof(ccv_filter_bank_t) + sizeof(ccv_dense_matrix_t*) * count);
+	bank->count = count;
+	bank->kernels = (ccv_dense_matrix_t**)(bank + 1);
+	memcpy(bank->kernels, kernels, sizeof(ccv_dense_matrix_t*) * count);
+	bank->plans = ccv_array_new(sizeof(ccv_filter_plan_t), 4, 0);
+	return bank;
+}
+
+void ccv_filter_bank(ccv_dense_matrix_t* a, ccv_filter_bank_t* bank, ccv_dense_matrix_t** d, int type, int padding_pattern)
+{
+	int i, j, q;
+	type = (type == 0) ? CCV_GET_DATA_TYPE(a->type) | CCV_GET_CHANNEL(a->type) : CCV_GET_DATA_TYPE(type) | CCV_GET_CHANNEL(a->type);
+	// the outputs that are yet to compute, and the ones for the kernels of a given size
+	ccv_dense_matrix_t** dd = (ccv_dense_matrix_t**)alloca(sizeof(ccv_dense_matrix_t*) * bank->count * 3);
+	ccv_dense_matrix_t** dq = dd + bank->count;
+	ccv_dense_matrix_t** kernels = dq + bank->count;
+	for (i = 0; i < bank->count; i++)
+	{
+		ccv_dense_matrix_t* b = bank->kernels[i];
+		ccv_declare_derived_signature(sig, a->sig != 0 && b->sig != 0, ccv_sign_with_literal("ccv_filter"), a->sig, b->sig, CCV_EOF_SIGN);
+		dd[i] = d[i] = ccv_dense_matrix_renew(d[i], a->rows, a->cols, CCV_ALL_DATA_TYPE | CCV_GET_CHANNEL(a->type), type, sig);
+		if (dd[i]->type & CCV_GARBAGE)
+		{
+			ccv_revive_object_if_cached(dd[i]);
+			dd[i] = 0;
+		} else if ((b->rows * b->cols < (log((double)(b->rows * b->cols)) + 1) * 15) && (a->type & CCV_8U)) {
+			/* the same choice as ccv_filter */
+			_ccv_filter_direct_8u(a, b, dd[i], padding_pattern);
+			dd[i] = 0;
+		}
+	}
+	const int fft_type = _ccv_filter_fft_type(type);
+	for (i = 0; i < bank->count; i++)
+	{
+		if (!dd[i])
+			continue;
+		ccv_dense_matrix_t* b = bank->kernels[i];
+		const int rows = _ccv_filter_fft_size(a->rows, b->rows);
+		const int cols = _ccv_filter_fft_size(a->cols, b->cols);
+		ccv_filter_plan_t* plan = 0;
+		for (j = 0; !plan && j < bank->plans->rnum; j++)
+		{
+			ccv_filter_plan_t* p = (ccv_filter_plan_t*)ccv_array_get(bank->plans, j);
+			if (p->krows == b->rows && p->kcols == b->cols && p->rows == rows && p->cols == cols && p->ch == CCV_GET_CHANNEL(a->type) && p->fft_type == fft_type)
+				plan = p;
+		}
+		if (!plan)
+		{
+			/* plan for all the kernels of this size, thus, they are transformed to frequency domain only once */
+			int* idx = (int*)ccmalloc(sizeof(int) * bank->count);
+			int count = 0;
+			for (j = i; j < bank->count; j++)
+				if (bank->kernels[j]->rows == b->rows && bank->kernels[j]->cols == b->cols)
+					kernels[count] = bank->kernels[j], idx[count++] = j;
+			for (j = 0; j < i; j++)
+				if (bank->kernels[j]->rows == b->rows && bank->kernels[j]->cols == b->cols)
+					kernels[count] = bank->kernels[j], idx[count++] = j;
+			ccv_filter_plan_t new_plan;
+			_ccv_filter_plan_init(&new_plan, a, kernels, count, fft_type);
+			new_plan.idx = idx;
+			ccv_array_push(bank->plans, &new_plan);
+			plan = (ccv_filter_plan_t*)ccv_array_get(bank->plans, bank->plans->rnum - 1);
+		}
+		for (q = 0; q < plan->count; q++)
+		{
+			dq[q] = dd[plan->idx[q]];
+			dd[plan->idx[q]] = 0;
+		}
+		_ccv_filter_fft(a, plan, dq);
 	}
 }
 
+void ccv_filter_bank_free(ccv_filter_bank_t* bank)
+{
+	int i;
+	for (i = 0; i < bank->plans->rnum; i++)
+		_ccv_filter_plan_free((ccv_filter_plan_t*)ccv_array_get(bank->plans, i));
+	ccv_array_free(bank->plans);
+	ccfree(bank);
+}
+
 void ccv_filter_kernel(ccv_dense_matrix_t* x, ccv_filter_kernel_f func, void* data)
 {
 	int i, j, k, ch = CCV_GET_CHANNEL(x->type);
@@ -1082,6 +1172,203 @@ void ccv_filter_kernel(ccv_dense_matrix_t* x, ccv_filter_kernel_f func, void* da
 	ccv_make_matrix_immutable(x);
 }
 
+/* the number of rows a band has in the row pass, and the number of columns a block has in the column pass,
+ * a block of columns is transposed into contiguous memory, thus, the column pass reads and writes whole cache lines */
+#define CCV_DISTANCE_TRANSFORM_BAND_SIZE (32)
+#define CCV_DISTANCE_TRANSFORM_BLOCK_SIZE (16)
+
+/* the parabola rooted at q is f(q) + dd * q * q - d * q, computed once for all q, rather than every time the lower
+ * envelope is tested against it */
+static void _ccv_distance_transform_parabola_32f(const float* f, float* h, int n, float d, float dd)
+{
+	int q = 0;
+#if defined(HAVE_SSE2)
+	const __m128 d4 = _mm_set1_ps(d);
+	const __m128 dd4 = _mm_set1_ps(dd);
+	__m128i q4 = _mm_setr_epi32(0, 1, 2, 3);
+	const __m128i four = _mm_set1_epi32(4);
+	for (; q < n - 3; q += 4)
+	{
+		const __m128 qf = _mm_cvtepi32_ps(q4);
+		_mm_storeu_ps(h + q, _mm_sub_ps(_mm_add_ps(_mm_loadu_ps(f + q), _mm_mul_ps(_mm_mul_ps(dd4, qf), qf)), _mm_mul_ps(d4, qf)));
+		q4 = _mm_add_epi32(q4, four);
+	}
+#elif defined(HAVE_NEON)
+	const float32x4_t d4 = vdupq_n_f32(d);
+	const float32x4_t dd4 = vdupq_n_f32(dd);
+	const int32_t q0[4] = { 0, 1, 2, 3 };
+	int32x4_t q4 = vld1q_s32(q0);
+	const int32x4_t four = vdupq_n_s32(4);
+	for (; q < n - 3; q += 4)
+	{
+		const float32x4_t qf = vcvtq_f32_s32(q4);
+		vst1q_f32(h + q, vsubq_f32(vaddq_f32(vld1q_f32(f + q), vmulq_f32(vmulq_f32(dd4, qf), qf)), vmulq_f32(d4, qf)));
+		q4 = vaddq_s32(q4, four);
+	}
+#endif
+	for (; q < n; q++)
+		h[q] = f[q] + dd * q * q - d * q;
+}
+
+static void _ccv_distance_transform_parabola_64f(const double* f, double* h, int n, double d, double dd)
+{
+	int q;
+	for (q = 0; q < n; q++)
+		h[q] = f[q] + dd * q * q - d * q;
+}
+
+/* all the q in [start, end) are closest to the parabola rooted at v, thus, it is the same polynomial over the segment */
+static void _ccv_distance_transform_segment_32f(const float* f, float* out, int* idx, int start, int end, int v, float d, float dd)
+{
+	int q = start;
+	const float fv = f[v];
+#if defined(HAVE_SSE2)
+	const __m128 d4 = _mm_set1_ps(d);
+	const __m128 dd4 = _mm_set1_ps(dd);
+	const __m128 fv4 = _mm_set1_ps(fv);
+	__m128i t4 = _mm_setr_epi32(start - v, start - v + 1, start - v + 2, start - v + 3);
+	const __m128i four = _mm_set1_epi32(4);
+	for (; q < end - 3; q += 4)
+	{
+		const __m128 tf = _mm_cvtepi32_ps(t4);
+		_mm_storeu_ps(out + q, _mm_add_ps(_mm_add_ps(_mm_mul_ps(d4, tf), _mm_mul_ps(_mm_mul_ps(dd4, tf), tf)), fv4));
+		if (idx)
+			_mm_storeu_si128((__m128i*)(idx + q), t4);
+		t4 = _mm_add_epi32(t4, four);
+	}
+#elif defined(HAVE_NEON)
+	const float32x4_t d4 = vdupq_n_f32(d);
+	const float32x4_t dd4 = vdupq_n_f32(dd);
+	const float32x4_t fv4 = vdupq_n_f32(fv);
+	const int32_t t0[4] = { start - v, start - v + 1, start - v + 2, start - v + 3 };
+	int32x4_t t4 = vld1q_s32(t0);
+	const int32x4_t four = vdupq_n_s32(4);
+	for (; q < end - 3; q += 4)
+	{
+		const float32x4_t tf = vcvtq_f32_s32(t4);
+		vst1q_f32(out + q, vaddq_f32(vaddq_f32(vmulq_f32(d4, tf), vmulq_f32(vmulq_f32(dd4, tf), tf)), fv4));
+		if (idx)
+			vst1q_s32(idx + q, t4);
+		t4 = vaddq_s32(t4, four);
+	}
+#endif
+	for (; q < end; q++)
+	{
+		out[q] = d * (q - v) + dd * (q - v) * (q - v) + fv;
+		if (idx)
+			idx[q] = q - v;
+	}
+}
+
+static void _ccv_distance_transform_segment_64f(const double* f, double* out, int* idx, int start, int end, int v, double d, double dd)
+{
+	int q;
+	const double fv = f[v];
+	for (q = start; q < end; q++)
+	{
+		out[q] = d * (q - v) + dd * (q - v) * (q - v) + fv;
+		if (idx)
+			idx[q] = q - v;
+	}
+}
+
+/* the 1-dimensional distance transform of f into out, h, v and z are scratch spaces for n, n and n + 1 elements */
+#define CCV_DISTANCE_TRANSFORM_1D(_for_type, _for_max, _for_suffix) \
+static void _ccv_distance_transform_1d_##_for_suffix(const _for_type* f, _for_type* out, int* idx, int n, _for_type d, _for_type dd, _for_type* h, int* v, _for_type* z) \
+{ \
+	int q, k; \
+	if (dd > 1e-6) \
+	{ \
+		_ccv_distance_transform_parabola_##_for_suffix(f, h, n, d, dd); \
+		k = 0; \
+		v[0] = 0; \
+		z[0] = (_for_type)-_for_max; \
+		z[1] = (_for_type)_for_max; \
+		for (q = 1; q < n; q++) \
+		{ \
+			_for_type s; \
+			for (;;) \
+			{ \
+				assert(k >= 0 && k < n); \
+				s = (h[q] - h[v[k]]) / (2.0 * dd * (q - v[k])); \
+				if (s > z[k]) break; \
+				--k; \
+			} \
+			++k; \
+			v[k] = q; \
+			z[k] = s; \
+			z[k + 1] = (_for_type)_for_max; \
+		} \
+		assert(z[k + 1] >= n - 1); \
+		/* q belongs to the first parabola k with z[k + 1] >= q */ \
+		for (k = 0, q = 0; q < n; k++) \
+		{ \
+			int end = q; \
+			while (end < n && !(z[k + 1] < end)) \
+				++end; \
+			_ccv_distance_transform_segment_##_for_suffix(f, out, idx, q, end, v[k], d, dd); \
+			q = end; \
+		} \
+	} else { /* above algorithm cannot handle dd == 0 properly, below is special casing for that */ \
+		assert(idx == 0); \
+		out[0] = f[0]; \
+		for (q = 1; q < n; q++) \
+			out[q] = ccv_min(f[q], out[q - 1] + d); \
+		for (q = n - 2; q >= 0; q--) \
+			out[q] = ccv_min(out[q], out[q + 1] - d); \
+	} \
+} \
+\
+/* the column pass, a block of columns is transposed in, transformed column by column, and transposed back */ \
+static void _ccv_distance_transform_columns_##_for_suffix(ccv_dense_matrix_t* db, ccv_dense_matrix_t* my, _for_type d, _for_type dd) \
+{ \
+	const int rows = db->rows; \
+	const int block_count = (db->cols + CCV_DISTANCE_TRANSFORM_BLOCK_SIZE - 1) / CCV_DISTANCE_TRANSFORM_BLOCK_SIZE; \
+	parallel_for(t, FOR_IS_PARALLEL ? block_count : 1) { \
+		int i, j, c; \
+		_for_type* ft = (_for_type*)ccmalloc(sizeof(_for_type) * (rows * CCV_DISTANCE_TRANSFORM_BLOCK_SIZE * 2 + rows * 2 + 1) + sizeof(int) * (rows * CCV_DISTANCE_TRANSFORM_BLOCK_SIZE + rows)); \
+		_for_type* ot = ft + rows * CCV_DISTANCE_TRANSFORM_BLOCK_SIZE; \
+		_for_type* h = ot + rows * CCV_DISTANCE_TRANSFORM_BLOCK_SIZE; \
+		_for_type* z = h + rows; \
+		int* it = (int*)(z + rows + 1); \
+		int* v = it + rows * CCV_DISTANCE_TRANSFORM_BLOCK_SIZE; \
+		const int end = FOR_IS_PARALLEL ? t + 1 : block_count; \
+		for (j = t * CCV_DISTANCE_TRANSFORM_BLOCK_SIZE; j < ccv_min(end * CCV_DISTANCE_TRANSFORM_BLOCK_SIZE, db->cols); j += CCV_DISTANCE_TRANSFORM_BLOCK_SIZE) \
+		{ \
+			const int bw = ccv_min(CCV_DISTANCE_TRANSFORM_BLOCK_SIZE, db->cols - j); \
+			_for_type* b_ptr = (_for_type*)(db->data.u8) + j; \
+			for (i = 0; i < rows; i++) \
+			{ \
+				for (c = 0; c < bw; c++) \
+					ft[c * rows + i] = b_ptr[c]; \
+				b_ptr = (_for_type*)((unsigned char*)b_ptr + db->step); \
+			} \
+			for (c = 0; c < bw; c++) \
+				_ccv_distance_transform_1d_##_for_suffix(ft + c * rows, ot + c * rows, my ? it + c * rows : 0, rows, d, dd, h, v, z); \
+			b_ptr = (_for_type*)(db->data.u8) + j; \
+			int* y_ptr = my ? my->data.i32 + j : 0; \
+			for (i = 0; i < rows; i++) \
+			{ \
+				for (c = 0; c < bw; c++) \
+					b_ptr[c] = ot[c * rows + i]; \
+				b_ptr = (_for_type*)((unsigned char*)b_ptr + db->step); \
+				if (y_ptr) \
+				{ \
+					for (c = 0; c < bw; c++) \
+						y_ptr[c] = it[c * rows + i]; \
+					y_ptr += my->cols; \
+				} \
+			} \
+		} \
+		ccfree(ft); \
+	} parallel_endfor \
+}
+
+CCV_DISTANCE_TRANSFORM_1D(float, FLT_MAX, 32f)
+CCV_DISTANCE_TRANSFORM_1D(double, DBL_MAX, 64f)
+
+#undef CCV_DISTANCE_TRANSFORM_1D
+
 void ccv_distance_transform(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type, ccv_dense_matrix_t** x, int x_type, ccv_dense_matrix_t** y, int y_type, double dx, double dy, double dxx, double dyy, int flag)
 {
 	assert(!(flag & CCV_L2_NORM) && (flag & CCV_GSEDT));
@@ -1102,166 +1389,49 @@ void ccv_distance_transform(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int t
 	}
 	ccv_object_return_if_cached(, db, mx, my);
 	ccv_revive_object_if_cached(db, mx, my);
-	int i, j, k;
-	unsigned char* a_ptr = a->data.u8;
-	unsigned char* b_ptr = db->data.u8;
-	int* v = (int*)alloca(sizeof(int) * ccv_max(db->rows, db->cols));
-	unsigned char* c_ptr = (unsigned char*)alloca(CCV_GET_DATA_TYPE_SIZE(db->type) * db->rows);
-	int* x_ptr = mx ? mx->data.i32 : 0;
-	int* y_ptr = my ? my->data.i32 : 0;
-#define for_block(_for_max, _for_type_b, _for_set_b, _for_get_b, _for_get_a) \
-	_for_type_b _dx = dx, _dy = dy, _dxx = dxx, _dyy = dyy; \
-	_for_type_b* z = (_for_type_b*)alloca(sizeof(_for_type_b) * (ccv_max(db->rows, db->cols) + 1)); \
-	if (_dxx > 1e-6) \
-	{ \
-		for (i = 0; i < a->rows; i++) \
-		{ \
-			k = 0; \
-			v[0] = 0; \
-			z[0] = (_for_type_b)-_for_max; \
-			z[1] = (_for_type_b)_for_max; \
-			for (j = 1; j < a->cols; j++) \
-			{ \
-				_for_type_b s; \
-				for (;;) \
-				{ \
-					assert(k >= 0 && k < ccv_max(db->rows, db->cols)); \
-					s = ((SGN _for_get_a(a_ptr, j, 0) + _dxx * j * j - _dx * j) - (SGN _for_get_a(a_ptr, v[k], 0) + _dxx * v[k] * v[k] - _dx * v[k])) / (2.0 * _dxx * (j - v[k])); \
-					if (s > z[k]) break; \
-					--k; \
-				} \
-				++k; \
-				assert(k >= 0 && k < ccv_max(db->rows, db->cols)); \
-				v[k] = j; \
-				z[k] = s; \
-				z[k + 1] = (_for_type_b)_for_max; \
-			} \
-			assert(z[k + 1] >= a->cols - 1); \
-			k = 0; \
-			if (mx) \
-			{ \
+	const int negative = !!(flag & CCV_NEGATIVE);
+	const int is_64f = !!(db->type & CCV_64F);
+	const size_t fsize = is_64f ? sizeof(double) : sizeof(float);
+	const int band_count = (a->rows + CCV_DISTANCE_TRANSFORM_BAND_SIZE - 1) / CCV_DISTANCE_TRANSFORM_BAND_SIZE;
+	/* the row pass, rows run in parallel bands */
+	parallel_for(t, FOR_IS_PARALLEL ? band_count : 1) {
+		int i, j;
+		unsigned char* f = (unsigned char*)ccmalloc(fsize * (a->cols * 3 + 1) + sizeof(int) * a->cols);
+		unsigned char* h = f + fsize * a->cols;
+		unsigned char* z = h + fsize * a->cols;
+		int* v = (int*)(z + fsize * (a->cols + 1));
+		const int start = FOR_IS_PARALLEL ? t * CCV_DISTANCE_TRANSFORM_BAND_SIZE : 0;
+		const int end = FOR_IS_PARALLEL ? ccv_min(start + CCV_DISTANCE_TRANSFORM_BAND_SIZE, a->rows) : a->rows;
+		unsigned char* a_ptr = a->data.u8 + start * a->step;
+		for (i = start; i < end; i++)
+		{
+			unsigned char* b_ptr = db->data.u8 + i * db->step;
+			int* x_ptr = mx ? mx->data.i32 + i * mx->cols : 0;
+#define for_block(_, _for_get) \
+			if (is_64f) \
 				for (j = 0; j < a->cols; j++) \
 				{ \
-					while (z[k + 1] < j) \
-					{ \
-						assert(k >= 0 && k < ccv_max(db->rows, db->cols) - 1); \
-						++k; \
-					} \
-					_for_set_b(b_ptr, j, _dx * (j - v[k]) + _dxx * (j - v[k]) * (j - v[k]) SGN _for_get_a(a_ptr, v[k], 0), 0); \
-					x_ptr[j] = j - v[k]; \
+					double w = _for_get(a_ptr, j, 0); \
+					((double*)f)[j] = negative ? -w : w; \
 				} \
-				x_ptr += mx->cols; \
-			} else { \
+			else \
 				for (j = 0; j < a->cols; j++) \
 				{ \
-					while (z[k + 1] < j) \
-					{ \
-						assert(k >= 0 && k < ccv_max(db->rows, db->cols) - 1); \
-						++k; \
-					} \
-					_for_set_b(b_ptr, j, _dx * (j - v[k]) + _dxx * (j - v[k]) * (j - v[k]) SGN _for_get_a(a_ptr, v[k], 0), 0); \
-				} \
-			} \
-			a_ptr += a->step; \
-			b_ptr += db->step; \
-		} \
-	} else { /* above algorithm cannot handle dxx == 0 properly, below is special casing for that */ \
-		assert(mx == 0); \
-		for (i = 0; i < a->rows; i++) \
-		{ \
-			for (j = 0; j < a->cols; j++) \
-				_for_set_b(b_ptr, j, SGN _for_get_a(a_ptr, j, 0), 0); \
-			for (j = 1; j < a->cols; j++) \
-				_for_set_b(b_ptr, j, ccv_min(_for_get_b(b_ptr, j, 0), _for_get_b(b_ptr, j - 1, 0) + _dx), 0); \
-			for (j = a->cols - 2; j >= 0; j--) \
-				_for_set_b(b_ptr, j, ccv_min(_for_get_b(b_ptr, j, 0), _for_get_b(b_ptr, j + 1, 0) - _dx), 0); \
-			a_ptr += a->step; \
-			b_ptr += db->step; \
-		} \
-	} \
-	b_ptr = db->data.u8; \
-	if (_dyy > 1e-6) \
-	{ \
-		for (j = 0; j < db->cols; j++) \
-		{ \
-			for (i = 0; i < db->rows; i++) \
-				_for_set_b(c_ptr, i, _for_get_b(b_ptr + i * db->step, j, 0), 0); \
-			k = 0; \
-			v[0] = 0; \
-			z[0] = (_for_type_b)-_for_max; \
-			z[1] = (_for_type_b)_for_max; \
-			for (i = 1; i < db->rows; i++) \
-			{ \
-				_for_type_b s; \
-				for (;;) \
-				{ \
-					assert(k >= 0 && k < ccv_max(db->rows, db->cols)); \
-					s = ((_for_get_b(c_ptr, i, 0) + _dyy * i * i - _dy * i) - (_for_get_b(c_ptr, v[k], 0) + _dyy * v[k] * v[k] - _dy * v[k])) / (2.0 * _dyy * (i - v[k])); \
-					if (s > z[k]) break; \
-					--k; \
-				} \
-				++k; \
-				assert(k >= 0 && k < ccv_max(db->rows, db->cols)); \
-				v[k] = i; \
-				z[k] = s; \
-				z[k + 1] = (_for_type_b)_for_max; \
-			} \
-			assert(z[k + 1] >= db->rows - 1); \
-			k = 0; \
-			if (my) \
-			{ \
-				for (i = 0; i < db->rows; i++) \
-				{ \
-					while (z[k + 1] < i) \
-					{ \
-						assert(k >= 0 && k < ccv_max(db->rows, db->cols) - 1); \
-						++k; \
-					} \
-					_for_set_b(b_ptr + i * db->step, j, _dy * (i - v[k]) + _dyy * (i - v[k]) * (i - v[k]) + _for_get_b(c_ptr, v[k], 0), 0); \
-					y_ptr[i * my->cols] = i - v[k]; \
-				} \
-				++y_ptr; \
-			} else { \
-				for (i = 0; i < db->rows; i++) \
-				{ \
-					while (z[k + 1] < i) \
-					{ \
-						assert(k >= 0 && k < ccv_max(db->rows, db->cols) - 1); \
-						++k; \
-					} \
-					_for_set_b(b_ptr + i * db->step, j, _dy * (i - v[k]) + _dyy * (i - v[k]) * (i - v[k]) + _for_get_b(c_ptr, v[k], 0), 0); \
-				} \
-			} \
-		} \
-	} else { \
-		assert(my == 0); \
-		for (j = 0; j < db->cols; j++) \
-		{ \
-			for (i = 1; i < db->rows; i++) \
-				_for_set_b(b_ptr + i * db->step, j, ccv_min(_for_get_b(b_ptr + i * db->step, j, 0), _for_get_b(b_ptr + (i - 1) * db->step, j, 0) + _dy), 0); \
-			for (i = db->rows - 2; i >= 0; i--) \
-				_for_set_b(b_ptr + i * db->step, j, ccv_min(_for_get_b(b_ptr + i * db->step, j, 0), _for_get_b(b_ptr + (i + 1) * db->step, j, 0) - _dy), 0); \
-		} \
-	}
-	if (flag & CCV_NEGATIVE)
-	{
-#define SGN -
-		if (db->type & CCV_64F)
-		{
-			ccv_matrix_typeof_setter_getter(db->type, ccv_matrix_getter, a->type, for_block, DBL_MAX);
-		} else {
-			ccv_matrix_typeof_setter_getter(db->type, ccv_matrix_getter, a->type, for_block, FLT_MAX);
-		}
-#undef SGN
-	} else {
-#define SGN +
-		if (db->type & CCV_64F)
-		{
-			ccv_matrix_typeof_setter_getter(db->type, ccv_matrix_getter, a->type, for_block, DBL_MAX);
-		} else {
-			ccv_matrix_typeof_setter_getter(db->type, ccv_matrix_getter, a->type, for_block, FLT_MAX);
-		}
-#undef SGN
-	}
+					float w = _for_get(a_ptr, j, 0); \
+					((float*)f)[j] = negative ? -w : w; \
+				}
+			ccv_matrix_getter(a->type, for_block);
 #undef for_block
+			if (is_64f)
+				_ccv_distance_transform_1d_64f((double*)f, (double*)b_ptr, x_ptr, a->cols, dx, dxx, (double*)h, v, (double*)z);
+			else
+				_ccv_distance_transform_1d_32f((float*)f, (float*)b_ptr, x_ptr, a->cols, dx, dxx, (float*)h, v, (float*)z);
+			a_ptr += a->step;
+		}
+		ccfree(f);
+	} parallel_endfor
+	if (is_64f)
+		_ccv_distance_transform_columns_64f(db, my, dy, dyy);
+	else
+		_ccv_distance_transform_columns_32f(db, my, dy, dyy);
 }
@@ -1,6 +1,12 @@
 #include "ccv.h"
 #include "ccv_internal.h"
 
+#if defined(HAVE_SSE2)
+#include <emmintrin.h>
+#elif defined(HAVE_NEON)
+#include <arm_neon.h>
+#endif
+
 /* area interpolation resample is adopted from OpenCV */
 
 typedef struct {
@@ -8,22 +14,136 @@ typedef struct {
 	unsigned int alpha;
 } ccv_int_alpha;
 
+/* the taps of dx are xofs[xtab[dx]] to xofs[xtab[dx + 1] - 1], one row is accumulated into buf */
+static void _ccv_resample_area_8u_row(const unsigned char* a_ptr, const ccv_int_alpha* xofs, const int* xtab, int cols, int ch, unsigned int* buf)
+{
+	int dx, i, k;
+	switch (ch)
+	{
+		case 1:
+			for (dx = 0; dx < cols; dx++)
+			{
+				unsigned int t = 0;
+				for (k = xtab[dx]; k < xtab[dx + 1]; k++)
+					t += a_ptr[xofs[k].si] * xofs[k].alpha;
+				buf[dx] = t;
+			}
+			break;
+		case 3:
+			for (dx = 0; dx < cols; dx++)
+			{
+				unsigned int t0 = 0, t1 = 0, t2 = 0;
+				for (k = xtab[dx]; k < xtab[dx + 1]; k++)
+				{
+					const unsigned char* p = a_ptr + xofs[k].si;
+					unsigned int alpha = xofs[k].alpha;
+					t0 += p[0] * alpha;
+					t1 += p[1] * alpha;
+					t2 += p[2] * alpha;
+				}
+				buf[dx * 3] = t0;
+				buf[dx * 3 + 1] = t1;
+				buf[dx * 3 + 2] = t2;
+			}
+			break;
+		default:
+			for (dx = 0; dx < cols; dx++)
+			{
+				for (i = 0; i < ch; i++)
+					buf[dx * ch + i] = 0;
+				for (k = xtab[dx]; k < xtab[dx + 1]; k++)
+					for (i = 0; i < ch; i++)
+						buf[dx * ch + i] += a_ptr[xofs[k].si + i] * xofs[k].alpha;
+			}
+	}
+}
+
+static void _ccv_resample_area_8u_accumulate(const unsigned int* buf, unsigned int* sum, int n)
+{
+	int i = 0;
+#if defined(HAVE_SSE2)
+	for (; i <= n - 4; i += 4)
+		_mm_storeu_si128((__m128i*)(sum + i), _mm_add_epi32(_mm_loadu_si128((const __m128i*)(sum + i)), _mm_slli_epi32(_mm_loadu_si128((const __m128i*)(buf + i)), 8)));
+#elif defined(HAVE_NEON)
+	for (; i <= n - 4; i += 4)
+		vst1q_u32(sum + i, vaddq_u32(vld1q_u32(sum + i), vshlq_n_u32(vld1q_u32(buf + i), 8)));
+#endif
+	for (; i < n; i++)
+		sum[i] += buf[i] * 256;
+}
+
+#if defined(HAVE_SSE2)
+/* SSE2 doesn't have 32-bit multiply, multiply the even and the odd lanes separately */
+static inline __m128i _ccv_mullo_epi32(__m128i a, __m128i b)
+{
+	__m128i even = _mm_mul_epu32(a, b);
+	__m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+/* nor does it have integer division. The dividend and the divisor are exact in double, but the quotient from
+ * double can be off by one (the division may be turned into multiplying the reciprocal with -ffast-math),
+ * thus, it is corrected with the remainder, which is exact with wrap-around integer arithmetic */
+static inline __m128i _ccv_div_epu32(__m128i x, __m128d dd, __m128i d)
+{
+	const __m128i bias = _mm_set1_epi32(0x80000000);
+	const __m128d dbias = _mm_set1_pd(2147483648.0);
+	__m128i xb = _mm_xor_si128(x, bias);
+	__m128d lo = _mm_div_pd(_mm_add_pd(_mm_cvtepi32_pd(xb), dbias), dd);
+	__m128d hi = _mm_div_pd(_mm_add_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(xb, _MM_SHUFFLE(1, 0, 3, 2))), dbias), dd);
+	__m128i q = _mm_unpacklo_epi64(_mm_cvttpd_epi32(lo), _mm_cvttpd_epi32(hi));
+	__m128i r = _mm_sub_epi32(x, _ccv_mullo_epi32(q, d));
+	q = _mm_add_epi32(q, _mm_cmplt_epi32(r, _mm_setzero_si128()));
+	return _mm_sub_epi32(q, _mm_cmpgt_epi32(r, _mm_sub_epi32(d, _mm_set1_epi32(1))));
+}
+#endif
+
+/* write out a row, the last source row contributes beta1 to this row, and beta to the next one */
+static void _ccv_resample_area_8u_flush(const unsigned int* buf, unsigned int* sum, unsigned char* b_ptr, int n, unsigned int beta, unsigned int inv_scale_256)
+{
+	unsigned int beta1 = 256 - beta;
+	int i = 0;
+#if defined(HAVE_SSE2)
+	const __m128i beta4 = _mm_set1_epi32(beta);
+	const __m128i beta14 = _mm_set1_epi32(beta1);
+	const __m128d inv_scale_256_2 = _mm_set1_pd(inv_scale_256);
+	const __m128i inv_scale_256_4 = _mm_set1_epi32(inv_scale_256);
+	for (; i <= n - 8; i += 8)
+	{
+		__m128i buf0 = _mm_loadu_si128((const __m128i*)(buf + i));
+		__m128i buf1 = _mm_loadu_si128((const __m128i*)(buf + i + 4));
+		__m128i q0 = _ccv_div_epu32(_mm_add_epi32(_mm_loadu_si128((const __m128i*)(sum + i)), _ccv_mullo_epi32(buf0, beta14)), inv_scale_256_2, inv_scale_256_4);
+		__m128i q1 = _ccv_div_epu32(_mm_add_epi32(_mm_loadu_si128((const __m128i*)(sum + i + 4)), _ccv_mullo_epi32(buf1, beta14)), inv_scale_256_2, inv_scale_256_4);
+		_mm_storeu_si128((__m128i*)(sum + i), _ccv_mullo_epi32(buf0, beta4));
+		_mm_storeu_si128((__m128i*)(sum + i + 4), _ccv_mullo_epi32(buf1, beta4));
+		_mm_storel_epi64((__m128i*)(b_ptr + i), _mm_packus_epi16(_mm_packs_epi32(q0, q1), _mm_setzero_si128()));
+	}
+#endif
+	for (; i < n; i++)
+	{
+		b_ptr[i] = ccv_clamp((sum[i] + buf[i] * beta1) / inv_scale_256, 0, 255);
+		sum[i] = buf[i] * beta;
+	}
+}
+
 static void _ccv_resample_area_8u(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b)
 {
 	assert(a->cols > 0 && b->cols > 0);
 	ccv_int_alpha* xofs = (ccv_int_alpha*)alloca(sizeof(ccv_int_alpha) * a->cols * 2);
+	int* xtab = (int*)alloca(sizeof(int) * (b->cols + 1));
 	int ch = ccv_clamp(CCV_GET_CHANNEL(a->type), 1, 4);
 	double scale_x = (double)a->cols / b->cols;
 	double scale_y = (double)a->rows / b->rows;
 	// double scale = 1.f / (scale_x * scale_y);
 	unsigned int inv_scale_256 = (int)(scale_x * scale_y * 0x10000);
-	int dx, dy, sx, sy, i, k;
+	int dx, dy, sx, sy, k;
 	for (dx = 0, k = 0; dx < b->cols; dx++)
 	{
 		double fsx1 = dx * scale_x, fsx2 = fsx1 + scale_x;
 		int sx1 = (int)(fsx1 + 1.0 - 1e-6), sx2 = (int)(fsx2);
 		sx1 = ccv_min(sx1, a->cols - 1);
 		sx2 = ccv_min(sx2, a->cols - 1);
+		xtab[dx] = k;
 
 		if (sx1 > fsx1)
 		{
@@ -46,64 +166,122 @@ static void _ccv_resample_area_8u(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b)
 			xofs[k++].alpha = (unsigned int)((fsx2 - sx2) * 256);
 		}
 	}
-	int xofs_count = k;
+	xtab[b->cols] = k;
 	unsigned int* buf = (unsigned int*)alloca(b->cols * ch * sizeof(unsigned int));
 	unsigned int* sum = (unsigned int*)alloca(b->cols * ch * sizeof(unsigned int));
 	for (dx = 0; dx < b->cols * ch; dx++)
-		buf[dx] = sum[dx] = 0;
+		sum[dx] = 0;
 	dy = 0;
 	for (sy = 0; sy < a->rows; sy++)
 	{
-		unsigned char* a_ptr = a->data.u8 + a->step * sy;
-		for (k = 0; k < xofs_count; k++)
-		{
-			int dxn = xofs[k].di;
-			unsigned int alpha = xofs[k].alpha;
-			for (i = 0; i < ch; i++)
-				buf[dxn + i] += a_ptr[xofs[k].si + i] * alpha;
-		}
+		_ccv_resample_area_8u_row(a->data.u8 + a->step * sy, xofs, xtab, b->cols, ch, buf);
 		if ((dy + 1) * scale_y <= sy + 1 || sy == a->rows - 1)
 		{
 			unsigned int beta = (int)(ccv_max(sy + 1 - (dy + 1) * scale_y, 0.f) * 256);
-			unsigned int beta1 = 256 - beta;
-			unsigned char* b_ptr = b->data.u8 + b->step * dy;
-			if (beta <= 0)
+			_ccv_resample_area_8u_flush(buf, sum, b->data.u8 + b->step * dy, b->cols * ch, beta, inv_scale_256);
+			dy++;
+		} else
+			_ccv_resample_area_8u_accumulate(buf, sum, b->cols * ch);
+	}
+}
+
+typedef struct {
+	int si, di;
+	float alpha;
+} ccv_area_alpha_t;
+
+static void _ccv_resample_area_32f_row(const float* a_ptr, const ccv_area_alpha_t* xofs, const int* xtab, int cols, int ch, float* buf)
+{
+	int dx, i, k;
+	switch (ch)
+	{
+		case 1:
+			for (dx = 0; dx < cols; dx++)
 			{
-				for (dx = 0; dx < b->cols * ch; dx++)
-				{
-					b_ptr[dx] = ccv_clamp((sum[dx] + buf[dx] * 256) / inv_scale_256, 0, 255);
-					sum[dx] = buf[dx] = 0;
-				}
-			} else {
-				for (dx = 0; dx < b->cols * ch; dx++)
+				float t = 0;
+				for (k = xtab[dx]; k < xtab[dx + 1]; k++)
+					t += a_ptr[xofs[k].si] * xofs[k].alpha;
+				buf[dx] = t;
+			}
+			break;
+		case 3:
+			for (dx = 0; dx < cols; dx++)
+			{
+				float t0 = 0, t1 = 0, t2 = 0;
+				for (k = xtab[dx]; k < xtab[dx + 1]; k++)
 				{
-					b_ptr[dx] = ccv_clamp((sum[dx] + buf[dx] * beta1) / inv_scale_256, 0, 255);
-					sum[dx] = buf[dx] * beta;
-					buf[dx] = 0;
+					const float* p = a_ptr + xofs[k].si;
+					float alpha = xofs[k].alpha;
+					t0 += p[0] * alpha;
+					t1 += p[1] * alpha;
+					t2 += p[2] * alpha;
 				}
+				buf[dx * 3] = t0;
+				buf[dx * 3 + 1] = t1;
+				buf[dx * 3 + 2] = t2;
 			}
-			dy++;
-		}
-		else
-		{
-			for(dx = 0; dx < b->cols * ch; dx++)
+			break;
+		default:
+			for (dx = 0; dx < cols; dx++)
 			{
-				sum[dx] += buf[dx] * 256;
-				buf[dx] = 0;
+				for (i = 0; i < ch; i++)
+					buf[dx * ch + i] = 0;
+				for (k = xtab[dx]; k < xtab[dx + 1]; k++)
+					for (i = 0; i < ch; i++)
+						buf[dx * ch + i] += a_ptr[xofs[k].si + i] * xofs[k].alpha;
 			}
-		}
 	}
 }
 
-typedef struct {
-	int si, di;
-	float alpha;
-} ccv_area_alpha_t;
+static void _ccv_resample_area_32f_accumulate(const float* buf, float* sum, int n)
+{
+	int i = 0;
+#if defined(HAVE_SSE2)
+	for (; i <= n - 4; i += 4)
+		_mm_storeu_ps(sum + i, _mm_add_ps(_mm_loadu_ps(sum + i), _mm_loadu_ps(buf + i)));
+#elif defined(HAVE_NEON)
+	for (; i <= n - 4; i += 4)
+		vst1q_f32(sum + i, vaddq_f32(vld1q_f32(sum + i), vld1q_f32(buf + i)));
+#endif
+	for (; i < n; i++)
+		sum[i] += buf[i];
+}
+
+static void _ccv_resample_area_32f_flush(const float* buf, float* sum, float* b_ptr, int n, float beta)
+{
+	float beta1 = 1 - beta;
+	int i = 0;
+#if defined(HAVE_SSE2)
+	const __m128 beta4 = _mm_set1_ps(beta);
+	const __m128 beta14 = _mm_set1_ps(beta1);
+	for (; i <= n - 4; i += 4)
+	{
+		__m128 buf4 = _mm_loadu_ps(buf + i);
+		_mm_storeu_ps(b_ptr + i, _mm_add_ps(_mm_loadu_ps(sum + i), _mm_mul_ps(buf4, beta14)));
+		_mm_storeu_ps(sum + i, _mm_mul_ps(buf4, beta4));
+	}
+#elif defined(HAVE_NEON)
+	const float32x4_t beta4 = vdupq_n_f32(beta);
+	const float32x4_t beta14 = vdupq_n_f32(beta1);
+	for (; i <= n - 4; i += 4)
+	{
+		float32x4_t buf4 = vld1q_f32(buf + i);
+		vst1q_f32(b_ptr + i, vaddq_f32(vld1q_f32(sum + i), vmulq_f32(buf4, beta14)));
+		vst1q_f32(sum + i, vmulq_f32(buf4, beta4));
+	}
+#endif
+	for (; i < n; i++)
+	{
+		b_ptr[i] = sum[i] + buf[i] * beta1;
+		sum[i] = buf[i] * beta;
+	}
+}
 
 static void _ccv_resample_area(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b)
 {
 	assert(a->cols > 0 && b->cols > 0);
 	ccv_area_alpha_t* xofs = (ccv_area_alpha_t*)alloca(sizeof(ccv_area_alpha_t) * a->cols * 2);
+	int* xtab = (int*)alloca(sizeof(int) * (b->cols + 1));
 	int ch = CCV_GET_CHANNEL(a->type);
 	double scale_x = (double)a->cols / b->cols;
 	double scale_y = (double)a->rows / b->rows;
@@ -115,6 +293,7 @@ static void _ccv_resample_area(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b)
 		int sx1 = (int)(fsx1 + 1.0 - 1e-6), sx2 = (int)(fsx2);
 		sx1 = ccv_min(sx1, a->cols - 1);
 		sx2 = ccv_min(sx2, a->cols - 1);
+		xtab[dx] = k;
 
 		if (sx1 > fsx1)
 		{
@@ -137,56 +316,49 @@ static void _ccv_resample_area(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b)
 			xofs[k++].alpha = (float)((fsx2 - sx2) * scale);
 		}
 	}
-	int xofs_count = k;
+	xtab[b->cols] = k;
 	float* buf = (float*)alloca(b->cols * ch * sizeof(float));
 	float* sum = (float*)alloca(b->cols * ch * sizeof(float));
+	/* when the output is not 32f, a row is flushed into a float row first, and then converted */
+	float* out = CCV_GET_DATA_TYPE(b->type) == CCV_32F ? 0 : (float*)alloca(b->cols * ch * sizeof(float));
 	for (dx = 0; dx < b->cols * ch; dx++)
-		buf[dx] = sum[dx] = 0;
+		sum[dx] = 0;
 	dy = 0;
-#define for_block(_for_get, _for_set) \
-	for (sy = 0; sy < a->rows; sy++) \
-	{ \
-		unsigned char* a_ptr = a->data.u8 + a->step * sy; \
-		for (k = 0; k < xofs_count; k++) \
-		{ \
-			int dxn = xofs[k].di; \
-			float alpha = xofs[k].alpha; \
-			for (i = 0; i < ch; i++) \
-				buf[dxn + i] += _for_get(a_ptr, xofs[k].si + i, 0) * alpha; \
-		} \
-		if ((dy + 1) * scale_y <= sy + 1 || sy == a->rows - 1) \
-		{ \
-			float beta = ccv_max(sy + 1 - (dy + 1) * scale_y, 0.f); \
-			float beta1 = 1 - beta; \
-			unsigned char* b_ptr = b->data.u8 + b->step * dy; \
-			if (fabs(beta) < 1e-3) \
+	for (sy = 0; sy < a->rows; sy++)
+	{
+		unsigned char* a_ptr = a->data.u8 + a->step * sy;
+		if (CCV_GET_DATA_TYPE(a->type) == CCV_32F)
+			_ccv_resample_area_32f_row(a->data.f32 + a->step / sizeof(float) * sy, xofs, xtab, b->cols, ch, buf);
+		else {
+#define for_block(_, _for_get) \
+			for (dx = 0; dx < b->cols; dx++) \
 			{ \
+				for (i = 0; i < ch; i++) \
+					buf[dx * ch + i] = 0; \
+				for (k = xtab[dx]; k < xtab[dx + 1]; k++) \
+					for (i = 0; i < ch; i++) \
+						buf[dx * ch + i] += _for_get(a_ptr, xofs[k].si + i, 0) * xofs[k].alpha; \
+			}
+			ccv_matrix_getter(a->type, for_block);
+#undef for_block
+		}
+		if ((dy + 1) * scale_y <= sy + 1 || sy == a->rows - 1)
+		{
+			float beta = ccv_max(sy + 1 - (dy + 1) * scale_y, 0.f);
+			unsigned char* b_ptr = b->data.u8 + b->step * dy;
+			_ccv_resample_area_32f_flush(buf, sum, out ? out : (float*)b_ptr, b->cols * ch, fabs(beta) < 1e-3 ? 0 : beta);
+			if (out)
+			{
+#define for_block(_, _for_set) \
 				for (dx = 0; dx < b->cols * ch; dx++) \
-				{ \
-					_for_set(b_ptr, dx, sum[dx] + buf[dx], 0); \
-					sum[dx] = buf[dx] = 0; \
-				} \
-			} else { \
-				for (dx = 0; dx < b->cols * ch; dx++) \
-				{ \
-					_for_set(b_ptr, dx, sum[dx] + buf[dx] * beta1, 0); \
-					sum[dx] = buf[dx] * beta; \
-					buf[dx] = 0; \
-				} \
-			} \
-			dy++; \
-		} \
-		else \
-		{ \
-			for(dx = 0; dx < b->cols * ch; dx++) \
-			{ \
-				sum[dx] += buf[dx]; \
-				buf[dx] = 0; \
-			} \
-		} \
-	}
-	ccv_matrix_getter(a->type, ccv_matrix_setter, b->type, for_block);
+					_for_set(b_ptr, dx, out[dx], 0);
+				ccv_matrix_setter(b->type, for_block);
 #undef for_block
+			}
+			dy++;
+		} else
+			_ccv_resample_area_32f_accumulate(buf, sum, b->cols * ch);
+	}
 }
 
 typedef struct {
@@ -213,6 +385,64 @@ static void _ccv_init_cubic_coeffs(int si, int sz, float s, ccv_cubic_coeffs_t*
 	coeff->coeffs[3] = 1.f - coeff->coeffs[0] - coeff->coeffs[1] - coeff->coeffs[2];
 }
 
+static void _ccv_resample_cubic_32f_row(const float* a_ptr, const ccv_cubic_coeffs_t* xofs, int cols, int ch, float* row)
+{
+	int j, k;
+	switch (ch)
+	{
+		case 1:
+			for (j = 0; j < cols; j++)
+				row[j] = a_ptr[xofs[j].si[0]] * xofs[j].coeffs[0] + a_ptr[xofs[j].si[1]] * xofs[j].coeffs[1] +
+						 a_ptr[xofs[j].si[2]] * xofs[j].coeffs[2] + a_ptr[xofs[j].si[3]] * xofs[j].coeffs[3];
+			break;
+		case 3:
+			for (j = 0; j < cols; j++)
+			{
+				const float* p0 = a_ptr + xofs[j].si[0] * 3;
+				const float* p1 = a_ptr + xofs[j].si[1] * 3;
+				const float* p2 = a_ptr + xofs[j].si[2] * 3;
+				const float* p3 = a_ptr + xofs[j].si[3] * 3;
+				const float c0 = xofs[j].coeffs[0], c1 = xofs[j].coeffs[1], c2 = xofs[j].coeffs[2], c3 = xofs[j].coeffs[3];
+				row[j * 3] = p0[0] * c0 + p1[0] * c1 + p2[0] * c2 + p3[0] * c3;
+				row[j * 3 + 1] = p0[1] * c0 + p1[1] * c1 + p2[1] * c2 + p3[1] * c3;
+				row[j * 3 + 2] = p0[2] * c0 + p1[2] * c1 + p2[2] * c2 + p3[2] * c3;
+			}
+			break;
+		default:
+			for (j = 0; j < cols; j++)
+				for (k = 0; k < ch; k++)
+					row[j * ch + k] = a_ptr[xofs[j].si[0] * ch + k] * xofs[j].coeffs[0] + a_ptr[xofs[j].si[1] * ch + k] * xofs[j].coeffs[1] +
+									  a_ptr[xofs[j].si[2] * ch + k] * xofs[j].coeffs[2] + a_ptr[xofs[j].si[3] * ch + k] * xofs[j].coeffs[3];
+	}
+}
+
+static void _ccv_resample_cubic_32f_column(float* const* row, const float* coeffs, float* b_ptr, int n)
+{
+	int j = 0;
+#if defined(HAVE_SSE2)
+	const __m128 c0 = _mm_set1_ps(coeffs[0]);
+	const __m128 c1 = _mm_set1_ps(coeffs[1]);
+	const __m128 c2 = _mm_set1_ps(coeffs[2]);
+	const __m128 c3 = _mm_set1_ps(coeffs[3]);
+	for (; j <= n - 4; j += 4)
+	{
+		__m128 v = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(row[0] + j), c0), _mm_mul_ps(_mm_loadu_ps(row[1] + j), c1));
+		v = _mm_add_ps(v, _mm_mul_ps(_mm_loadu_ps(row[2] + j), c2));
+		_mm_storeu_ps(b_ptr + j, _mm_add_ps(v, _mm_mul_ps(_mm_loadu_ps(row[3] + j), c3)));
+	}
+#elif defined(HAVE_NEON)
+	for (; j <= n - 4; j += 4)
+	{
+		float32x4_t v = vmulq_n_f32(vld1q_f32(row[0] + j), coeffs[0]);
+		v = vmlaq_n_f32(v, vld1q_f32(row[1] + j), coeffs[1]);
+		v = vmlaq_n_f32(v, vld1q_f32(row[2] + j), coeffs[2]);
+		vst1q_f32(b_ptr + j, vmlaq_n_f32(v, vld1q_f32(row[3] + j), coeffs[3]));
+	}
+#endif
+	for (; j < n; j++)
+		b_ptr[j] = row[0][j] * coeffs[0] + row[1][j] * coeffs[1] + row[2][j] * coeffs[2] + row[3][j] * coeffs[3];
+}
+
 static void _ccv_resample_cubic_float_only(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b)
 {
 	assert(CCV_GET_DATA_TYPE(b->type) == CCV_32F || CCV_GET_DATA_TYPE(b->type) == CCV_64F);
@@ -233,40 +463,51 @@ static void _ccv_resample_cubic_float_only(ccv_dense_matrix_t* a, ccv_dense_matr
 	unsigned char* a_ptr = a->data.u8;
 	unsigned char* b_ptr = b->data.u8;
 	int psi = -1, siy = 0;
-#define for_block(_for_get, _for_set_b, _for_get_b) \
-	for (i = 0; i < b->rows; i++) \
-	{ \
-		ccv_cubic_coeffs_t yofs; \
-		float sy = (i + 0.5) * scale_y - 0.5; \
-		_ccv_init_cubic_coeffs((int)sy, a->rows, sy, &yofs); \
-		if (yofs.si[3] > psi) \
-		{ \
-			for (; siy <= yofs.si[3]; siy++) \
-			{ \
-				unsigned char* row = buf + (siy & 0x3) * b->step; \
-				for (j = 0; j < b->cols; j++) \
-					for (k = 0; k < ch; k++) \
-						_for_set_b(row, j * ch + k, _for_get(a_ptr, xofs[j].si[0] * ch + k, 0) * xofs[j].coeffs[0] + \
-													_for_get(a_ptr, xofs[j].si[1] * ch + k, 0) * xofs[j].coeffs[1] + \
-													_for_get(a_ptr, xofs[j].si[2] * ch + k, 0) * xofs[j].coeffs[2] + \
-													_for_get(a_ptr, xofs[j].si[3] * ch + k, 0) * xofs[j].coeffs[3], 0); \
-				a_ptr += a->step; \
-			} \
-			psi = yofs.si[3]; \
-		} \
-		unsigned char* row[4] = { \
-			buf + (yofs.si[0] & 0x3) * b->step, \
-			buf + (yofs.si[1] & 0x3) * b->step, \
-			buf + (yofs.si[2] & 0x3) * b->step, \
-			buf + (yofs.si[3] & 0x3) * b->step, \
-		}; \
-		for (j = 0; j < b->cols * ch; j++) \
-			_for_set_b(b_ptr, j, _for_get_b(row[0], j, 0) * yofs.coeffs[0] + _for_get_b(row[1], j, 0) * yofs.coeffs[1] + \
-								 _for_get_b(row[2], j, 0) * yofs.coeffs[2] + _for_get_b(row[3], j, 0) * yofs.coeffs[3], 0); \
-		b_ptr += b->step; \
-	}
-	ccv_matrix_getter(a->type, ccv_matrix_setter_getter_float_only, b->type, for_block);
+	for (i = 0; i < b->rows; i++)
+	{
+		ccv_cubic_coeffs_t yofs;
+		float sy = (i + 0.5) * scale_y - 0.5;
+		_ccv_init_cubic_coeffs((int)sy, a->rows, sy, &yofs);
+		if (yofs.si[3] > psi)
+		{
+			for (; siy <= yofs.si[3]; siy++)
+			{
+				unsigned char* row = buf + (siy & 0x3) * b->step;
+				if (CCV_GET_DATA_TYPE(a->type) == CCV_32F && CCV_GET_DATA_TYPE(b->type) == CCV_32F)
+					_ccv_resample_cubic_32f_row((float*)a_ptr, xofs, b->cols, ch, (float*)row);
+				else {
+#define for_block(_for_get, _for_set_b) \
+					for (j = 0; j < b->cols; j++) \
+						for (k = 0; k < ch; k++) \
+							_for_set_b(row, j * ch + k, _for_get(a_ptr, xofs[j].si[0] * ch + k, 0) * xofs[j].coeffs[0] + \
+														_for_get(a_ptr, xofs[j].si[1] * ch + k, 0) * xofs[j].coeffs[1] + \
+														_for_get(a_ptr, xofs[j].si[2] * ch + k, 0) * xofs[j].coeffs[2] + \
+														_for_get(a_ptr, xofs[j].si[3] * ch + k, 0) * xofs[j].coeffs[3], 0);
+					ccv_matrix_getter(a->type, ccv_matrix_setter_float_only, b->type, for_block);
+#undef for_block
+				}
+				a_ptr += a->step;
+			}
+			psi = yofs.si[3];
+		}
+		unsigned char* row[4] = {
+			buf + (yofs.si[0] & 0x3) * b->step,
+			buf + (yofs.si[1] & 0x3) * b->step,
+			buf + (yofs.si[2] & 0x3) * b->step,
+			buf + (yofs.si[3] & 0x3) * b->step,
+		};
+		if (CCV_GET_DATA_TYPE(b->type) == CCV_32F)
+			_ccv_resample_cubic_32f_column((float**)row, yofs.coeffs, (float*)b_ptr, b->cols * ch);
+		else {
+#define for_block(_, _for_set_b, _for_get_b) \
+			for (j = 0; j < b->cols * ch; j++) \
+				_for_set_b(b_ptr, j, _for_get_b(row[0], j, 0) * yofs.coeffs[0] + _for_get_b(row[1], j, 0) * yofs.coeffs[1] + \
+									 _for_get_b(row[2], j, 0) * yofs.coeffs[2] + _for_get_b(row[3], j, 0) * yofs.coeffs[3], 0);
+			ccv_matrix_setter_getter_float_only(b->type, for_block);
 #undef for_block
+		}
+		b_ptr += b->step;
+	}
 }
 
 static void _ccv_init_cubic_integer_coeffs(int si, int sz, float s, ccv_cubic_integer_coeffs_t* coeff)
@@ -284,6 +525,78 @@ static void _ccv_init_cubic_integer_coeffs(int si, int sz, float s, ccv_cubic_in
 	coeff->coeffs[3] = W_BITS - coeff->coeffs[0] - coeff->coeffs[1] - coeff->coeffs[2];
 }
 
+static void _ccv_resample_cubic_8u_row(const unsigned char* a_ptr, const ccv_cubic_integer_coeffs_t* xofs, int cols, int ch, int* row)
+{
+	int j, k;
+	switch (ch)
+	{
+		case 1:
+			for (j = 0; j < cols; j++)
+				row[j] = a_ptr[xofs[j].si[0]] * xofs[j].coeffs[0] + a_ptr[xofs[j].si[1]] * xofs[j].coeffs[1] +
+						 a_ptr[xofs[j].si[2]] * xofs[j].coeffs[2] + a_ptr[xofs[j].si[3]] * xofs[j].coeffs[3];
+			break;
+		case 3:
+			for (j = 0; j < cols; j++)
+			{
+				const unsigned char* p0 = a_ptr + xofs[j].si[0] * 3;
+				const unsigned char* p1 = a_ptr + xofs[j].si[1] * 3;
+				const unsigned char* p2 = a_ptr + xofs[j].si[2] * 3;
+				const unsigned char* p3 = a_ptr + xofs[j].si[3] * 3;
+				const int c0 = xofs[j].coeffs[0], c1 = xofs[j].coeffs[1], c2 = xofs[j].coeffs[2], c3 = xofs[j].coeffs[3];
+				row[j * 3] = p0[0] * c0 + p1[0] * c1 + p2[0] * c2 + p3[0] * c3;
+				row[j * 3 + 1] = p0[1] * c0 + p1[1] * c1 + p2[1] * c2 + p3[1] * c3;
+				row[j * 3 + 2] = p0[2] * c0 + p1[2] * c1 + p2[2] * c2 + p3[2] * c3;
+			}
+			break;
+		default:
+			for (j = 0; j < cols; j++)
+				for (k = 0; k < ch; k++)
+					row[j * ch + k] = a_ptr[xofs[j].si[0] * ch + k] * xofs[j].coeffs[0] + a_ptr[xofs[j].si[1] * ch + k] * xofs[j].coeffs[1] +
+									  a_ptr[xofs[j].si[2] * ch + k] * xofs[j].coeffs[2] + a_ptr[xofs[j].si[3] * ch + k] * xofs[j].coeffs[3];
+	}
+}
+
+static void _ccv_resample_cubic_8u_column(int* const* row, const int* coeffs, unsigned char* b_ptr, int n)
+{
+	int j = 0;
+#if defined(HAVE_SSE2)
+	const __m128i c0 = _mm_set1_epi32(coeffs[0]);
+	const __m128i c1 = _mm_set1_epi32(coeffs[1]);
+	const __m128i c2 = _mm_set1_epi32(coeffs[2]);
+	const __m128i c3 = _mm_set1_epi32(coeffs[3]);
+	const __m128i delta = _mm_set1_epi32(1 << 11);
+#define _ccv_cubic_8u_column_sse2(_j) \
+	_mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(_mm_add_epi32(_mm_add_epi32( \
+		_ccv_mullo_epi32(_mm_loadu_si128((const __m128i*)(row[0] + (_j))), c0), \
+		_ccv_mullo_epi32(_mm_loadu_si128((const __m128i*)(row[1] + (_j))), c1)), \
+		_ccv_mullo_epi32(_mm_loadu_si128((const __m128i*)(row[2] + (_j))), c2)), \
+		_ccv_mullo_epi32(_mm_loadu_si128((const __m128i*)(row[3] + (_j))), c3)), delta), 12)
+	for (; j <= n - 8; j += 8)
+	{
+		__m128i v0 = _ccv_cubic_8u_column_sse2(j);
+		__m128i v1 = _ccv_cubic_8u_column_sse2(j + 4);
+		_mm_storel_epi64((__m128i*)(b_ptr + j), _mm_packus_epi16(_mm_packs_epi32(v0, v1), _mm_setzero_si128()));
+	}
+#undef _ccv_cubic_8u_column_sse2
+#elif defined(HAVE_NEON)
+	for (; j <= n - 8; j += 8)
+	{
+		int32x4_t v0 = vmulq_n_s32(vld1q_s32(row[0] + j), coeffs[0]);
+		int32x4_t v1 = vmulq_n_s32(vld1q_s32(row[0] + j + 4), coeffs[0]);
+		v0 = vmlaq_n_s32(v0, vld1q_s32(row[1] + j), coeffs[1]);
+		v1 = vmlaq_n_s32(v1, vld1q_s32(row[1] + j + 4), coeffs[1]);
+		v0 = vmlaq_n_s32(v0, vld1q_s32(row[2] + j), coeffs[2]);
+		v1 = vmlaq_n_s32(v1, vld1q_s32(row[2] + j + 4), coeffs[2]);
+		v0 = vmlaq_n_s32(v0, vld1q_s32(row[3] + j), coeffs[3]);
+		v1 = vmlaq_n_s32(v1, vld1q_s32(row[3] + j + 4), coeffs[3]);
+		// the rounding shift is the same as ccv_descale
+		vst1_u8(b_ptr + j, vqmovun_s16(vcombine_s16(vqmovn_s32(vrshrq_n_s32(v0, 12)), vqmovn_s32(vrshrq_n_s32(v1, 12)))));
+	}
+#endif
+	for (; j < n; j++)
+		b_ptr[j] = ccv_clamp(ccv_descale(row[0][j] * coeffs[0] + row[1][j] * coeffs[1] + row[2][j] * coeffs[2] + row[3][j] * coeffs[3], 12), 0, 255);
+}
+
 static void _ccv_resample_cubic_integer_only(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b)
 {
 	assert(CCV_GET_DATA_TYPE(b->type) == CCV_8U || CCV_GET_DATA_TYPE(b->type) == CCV_32S || CCV_GET_DATA_TYPE(b->type) == CCV_64S);
@@ -305,41 +618,54 @@ static void _ccv_resample_cubic_integer_only(ccv_dense_matrix_t* a, ccv_dense_ma
 #endif
 	unsigned char* a_ptr = a->data.u8;
 	unsigned char* b_ptr = b->data.u8;
+	/* 8u to 8u buffers the rows in 32s */
+	int fast_8u = CCV_GET_DATA_TYPE(a->type) == CCV_8U && CCV_GET_DATA_TYPE(b->type) == CCV_8U;
 	int psi = -1, siy = 0;
-#define for_block(_for_get_a, _for_set, _for_get, _for_set_b) \
-	for (i = 0; i < b->rows; i++) \
-	{ \
-		ccv_cubic_integer_coeffs_t yofs; \
-		float sy = (i + 0.5) * scale_y - 0.5; \
-		_ccv_init_cubic_integer_coeffs((int)sy, a->rows, sy, &yofs); \
-		if (yofs.si[3] > psi) \
-		{ \
-			for (; siy <= yofs.si[3]; siy++) \
-			{ \
-				unsigned char* row = buf + (siy & 0x3) * bufstep; \
-				for (j = 0; j < b->cols; j++) \
-					for (k = 0; k < ch; k++) \
-						_for_set(row, j * ch + k, _for_get_a(a_ptr, xofs[j].si[0] * ch + k, 0) * xofs[j].coeffs[0] + \
-												  _for_get_a(a_ptr, xofs[j].si[1] * ch + k, 0) * xofs[j].coeffs[1] + \
-												  _for_get_a(a_ptr, xofs[j].si[2] * ch + k, 0) * xofs[j].coeffs[2] + \
-												  _for_get_a(a_ptr, xofs[j].si[3] * ch + k, 0) * xofs[j].coeffs[3], 0); \
-				a_ptr += a->step; \
-			} \
-			psi = yofs.si[3]; \
-		} \
-		unsigned char* row[4] = { \
-			buf + (yofs.si[0] & 0x3) * bufstep, \
-			buf + (yofs.si[1] & 0x3) * bufstep, \
-			buf + (yofs.si[2] & 0x3) * bufstep, \
-			buf + (yofs.si[3] & 0x3) * bufstep, \
-		}; \
-		for (j = 0; j < b->cols * ch; j++) \
-			_for_set_b(b_ptr, j, ccv_descale(_for_get(row[0], j, 0) * yofs.coeffs[0] + _for_get(row[1], j, 0) * yofs.coeffs[1] + \
-											 _for_get(row[2], j, 0) * yofs.coeffs[2] + _for_get(row[3], j, 0) * yofs.coeffs[3], 12), 0); \
-		b_ptr += b->step; \
-	}
-	ccv_matrix_getter(a->type, ccv_matrix_setter_getter_integer_only, no_8u_type, ccv_matrix_setter_integer_only, b->type, for_block);
+	for (i = 0; i < b->rows; i++)
+	{
+		ccv_cubic_integer_coeffs_t yofs;
+		float sy = (i + 0.5) * scale_y - 0.5;
+		_ccv_init_cubic_integer_coeffs((int)sy, a->rows, sy, &yofs);
+		if (yofs.si[3] > psi)
+		{
+			for (; siy <= yofs.si[3]; siy++)
+			{
+				unsigned char* row = buf + (siy & 0x3) * bufstep;
+				if (fast_8u)
+					_ccv_resample_cubic_8u_row(a_ptr, xofs, b->cols, ch, (int*)row);
+				else {
+#define for_block(_for_get_a, _for_set) \
+					for (j = 0; j < b->cols; j++) \
+						for (k = 0; k < ch; k++) \
+							_for_set(row, j * ch + k, _for_get_a(a_ptr, xofs[j].si[0] * ch + k, 0) * xofs[j].coeffs[0] + \
+													  _for_get_a(a_ptr, xofs[j].si[1] * ch + k, 0) * xofs[j].coeffs[1] + \
+													  _for_get_a(a_ptr, xofs[j].si[2] * ch + k, 0) * xofs[j].coeffs[2] + \
+													  _for_get_a(a_ptr, xofs[j].si[3] * ch + k, 0) * xofs[j].coeffs[3], 0);
+					ccv_matrix_getter(a->type, ccv_matrix_setter_integer_only, no_8u_type, for_block);
+#undef for_block
+				}
+				a_ptr += a->step;
+			}
+			psi = yofs.si[3];
+		}
+		unsigned char* row[4] = {
+			buf + (yofs.si[0] & 0x3) * bufstep,
+			buf + (yofs.si[1] & 0x3) * bufstep,
+			buf + (yofs.si[2] & 0x3) * bufstep,
+			buf + (yofs.si[3] & 0x3) * bufstep,
+		};
+		if (CCV_GET_DATA_TYPE(b->type) == CCV_8U)
+			_ccv_resample_cubic_8u_column((int**)row, yofs.coeffs, b_ptr, b->cols * ch);
+		else {
+#define for_block(_for_get, _for_set_b) \
+			for (j = 0; j < b->cols * ch; j++) \
+				_for_set_b(b_ptr, j, ccv_descale(_for_get(row[0], j, 0) * yofs.coeffs[0] + _for_get(row[1], j, 0) * yofs.coeffs[1] + \
+												 _for_get(row[2], j, 0) * yofs.coeffs[2] + _for_get(row[3], j, 0) * yofs.coeffs[3], 12), 0);
+			ccv_matrix_getter_integer_only(no_8u_type, ccv_matrix_setter_integer_only, b->type, for_block);
 #undef for_block
+		}
+		b_ptr += b->step;
+	}
 }
 
 void ccv_resample(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int btype, int rows, int cols, int type)
@@ -379,6 +705,367 @@ void ccv_resample(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int btype, int
 	}
 }
 
+/* the fused resample is separable: every output coordinate has a list of (source, weight) taps on each axis,
+ * source rows go through the horizontal taps once and are kept in a small ring, the output row is the
+ * weighted sum of the ring rows, color converted, normalized and written in the final layout */
+#define CCV_RESAMPLE_BAND_SIZE (32)
+
+typedef struct {
+	int si;
+	float alpha;
+} ccv_resample_tap_t;
+
+static int _ccv_resample_area_taps(int ssz, int dsz, ccv_resample_tap_t* taps, int* tab)
+{
+	double scale = (double)ssz / dsz;
+	double inv_scale = 1.0 / scale;
+	int d, s, k, span = 1;
+	for (d = 0, k = 0; d < dsz; d++)
+	{
+		double fs1 = d * scale, fs2 = fs1 + scale;
+		int s1 = (int)(fs1 + 1.0 - 1e-6), s2 = (int)(fs2);
+		s1 = ccv_min(s1, ssz - 1);
+		s2 = ccv_min(s2, ssz - 1);
+		tab[d] = k;
+		if (s1 > fs1)
+		{
+			taps[k].si = s1 - 1;
+			taps[k++].alpha = (float)((s1 - fs1) * inv_scale);
+		}
+		for (s = s1; s < s2; s++)
+		{
+			taps[k].si = s;
+			taps[k++].alpha = (float)inv_scale;
+		}
+		if (fs2 - s2 > 1e-3)
+		{
+			taps[k].si = s2;
+			taps[k++].alpha = (float)((fs2 - s2) * inv_scale);
+		}
+		span = ccv_max(span, taps[k - 1].si - taps[tab[d]].si + 1);
+	}
+	tab[dsz] = k;
+	return span;
+}
+
+static int _ccv_resample_cubic_taps(int ssz, int dsz, ccv_resample_tap_t* taps, int* tab)
+{
+	float scale = (float)ssz / dsz;
+	int d, k;
+	for (d = 0; d < dsz; d++)
+	{
+		ccv_cubic_coeffs_t coeff;
+		float s = (d + 0.5) * scale - 0.5;
+		_ccv_init_cubic_coeffs((int)s, ssz, s, &coeff);
+		tab[d] = d * 4;
+		for (k = 0; k < 4; k++)
+		{
+			taps[d * 4 + k].si = coeff.si[k];
+			taps[d * 4 + k].alpha = coeff.coeffs[k];
+		}
+	}
+	tab[dsz] = dsz * 4;
+	return 4;
+}
+
+static void _ccv_resample_normalize_row(const unsigned char* a_ptr, const ccv_resample_tap_t* xtaps, const int* xtab, int cols, int ch, float* row)
+{
+	int dx, i, k;
+	switch (ch)
+	{
+		case 1:
+			for (dx = 0; dx < cols; dx++)
+			{
+				float t = 0;
+				for (k = xtab[dx]; k < xtab[dx + 1]; k++)
+					t += a_ptr[xtaps[k].si] * xtaps[k].alpha;
+				row[dx] = t;
+			}
+			break;
+		case 3:
+			for (dx = 0; dx < cols; dx++)
+			{
+				float t0 = 0, t1 = 0, t2 = 0;
+				for (k = xtab[dx]; k < xtab[dx + 1]; k++)
+				{
+					const unsigned char* p = a_ptr + xtaps[k].si * 3;
+					const float alpha = xtaps[k].alpha;
+					t0 += p[0] * alpha;
+					t1 += p[1] * alpha;
+					t2 += p[2] * alpha;
+				}
+				row[dx * 3] = t0;
+				row[dx * 3 + 1] = t1;
+				row[dx * 3 + 2] = t2;
+			}
+			break;
+		default:
+			for (dx = 0; dx < cols; dx++)
+			{
+				for (i = 0; i < ch; i++)
+					row[dx * ch + i] = 0;
+				for (k = xtab[dx]; k < xtab[dx + 1]; k++)
+					for (i = 0; i < ch; i++)
+						row[dx * ch + i] += a_ptr[xtaps[k].si * ch + i] * xtaps[k].alpha;
+			}
+	}
+}
+
+static void _ccv_resample_normalize_accumulate(const float* row, float alpha, float* sum, int n, int first)
+{
+	int i = 0;
+#if defined(HAVE_SSE2)
+	const __m128 alpha4 = _mm_set1_ps(alpha);
+	if (first)
+		for (; i <= n - 4; i += 4)
+			_mm_storeu_ps(sum + i, _mm_mul_ps(_mm_loadu_ps(row + i), alpha4));
+	else
+		for (; i <= n - 4; i += 4)
+			_mm_storeu_ps(sum + i, _mm_add_ps(_mm_loadu_ps(sum + i), _mm_mul_ps(_mm_loadu_ps(row + i), alpha4)));
+#elif defined(HAVE_NEON)
+	if (first)
+		for (; i <= n - 4; i += 4)
+			vst1q_f32(sum + i, vmulq_n_f32(vld1q_f32(row + i), alpha));
+	else
+		for (; i <= n - 4; i += 4)
+			vst1q_f32(sum + i, vmlaq_n_f32(vld1q_f32(sum + i), vld1q_f32(row + i), alpha));
+#endif
+	if (first)
+		for (; i < n; i++)
+			sum[i] = row[i] * alpha;
+	else
+		for (; i < n; i++)
+			sum[i] += row[i] * alpha;
+}
+
+/* (x - mean) / std is computed as x * scale + bias, with scale = 1 / std, bias = -mean / std */
+static void _ccv_resample_normalize_flush(const float* sum, int cols, int ich, int och, const float* scale, const float* bias, float* b_ptr, int pstride, int cstride)
+{
+	int dx = 0, i;
+	if (ich == och && (och == 1 || pstride == och))
+	{
+		/* the layout is the same as the sum, thus, the scale and bias repeats every 12 floats */
+		const int n = cols * och;
+		float s[12], c[12];
+		for (i = 0; i < 12; i++)
+			s[i] = scale[i % och], c[i] = bias[i % och];
+#if defined(HAVE_SSE2)
+		const __m128 s0 = _mm_loadu_ps(s), s1 = _mm_loadu_ps(s + 4), s2 = _mm_loadu_ps(s + 8);
+		const __m128 c0 = _mm_loadu_ps(c), c1 = _mm_loadu_ps(c + 4), c2 = _mm_loadu_ps(c + 8);
+		for (i = 0; i <= n - 12; i += 12)
+		{
+			_mm_storeu_ps(b_ptr + i, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(sum + i), s0), c0));
+			_mm_storeu_ps(b_ptr + i + 4, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(sum + i + 4), s1), c1));
+			_mm_storeu_ps(b_ptr + i + 8, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(sum + i + 8), s2), c2));
+		}
+#elif defined(HAVE_NEON)
+		const float32x4_t s0 = vld1q_f32(s), s1 = vld1q_f32(s + 4), s2 = vld1q_f32(s + 8);
+		const float32x4_t c0 = vld1q_f32(c), c1 = vld1q_f32(c + 4), c2 = vld1q_f32(c + 8);
+		for (i = 0; i <= n - 12; i += 12)
+		{
+			vst1q_f32(b_ptr + i, vmlaq_f32(c0, vld1q_f32(sum + i), s0));
+			vst1q_f32(b_ptr + i + 4, vmlaq_f32(c1, vld1q_f32(sum + i + 4), s1));
+			vst1q_f32(b_ptr + i + 8, vmlaq_f32(c2, vld1q_f32(sum + i + 8), s2));
+		}
+#else
+		i = 0;
+#endif
+		for (; i < n; i++)
+			b_ptr[i] = sum[i] * s[i % 12] + c[i % 12];
+		return;
+	}
+	if (ich == 3 && och == 1)
+	{
+		for (dx = 0; dx < cols; dx++)
+		{
+			/* the same weights ccv_read uses to convert RGB to gray */
+			const float g = sum[dx * 3] * (6969.f / 32768) + sum[dx * 3 + 1] * (23434.f / 32768) + sum[dx * 3 + 2] * (2365.f / 32768);
+			b_ptr[dx * pstride] = g * scale[0] + bias[0];
+		}
+	} else if (ich == 1) {
+		for (dx = 0; dx < cols; dx++)
+			for (i = 0; i < och; i++)
+				b_ptr[dx * pstride + i * cstride] = sum[dx] * scale[i] + bias[i];
+	} else {
+		assert(ich == och);
+		for (dx = 0; dx < cols; dx++)
+			for (i = 0; i < och; i++)
+				b_ptr[dx * pstride + i * cstride] = sum[dx * ich + i] * scale[i] + bias[i];
+	}
+}
+
+void ccv_resample_normalize(ccv_dense_matrix_t* a, float* b, int rows, int cols, int type, const float* mean, const float* std)
+{
+	assert(rows > 0 && cols > 0);
+	assert(CCV_GET_DATA_TYPE(a->type) == CCV_8U);
+	const int ich = CCV_GET_CHANNEL(a->type);
+	const int och = (type & CCV_RESAMPLE_GRAY) ? 1 : ((type & CCV_RESAMPLE_RGB) ? 3 : ich);
+	assert(ich == och || ich == 1 || (ich == 3 && och == 1));
+	int i;
+	float* scale = (float*)alloca(sizeof(float) * och * 2);
+	float* bias = scale + och;
+	for (i = 0; i < och; i++)
+	{
+		scale[i] = std ? 1.f / std[i] : 1;
+		bias[i] = mean ? -mean[i] * scale[i] : 0;
+	}
+	const int area = !(type & CCV_INTER_CUBIC) && a->rows >= rows && a->cols >= cols;
+	ccv_resample_tap_t* xtaps = (ccv_resample_tap_t*)alloca(sizeof(ccv_resample_tap_t) * ccv_max(a->cols + cols * 2, cols * 4));
+	int* xtab = (int*)alloca(sizeof(int) * (cols + 1));
+	ccv_resample_tap_t* ytaps = (ccv_resample_tap_t*)ccmalloc(sizeof(ccv_resample_tap_t) * ccv_max(a->rows + rows * 2, rows * 4) + sizeof(int) * (rows + 1));
+	int* ytab = (int*)(ytaps + ccv_max(a->rows + rows * 2, rows * 4));
+	if (area)
+		_ccv_resample_area_taps(a->cols, cols, xtaps, xtab);
+	else
+		_ccv_resample_cubic_taps(a->cols, cols, xtaps, xtab);
+	/* output rows take increasing source rows, a ring as large as the taps of one output row is enough */
+	const int ring = area ? _ccv_resample_area_taps(a->rows, rows, ytaps, ytab) : _ccv_resample_cubic_taps(a->rows, rows, ytaps, ytab);
+	const int n = cols * ich;
+	const int pstride = (type & CCV_RESAMPLE_NCHW) ? 1 : och;
+	const int cstride = (type & CCV_RESAMPLE_NCHW) ? rows * cols : 1;
+	const int band_count = FOR_IS_PARALLEL ? (rows + CCV_RESAMPLE_BAND_SIZE - 1) / CCV_RESAMPLE_BAND_SIZE : 1;
+	const size_t band_size = sizeof(float) * n * (ring + 1) + sizeof(int) * ring;
+	unsigned char* bufs = (unsigned char*)ccmalloc(band_size * band_count);
+	parallel_for(i, band_count) {
+		int dy, k;
+		float* const sum = (float*)(bufs + band_size * i);
+		float* const rows_ptr = sum + n;
+		int* const tags = (int*)(rows_ptr + n * ring);
+		for (k = 0; k < ring; k++)
+			tags[k] = -1;
+		const int dy0 = band_count > 1 ? i * CCV_RESAMPLE_BAND_SIZE : 0;
+		const int dy1 = band_count > 1 ? ccv_min(dy0 + CCV_RESAMPLE_BAND_SIZE, rows) : rows;
+		for (dy = dy0; dy < dy1; dy++)
+		{
+			for (k = ytab[dy]; k < ytab[dy + 1]; k++)
+			{
+				const int sy = ytaps[k].si;
+				float* const row = rows_ptr + (sy % ring) * n;
+				if (tags[sy % ring] != sy)
+				{
+					_ccv_resample_normalize_row(a->data.u8 + a->step * sy, xtaps, xtab, cols, ich, row);
+					tags[sy % ring] = sy;
+				}
+				_ccv_resample_normalize_accumulate(row, ytaps[k].alpha, sum, n, k == ytab[dy]);
+			}
+			_ccv_resample_normalize_flush(sum, cols, ich, och, scale, bias, b + dy * cols * pstride, pstride, cstride);
+		}
+	} parallel_endfor
+	ccfree(bufs);
+	ccfree(ytaps);
+}
+
+/* the number of rows a band has when sample down / up runs in parallel, each band filters its own halo rows */
+#define CCV_SAMPLE_BAND_SIZE (64)
+
+static void _ccv_sample_down_8u_row(const unsigned char* a_ptr, const int* tab, int a_cols, int b_cols, int ch, int src_x, int* row)
+{
+	int cols0 = b_cols - 1 - src_x;
+	int sx = src_x * ch, dx, k;
+	for (k = 0; k < ch; k++)
+		row[k] = a_ptr[sx + k] * 10 + a_ptr[ch + sx + k] * 5 + a_ptr[2 * ch + sx + k];
+	dx = ch;
+	if (ch == 1)
+	{
+#if defined(HAVE_SSE2)
+		const __m128i mask = _mm_set1_epi16(0xff);
+		const __m128i zero = _mm_setzero_si128();
+		/* 8 outputs read 20 bytes from 2 * dx + sx - 2 on, deinterleave them to even and odd taps */
+		for (; dx + 8 <= cols0 && dx * 2 + sx + 18 <= a_cols; dx += 8)
+		{
+			const unsigned char* p = a_ptr + dx * 2 + sx - 2;
+			__m128i v0 = _mm_loadu_si128((const __m128i*)p);
+			__m128i v1 = _mm_loadu_si128((const __m128i*)(p + 2));
+			__m128i v2 = _mm_loadu_si128((const __m128i*)(p + 4));
+			__m128i e1 = _mm_and_si128(v1, mask);
+			__m128i sum = _mm_add_epi16(_mm_add_epi16(_mm_and_si128(v0, mask), _mm_and_si128(v2, mask)), _mm_slli_epi16(_mm_add_epi16(_mm_srli_epi16(v0, 8), _mm_srli_epi16(v1, 8)), 2));
+			sum = _mm_add_epi16(sum, _mm_add_epi16(_mm_slli_epi16(e1, 2), _mm_slli_epi16(e1, 1)));
+			_mm_storeu_si128((__m128i*)(row + dx), _mm_unpacklo_epi16(sum, zero));
+			_mm_storeu_si128((__m128i*)(row + dx + 4), _mm_unpackhi_epi16(sum, zero));
+		}
+#elif defined(HAVE_NEON)
+		for (; dx + 8 <= cols0 && dx * 2 + sx + 18 <= a_cols; dx += 8)
+		{
+			const unsigned char* p = a_ptr + dx * 2 + sx - 2;
+			uint8x8x2_t v0 = vld2_u8(p);
+			uint8x8x2_t v1 = vld2_u8(p + 2);
+			uint8x8x2_t v2 = vld2_u8(p + 4);
+			uint16x8_t sum = vaddl_u8(v0.val[0], v2.val[0]);
+			sum = vaddq_u16(sum, vshlq_n_u16(vaddl_u8(v0.val[1], v1.val[1]), 2));
+			sum = vmlaq_n_u16(sum, vmovl_u8(v1.val[0]), 6);
+			vst1q_s32(row + dx, vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(sum))));
+			vst1q_s32(row + dx + 4, vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(sum))));
+		}
+#endif
+		for (; dx < cols0; dx++)
+			row[dx] = a_ptr[dx * 2 + sx] * 6 + (a_ptr[dx * 2 + sx - 1] + a_ptr[dx * 2 + sx + 1]) * 4 + a_ptr[dx * 2 + sx - 2] + a_ptr[dx * 2 + sx + 2];
+	} else {
+		for (; dx < cols0 * ch; dx += ch)
+			for (k = 0; k < ch; k++)
+				row[dx + k] = a_ptr[dx * 2 + sx + k] * 6 + (a_ptr[dx * 2 + sx + k - ch] + a_ptr[dx * 2 + sx + k + ch]) * 4 + a_ptr[dx * 2 + sx + k - ch * 2] + a_ptr[dx * 2 + sx + k + ch * 2];
+	}
+	if (src_x > 0)
+	{
+		for (dx = cols0 * ch; dx < b_cols * ch; dx += ch)
+			for (k = 0; k < ch; k++)
+				row[dx + k] = a_ptr[tab[dx * 2 + sx + k]] * 6 + (a_ptr[tab[dx * 2 + sx + k - ch]] + a_ptr[tab[dx * 2 + sx + k + ch]]) * 4 + a_ptr[tab[dx * 2 + sx + k - ch * 2]] + a_ptr[tab[dx * 2 + sx + k + ch * 2]];
+	} else {
+		for (k = 0; k < ch; k++)
+			row[(b_cols - 1) * ch + k] = a_ptr[a_cols * ch + sx - ch + k] * 10 + a_ptr[(a_cols - 2) * ch + sx + k] * 5 + a_ptr[(a_cols - 3) * ch + sx + k];
+	}
+}
+
+static void _ccv_sample_down_8u_column(int* const* rows, unsigned char* b_ptr, int n)
+{
+	int dx = 0;
+#if defined(HAVE_SSE2)
+	for (; dx <= n - 8; dx += 8)
+	{
+#define _ccv_sample_down_8u_column_sse2(_dx) \
+		_mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(_mm_add_epi32(_mm_slli_epi32(_mm_loadu_si128((const __m128i*)(rows[2] + (_dx))), 2), _mm_slli_epi32(_mm_loadu_si128((const __m128i*)(rows[2] + (_dx))), 1)), \
+			_mm_slli_epi32(_mm_add_epi32(_mm_loadu_si128((const __m128i*)(rows[1] + (_dx))), _mm_loadu_si128((const __m128i*)(rows[3] + (_dx)))), 2)), \
+			_mm_add_epi32(_mm_loadu_si128((const __m128i*)(rows[0] + (_dx))), _mm_loadu_si128((const __m128i*)(rows[4] + (_dx))))), 8)
+		__m128i v0 = _ccv_sample_down_8u_column_sse2(dx);
+		__m128i v1 = _ccv_sample_down_8u_column_sse2(dx + 4);
+#undef _ccv_sample_down_8u_column_sse2
+		_mm_storel_epi64((__m128i*)(b_ptr + dx), _mm_packus_epi16(_mm_packs_epi32(v0, v1), _mm_setzero_si128()));
+	}
+#elif defined(HAVE_NEON)
+	for (; dx <= n - 8; dx += 8)
+	{
+		int32x4_t v0 = vaddq_s32(vmulq_n_s32(vld1q_s32(rows[2] + dx), 6), vshlq_n_s32(vaddq_s32(vld1q_s32(rows[1] + dx), vld1q_s32(rows[3] + dx)), 2));
+		int32x4_t v1 = vaddq_s32(vmulq_n_s32(vld1q_s32(rows[2] + dx + 4), 6), vshlq_n_s32(vaddq_s32(vld1q_s32(rows[1] + dx + 4), vld1q_s32(rows[3] + dx + 4)), 2));
+		v0 = vaddq_s32(v0, vaddq_s32(vld1q_s32(rows[0] + dx), vld1q_s32(rows[4] + dx)));
+		v1 = vaddq_s32(v1, vaddq_s32(vld1q_s32(rows[0] + dx + 4), vld1q_s32(rows[4] + dx + 4)));
+		vst1_u8(b_ptr + dx, vqmovun_s16(vcombine_s16(vqmovn_s32(vshrq_n_s32(v0, 8)), vqmovn_s32(vshrq_n_s32(v1, 8)))));
+	}
+#endif
+	for (; dx < n; dx++)
+		b_ptr[dx] = ccv_clamp((rows[2][dx] * 6 + (rows[1][dx] + rows[3][dx]) * 4 + rows[0][dx] + rows[4][dx]) / 256, 0, 255);
+}
+
+/* the rows from dy0 to dy1 (exclusive) of an 8u to 8u sample down, the horizontally filtered rows are kept in 32s */
+static void _ccv_sample_down_8u(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b, int src_x, int src_y, const int* tab, int dy0, int dy1, int* buf)
+{
+	int ch = CCV_GET_CHANNEL(a->type);
+	int bufstep = b->cols * ch;
+	int dy, k, sy = dy0 * 2 - 2 + src_y;
+	unsigned char* b_ptr = b->data.u8 + b->step * dy0;
+	for (dy = dy0; dy < dy1; dy++)
+	{
+		for (; sy <= dy * 2 + 2 + src_y; sy++)
+		{
+			int _sy = (sy < 0) ? -1 - sy : (sy >= a->rows) ? a->rows * 2 - 1 - sy : sy;
+			_ccv_sample_down_8u_row(a->data.u8 + a->step * _sy, tab, a->cols, b->cols, ch, src_x, buf + ((sy + src_y * 4 + 2) % 5) * bufstep);
+		}
+		int* rows[5];
+		for (k = 0; k < 5; k++)
+			rows[k] = buf + ((dy * 2 + k) % 5) * bufstep;
+		_ccv_sample_down_8u_column(rows, b_ptr, b->cols * ch);
+		b_ptr += b->step;
+	}
+}
+
 /* the following code is adopted from OpenCV cvPyrDown */
 void ccv_sample_down(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type, int src_x, int src_y)
 {
@@ -389,17 +1076,29 @@ void ccv_sample_down(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type, in
 	ccv_object_return_if_cached(, db);
 	int ch = CCV_GET_CHANNEL(a->type);
 	int cols0 = db->cols - 1 - src_x;
-	int dy, sy = -2 + src_y, sx = src_x * ch, dx, k;
+	int sx = src_x * ch, dx, k;
 	int* tab = (int*)alloca((a->cols + src_x + 2) * ch * sizeof(int));
 	for (dx = 0; dx < a->cols + src_x + 2; dx++)
 		for (k = 0; k < ch; k++)
 			tab[dx * ch + k] = ((dx >= a->cols) ? a->cols * 2 - 1 - dx : dx) * ch + k;
-	unsigned char* buf = (unsigned char*)alloca(5 * db->cols * ch * ccv_max(CCV_GET_DATA_TYPE_SIZE(db->type), sizeof(int)));
-	int bufstep = db->cols * ch * ccv_max(CCV_GET_DATA_TYPE_SIZE(db->type), sizeof(int));
+	int bufstep = db->cols * ch * ccv_max(ccv_max(CCV_GET_DATA_TYPE_SIZE(db->type), CCV_GET_DATA_TYPE_SIZE(a->type)), sizeof(int));
+	/* each band has its own 5-row buffer, and starts with the 3 halo rows above it */
+	int band_rows = ccv_band_rows(CCV_SAMPLE_BAND_SIZE);
+	int band_count = band_rows > 0 ? (db->rows + band_rows - 1) / band_rows : 1;
+	unsigned char* bufs = band_count > 1 ? (unsigned char*)ccmalloc(band_count * 5 * bufstep) : (unsigned char*)alloca(5 * bufstep);
 #ifdef __clang_analyzer__
-	memset(buf, 0, 5 * bufstep);
+	memset(bufs, 0, band_count * 5 * bufstep);
 #endif
-	unsigned char* b_ptr = db->data.u8;
+	int no_8u_type = (a->type & CCV_8U) ? CCV_32S : a->type;
+	parallel_for(i, band_count) {
+		int dy0 = band_count > 1 ? i * band_rows : 0;
+		int dy1 = band_count > 1 ? ccv_min(dy0 + band_rows, db->rows) : db->rows;
+		unsigned char* buf = bufs + i * 5 * bufstep;
+		if (CCV_GET_DATA_TYPE(a->type) == CCV_8U && CCV_GET_DATA_TYPE(db->type) == CCV_8U)
+			_ccv_sample_down_8u(a, db, src_x, src_y, tab, dy0, dy1, (int*)buf);
+		else {
+			int dy, sy = dy0 * 2 - 2 + src_y, dx, k;
+			unsigned char* b_ptr = db->data.u8 + db->step * dy0;
 	/* why is src_y * 4 in computing the offset of row?
 	 * Essentially, it means sy - src_y but in a manner that doesn't result negative number.
 	 * notice that we added src_y before when computing sy in the first place, however,
@@ -407,7 +1106,7 @@ void ccv_sample_down(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type, in
 	 * because in later rearrangement, we have no src_y to backup the arrangement). In
 	 * such micro scope, we managed to stripe 5 addition into one shift and addition. */
 #define for_block(_for_get_a, _for_set, _for_get, _for_set_b) \
-	for (dy = 0; dy < db->rows; dy++) \
+	for (dy = dy0; dy < dy1; dy++) \
 	{ \
 		for(; sy <= dy * 2 + 2 + src_y; sy++) \
 		{ \
@@ -428,23 +1127,26 @@ void ccv_sample_down(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type, in
 			_for_set_b(b_ptr, dx, (_for_get(rows[2], dx, 0) * 6 + (_for_get(rows[1], dx, 0) + _for_get(rows[3], dx, 0)) * 4 + _for_get(rows[0], dx, 0) + _for_get(rows[4], dx, 0)) / 256, 0); \
 		b_ptr += db->step; \
 	}
-	int no_8u_type = (a->type & CCV_8U) ? CCV_32S : a->type;
-	if (src_x > 0)
-	{
+			if (src_x > 0)
+			{
 #define x_block(_for_get_a, _for_set, _for_get, _for_set_b) \
 		for (dx = cols0 * ch; dx < db->cols * ch; dx += ch) \
 			for (k = 0; k < ch; k++) \
 				_for_set(row, dx + k, _for_get_a(a_ptr, tab[dx * 2 + sx + k], 0) * 6 + (_for_get_a(a_ptr, tab[dx * 2 + sx + k - ch], 0) + _for_get_a(a_ptr, tab[dx * 2 + sx + k + ch], 0)) * 4 + _for_get_a(a_ptr, tab[dx * 2 + sx + k - ch * 2], 0) + _for_get_a(a_ptr, tab[dx * 2 + sx + k + ch * 2], 0), 0);
-		ccv_matrix_getter_a(a->type, ccv_matrix_setter_getter, no_8u_type, ccv_matrix_setter_b, db->type, for_block);
+				ccv_matrix_getter_a(a->type, ccv_matrix_setter_getter, no_8u_type, ccv_matrix_setter_b, db->type, for_block);
 #undef x_block
-	} else {
+			} else {
 #define x_block(_for_get_a, _for_set, _for_get, _for_set_b) \
 		for (k = 0; k < ch; k++) \
 			_for_set(row, (db->cols - 1) * ch + k, _for_get_a(a_ptr, a->cols * ch + sx - ch + k, 0) * 10 + _for_get_a(a_ptr, (a->cols - 2) * ch + sx + k, 0) * 5 + _for_get_a(a_ptr, (a->cols - 3) * ch + sx + k, 0), 0);
-		ccv_matrix_getter_a(a->type, ccv_matrix_setter_getter, no_8u_type, ccv_matrix_setter_b, db->type, for_block);
+				ccv_matrix_getter_a(a->type, ccv_matrix_setter_getter, no_8u_type, ccv_matrix_setter_b, db->type, for_block);
 #undef x_block
-	}
+			}
 #undef for_block
+		}
+	} parallel_endfor
+	if (band_count > 1)
+		ccfree(bufs);
 }
 
 void ccv_sample_up(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type, int src_x, int src_y)
@@ -457,20 +1159,29 @@ void ccv_sample_up(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type, int
 	int ch = CCV_GET_CHANNEL(a->type);
 	int cols0 = a->cols - 1 - src_x;
 	assert(a->cols > 0 && cols0 > 0);
-	int y, x, sy = -1 + src_y, sx = src_x * ch, k;
+	int sx = src_x * ch, i, j;
 	int* tab = (int*)alloca((a->cols + src_x + 2) * ch * sizeof(int));
-	for (x = 0; x < a->cols + src_x + 2; x++)
-		for (k = 0; k < ch; k++)
-			tab[x * ch + k] = ((x >= a->cols) ? a->cols * 2 - 1 - x : x) * ch + k;
-	unsigned char* buf = (unsigned char*)alloca(3 * db->cols * ch * ccv_max(CCV_GET_DATA_TYPE_SIZE(db->type), sizeof(int)));
-	int bufstep = db->cols * ch * ccv_max(CCV_GET_DATA_TYPE_SIZE(db->type), sizeof(int));
+	for (i = 0; i < a->cols + src_x + 2; i++)
+		for (j = 0; j < ch; j++)
+			tab[i * ch + j] = ((i >= a->cols) ? a->cols * 2 - 1 - i : i) * ch + j;
+	int bufstep = db->cols * ch * ccv_max(ccv_max(CCV_GET_DATA_TYPE_SIZE(db->type), CCV_GET_DATA_TYPE_SIZE(a->type)), sizeof(int));
+	/* bands are in source rows, each with its own 3-row buffer and the halo row above it */
+	int band_rows = ccv_band_rows(CCV_SAMPLE_BAND_SIZE / 2);
+	int band_count = band_rows > 0 ? (a->rows + band_rows - 1) / band_rows : 1;
+	unsigned char* bufs = band_count > 1 ? (unsigned char*)ccmalloc(band_count * 3 * bufstep) : (unsigned char*)alloca(3 * bufstep);
 #ifdef __clang_analyzer__
-	memset(buf, 0, 3 * bufstep);
+	memset(bufs, 0, band_count * 3 * bufstep);
 #endif
-	unsigned char* b_ptr = db->data.u8;
+	int no_8u_type = (a->type & CCV_8U) ? CCV_32S : a->type;
+	parallel_for(band, band_count) {
+	int y0 = band_count > 1 ? band * band_rows : 0;
+	int y1 = band_count > 1 ? ccv_min(y0 + band_rows, a->rows) : a->rows;
+	int y, x, sy = y0 - 1 + src_y, k;
+	unsigned char* buf = bufs + band * 3 * bufstep;
+	unsigned char* b_ptr = db->data.u8 + db->step * y0 * 2;
 	/* why src_y * 2: the same argument as in ccv_sample_down */
 #define for_block(_for_get_a, _for_set, _for_get, _for_set_b) \
-	for (y = 0; y < a->rows; y++) \
+	for (y = y0; y < y1; y++) \
 	{ \
 		for (; sy <= y + 1 + src_y; sy++) \
 		{ \
@@ -520,7 +1231,6 @@ void ccv_sample_up(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type, int
 		} \
 		b_ptr += 2 * db->step; \
 	}
-	int no_8u_type = (a->type & CCV_8U) ? CCV_32S : a->type;
 	/* unswitch if condition in manual way */
 	if ((a->type & CCV_8U) || (a->type & CCV_32S) || (a->type & CCV_64S))
 	{
@@ -585,4 +1295,101 @@ void ccv_sample_up(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type, int
 #undef G025
 	}
 #undef for_block
+	} parallel_endfor
+	if (band_count > 1)
+		ccfree(bufs);
+}
+
+ccv_pyramid_t* ccv_pyramid_new(void)
+{
+	ccv_pyramid_t* pyramid = (ccv_pyramid_t*)cccalloc(1, sizeof(ccv_pyramid_t));
+	return pyramid;
+}
+
+void ccv_pyramid(ccv_dense_matrix_t* a, ccv_pyramid_t* pyramid, int interval, int count, int flags)
+{
+	assert(interval >= 0 && count > 0);
+	int type = CCV_GET_DATA_TYPE(a->type) | CCV_GET_CHANNEL(a->type);
+	if (a->sig != 0 && pyramid->sig == a->sig && pyramid->type == type && pyramid->rows == a->rows && pyramid->cols == a->cols &&
+		pyramid->interval == interval && pyramid->count >= count && (pyramid->flags & flags) == flags)
+	{
+		/* the same image may live in a different matrix now */
+		pyramid->levels[0].data.u8 = a->data.u8;
+		pyramid->levels[0].step = a->step;
+		return;
+	}
+	int i, next = interval + 1;
+	int offset_count = (flags & CCV_PYRAMID_ACCURATE) ? ccv_max(count - next * 2, 0) * 3 : 0;
+	pyramid->levels = (ccv_dense_matrix_t*)ccrealloc(pyramid->levels, sizeof(ccv_dense_matrix_t) * (count + offset_count));
+	pyramid->offsets = offset_count > 0 ? pyramid->levels + count : 0;
+	ccv_dense_matrix_t* levels = pyramid->levels;
+	levels[0] = ccv_dense_matrix(a->rows, a->cols, type, a->data.u8, a->sig);
+	levels[0].step = a->step;
+	/* lay out all levels and their offset levels in one allocation, 16-byte aligned */
+	double scale = pow(2., 1. / next);
+	size_t size = 0;
+	size_t* offset = (size_t*)alloca(sizeof(size_t) * (count + offset_count));
+	for (i = 1; i < count; i++)
+	{
+		int rows = i < next ? (int)(a->rows / pow(scale, i)) : levels[i - next].rows / 2;
+		int cols = i < next ? (int)(a->cols / pow(scale, i)) : levels[i - next].cols / 2;
+		levels[i] = ccv_dense_matrix(rows, cols, type, 0, 0);
+		offset[i] = size;
+		size += (levels[i].step * rows + 15) & -16;
+		if (offset_count > 0 && i >= next * 2)
+		{
+			int q;
+			for (q = 0; q < 3; q++)
+			{
+				int j = count + (i - next * 2) * 3 + q;
+				levels[j] = levels[i];
+				offset[j] = size;
+				size += (levels[i].step * rows + 15) & -16;
+			}
+		}
+	}
+	if (size > pyramid->size)
+	{
+		ccfree(pyramid->data);
+		pyramid->data = (unsigned char*)ccmalloc(size);
+		pyramid->size = size;
+	}
+	for (i = 1; i < count + offset_count; i++)
+		levels[i].data.u8 = pyramid->data + offset[i];
+	parallel_for(k, ccv_min(interval, count - 1)) {
+		ccv_dense_matrix_t* b = levels + k + 1;
+		ccv_resample(levels, &b, 0, b->rows, b->cols, CCV_INTER_AREA);
+	} parallel_endfor
+	/* every level of an octave only depends on the octave above */
+	for (i = next; i < count; i += next)
+	{
+		int start = i;
+		parallel_for(j, ccv_min(next, count - start)) {
+			ccv_dense_matrix_t* b = levels + start + j;
+			ccv_sample_down(levels + start + j - next, &b, 0, 0, 0);
+			if (offset_count > 0 && start + j >= next * 2)
+			{
+				int q;
+				for (q = 0; q < 3; q++)
+				{
+					b = pyramid->offsets + (start + j - next * 2) * 3 + q;
+					ccv_sample_down(levels + start + j - next, &b, 0, (q + 1) & 1, (q + 1) >> 1);
+				}
+			}
+		} parallel_endfor
+	}
+	pyramid->type = type;
+	pyramid->rows = a->rows;
+	pyramid->cols = a->cols;
+	pyramid->interval = interval;
+	pyramid->count = count;
+	pyramid->flags = offset_count > 0 ? CCV_PYRAMID_ACCURATE : 0;
+	pyramid->sig = a->sig;
+}
+
+void ccv_pyramid_free(ccv_pyramid_t* pyramid)
+{
+	ccfree(pyramid->levels);
+	ccfree(pyramid->data);
+	ccfree(pyramid);
 }
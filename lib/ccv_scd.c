@@ -1680,6 +1680,8 @@ ccv_array_t* ccv_scd_detect_objects(ccv_dense_matrix_t* a, ccv_scd_classifier_ca
 	ccv_array_t** seq = (ccv_array_t**)alloca(sizeof(ccv_array_t*) * count);
 	for (i = 0; i < count; i++)
 		seq[i] = ccv_array_new(sizeof(ccv_comp_t), 64, 0);
+	ccv_dense_matrix_t* sat_buffer = 0;
+	ccv_dense_matrix_t sat_header;
 	for (i = 0; i < scale_upto; i++)
 	{
 		// run it
@@ -1711,8 +1713,7 @@ ccv_array_t* ccv_scd_detect_objects(ccv_dense_matrix_t* a, ccv_scd_classifier_ca
 					ccv_scd(bordered, &scd, 0);
 					ccv_matrix_free(bordered);
 				}
-				ccv_dense_matrix_t* sat = 0;
-				ccv_sat(scd, &sat, 0, CCV_PADDING_ZERO);
+				ccv_dense_matrix_t* sat = ccv_sat_scratch(scd, &sat_buffer, &sat_header);
 				assert(CCV_GET_CHANNEL(sat->type) == CCV_SCD_CHANNEL);
 				ccv_matrix_free(scd);
 				float* ptr = sat->data.f32;
@@ -1779,12 +1780,13 @@ ccv_array_t* ccv_scd_detect_objects(ccv_dense_matrix_t* a, ccv_scd_classifier_ca
 					}
 					ptr += sat->cols * CCV_SCD_CHANNEL * params.step_through;
 				}
-				ccv_matrix_free(sat);
 				scale *= scale_ratio;
 			}
 		}
 	}
 
+	if (sat_buffer)
+		ccv_matrix_free(sat_buffer);
 	for (i = 1; i < scale_upto; i++)
 		ccv_matrix_free(pyr[i]);
 	if (up_ratio - 1.0 > 1e-4)
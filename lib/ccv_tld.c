@@ -427,12 +427,11 @@ static void _ccv_tld_ferns_feature_for(ccv_ferns_t* ferns, ccv_dense_matrix_t* a
 		assert(hull.y + hull.height <= a->rows);
 		ccv_dense_matrix_t roi = ccv_dense_matrix(hull.height, hull.width, CCV_GET_DATA_TYPE(a->type) | CCV_GET_CHANNEL(a->type), ccv_get_dense_matrix_cell(a, hull.y, hull.x, 0), 0);
 		roi.step = a->step;
-		ccv_dense_matrix_t* b = 0;
-		ccv_perspective_transform(&roi, &b, 0, m00, m01, m02, m10, m11, m12, m20, m21, m22);
-		roi = ccv_dense_matrix(box.rect.height, box.rect.width, CCV_GET_DATA_TYPE(b->type) | CCV_GET_CHANNEL(b->type), ccv_get_dense_matrix_cell(b, padding_top, padding_left, 0), 0);
-		roi.step = b->step;
-		ccv_ferns_feature(ferns, &roi, box.classification.id, fern);
-		ccv_matrix_free(b);
+		// only warp the box out of the transformed hull
+		ccv_warp_t warp = ccv_perspective_warp(&roi, 0, padding_top, padding_left, box.rect.height, box.rect.width, m00, m01, m02, m10, m11, m12, m20, m21, m22);
+		ccv_warp(&warp, 1);
+		ccv_ferns_feature(ferns, warp.b, box.classification.id, fern);
+		ccv_matrix_free(warp.b);
 	}
 }
 
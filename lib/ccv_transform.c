@@ -1,5 +1,10 @@
 #include "ccv.h"
 #include "ccv_internal.h"
+#if defined(HAVE_SSE2)
+#include <emmintrin.h>
+#elif defined(HAVE_NEON)
+#include <arm_neon.h>
+#endif
 
 void ccv_decimal_slice(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type, float y, float x, int rows, int cols)
 {
@@ -172,3 +177,322 @@ void ccv_perspective_transform(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, in
 	ccv_matrix_setter(db->type, ccv_matrix_getter, a->type, for_block);
 #undef for_block
 }
+
+ccv_warp_t ccv_perspective_warp(ccv_dense_matrix_t* a, int type, int y, int x, int rows, int cols, float m00, float m01, float m02, float m10, float m11, float m12, float m20, float m21, float m22)
+{
+	// the same normalization as ccv_perspective_transform, and then fold the centering and the (y, x) offset in
+	const float s = 1.0 / ccv_max(a->rows, a->cols);
+	m00 *= s, m01 *= s, m02 *= s;
+	m10 *= s, m11 *= s, m12 *= s;
+	m20 *= s * s, m21 *= s * s, m22 *= s;
+	const float ox = x - a->cols * 0.5;
+	const float oy = y - a->rows * 0.5;
+	const float z = m20 * ox + m21 * oy + m22;
+	ccv_warp_t warp = {
+		.a = a,
+		.b = 0,
+		.type = type,
+		.rows = rows,
+		.cols = cols,
+		.m = {
+			m00 + a->cols * 0.5 * m20, m01 + a->cols * 0.5 * m21, m00 * ox + m01 * oy + m02 + a->cols * 0.5 * z,
+			m10 + a->rows * 0.5 * m20, m11 + a->rows * 0.5 * m21, m10 * ox + m11 * oy + m12 + a->rows * 0.5 * z,
+			m20, m21, z,
+		},
+	};
+	return warp;
+}
+
+/* the fractional bits of a coordinate in the remap table, the 4 bilinear weights of a pixel sum up to CCV_WARP_ONE * CCV_WARP_ONE (14 bits) */
+#define CCV_WARP_BITS (7)
+#define CCV_WARP_ONE (1 << CCV_WARP_BITS)
+/* the number of rows a band has when warps run in parallel */
+#define CCV_WARP_BAND_SIZE (32)
+
+static inline void _ccv_warp_remap_pixel(const float x, const float y, const int rows, const int cols, const int step, const int psize, int* const ofs, short* const w)
+{
+	const float bound = (float)(1 << 30);
+	// clamp before the conversion so that it never overflows (or gets a NaN)
+	const int fx = (int)lrintf(ccv_clamp(x * CCV_WARP_ONE, -bound, bound));
+	const int fy = (int)lrintf(ccv_clamp(y * CCV_WARP_ONE, -bound, bound));
+	int ix = fx >> CCV_WARP_BITS, iy = fy >> CCV_WARP_BITS;
+	int wx = fx & (CCV_WARP_ONE - 1), wy = fy & (CCV_WARP_ONE - 1);
+	if (ix < 0 || ix >= cols || iy < 0 || iy >= rows)
+	{
+		ofs[0] = 0;
+		w[0] = w[1] = w[2] = w[3] = 0;
+		return;
+	}
+	// at the last column / row, step back one and put all the weight on the next one, thus, the 2x2 neighborhood is always inside
+	if (ix == cols - 1 && cols > 1)
+		--ix, wx = CCV_WARP_ONE;
+	if (iy == rows - 1 && rows > 1)
+		--iy, wy = CCV_WARP_ONE;
+	ofs[0] = iy * step + ix * psize;
+	w[0] = (CCV_WARP_ONE - wx) * (CCV_WARP_ONE - wy);
+	w[1] = wx * (CCV_WARP_ONE - wy);
+	w[2] = (CCV_WARP_ONE - wx) * wy;
+	w[3] = wx * wy;
+}
+
+// computes the remap table of one output row: the byte offset of the top-left pixel of the 2x2 neighborhood, and its 4 weights in fixed point
+static void _ccv_warp_remap_row(const ccv_warp_t* const warp, const int affine, const int i, int* const ofs, short* const w)
+{
+	const ccv_dense_matrix_t* const a = warp->a;
+	const float* const m = warp->m;
+	const int cols = warp->cols;
+	const int psize = CCV_GET_DATA_TYPE_SIZE(a->type) * CCV_GET_CHANNEL(a->type);
+	const float x0 = m[1] * i + m[2];
+	const float y0 = m[4] * i + m[5];
+	const float z0 = m[7] * i + m[8];
+	int j = 0;
+#if defined(HAVE_SSE2)
+	const __m128 m0 = _mm_set1_ps(m[0]);
+	const __m128 m3 = _mm_set1_ps(m[3]);
+	const __m128 m6 = _mm_set1_ps(m[6]);
+	const __m128 x0v = _mm_set1_ps(x0);
+	const __m128 y0v = _mm_set1_ps(y0);
+	const __m128 z0v = _mm_set1_ps(z0);
+	const __m128 onef = _mm_set1_ps(CCV_WARP_ONE);
+	const __m128 bound = _mm_set1_ps((float)(1 << 30));
+	const __m128 nbound = _mm_set1_ps(-(float)(1 << 30));
+	const __m128 four = _mm_set1_ps(4);
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i mask = _mm_set1_epi32(CCV_WARP_ONE - 1);
+	const __m128i one = _mm_set1_epi32(CCV_WARP_ONE);
+	const __m128i one16 = _mm_set1_epi16(CCV_WARP_ONE);
+	const __m128i rows_1 = _mm_set1_epi32(a->rows - 1);
+	const __m128i cols_1 = _mm_set1_epi32(a->cols - 1);
+	const __m128i xedge = _mm_set1_epi32(a->cols > 1 ? -1 : 0);
+	const __m128i yedge = _mm_set1_epi32(a->rows > 1 ? -1 : 0);
+	__m128 jv = _mm_setr_ps(0, 1, 2, 3);
+	int ix[4], iy[4];
+	for (; j < cols - 3; j += 4)
+	{
+		__m128 x = _mm_add_ps(_mm_mul_ps(jv, m0), x0v);
+		__m128 y = _mm_add_ps(_mm_mul_ps(jv, m3), y0v);
+		if (affine)
+		{
+			x = _mm_mul_ps(x, onef);
+			y = _mm_mul_ps(y, onef);
+		} else {
+			const __m128 z = _mm_div_ps(onef, _mm_add_ps(_mm_mul_ps(jv, m6), z0v));
+			x = _mm_mul_ps(x, z);
+			y = _mm_mul_ps(y, z);
+		}
+		// _mm_min_ps returns the second operand on NaN, thus, it clamps NaN to the bound too
+		__m128i fx = _mm_cvtps_epi32(_mm_max_ps(_mm_min_ps(x, bound), nbound));
+		__m128i fy = _mm_cvtps_epi32(_mm_max_ps(_mm_min_ps(y, bound), nbound));
+		__m128i ixv = _mm_srai_epi32(fx, CCV_WARP_BITS);
+		__m128i iyv = _mm_srai_epi32(fy, CCV_WARP_BITS);
+		fx = _mm_and_si128(fx, mask);
+		fy = _mm_and_si128(fy, mask);
+		const __m128i out = _mm_or_si128(_mm_or_si128(_mm_cmplt_epi32(ixv, zero), _mm_cmpgt_epi32(ixv, cols_1)), _mm_or_si128(_mm_cmplt_epi32(iyv, zero), _mm_cmpgt_epi32(iyv, rows_1)));
+		const __m128i ex = _mm_and_si128(_mm_cmpeq_epi32(ixv, cols_1), xedge);
+		const __m128i ey = _mm_and_si128(_mm_cmpeq_epi32(iyv, rows_1), yedge);
+		ixv = _mm_andnot_si128(out, _mm_add_epi32(ixv, ex));
+		iyv = _mm_andnot_si128(out, _mm_add_epi32(iyv, ey));
+		fx = _mm_or_si128(_mm_andnot_si128(ex, fx), _mm_and_si128(ex, one));
+		fy = _mm_or_si128(_mm_andnot_si128(ey, fy), _mm_and_si128(ey, one));
+		// 16-bit [fx, fy] and [1 - fx, 1 - fy], the products are at most 1 << 14, which fits
+		const __m128i fxy = _mm_packs_epi32(fx, fy);
+		const __m128i gxy = _mm_sub_epi16(one16, fxy);
+		const __m128i out16 = _mm_packs_epi32(out, out);
+		const __m128i xs = _mm_unpacklo_epi64(gxy, fxy);
+		const __m128i w0 = _mm_andnot_si128(out16, _mm_mullo_epi16(xs, _mm_unpackhi_epi64(gxy, gxy))); // w00 x 4, w01 x 4
+		const __m128i w1 = _mm_andnot_si128(out16, _mm_mullo_epi16(xs, _mm_unpackhi_epi64(fxy, fxy))); // w10 x 4, w11 x 4
+		const __m128i p = _mm_unpacklo_epi16(w0, _mm_unpackhi_epi64(w0, w0));
+		const __m128i q = _mm_unpacklo_epi16(w1, _mm_unpackhi_epi64(w1, w1));
+		_mm_storeu_si128((__m128i*)(w + j * 4), _mm_unpacklo_epi32(p, q));
+		_mm_storeu_si128((__m128i*)(w + j * 4 + 8), _mm_unpackhi_epi32(p, q));
+		_mm_storeu_si128((__m128i*)ix, ixv);
+		_mm_storeu_si128((__m128i*)iy, iyv);
+		ofs[j] = iy[0] * a->step + ix[0] * psize;
+		ofs[j + 1] = iy[1] * a->step + ix[1] * psize;
+		ofs[j + 2] = iy[2] * a->step + ix[2] * psize;
+		ofs[j + 3] = iy[3] * a->step + ix[3] * psize;
+		jv = _mm_add_ps(jv, four);
+	}
+#endif
+	if (affine)
+		for (; j < cols; j++)
+			_ccv_warp_remap_pixel(j * m[0] + x0, j * m[3] + y0, a->rows, a->cols, a->step, psize, ofs + j, w + j * 4);
+	else
+		for (; j < cols; j++)
+		{
+			const float z = 1.0 / (j * m[6] + z0);
+			_ccv_warp_remap_pixel((j * m[0] + x0) * z, (j * m[3] + y0) * z, a->rows, a->cols, a->step, psize, ofs + j, w + j * 4);
+		}
+}
+
+static void _ccv_warp_8u_c1(const unsigned char* const a_ptr, const int dx, const int dy, const int* const ofs, const short* const w, const int cols, unsigned char* const b_ptr, uint32_t* const nb)
+{
+	int j = 0;
+	if (dx == 1)
+	{
+		// gather the 2x2 neighborhood of each pixel with two 16-bit loads, in the same order as the weights
+		for (j = 0; j < cols; j++)
+		{
+			const unsigned char* const p = a_ptr + ofs[j];
+			nb[j] = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[dy] << 16) | ((uint32_t)p[dy + 1] << 24);
+		}
+		j = 0;
+#if defined(HAVE_SSE2)
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i half = _mm_set1_epi32(1 << (CCV_WARP_BITS * 2 - 1));
+		for (; j < cols - 7; j += 8)
+		{
+			const __m128i n0 = _mm_loadu_si128((const __m128i*)(nb + j));
+			const __m128i n1 = _mm_loadu_si128((const __m128i*)(nb + j + 4));
+			const __m128i s0 = _mm_madd_epi16(_mm_unpacklo_epi8(n0, zero), _mm_loadu_si128((const __m128i*)(w + j * 4)));
+			const __m128i s1 = _mm_madd_epi16(_mm_unpackhi_epi8(n0, zero), _mm_loadu_si128((const __m128i*)(w + j * 4 + 8)));
+			const __m128i s2 = _mm_madd_epi16(_mm_unpacklo_epi8(n1, zero), _mm_loadu_si128((const __m128i*)(w + j * 4 + 16)));
+			const __m128i s3 = _mm_madd_epi16(_mm_unpackhi_epi8(n1, zero), _mm_loadu_si128((const __m128i*)(w + j * 4 + 24)));
+			// each pixel has its top and bottom half in two adjacent lanes, add them up
+			__m128i v0 = _mm_add_epi32(_mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(s0), _mm_castsi128_ps(s1), _MM_SHUFFLE(2, 0, 2, 0))), _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(s0), _mm_castsi128_ps(s1), _MM_SHUFFLE(3, 1, 3, 1))));
+			__m128i v1 = _mm_add_epi32(_mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(s2), _mm_castsi128_ps(s3), _MM_SHUFFLE(2, 0, 2, 0))), _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(s2), _mm_castsi128_ps(s3), _MM_SHUFFLE(3, 1, 3, 1))));
+			v0 = _mm_srai_epi32(_mm_add_epi32(v0, half), CCV_WARP_BITS * 2);
+			v1 = _mm_srai_epi32(_mm_add_epi32(v1, half), CCV_WARP_BITS * 2);
+			const __m128i v = _mm_packs_epi32(v0, v1);
+			_mm_storel_epi64((__m128i*)(b_ptr + j), _mm_packus_epi16(v, v));
+		}
+#elif defined(HAVE_NEON)
+		for (; j < cols - 7; j += 8)
+		{
+			uint32x2_t s[4];
+			int k;
+			for (k = 0; k < 4; k++)
+			{
+				const uint16x8_t n = vmovl_u8(vld1_u8((const uint8_t*)(nb + j + k * 2)));
+				const uint16x8_t wv = vld1q_u16((const uint16_t*)(w + (j + k * 2) * 4));
+				const uint32x4_t p0 = vmull_u16(vget_low_u16(n), vget_low_u16(wv));
+				const uint32x4_t p1 = vmull_u16(vget_high_u16(n), vget_high_u16(wv));
+				s[k] = vpadd_u32(vpadd_u32(vget_low_u32(p0), vget_high_u32(p0)), vpadd_u32(vget_low_u32(p1), vget_high_u32(p1)));
+			}
+			const uint16x8_t v = vcombine_u16(vrshrn_n_u32(vcombine_u32(s[0], s[1]), CCV_WARP_BITS * 2), vrshrn_n_u32(vcombine_u32(s[2], s[3]), CCV_WARP_BITS * 2));
+			vst1_u8(b_ptr + j, vmovn_u16(v));
+		}
+#endif
+	}
+	for (; j < cols; j++)
+	{
+		const unsigned char* const p = a_ptr + ofs[j];
+		const short* const wj = w + j * 4;
+		b_ptr[j] = (p[0] * wj[0] + p[dx] * wj[1] + p[dy] * wj[2] + p[dy + dx] * wj[3] + (1 << (CCV_WARP_BITS * 2 - 1))) >> (CCV_WARP_BITS * 2);
+	}
+}
+
+static void _ccv_warp_band(const ccv_warp_t* const warp, const int start, const int end, int* const ofs, short* const w, uint32_t* const nb)
+{
+	const ccv_dense_matrix_t* const a = warp->a;
+	const ccv_dense_matrix_t* const db = warp->b;
+	const int affine = (warp->m[6] == 0 && warp->m[7] == 0 && warp->m[8] == 1);
+	const int ch = CCV_GET_CHANNEL(a->type);
+	// in bytes, when the input is only one pixel wide (or high), the neighbor is the pixel itself
+	const int dx = a->cols > 1 ? CCV_GET_DATA_TYPE_SIZE(a->type) * ch : 0;
+	const int dy = a->rows > 1 ? a->step : 0;
+	const float scale = 1.0 / (CCV_WARP_ONE * CCV_WARP_ONE);
+	int i, j, k;
+	unsigned char* b_ptr = db->data.u8 + start * db->step;
+	if (CCV_GET_DATA_TYPE(a->type) == CCV_8U && CCV_GET_DATA_TYPE(db->type) == CCV_8U)
+	{
+		for (i = start; i < end; i++)
+		{
+			_ccv_warp_remap_row(warp, affine, i, ofs, w);
+			if (ch == 1)
+				_ccv_warp_8u_c1(a->data.u8, dx, dy, ofs, w, db->cols, b_ptr, nb);
+			else
+				for (j = 0; j < db->cols; j++)
+				{
+					const unsigned char* const p = a->data.u8 + ofs[j];
+					const short* const wj = w + j * 4;
+					for (k = 0; k < ch; k++)
+						b_ptr[j * ch + k] = (p[k] * wj[0] + p[dx + k] * wj[1] + p[dy + k] * wj[2] + p[dy + dx + k] * wj[3] + (1 << (CCV_WARP_BITS * 2 - 1))) >> (CCV_WARP_BITS * 2);
+				}
+			b_ptr += db->step;
+		}
+	} else if (CCV_GET_DATA_TYPE(a->type) == CCV_32F && CCV_GET_DATA_TYPE(db->type) == CCV_32F) {
+		const int dxf = dx / sizeof(float);
+		const int dyf = dy / sizeof(float);
+		for (i = start; i < end; i++)
+		{
+			_ccv_warp_remap_row(warp, affine, i, ofs, w);
+			float* const bf = (float*)b_ptr;
+			for (j = 0; j < db->cols; j++)
+			{
+				const float* const p = (const float*)(a->data.u8 + ofs[j]);
+				const short* const wj = w + j * 4;
+				const float w00 = wj[0] * scale, w01 = wj[1] * scale, w10 = wj[2] * scale, w11 = wj[3] * scale;
+				for (k = 0; k < ch; k++)
+					bf[j * ch + k] = p[k] * w00 + p[dxf + k] * w01 + p[dyf + k] * w10 + p[dyf + dxf + k] * w11;
+			}
+			b_ptr += db->step;
+		}
+	} else {
+		const int esize = CCV_GET_DATA_TYPE_SIZE(a->type);
+		const int dxe = dx / esize;
+#define for_block(_for_set, _for_get) \
+		for (i = start; i < end; i++) \
+		{ \
+			_ccv_warp_remap_row(warp, affine, i, ofs, w); \
+			for (j = 0; j < db->cols; j++) \
+			{ \
+				const unsigned char* const p = a->data.u8 + ofs[j]; \
+				const short* const wj = w + j * 4; \
+				const float w00 = wj[0] * scale, w01 = wj[1] * scale, w10 = wj[2] * scale, w11 = wj[3] * scale; \
+				for (k = 0; k < ch; k++) \
+					_for_set(b_ptr, j * ch + k, _for_get(p, k, 0) * w00 + _for_get(p, dxe + k, 0) * w01 + _for_get(p + dy, k, 0) * w10 + _for_get(p + dy, dxe + k, 0) * w11, 0); \
+			} \
+			b_ptr += db->step; \
+		}
+		ccv_matrix_setter(db->type, ccv_matrix_getter, a->type, for_block);
+#undef for_block
+	}
+}
+
+void ccv_warp(ccv_warp_t* warps, int count)
+{
+	int i;
+	int* const band_offset = (int*)ccmalloc(sizeof(int) * (count + 1));
+	band_offset[0] = 0;
+	// allocate (or retrieve from cache) the outputs sequentially, the parallel part only writes to them
+	for (i = 0; i < count; i++)
+	{
+		ccv_warp_t* const warp = warps + i;
+		ccv_dense_matrix_t* const a = warp->a;
+		const float* const m = warp->m;
+		ccv_declare_derived_signature(sig, a->sig != 0, ccv_sign_with_format(256, "ccv_warp(%d,%d,%a,%a,%a,%a,%a,%a,%a,%a,%a)", warp->rows, warp->cols, m[0], m[1], m[2], m[3], m[4], m[5], m[6], m[7], m[8]), a->sig, CCV_EOF_SIGN);
+		const int type = (warp->type == 0) ? CCV_GET_DATA_TYPE(a->type) | CCV_GET_CHANNEL(a->type) : CCV_GET_DATA_TYPE(warp->type) | CCV_GET_CHANNEL(a->type);
+		ccv_dense_matrix_t* const db = warp->b = ccv_dense_matrix_renew(warp->b, warp->rows, warp->cols, CCV_ALL_DATA_TYPE | CCV_GET_CHANNEL(a->type), type, sig);
+		int band_count = FOR_IS_PARALLEL ? (warp->rows + CCV_WARP_BAND_SIZE - 1) / CCV_WARP_BAND_SIZE : 1;
+		if (db->type & CCV_GARBAGE)
+		{
+			ccv_revive_object_if_cached(db);
+			band_count = 0;
+		}
+		band_offset[i + 1] = band_offset[i] + band_count;
+	}
+	parallel_for(k, band_offset[count]) {
+		// find the warp this band belongs to
+		int lo = 0, hi = count - 1;
+		while (lo < hi)
+		{
+			const int mid = (lo + hi + 1) >> 1;
+			if (band_offset[mid] <= k)
+				lo = mid;
+			else
+				hi = mid - 1;
+		}
+		const ccv_warp_t* const warp = warps + lo;
+		const int band_count = band_offset[lo + 1] - band_offset[lo];
+		const int band_size = (warp->rows + band_count - 1) / band_count;
+		const int start = (k - band_offset[lo]) * band_size;
+		const int end = ccv_min(start + band_size, warp->rows);
+		int* const ofs = (int*)ccmalloc((sizeof(int) * 2 + sizeof(short) * 4) * warp->cols);
+		uint32_t* const nb = (uint32_t*)(ofs + warp->cols);
+		short* const w = (short*)(nb + warp->cols);
+		_ccv_warp_band(warp, start, end, ofs, w, nb);
+		ccfree(ofs);
+	} parallel_endfor
+	ccfree(band_offset);
+}
@@ -1,6 +1,20 @@
 #include "ccv.h"
 #include "ccv_internal.h"
 
+int _ccv_band_rows = 0;
+
+void ccv_set_band_rows(int rows)
+{
+	_ccv_band_rows = rows;
+}
+
+int _ccv_simd_enabled = 1;
+
+void ccv_set_simd(int enabled)
+{
+	_ccv_simd_enabled = !!enabled;
+}
+
 ccv_dense_matrix_t* ccv_get_dense_matrix(ccv_matrix_t* mat)
 {
 	int type = *(int*)mat;
@@ -1652,14 +1666,24 @@ void ccv_half_precision_to_float(uint16_t* h, float* f, size_t len)
 		u[i] = _ccv_mantissa_table[_ccv_offset_table[h[i] >> 10] + (h[i] & 0x3ff)] + _ccv_exponent_table[h[i] >> 10];
 }
 
+static void _ccv_array_reserve(ccv_array_t* array, int size)
+{
+	if (array->type & CCV_UNMANAGED)
+	{
+		// arena cannot realloc, copy over to the new space and leave the old one to be released with the arena
+		void* data = ccv_arena_alloc(ccv_array_arena(array), (size_t)size * (size_t)array->rsize);
+		memcpy(data, array->data, (size_t)array->size * (size_t)array->rsize);
+		array->data = data;
+	} else
+		array->data = ccrealloc(array->data, (size_t)size * (size_t)array->rsize);
+	array->size = size;
+}
+
 void ccv_array_push(ccv_array_t* array, const void* r)
 {
 	array->rnum++;
 	if (array->rnum > array->size)
-	{
-		array->size = ccv_max(array->size * 3 / 2, array->size + 1);
-		array->data = ccrealloc(array->data, (size_t)array->size * (size_t)array->rsize);
-	}
+		_ccv_array_reserve(array, ccv_max(array->size * 3 / 2, array->size + 1));
 	memcpy(ccv_array_get(array, array->rnum - 1), r, array->rsize);
 }
 
@@ -1671,10 +1695,7 @@ void ccv_array_zero(ccv_array_t* array)
 void ccv_array_resize(ccv_array_t* array, int rnum)
 {
 	if (rnum > array->size)
-	{
-		array->size = ccv_max(array->size * 3 / 2, rnum);
-		array->data = ccrealloc(array->data, (size_t)array->size * (size_t)array->rsize);
-	}
+		_ccv_array_reserve(array, ccv_max(array->size * 3 / 2, rnum));
 	memset(ccv_array_get(array, array->rnum), 0, (size_t)array->rsize * (size_t)(rnum - array->rnum));
 	array->rnum = rnum;
 }
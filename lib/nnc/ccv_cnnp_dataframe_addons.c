@@ -352,6 +352,64 @@ int ccv_cnnp_dataframe_image_random_jitter(ccv_cnnp_dataframe_t* const dataframe
 	return ccv_cnnp_dataframe_map(dataframe, _ccv_cnnp_random_jitter, 0, _ccv_cnnp_image_deinit, COLUMN_ID_LIST(column_idx), random_jitter_context, (ccv_cnnp_column_data_context_deinit_f)ccfree);
 }
 
+#pragma mark - Resize and Normalize Image
+
+typedef struct {
+	int rows;
+	int cols;
+	int channels;
+	int format;
+	float mean[3];
+	float std[3];
+} ccv_cnnp_resize_normalize_context_t;
+
+static void _ccv_cnnp_resize_normalize(void*** const column_data, const int column_size, const int batch_size, void** const data, void* const context, ccv_nnc_stream_context_t* const stream_context)
+{
+	ccv_cnnp_resize_normalize_context_t* const ctx = (ccv_cnnp_resize_normalize_context_t*)context;
+	ccv_nnc_tensor_param_t params = {
+		.datatype = CCV_32F,
+		.type = CCV_TENSOR_CPU_MEMORY,
+		.format = ctx->format,
+	};
+	if (ctx->format == CCV_TENSOR_FORMAT_NCHW)
+	{
+		params.dim[0] = ctx->channels;
+		params.dim[1] = ctx->rows;
+		params.dim[2] = ctx->cols;
+	} else {
+		params.dim[0] = ctx->rows;
+		params.dim[1] = ctx->cols;
+		params.dim[2] = ctx->channels;
+	}
+	const int type = (ctx->format == CCV_TENSOR_FORMAT_NCHW ? CCV_RESAMPLE_NCHW : 0) | (ctx->channels == 1 ? CCV_RESAMPLE_GRAY : CCV_RESAMPLE_RGB);
+	parallel_for(i, batch_size) {
+		ccv_dense_matrix_t* const input = (ccv_dense_matrix_t*)column_data[0][i];
+		if (!data[i])
+			data[i] = ccv_nnc_tensor_new(0, params, 0);
+		ccv_nnc_tensor_t* const tensor = (ccv_nnc_tensor_t*)data[i];
+		ccv_resample_normalize(input, tensor->data.f32, ctx->rows, ctx->cols, type, ctx->mean, ctx->std);
+	} parallel_endfor
+}
+
+int ccv_cnnp_dataframe_image_resize_normalize(ccv_cnnp_dataframe_t* const dataframe, const int column_idx, const int datatype, const int format, const int rows, const int cols, const int channels, const float* const mean, const float* const std)
+{
+	assert(datatype == CCV_32F);
+	assert(format == CCV_TENSOR_FORMAT_NCHW || format == CCV_TENSOR_FORMAT_NHWC);
+	assert(channels == 1 || channels == 3);
+	ccv_cnnp_resize_normalize_context_t* const resize_normalize = (ccv_cnnp_resize_normalize_context_t*)ccmalloc(sizeof(ccv_cnnp_resize_normalize_context_t));
+	resize_normalize->rows = rows;
+	resize_normalize->cols = cols;
+	resize_normalize->channels = channels;
+	resize_normalize->format = format;
+	int i;
+	for (i = 0; i < channels; i++)
+	{
+		resize_normalize->mean[i] = mean ? mean[i] : 0;
+		resize_normalize->std[i] = std ? std[i] : 1;
+	}
+	return ccv_cnnp_dataframe_map(dataframe, _ccv_cnnp_resize_normalize, 0, _ccv_cnnp_tensor_deinit, COLUMN_ID_LIST(column_idx), resize_normalize, (ccv_cnnp_column_data_context_deinit_f)ccfree);
+}
+
 typedef struct {
 	int range;
 	int datatype;
@@ -2319,6 +2319,21 @@ typedef struct {
  * @return The index of the newly derived column.
  */
 CCV_WARN_UNUSED(int) ccv_cnnp_dataframe_image_random_jitter(ccv_cnnp_dataframe_t* const dataframe, const int column_idx, const int datatype, const ccv_cnnp_random_jitter_t random_jitter);
+/**
+ * Resize an 8-bit image and normalize it into a tensor, in one pass (see ccv_resample_normalize). It is
+ * the same as resizing, converting to float and normalizing, without the intermediate images.
+ * @param dataframe The dataframe object that contains the original image.
+ * @param column_idx The column which contains the original image.
+ * @param datatype The datatype of the tensor. We only support CCV_32F right now.
+ * @param format The format of the tensor, CCV_TENSOR_FORMAT_NHWC or CCV_TENSOR_FORMAT_NCHW.
+ * @param rows The height of the tensor.
+ * @param cols The width of the tensor.
+ * @param channels The channels of the tensor, 1 or 3. The image will be converted to grayscale or RGB if it doesn't match.
+ * @param mean The mean for each channel, 0 for no mean. pixel = (pixel - mean) / std
+ * @param std The standard deviation for each channel, 0 for no std.
+ * @return The index of the newly derived column.
+ */
+CCV_WARN_UNUSED(int) ccv_cnnp_dataframe_image_resize_normalize(ccv_cnnp_dataframe_t* const dataframe, const int column_idx, const int datatype, const int format, const int rows, const int cols, const int channels, const float* const mean, const float* const std);
 /**
  * Generate a one-hot tensor off the label from a struct.
  * @param dataframe The dataframe object that contains the label.
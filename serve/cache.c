@@ -0,0 +1,53 @@
+#include "uri.h"
+#include "ccv.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+
+#define CACHE_SOURCES (64)
+
+static void _uri_cache_append(char** body, size_t* len, size_t* written, const char* format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	int n = vsnprintf(*body + *written, *len - *written, format, args);
+	va_end(args);
+	if (n < 0)
+		return;
+	if (*written + n >= *len)
+	{
+		// truncated, grow the body to fit and print it again
+		*len = ccv_max((*len * 3 + 1) / 2, *written + n + 1);
+		*body = (char*)realloc(*body, *len);
+		va_start(args, format);
+		vsnprintf(*body + *written, *len - *written, format, args);
+		va_end(args);
+	}
+	*written += n;
+}
+
+int uri_cache_stats(const void* context, const void* parsed, ebb_buf* buf)
+{
+	ccv_cache_stats_t stats;
+	ccv_cache_stats(&stats);
+	ccv_cache_source_stats_t sources[CACHE_SOURCES];
+	int i, rnum = ccv_cache_source_stats(sources, CACHE_SOURCES);
+	size_t len = 512 + rnum * 128, written = 0;
+	char* body = (char*)malloc(len);
+	_uri_cache_append(&body, &len, &written, "{\"hits\":%llu,\"misses\":%llu,\"evictions\":%llu,\"lifetime\":%f,\"matrix\":{\"count\":%u,\"size\":%zu},\"array\":{\"count\":%u,\"size\":%zu},\"sources\":[",
+		(unsigned long long)stats.hits, (unsigned long long)stats.misses, (unsigned long long)stats.evictions, stats.lifetime, stats.rnum[0], stats.size[0], stats.rnum[1], stats.size[1]);
+	for (i = 0; i < rnum; i++)
+		_uri_cache_append(&body, &len, &written, "{\"source\":\"%.64s\",\"hits\":%llu,\"misses\":%llu}%s",
+			sources[i].source, (unsigned long long)sources[i].hits, (unsigned long long)sources[i].misses, (i == rnum - 1) ? "" : ",");
+	_uri_cache_append(&body, &len, &written, "]}\n");
+	char* data = (char*)malloc(192 + written);
+	snprintf(data, 192, ebb_http_header, (size_t)written);
+	size_t header_len = strnlen(data, 192);
+	memcpy(data + header_len, body, written);
+	free(body);
+	buf->data = data;
+	buf->len = buf->written = header_len + written;
+	buf->on_release = uri_ebb_buf_free;
+	return 0;
+}
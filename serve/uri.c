@@ -33,6 +33,15 @@ static uri_dispatch_t uri_map[] = {
 		.delete = 0,
 		.destroy = uri_bbf_detect_objects_destroy,
 	},
+	{
+		.uri = "/cache/stats",
+		.init = 0,
+		.parse = 0,
+		.get = uri_cache_stats,
+		.post = 0,
+		.delete = 0,
+		.destroy = 0,
+	},
 	{
 		.uri = "/convnet/classify",
 		.init = uri_convnet_classify_init,
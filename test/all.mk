@@ -4,7 +4,7 @@ export LSAN_OPTIONS=suppressions=known-leaks.txt
 LDFLAGS := -L"../lib" -lccv $(LDFLAGS)
 CFLAGS := -O3 -Wall -I"../lib" -I"." $(CFLAGS)
 
-SRCS := regression/defects.l0.1.tests.c unit/3rdparty.tests.c unit/io.tests.c unit/algebra.tests.c unit/memory.tests.c unit/convnet.tests.c unit/transform.tests.c unit/image_processing.tests.c unit/output.tests.c unit/nnc/while.tests.c unit/nnc/case_of.tests.c unit/nnc/crossentropy.tests.c unit/nnc/backward.tests.c unit/nnc/simplify.tests.c unit/nnc/rand.tests.c unit/nnc/dropout.tests.c unit/nnc/winograd.tests.c unit/nnc/tape.tests.c unit/nnc/broadcast.tests.c unit/nnc/tensor.tests.c unit/nnc/dataframe.addons.tests.c unit/nnc/numa.tests.c unit/nnc/case_of.backward.tests.c unit/nnc/forward.tests.c unit/nnc/autograd.tests.c unit/nnc/tfb.tests.c unit/nnc/custom.tests.c unit/nnc/dataframe.tests.c unit/nnc/gradient.tests.c unit/nnc/transform.tests.c unit/nnc/graph.io.tests.c unit/nnc/batch.norm.tests.c unit/nnc/tensor.bind.tests.c unit/nnc/symbolic.graph.compile.tests.c unit/nnc/dynamic.graph.tests.c unit/nnc/cnnp.core.tests.c unit/nnc/minimize.tests.c unit/nnc/while.backward.tests.c unit/nnc/graph.tests.c unit/nnc/parallel.tests.c unit/nnc/autograd.vector.tests.c unit/nnc/reduce.tests.c unit/nnc/symbolic.graph.tests.c unit/util.tests.c unit/basic.tests.c unit/numeric.tests.c int/nnc/cudnn.tests.c int/nnc/cublas.tests.c int/nnc/nccl.tests.c int/nnc/schedule.tests.c int/nnc/graph.vgg.d.tests.c int/nnc/symbolic.graph.vgg.d.tests.c int/nnc/cifar.tests.c int/nnc/dense.net.tests.c int/nnc/parallel.tests.c
+SRCS := regression/defects.l0.1.tests.c unit/3rdparty.tests.c unit/io.tests.c unit/algebra.tests.c unit/memory.tests.c unit/convnet.tests.c unit/transform.tests.c unit/bbf.tests.c unit/icf.tests.c unit/image_processing.tests.c unit/output.tests.c unit/nnc/while.tests.c unit/nnc/case_of.tests.c unit/nnc/crossentropy.tests.c unit/nnc/backward.tests.c unit/nnc/simplify.tests.c unit/nnc/rand.tests.c unit/nnc/dropout.tests.c unit/nnc/winograd.tests.c unit/nnc/tape.tests.c unit/nnc/broadcast.tests.c unit/nnc/tensor.tests.c unit/nnc/dataframe.addons.tests.c unit/nnc/numa.tests.c unit/nnc/case_of.backward.tests.c unit/nnc/forward.tests.c unit/nnc/autograd.tests.c unit/nnc/tfb.tests.c unit/nnc/custom.tests.c unit/nnc/dataframe.tests.c unit/nnc/gradient.tests.c unit/nnc/transform.tests.c unit/nnc/graph.io.tests.c unit/nnc/batch.norm.tests.c unit/nnc/tensor.bind.tests.c unit/nnc/symbolic.graph.compile.tests.c unit/nnc/dynamic.graph.tests.c unit/nnc/cnnp.core.tests.c unit/nnc/minimize.tests.c unit/nnc/while.backward.tests.c unit/nnc/graph.tests.c unit/nnc/parallel.tests.c unit/nnc/autograd.vector.tests.c unit/nnc/reduce.tests.c unit/nnc/symbolic.graph.tests.c unit/util.tests.c unit/basic.tests.c unit/numeric.tests.c int/nnc/cudnn.tests.c int/nnc/cublas.tests.c int/nnc/nccl.tests.c int/nnc/schedule.tests.c int/nnc/graph.vgg.d.tests.c int/nnc/symbolic.graph.vgg.d.tests.c int/nnc/cifar.tests.c int/nnc/dense.net.tests.c int/nnc/parallel.tests.c
 
 SRC_OBJS := $(patsubst %.c,%.o,$(SRCS))
 
@@ -37,6 +37,12 @@ unit/convnet.tests.o: unit/convnet.tests.c
 unit/transform.tests.o: unit/transform.tests.c
 	$(CC) $< -D CASE_DISABLE_MAIN -D CASE_TEST_DIR='"unit"' -o $@ -c $(CFLAGS)
 
+unit/bbf.tests.o: unit/bbf.tests.c
+	$(CC) $< -D CASE_DISABLE_MAIN -D CASE_TEST_DIR='"unit"' -o $@ -c $(CFLAGS)
+
+unit/icf.tests.o: unit/icf.tests.c
+	$(CC) $< -D CASE_DISABLE_MAIN -D CASE_TEST_DIR='"unit"' -o $@ -c $(CFLAGS)
+
 unit/image_processing.tests.o: unit/image_processing.tests.c
 	$(CC) $< -D CASE_DISABLE_MAIN -D CASE_TEST_DIR='"unit"' -o $@ -c $(CFLAGS)
 
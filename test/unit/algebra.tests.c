@@ -164,4 +164,42 @@ TEST_CASE("summed area table with padding")
 	ccv_matrix_free(b);
 }
 
+TEST_CASE("summed area table of 10-channel float matrix, in place and on a reused buffer")
+{
+	int i, j;
+	ccv_dense_matrix_t* dmt = ccv_dense_matrix_new(37, 29, CCV_32F | 10, 0, 0);
+	for (i = 0; i < dmt->rows * dmt->cols * 10; i++)
+		dmt->data.f32[i] = (i * 7 + 3) % 11;
+	ccv_dense_matrix_t* b = 0;
+	ccv_sat(dmt, &b, 0, CCV_PADDING_ZERO);
+	float* sat = (float*)ccmalloc(sizeof(float) * (dmt->rows + 1) * (dmt->cols + 1) * 10);
+	memset(sat, 0, sizeof(float) * (dmt->cols + 1) * 10);
+	for (i = 0; i < dmt->rows; i++)
+	{
+		float* s = sat + (i + 1) * (dmt->cols + 1) * 10;
+		for (j = 0; j < 10; j++)
+			s[j] = 0;
+		for (j = 10; j < (dmt->cols + 1) * 10; j++)
+			s[j] = s[j - 10] - s[j - (dmt->cols + 2) * 10] + s[j - (dmt->cols + 1) * 10] + dmt->data.f32[i * dmt->cols * 10 + j - 10];
+	}
+	REQUIRE_ARRAY_EQ_WITH_TOLERANCE(float, sat, b->data.f32, (dmt->rows + 1) * (dmt->cols + 1) * 10, 1e-6, "10-channel summed area table (with padding) computation error");
+	// the same buffer, as a smaller matrix
+	ccv_dense_matrix_t* c = ccv_dense_matrix_new(12, 8, CCV_32F | 10, 0, 0);
+	for (i = 0; i < c->rows; i++)
+		memcpy(c->data.f32 + i * c->cols * 10, dmt->data.f32 + i * dmt->cols * 10, sizeof(float) * c->cols * 10);
+	ccv_dense_matrix_t header = ccv_dense_matrix(c->rows + 1, c->cols + 1, CCV_32F | 10, b->data.u8, 0);
+	ccv_dense_matrix_t* h = &header;
+	ccv_sat(c, &h, 0, CCV_PADDING_ZERO);
+	for (i = 0; i <= c->rows; i++)
+		REQUIRE_ARRAY_EQ_WITH_TOLERANCE(float, sat + i * (dmt->cols + 1) * 10, h->data.f32 + i * h->cols * 10, h->cols * 10, 1e-6, "10-channel summed area table on a reused buffer computation error");
+	// in place
+	ccv_sat(dmt, &dmt, 0, CCV_NO_PADDING);
+	for (i = 0; i < dmt->rows; i++)
+		REQUIRE_ARRAY_EQ_WITH_TOLERANCE(float, sat + (i + 1) * (dmt->cols + 1) * 10 + 10, dmt->data.f32 + i * dmt->cols * 10, dmt->cols * 10, 1e-6, "10-channel summed area table in place computation error");
+	ccfree(sat);
+	ccv_matrix_free(c);
+	ccv_matrix_free(dmt);
+	ccv_matrix_free(b);
+}
+
 #include "case_main.h"
@@ -1,4 +1,5 @@
 #include "ccv.h"
+#include "ccv_internal.h"
 #include "case.h"
 #include "ccv_case.h"
 
@@ -41,6 +42,63 @@ TEST_CASE("sobel operation")
 	ccv_matrix_free(y5);
 }
 
+TEST_CASE("gradient and its orientation bins are the same as sobel, then arctan")
+{
+	ccv_dense_matrix_t* image = 0;
+	ccv_read("../../samples/nature.png", &image, CCV_IO_RGB_COLOR | CCV_IO_ANY_FILE);
+	ccv_dense_matrix_t* x = 0;
+	ccv_sobel(image, &x, CCV_32F | CCV_C3, 1, 0);
+	ccv_dense_matrix_t* y = 0;
+	ccv_sobel(image, &y, CCV_32F | CCV_C3, 0, 1);
+	ccv_dense_matrix_t* theta = 0;
+	ccv_dense_matrix_t* m = 0;
+	ccv_gradient(image, &theta, 0, &m, 0, 1, 1);
+	ccv_dense_matrix_t* gb = 0;
+	ccv_gradient_bin(image, &gb, 18);
+	int i, j, k;
+	int n = image->rows * image->cols;
+	float* mag = (float*)ccmalloc(sizeof(float) * n * 3);
+	float* bin = (float*)ccmalloc(sizeof(float) * n * 2);
+	float* gbin = (float*)ccmalloc(sizeof(float) * n * 2);
+	int ok = 1;
+	for (i = 0; i < n; i++)
+	{
+		k = 0;
+		for (j = 0; j < 3; j++)
+		{
+			float xf = x->data.f32[i * 3 + j], yf = y->data.f32[i * 3 + j];
+			mag[i * 3 + j] = sqrtf(xf * xf + yf * yf);
+			// the fast arctan is within 0.5 degree
+			if (mag[i * 3 + j] > 0)
+			{
+				float ag = atan2f(yf, xf) * 180 / CCV_PI;
+				float d = fabsf(theta->data.f32[i * 3 + j] - (ag < 0 ? ag + 360 : ag));
+				if (ccv_min(d, 360 - d) > 0.5)
+					ok = 0;
+			}
+			if (m->data.f32[i * 3 + j] > m->data.f32[i * 3 + k])
+				k = j;
+		}
+		bin[i * 2] = ccv_clamp(theta->data.f32[i * 3 + k], 0, 359.99) * 18 / 360;
+		bin[i * 2 + 1] = m->data.f32[i * 3 + k];
+		// the orientation may wrap around between the last bin and the first one
+		gbin[i * 2] = gb->data.f32[i * 2] - bin[i * 2] > 9 ? gb->data.f32[i * 2] - 18 : (bin[i * 2] - gb->data.f32[i * 2] > 9 ? gb->data.f32[i * 2] + 18 : gb->data.f32[i * 2]);
+		gbin[i * 2 + 1] = gb->data.f32[i * 2 + 1];
+	}
+	REQUIRE(ok, "the angle should be close to atan2");
+	REQUIRE_ARRAY_EQ_WITH_TOLERANCE(float, m->data.f32, mag, n * 3, 1e-3, "the magnitude should be the same as the one computed from sobel");
+	REQUIRE_ARRAY_EQ_WITH_TOLERANCE(float, gbin, bin, n * 2, 1e-3, "the orientation bin and the magnitude should be from the channel with the largest magnitude");
+	ccfree(mag);
+	ccfree(bin);
+	ccfree(gbin);
+	ccv_matrix_free(image);
+	ccv_matrix_free(x);
+	ccv_matrix_free(y);
+	ccv_matrix_free(theta);
+	ccv_matrix_free(m);
+	ccv_matrix_free(gb);
+}
+
 TEST_CASE("resample operation of CCV_INTER_AREA")
 {
 	ccv_dense_matrix_t* image = 0;
@@ -52,6 +110,119 @@ TEST_CASE("resample operation of CCV_INTER_AREA")
 	ccv_matrix_free(x);
 }
 
+TEST_CASE("resample of a color image is the resample of its channels")
+{
+	ccv_dense_matrix_t* image = 0;
+	ccv_read("../../samples/chessbox.png", &image, CCV_IO_RGB_COLOR | CCV_IO_ANY_FILE);
+	ccv_dense_matrix_t* fimage = 0;
+	ccv_shift(image, (ccv_matrix_t**)&fimage, CCV_32F, 0, 0);
+	ccv_dense_matrix_t* images[] = { image, fimage };
+	int types[] = { CCV_INTER_AREA, CCV_INTER_CUBIC };
+	int i, j, k, l, c;
+	for (i = 0; i < 2; i++)
+		for (j = 0; j < 2; j++)
+		{
+			ccv_dense_matrix_t* a = images[i];
+			int rows = types[j] == CCV_INTER_AREA ? a->rows * 5 / 7 : a->rows * 3 / 2;
+			int cols = types[j] == CCV_INTER_AREA ? a->cols * 5 / 7 : a->cols * 3 / 2;
+			ccv_dense_matrix_t* x = 0;
+			ccv_resample(a, &x, 0, rows, cols, types[j]);
+			for (c = 0; c < 3; c++)
+			{
+				ccv_dense_matrix_t* ac = ccv_dense_matrix_new(a->rows, a->cols, CCV_GET_DATA_TYPE(a->type) | CCV_C1, 0, 0);
+				ccv_dense_matrix_t* xc = ccv_dense_matrix_new(x->rows, x->cols, CCV_GET_DATA_TYPE(x->type) | CCV_C1, 0, 0);
+				for (k = 0; k < a->rows; k++)
+					for (l = 0; l < a->cols; l++)
+						ccv_set_value(ac->type, ac->data.u8 + k * ac->step, l, ccv_get_value(a->type, a->data.u8 + k * a->step, l * 3 + c), 0);
+				for (k = 0; k < x->rows; k++)
+					for (l = 0; l < x->cols; l++)
+						ccv_set_value(xc->type, xc->data.u8 + k * xc->step, l, ccv_get_value(x->type, x->data.u8 + k * x->step, l * 3 + c), 0);
+				ccv_dense_matrix_t* y = 0;
+				ccv_resample(ac, &y, 0, rows, cols, types[j]);
+				REQUIRE_MATRIX_EQ(xc, y, "channel %d should match resampling it alone", c);
+				ccv_matrix_free(ac);
+				ccv_matrix_free(xc);
+				ccv_matrix_free(y);
+			}
+			ccv_matrix_free(x);
+		}
+	ccv_matrix_free(image);
+	ccv_matrix_free(fimage);
+}
+
+TEST_CASE("resample normalize is the same as resample, then normalize")
+{
+	ccv_dense_matrix_t* image = 0;
+	ccv_read("../../samples/nature.png", &image, CCV_IO_RGB_COLOR | CCV_IO_ANY_FILE);
+	const float mean[] = { 123.68, 116.779, 103.939 };
+	const float std[] = { 58.393, 57.12, 57.375 };
+	int sizes[][2] = { { 224, 224 }, { image->rows * 3 / 2, image->cols * 4 / 3 } };
+	int i, j, k, l;
+	for (i = 0; i < 2; i++)
+		for (j = 0; j < 2; j++)
+		{
+			const int rows = sizes[i][0];
+			const int cols = sizes[i][1];
+			const int nchw = j ? CCV_RESAMPLE_NCHW : 0;
+			float* b = (float*)ccmalloc(sizeof(float) * rows * cols * 3);
+			ccv_resample_normalize(image, b, rows, cols, nchw, mean, std);
+			ccv_dense_matrix_t* x = 0;
+			ccv_resample(image, &x, CCV_32F | CCV_C3, rows, cols, i == 0 ? CCV_INTER_AREA : CCV_INTER_CUBIC);
+			float* y = (float*)ccmalloc(sizeof(float) * rows * cols * 3);
+			for (k = 0; k < rows; k++)
+				for (l = 0; l < cols * 3; l++)
+				{
+					const int c = l % 3;
+					const float v = (x->data.f32[k * cols * 3 + l] - mean[c]) / std[c];
+					if (nchw)
+						y[c * rows * cols + k * cols + l / 3] = v;
+					else
+						y[k * cols * 3 + l] = v;
+				}
+			REQUIRE_ARRAY_EQ_WITH_TOLERANCE(float, b, y, rows * cols * 3, 2e-6, "resample normalize should match resample and normalize (%d x %d, nchw %d)", rows, cols, j);
+			ccfree(b);
+			ccfree(y);
+			ccv_matrix_free(x);
+		}
+	ccv_matrix_free(image);
+}
+
+TEST_CASE("image pyramid is the same as resample and sample down")
+{
+	ccv_dense_matrix_t* image = 0;
+	ccv_read("../../samples/nature.png", &image, CCV_IO_GRAY | CCV_IO_ANY_FILE);
+	ccv_pyramid_t* pyramid = ccv_pyramid_new();
+	int i, q, interval = 3, next = interval + 1, count = next * 3 + 2;
+	ccv_pyramid(image, pyramid, interval, count, CCV_PYRAMID_ACCURATE);
+	double scale = pow(2., 1. / next);
+	ccv_dense_matrix_t** pyr = (ccv_dense_matrix_t**)alloca(sizeof(ccv_dense_matrix_t*) * count);
+	pyr[0] = image;
+	for (i = 1; i < count; i++)
+	{
+		pyr[i] = 0;
+		if (i < next)
+			ccv_resample(image, &pyr[i], 0, (int)(image->rows / pow(scale, i)), (int)(image->cols / pow(scale, i)), CCV_INTER_AREA);
+		else
+			ccv_sample_down(pyr[i - next], &pyr[i], 0, 0, 0);
+		REQUIRE_MATRIX_EQ(ccv_pyramid_level(pyramid, i), pyr[i], "level %d should match", i);
+	}
+	for (i = next * 2; i < count; i++)
+		for (q = 1; q < 4; q++)
+		{
+			ccv_dense_matrix_t* x = 0;
+			ccv_sample_down(pyr[i - next], &x, 0, q & 1, q >> 1);
+			REQUIRE_MATRIX_EQ(ccv_pyramid_offset_level(pyramid, i, q), x, "offset level %d, %d should match", i, q);
+			ccv_matrix_free(x);
+		}
+	unsigned char* data = pyramid->data;
+	ccv_pyramid(image, pyramid, interval, next, 0);
+	REQUIRE(pyramid->data == data && pyramid->count == count, "the pyramid of the same image should be reused");
+	for (i = 1; i < count; i++)
+		ccv_matrix_free(pyr[i]);
+	ccv_pyramid_free(pyramid);
+	ccv_matrix_free(image);
+}
+
 TEST_CASE("sample down operation with source offset (10, 10)")
 {
 	ccv_dense_matrix_t* image = 0;
@@ -63,6 +234,79 @@ TEST_CASE("sample down operation with source offset (10, 10)")
 	ccv_matrix_free(x);
 }
 
+TEST_CASE("sample down of an 8-bit image is the same as its integer sample down")
+{
+	ccv_dense_matrix_t* image = 0;
+	ccv_read("../../samples/nature.png", &image, CCV_IO_RGB_COLOR | CCV_IO_ANY_FILE);
+	ccv_dense_matrix_t* gray = 0;
+	ccv_read("../../samples/nature.png", &gray, CCV_IO_GRAY | CCV_IO_ANY_FILE);
+	ccv_dense_matrix_t* images[] = { image, gray };
+	int offsets[] = { 0, 0, 1, 1, 3, 2 };
+	int i, j;
+	for (i = 0; i < 2; i++)
+		for (j = 0; j < 3; j++)
+		{
+			ccv_dense_matrix_t* x = 0;
+			ccv_sample_down(images[i], &x, 0, offsets[j * 2], offsets[j * 2 + 1]);
+			ccv_dense_matrix_t* y = 0;
+			ccv_sample_down(images[i], &y, CCV_32S, offsets[j * 2], offsets[j * 2 + 1]);
+			ccv_dense_matrix_t* z = 0;
+			ccv_shift(y, (ccv_matrix_t**)&z, CCV_8U, 0, 0);
+			REQUIRE_MATRIX_EQ(x, z, "sample down with source offset (%d, %d) should match", offsets[j * 2], offsets[j * 2 + 1]);
+			ccv_matrix_free(x);
+			ccv_matrix_free(y);
+			ccv_matrix_free(z);
+		}
+	ccv_matrix_free(image);
+	ccv_matrix_free(gray);
+}
+
+static void _ccv_sample_in_bands(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int up, int src_x, int src_y, int band_rows)
+{
+	ccv_set_band_rows(band_rows);
+	if (up)
+		ccv_sample_up(a, b, 0, src_x, src_y);
+	else
+		ccv_sample_down(a, b, 0, src_x, src_y);
+	ccv_set_band_rows(0);
+}
+
+TEST_CASE("sample down / up in several bands is bit-exact with one band")
+{
+	ccv_dense_matrix_t* image = 0;
+	ccv_read("../../samples/nature.png", &image, CCV_IO_RGB_COLOR | CCV_IO_ANY_FILE);
+	ccv_dense_matrix_t* gray = 0;
+	ccv_read("../../samples/nature.png", &gray, CCV_IO_GRAY | CCV_IO_ANY_FILE);
+	ccv_dense_matrix_t* images[] = { image, gray };
+	int types[] = { CCV_8U, CCV_32F, CCV_64F };
+	int offsets[] = { 0, 0, 1, 1, 3, 2 };
+	int i, j, k, up, y;
+	for (i = 0; i < 2; i++)
+		for (j = 0; j < 3; j++)
+		{
+			ccv_dense_matrix_t* a = 0;
+			ccv_shift(images[i], (ccv_matrix_t**)&a, types[j], 0, 0);
+			a->sig = 0;
+			for (up = 0; up < 2; up++)
+				for (k = 0; k < 3; k++)
+				{
+					ccv_dense_matrix_t* x = 0;
+					_ccv_sample_in_bands(a, &x, up, offsets[k * 2], offsets[k * 2 + 1], -1);
+					ccv_dense_matrix_t* z = 0;
+					_ccv_sample_in_bands(a, &z, up, offsets[k * 2], offsets[k * 2 + 1], 7);
+					REQUIRE_EQ(x->rows, z->rows, "should have the same rows");
+					REQUIRE_EQ(x->cols, z->cols, "should have the same cols");
+					for (y = 0; y < x->rows; y++)
+						REQUIRE_ARRAY_EQ(unsigned char, x->data.u8 + x->step * y, z->data.u8 + z->step * y, x->cols * CCV_GET_CHANNEL(x->type) * CCV_GET_DATA_TYPE_SIZE(x->type), "sample %s of type %d, channel %d, offset (%d, %d) should match at row %d", up ? "up" : "down", types[j], CCV_GET_CHANNEL(x->type), offsets[k * 2], offsets[k * 2 + 1], y);
+					ccv_matrix_free(x);
+					ccv_matrix_free(z);
+				}
+			ccv_matrix_free(a);
+		}
+	ccv_matrix_free(image);
+	ccv_matrix_free(gray);
+}
+
 TEST_CASE("sample up operation with source offset (10, 10)")
 {
 	ccv_dense_matrix_t* image = 0;
@@ -85,6 +329,50 @@ TEST_CASE("blur operation with sigma 10")
 	ccv_matrix_free(x);
 }
 
+TEST_CASE("blur operation with sigma 12 is close to Gaussian filter")
+{
+	ccv_dense_matrix_t* image = 0;
+	ccv_read("../../samples/nature.png", &image, CCV_IO_GRAY | CCV_IO_ANY_FILE);
+	ccv_dense_matrix_t* small = 0;
+	ccv_sample_down(image, &small, 0, 0, 0);
+	ccv_dense_matrix_t* a = 0;
+	ccv_shift(small, (ccv_matrix_t**)&a, CCV_32F, 0, 0);
+	ccv_dense_matrix_t* x = 0;
+	double sigma = 12;
+	ccv_blur(a, &x, 0, sigma);
+	int i, j, k, hfz = (int)(sigma * 6);
+	float* w = (float*)ccmalloc(sizeof(float) * (hfz * 2 + 1));
+	float tw = 0;
+	for (k = -hfz; k <= hfz; k++)
+		tw += w[k + hfz] = exp(-k * k / (2 * sigma * sigma));
+	ccv_dense_matrix_t* t = ccv_dense_matrix_new(a->rows, a->cols, CCV_32F | CCV_C1, 0, 0);
+	ccv_dense_matrix_t* y = ccv_dense_matrix_new(a->rows, a->cols, CCV_32F | CCV_C1, 0, 0);
+	for (i = 0; i < a->rows; i++)
+		for (j = 0; j < a->cols; j++)
+		{
+			float sum = 0;
+			for (k = -hfz; k <= hfz; k++)
+				sum += w[k + hfz] * a->data.f32[i * a->cols + ccv_clamp(j + k, 0, a->cols - 1)];
+			t->data.f32[i * a->cols + j] = sum / tw;
+		}
+	for (i = 0; i < a->rows; i++)
+		for (j = 0; j < a->cols; j++)
+		{
+			float sum = 0;
+			for (k = -hfz; k <= hfz; k++)
+				sum += w[k + hfz] * t->data.f32[ccv_clamp(i + k, 0, a->rows - 1) * a->cols + j];
+			y->data.f32[i * a->cols + j] = sum / tw;
+		}
+	REQUIRE_ARRAY_EQ_WITH_TOLERANCE(float, x->data.f32, y->data.f32, a->rows * a->cols, 0.1, "should be close to image applied with Gaussian filter with sigma 12");
+	ccfree(w);
+	ccv_matrix_free(image);
+	ccv_matrix_free(small);
+	ccv_matrix_free(a);
+	ccv_matrix_free(t);
+	ccv_matrix_free(x);
+	ccv_matrix_free(y);
+}
+
 TEST_CASE("flip operation")
 {
 	ccv_dense_matrix_t* image = 0;
@@ -0,0 +1,87 @@
+#include "ccv.h"
+#include "ccv_internal.h"
+#include "case.h"
+#include "ccv_case.h"
+
+/* the face cascade with every stage threshold lowered by margin, thus, a lot more windows pass the late stages */
+static ccv_bbf_classifier_cascade_t* _ccv_bbf_read_loose_cascade(float margin)
+{
+	ccv_bbf_classifier_cascade_t* cascade = ccv_bbf_read_classifier_cascade("../../samples/face");
+	int i;
+	for (i = 0; i < cascade->count; i++)
+		cascade->stage_classifier[i].threshold -= margin;
+	ccv_bbf_classifier_cascade_compile(cascade);
+	return cascade;
+}
+
+static ccv_array_t* _ccv_bbf_detect_in_bands(ccv_dense_matrix_t* image, ccv_bbf_classifier_cascade_t* cascade, int band_rows)
+{
+	ccv_bbf_param_t params = ccv_bbf_default_params;
+	params.min_neighbors = 0;
+	ccv_set_band_rows(band_rows);
+	ccv_array_t* seq = ccv_bbf_detect_objects(image, &cascade, 1, params);
+	ccv_set_band_rows(0);
+	return seq;
+}
+
+TEST_CASE("bbf detection in several bands is the same as in one band")
+{
+	ccv_dense_matrix_t* image = 0;
+	ccv_read("../../samples/nature.png", &image, CCV_IO_GRAY | CCV_IO_ANY_FILE);
+	const float margins[] = { 0, 6 };
+	int i, j;
+	for (i = 0; i < 2; i++)
+	{
+		ccv_bbf_classifier_cascade_t* cascade = _ccv_bbf_read_loose_cascade(margins[i]);
+		ccv_array_t* x = _ccv_bbf_detect_in_bands(image, cascade, -1);
+		ccv_array_t* y = _ccv_bbf_detect_in_bands(image, cascade, 3);
+		REQUIRE(x->rnum > 0, "should have windows that pass the cascade (margin %g)", margins[i]);
+		REQUIRE_EQ(x->rnum, y->rnum, "should have the same number of windows (margin %g)", margins[i]);
+		for (j = 0; j < x->rnum; j++)
+		{
+			ccv_comp_t* a = (ccv_comp_t*)ccv_array_get(x, j);
+			ccv_comp_t* b = (ccv_comp_t*)ccv_array_get(y, j);
+			REQUIRE(a->rect.x == b->rect.x && a->rect.y == b->rect.y && a->rect.width == b->rect.width && a->rect.height == b->rect.height, "window %d should be the same (margin %g)", j, margins[i]);
+			REQUIRE_EQ(a->classification.confidence, b->classification.confidence, "window %d should have the same confidence (margin %g)", j, margins[i]);
+		}
+		ccv_array_free(x);
+		ccv_array_free(y);
+		ccv_bbf_classifier_cascade_free(cascade);
+	}
+	ccv_matrix_free(image);
+}
+
+TEST_CASE("bbf detection with 16 windows at once is the same as one window at a time")
+{
+	const char* files[] = { "../../samples/nature.png", "../../samples/street.png" };
+	const float margins[] = { 0, 6 };
+	int i, j, k;
+	for (i = 0; i < 2; i++)
+	{
+		ccv_dense_matrix_t* image = 0;
+		ccv_read(files[i], &image, CCV_IO_GRAY | CCV_IO_ANY_FILE);
+		for (j = 0; j < 2; j++)
+		{
+			ccv_bbf_classifier_cascade_t* cascade = _ccv_bbf_read_loose_cascade(margins[j]);
+			ccv_array_t* x = _ccv_bbf_detect_in_bands(image, cascade, 0);
+			ccv_set_simd(0);
+			ccv_array_t* y = _ccv_bbf_detect_in_bands(image, cascade, 0);
+			ccv_set_simd(1);
+			REQUIRE(y->rnum > 0, "should have windows that pass the cascade (%s, margin %g)", files[i], margins[j]);
+			REQUIRE_EQ(x->rnum, y->rnum, "should have the same number of windows (%s, margin %g)", files[i], margins[j]);
+			for (k = 0; k < x->rnum; k++)
+			{
+				ccv_comp_t* a = (ccv_comp_t*)ccv_array_get(x, k);
+				ccv_comp_t* b = (ccv_comp_t*)ccv_array_get(y, k);
+				REQUIRE(a->rect.x == b->rect.x && a->rect.y == b->rect.y && a->rect.width == b->rect.width && a->rect.height == b->rect.height, "window %d should be the same (%s, margin %g)", k, files[i], margins[j]);
+				REQUIRE_EQ(a->classification.confidence, b->classification.confidence, "window %d should have the same confidence (%s, margin %g)", k, files[i], margins[j]);
+			}
+			ccv_array_free(x);
+			ccv_array_free(y);
+			ccv_bbf_classifier_cascade_free(cascade);
+		}
+		ccv_matrix_free(image);
+	}
+}
+
+#include "case_main.h"
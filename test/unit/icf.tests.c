@@ -0,0 +1,214 @@
+#include "ccv.h"
+#include "case.h"
+#include "ccv_case.h"
+#include <unistd.h>
+#include <math.h>
+
+static int _ccv_icf_feature_is_equal(ccv_icf_feature_t* a, ccv_icf_feature_t* b)
+{
+	if (a->count != b->count || a->beta != b->beta)
+		return 0;
+	int i;
+	for (i = 0; i < a->count; i++)
+		if (a->channel[i] != b->channel[i] || a->alpha[i] != b->alpha[i] ||
+			a->sat[i * 2].x != b->sat[i * 2].x || a->sat[i * 2].y != b->sat[i * 2].y ||
+			a->sat[i * 2 + 1].x != b->sat[i * 2 + 1].x || a->sat[i * 2 + 1].y != b->sat[i * 2 + 1].y)
+			return 0;
+	return 1;
+}
+
+/* the weak classifiers only, the power law factors are checked on their own */
+static int _ccv_icf_classifier_cascade_is_equal(ccv_icf_classifier_cascade_t* a, ccv_icf_classifier_cascade_t* b)
+{
+	if (a->count != b->count || a->grayscale != b->grayscale ||
+		a->size.width != b->size.width || a->size.height != b->size.height ||
+		a->margin.left != b->margin.left || a->margin.top != b->margin.top || a->margin.right != b->margin.right || a->margin.bottom != b->margin.bottom)
+		return 0;
+	int i;
+	for (i = 0; i < a->count; i++)
+	{
+		ccv_icf_decision_tree_t* x = a->weak_classifiers + i;
+		ccv_icf_decision_tree_t* y = b->weak_classifiers + i;
+		if (x->pass != y->pass || x->weigh[0] != y->weigh[0] || x->weigh[1] != y->weigh[1] || x->threshold != y->threshold ||
+			!_ccv_icf_feature_is_equal(x->features, y->features) ||
+			((x->pass & 0x2) && !_ccv_icf_feature_is_equal(x->features + 1, y->features + 1)) ||
+			((x->pass & 0x1) && !_ccv_icf_feature_is_equal(x->features + 2, y->features + 2)))
+			return 0;
+	}
+	return 1;
+}
+
+TEST_CASE("icf classifier cascade round-trips the power law factors")
+{
+	ccv_icf_classifier_cascade_t* cascade = ccv_icf_read_classifier_cascade("../../samples/pedestrian.icf");
+	char filename[] = "/tmp/ccv-icf-XXXXXX";
+	int fd = mkstemp(filename);
+	REQUIRE(fd >= 0, "should create a temporary file");
+	close(fd);
+	ccv_icf_write_classifier_cascade(cascade, filename);
+	ccv_icf_classifier_cascade_t* x = ccv_icf_read_classifier_cascade(filename);
+	REQUIRE(_ccv_icf_classifier_cascade_is_equal(cascade, x), "should read back the same weak classifiers");
+	REQUIRE_ARRAY_EQ(float, cascade->lambda, x->lambda, CCV_ICF_CHANNEL_MAX, "should read back the same power law factors");
+	ccv_icf_classifier_cascade_free(x);
+	float zeros[CCV_ICF_CHANNEL_MAX] = {0};
+	memset(cascade->lambda, 0, sizeof(cascade->lambda));
+	ccv_icf_write_classifier_cascade(cascade, filename);
+	x = ccv_icf_read_classifier_cascade(filename);
+	REQUIRE(_ccv_icf_classifier_cascade_is_equal(cascade, x), "should read back the same weak classifiers without the power law factors");
+	REQUIRE_ARRAY_EQ(float, zeros, x->lambda, CCV_ICF_CHANNEL_MAX, "should read back no power law factors");
+	ccv_icf_classifier_cascade_free(x);
+	unlink(filename);
+	ccv_icf_classifier_cascade_free(cascade);
+}
+
+TEST_CASE("icf classifier cascade reads a file without the power law factors")
+{
+	ccv_icf_classifier_cascade_t* cascade = ccv_icf_read_classifier_cascade("../../samples/pedestrian.icf");
+	float zeros[CCV_ICF_CHANNEL_MAX] = {0};
+	REQUIRE(memcmp(zeros, cascade->lambda, sizeof(zeros)) != 0, "the sample should have the power law factors");
+	/* the sample file less its last line, which is what the files written before the power law factors are */
+	FILE* r = fopen("../../samples/pedestrian.icf", "rb");
+	fseek(r, 0, SEEK_END);
+	long size = ftell(r);
+	fseek(r, 0, SEEK_SET);
+	char* data = (char*)ccmalloc(size);
+	REQUIRE_EQ(size, (long)fread(data, 1, size, r), "should read the whole sample");
+	fclose(r);
+	long end = size - 1;
+	while (end > 0 && data[end - 1] != '\n')
+		--end;
+	char filename[] = "/tmp/ccv-icf-XXXXXX";
+	int fd = mkstemp(filename);
+	REQUIRE(fd >= 0, "should create a temporary file");
+	REQUIRE_EQ(end, (long)write(fd, data, end), "should write the sample less its last line");
+	close(fd);
+	ccfree(data);
+	ccv_icf_classifier_cascade_t* x = ccv_icf_read_classifier_cascade(filename);
+	unlink(filename);
+	REQUIRE(_ccv_icf_classifier_cascade_is_equal(cascade, x), "should read the same weak classifiers");
+	REQUIRE_ARRAY_EQ(float, zeros, x->lambda, CCV_ICF_CHANNEL_MAX, "should read no power law factors");
+	ccv_icf_classifier_cascade_free(x);
+	ccv_icf_classifier_cascade_free(cascade);
+}
+
+TEST_CASE("icf power law factors estimated on natural images")
+{
+	ccv_icf_classifier_cascade_t* cascade = ccv_icf_read_classifier_cascade("../../samples/pedestrian.icf");
+	ccv_array_t* files = ccv_array_new(sizeof(ccv_file_info_t), 2, 0);
+	ccv_file_info_t file_info;
+	file_info.filename = "../../samples/no-such-image.png";
+	ccv_array_push(files, &file_info);
+	float zeros[CCV_ICF_CHANNEL_MAX] = {0};
+	const int levels = ccv_cli_get_output_levels();
+	ccv_cli_set_output_levels(CCV_CLI_NONE);
+	ccv_icf_classifier_cascade_power_law(cascade, files);
+	REQUIRE_ARRAY_EQ(float, zeros, cascade->lambda, CCV_ICF_CHANNEL_MAX, "should have no power law factors without an image");
+	ccv_array_clear(files);
+	file_info.filename = "../../samples/nature.png";
+	ccv_array_push(files, &file_info);
+	file_info.filename = "../../samples/street.png";
+	ccv_array_push(files, &file_info);
+	ccv_icf_classifier_cascade_power_law(cascade, files);
+	ccv_cli_set_output_levels(levels);
+	ccv_array_free(files);
+	int i;
+	/* the color channels keep their means across scales, and the gradients get sharper on the smaller images */
+	for (i = 0; i < 3; i++)
+		REQUIRE(fabsf(cascade->lambda[i]) < 0.05, "the color channel %d should have a power law factor about 0, not %f", i, cascade->lambda[i]);
+	for (i = 3; i < CCV_ICF_CHANNEL_MAX; i++)
+		REQUIRE(cascade->lambda[i] > 0.05 && cascade->lambda[i] < 1, "the gradient channel %d should have a power law factor in (0.05, 1), not %f", i, cascade->lambda[i]);
+	ccv_icf_classifier_cascade_free(cascade);
+}
+
+/* the pedestrian cascade with every soft cascade threshold lowered by margin, thus, a lot more windows come out */
+static ccv_icf_classifier_cascade_t* _ccv_icf_read_loose_cascade(float margin)
+{
+	ccv_icf_classifier_cascade_t* cascade = ccv_icf_read_classifier_cascade("../../samples/pedestrian.icf");
+	int i;
+	for (i = 0; i < cascade->count; i++)
+		cascade->weak_classifiers[i].threshold -= margin;
+	return cascade;
+}
+
+static ccv_array_t* _ccv_icf_detect(ccv_dense_matrix_t* image, ccv_icf_classifier_cascade_t* cascade, int approximate)
+{
+	ccv_icf_param_t params = ccv_icf_default_params;
+	params.min_neighbors = 0;
+	params.approximate = approximate;
+	return ccv_icf_detect_objects(image, &cascade, 1, params);
+}
+
+/* the windows at the octave scales are the ones exactly as big as the cascade, times a power of 2 */
+static ccv_array_t* _ccv_icf_octave_windows(ccv_array_t* seq, ccv_icf_classifier_cascade_t* cascade)
+{
+	const int width = cascade->size.width - cascade->margin.left - cascade->margin.right;
+	const int height = cascade->size.height - cascade->margin.top - cascade->margin.bottom;
+	ccv_array_t* windows = ccv_array_new(sizeof(ccv_comp_t), 64, 0);
+	int i, j;
+	for (i = 0; i < seq->rnum; i++)
+	{
+		ccv_comp_t* comp = (ccv_comp_t*)ccv_array_get(seq, i);
+		for (j = 0; (width << j) <= comp->rect.width; j++)
+			if (comp->rect.width == (width << j) && comp->rect.height == (height << j))
+				ccv_array_push(windows, comp);
+	}
+	return windows;
+}
+
+TEST_CASE("icf approximate detection is the same as exact detection on the octave scales")
+{
+	ccv_dense_matrix_t* image = 0;
+	ccv_read("../../samples/street.png", &image, CCV_IO_RGB_COLOR | CCV_IO_ANY_FILE);
+	const float margins[] = { 0.02, 0.05 };
+	int i, j;
+	for (i = 0; i < 2; i++)
+	{
+		ccv_icf_classifier_cascade_t* cascade = _ccv_icf_read_loose_cascade(margins[i]);
+		ccv_array_t* exact = _ccv_icf_detect(image, cascade, 0);
+		ccv_array_t* approximate = _ccv_icf_detect(image, cascade, 1);
+		ccv_array_t* x = _ccv_icf_octave_windows(exact, cascade);
+		ccv_array_t* y = _ccv_icf_octave_windows(approximate, cascade);
+		REQUIRE(x->rnum > 0, "should have windows on the octave scales (margin %g)", margins[i]);
+		REQUIRE(approximate->rnum > y->rnum, "should have windows on the approximated scales (margin %g)", margins[i]);
+		REQUIRE_EQ(x->rnum, y->rnum, "should have the same number of windows on the octave scales (margin %g)", margins[i]);
+		for (j = 0; j < x->rnum; j++)
+		{
+			ccv_comp_t* a = (ccv_comp_t*)ccv_array_get(x, j);
+			ccv_comp_t* b = (ccv_comp_t*)ccv_array_get(y, j);
+			REQUIRE(a->rect.x == b->rect.x && a->rect.y == b->rect.y, "window %d should be at the same place (margin %g)", j, margins[i]);
+			REQUIRE_EQ(a->classification.confidence, b->classification.confidence, "window %d should have the same confidence (margin %g)", j, margins[i]);
+		}
+		ccv_array_free(x);
+		ccv_array_free(y);
+		ccv_array_free(exact);
+		ccv_array_free(approximate);
+		ccv_icf_classifier_cascade_free(cascade);
+	}
+	ccv_matrix_free(image);
+}
+
+TEST_CASE("icf approximate detection without the power law factors is exact detection")
+{
+	ccv_dense_matrix_t* image = 0;
+	ccv_read("../../samples/street.png", &image, CCV_IO_RGB_COLOR | CCV_IO_ANY_FILE);
+	ccv_icf_classifier_cascade_t* cascade = _ccv_icf_read_loose_cascade(0.05);
+	memset(cascade->lambda, 0, sizeof(cascade->lambda));
+	ccv_array_t* x = _ccv_icf_detect(image, cascade, 0);
+	ccv_array_t* y = _ccv_icf_detect(image, cascade, 1);
+	REQUIRE(x->rnum > 0, "should have windows that pass the cascade");
+	REQUIRE_EQ(x->rnum, y->rnum, "should have the same number of windows");
+	int i;
+	for (i = 0; i < x->rnum; i++)
+	{
+		ccv_comp_t* a = (ccv_comp_t*)ccv_array_get(x, i);
+		ccv_comp_t* b = (ccv_comp_t*)ccv_array_get(y, i);
+		REQUIRE(a->rect.x == b->rect.x && a->rect.y == b->rect.y && a->rect.width == b->rect.width && a->rect.height == b->rect.height, "window %d should be the same", i);
+		REQUIRE_EQ(a->classification.confidence, b->classification.confidence, "window %d should have the same confidence", i);
+	}
+	ccv_array_free(x);
+	ccv_array_free(y);
+	ccv_icf_classifier_cascade_free(cascade);
+	ccv_matrix_free(image);
+}
+
+#include "case_main.h"
@@ -1,6 +1,7 @@
 #include "ccv.h"
 #include "case.h"
 #include "ccv_case.h"
+#include <unistd.h>
 
 TEST_CASE("read raw memory, rgb => gray")
 {
@@ -334,6 +335,100 @@ TEST_CASE("read raw memory with no copy mode")
 	ccv_matrix_free(x);
 }
 
+TEST_CASE("read binary file with mmap mode")
+{
+	ccv_dense_matrix_t* x = 0;
+	ccv_read("data/chessbox.sample_down.bin", &x, CCV_IO_ANY_FILE);
+	ccv_dense_matrix_t* y = 0;
+	ccv_read("data/chessbox.sample_down.bin", &y, CCV_IO_ANY_FILE | CCV_IO_MMAP);
+	REQUIRE(y != 0, "should map the binary file");
+	REQUIRE((y->type & (CCV_NO_DATA_ALLOC | CCV_UNMANAGED)) == (CCV_NO_DATA_ALLOC | CCV_UNMANAGED), "the mapped matrix should not own its data section");
+	REQUIRE_EQ(x->sig, y->sig, "the mapped matrix should have the same signature");
+	REQUIRE_MATRIX_EQ(x, y, "read chessbox.sample_down.bin with and without mmap should be the same");
+	ccv_matrix_free(y);
+	ccv_matrix_free(x);
+}
+
+TEST_CASE("read raw file with mmap mode")
+{
+	unsigned char rgb[] = {
+		10, 20, 30, 40, 50, 60, 70, 80, 90,
+		15, 25, 35, 45, 55, 65, 75, 85, 95,
+	};
+	char filename[] = "/tmp/ccv-io-mmap-XXXXXX";
+	int fd = mkstemp(filename);
+	REQUIRE(fd >= 0, "should create a temporary file");
+	REQUIRE_EQ((ssize_t)sizeof(rgb), write(fd, rgb, sizeof(rgb)), "should write raw data into the file");
+	close(fd);
+	ccv_dense_matrix_t* x = 0;
+	ccv_read(filename, &x, CCV_IO_RGB_RAW | CCV_IO_MMAP, 2, 3, 9);
+	unlink(filename); // the mapping outlives the file
+	REQUIRE(x != 0, "should map the raw file");
+	REQUIRE_EQ(9, x->step, "its step value should be equal to the passing scanline value");
+	REQUIRE_EQ(CCV_8U | CCV_C3, CCV_GET_DATA_TYPE(x->type) | CCV_GET_CHANNEL(x->type), "it should be a rgb matrix");
+	REQUIRE_ARRAY_EQ(unsigned char, rgb, x->data.u8, 18, "the mapped data should be the same as the raw data");
+	ccv_matrix_free(x);
+	x = 0;
+	REQUIRE_EQ(CCV_IO_ERROR, ccv_read(filename, &x, CCV_IO_RGB_RAW | CCV_IO_MMAP, 2, 3, 9), "should fail to map a file that doesn't exist");
+}
+
+static void _ccv_write_binary_header(const char* filename, int type, int rows, int cols, const void* data, size_t size)
+{
+	FILE* w = fopen(filename, "wb");
+	fwrite("CCVBINDM", 1, 8, w);
+	fwrite(&type, 1, 4, w);
+	fwrite(&rows, 1, 4, w);
+	fwrite(&cols, 1, 4, w);
+	fwrite(data, 1, size, w);
+	fclose(w);
+}
+
+TEST_CASE("read binary file with mmap mode, fall back or fail safely")
+{
+	char filename[] = "/tmp/ccv-io-mmap-XXXXXX";
+	int fd = mkstemp(filename);
+	REQUIRE(fd >= 0, "should create a temporary file");
+	close(fd);
+	double f64[] = {
+		0.5, 1.5, 2.5,
+		3.5, 4.5, 5.5,
+	};
+	_ccv_write_binary_header(filename, CCV_64F | CCV_C1, 2, 3, f64, sizeof(f64));
+	ccv_dense_matrix_t* x = 0;
+	REQUIRE_EQ(CCV_IO_FINAL, ccv_read(filename, &x, CCV_IO_ANY_FILE | CCV_IO_MMAP), "should read a 64-bit binary file");
+	REQUIRE(!(x->type & CCV_NO_DATA_ALLOC), "the 64-bit data section is not aligned in the file, thus, it should be copied");
+	REQUIRE(((uintptr_t)x->data.u8 & 7) == 0, "the data section should be aligned");
+	REQUIRE_ARRAY_EQ(double, f64, x->data.f64, 6, "the data should be the same as the one written");
+	ccv_matrix_free(x);
+	_ccv_write_binary_header(filename, CCV_32F | CCV_C1, -2, 3, f64, sizeof(f64));
+	x = 0;
+	REQUIRE_EQ(CCV_IO_ERROR, ccv_read(filename, &x, CCV_IO_ANY_FILE | CCV_IO_MMAP), "should fail on negative rows");
+	REQUIRE(x == 0, "should not return a matrix on negative rows");
+	_ccv_write_binary_header(filename, 0x7, 2, 3, f64, sizeof(f64));
+	REQUIRE_EQ(CCV_IO_ERROR, ccv_read(filename, &x, CCV_IO_ANY_FILE | CCV_IO_MMAP), "should fail on an unknown data type");
+	_ccv_write_binary_header(filename, CCV_32F | CCV_C1, 200, 300, f64, sizeof(f64));
+	REQUIRE_EQ(CCV_IO_ERROR, ccv_read(filename, &x, CCV_IO_ANY_FILE | CCV_IO_MMAP), "should fail if the data section is truncated");
+	unlink(filename);
+}
+
+TEST_CASE("modify a mapped matrix in place")
+{
+	ccv_dense_matrix_t* x = 0;
+	ccv_read("data/chessbox.sample_down.bin", &x, CCV_IO_ANY_FILE);
+	ccv_flip(x, 0, 0, CCV_FLIP_X);
+	ccv_dense_matrix_t* y = 0;
+	ccv_read("data/chessbox.sample_down.bin", &y, CCV_IO_ANY_FILE | CCV_IO_MMAP);
+	ccv_flip(y, 0, 0, CCV_FLIP_X);
+	REQUIRE_MATRIX_EQ(x, y, "flip the mapped matrix in place should be the same as flip the copied one");
+	ccv_matrix_free(y);
+	y = 0;
+	ccv_read("data/chessbox.sample_down.bin", &y, CCV_IO_ANY_FILE | CCV_IO_MMAP);
+	ccv_flip(x, 0, 0, CCV_FLIP_X);
+	REQUIRE_MATRIX_EQ(x, y, "the file should stay intact after the mapped matrix is modified");
+	ccv_matrix_free(y);
+	ccv_matrix_free(x);
+}
+
 TEST_CASE("read JPEG from memory")
 {
 	ccv_dense_matrix_t* x = 0;
@@ -353,6 +448,208 @@ TEST_CASE("read JPEG from memory")
 	ccv_matrix_free(x);
 }
 
+TEST_CASE("read JPEG with scaled decode")
+{
+	ccv_dense_matrix_t* image = 0;
+	ccv_read("../../samples/nature.png", &image, CCV_IO_ANY_FILE | CCV_IO_RGB_COLOR);
+	char filename[] = "/tmp/ccv-io-scaled-XXXXXX";
+	int fd = mkstemp(filename);
+	REQUIRE(fd >= 0, "should create a temporary file");
+	close(fd);
+	ccv_write(image, filename, 0, CCV_IO_JPEG_FILE, 0);
+	ccv_dense_matrix_t* x = 0;
+	ccv_read(filename, &x, CCV_IO_ANY_FILE | CCV_IO_RGB_COLOR);
+	ccv_dense_matrix_t* y = 0;
+	ccv_read_scaled(filename, &y, CCV_IO_ANY_FILE | CCV_IO_RGB_COLOR, 0, 0);
+	REQUIRE_MATRIX_EQ(x, y, "scaled decode without max dimension should be the same as full decode");
+	ccv_matrix_free(y);
+	y = 0;
+	int max_dimension = ccv_max(image->rows, image->cols) / 3;
+	ccv_read_scaled(filename, &y, CCV_IO_ANY_FILE | CCV_IO_RGB_COLOR, 0, max_dimension);
+	REQUIRE_EQ(y->rows, (image->rows + 1) / 2, "should be decoded at 1/2 scale");
+	REQUIRE_EQ(y->cols, (image->cols + 1) / 2, "should be decoded at 1/2 scale");
+	REQUIRE_EQ(CCV_GET_CHANNEL(y->type), CCV_C3, "should be a color image");
+	ccv_dense_matrix_t* z = 0;
+	ccv_read_scaled(filename, &z, CCV_IO_ANY_FILE | CCV_IO_GRAY | CCV_IO_LUMA, 0, max_dimension);
+	REQUIRE_EQ(z->rows, y->rows, "grayscale decode should have the same scale");
+	REQUIRE_EQ(z->cols, y->cols, "grayscale decode should have the same scale");
+	REQUIRE_EQ(CCV_GET_CHANNEL(z->type), CCV_C1, "should be decoded as luma only");
+	ccv_matrix_free(z);
+	z = 0;
+	ccv_matrix_free(x);
+	x = 0;
+	ccv_read(filename, &x, CCV_IO_ANY_FILE | CCV_IO_GRAY);
+	ccv_read_scaled(filename, &z, CCV_IO_ANY_FILE | CCV_IO_GRAY, 0, 0);
+	REQUIRE_MATRIX_EQ(x, z, "grayscale decode without luma should be converted from RGB the same way as full decode");
+	ccv_matrix_free(z);
+	ccv_matrix_free(y);
+	ccv_matrix_free(x);
+	ccv_matrix_free(image);
+	unlink(filename);
+}
+
+TEST_CASE("write PNG to memory in batch")
+{
+	ccv_dense_matrix_t* image = 0;
+	ccv_read("../../samples/nature.png", &image, CCV_IO_ANY_FILE | CCV_IO_RGB_COLOR);
+	ccv_dense_matrix_t* gray = 0;
+	ccv_read("../../samples/nature.png", &gray, CCV_IO_ANY_FILE | CCV_IO_GRAY);
+	ccv_dense_matrix_t* mats[] = {image, gray, image, gray};
+	int size = image->rows * image->step * 2;
+	char* data = (char*)ccmalloc(size * 4);
+	char* outs[] = {data, data + size, data + size * 2, data + size * 3};
+	int lens[] = {size, size, size, size};
+	ccv_io_png_param_t params = {
+		.compression_level = 9,
+		.filters = CCV_IO_PNG_FILTER_PAETH,
+	};
+	REQUIRE_EQ(CCV_IO_FINAL, ccv_write_batch(mats, outs, lens, 4, CCV_IO_PNG_STREAM | CCV_IO_PNG_PARAMS, &params), "should write all images into memory");
+	int i;
+	for (i = 0; i < 4; i++)
+	{
+		REQUIRE(lens[i] > 0 && lens[i] < size, "should report the written bytes");
+		ccv_dense_matrix_t* x = 0;
+		ccv_read(outs[i], &x, CCV_IO_ANY_STREAM, lens[i]);
+		REQUIRE_MATRIX_EQ(x, mats[i], "PNG written to memory should be read back the same");
+		ccv_matrix_free(x);
+	}
+	int len = lens[0] - 1;
+	REQUIRE_EQ(CCV_IO_ERROR, ccv_write(image, data, &len, CCV_IO_PNG_STREAM | CCV_IO_PNG_PARAMS, &params), "should fail if the data memory is not large enough");
+	len = size;
+	REQUIRE_EQ(CCV_IO_FINAL, ccv_write(image, data, &len, CCV_IO_PNG_STREAM, 0), "should write with default settings");
+	REQUIRE(len > lens[0], "default settings should favor speed over size");
+	// without CCV_IO_PNG_PARAMS, conf is still an int* of the zlib memory level
+	int mem_level = 9;
+	int mem_len = size;
+	REQUIRE_EQ(CCV_IO_FINAL, ccv_write(image, data, &mem_len, CCV_IO_PNG_STREAM, &mem_level), "should write with the zlib memory level");
+	ccv_dense_matrix_t* x = 0;
+	ccv_read(data, &x, CCV_IO_ANY_STREAM, mem_len);
+	REQUIRE_MATRIX_EQ(x, image, "PNG written with the zlib memory level should be read back the same");
+	ccv_matrix_free(x);
+	ccfree(data);
+	ccv_matrix_free(gray);
+	ccv_matrix_free(image);
+}
+
+TEST_CASE("write and read matrices in a container")
+{
+	ccv_dense_matrix_t* image = 0;
+	ccv_read("../../samples/nature.png", &image, CCV_IO_ANY_FILE | CCV_IO_GRAY);
+	ccv_dense_matrix_t* a = ccv_dense_matrix_new(97, 61, CCV_32F | CCV_C2, 0, 0);
+	ccv_dense_matrix_t* b = ccv_dense_matrix_new(33, 45, CCV_8U | CCV_C3, 0, 0);
+	int i;
+	for (i = 0; i < a->rows * a->cols * 2; i++)
+		a->data.f32[i] = (i % 61) * 0.25 + (i / 122);
+	uint32_t seed = 1;
+	for (i = 0; i < b->rows * b->step; i++)
+		b->data.u8[i] = (seed = seed * 1103515245 + 12345) >> 24; // random bytes don't compress
+	char filename[] = "/tmp/ccv-io-container-XXXXXX";
+	int fd = mkstemp(filename);
+	REQUIRE(fd >= 0, "should create a temporary file");
+	close(fd);
+	ccv_container_t* container = ccv_container_new(filename);
+	REQUIRE_EQ(0, ccv_container_write(container, image, 0), "should be the first matrix");
+	REQUIRE_EQ(1, ccv_container_write(container, a, 7), "should be the second matrix");
+	REQUIRE_EQ(2, ccv_container_write(container, b, 5), "should be the third matrix");
+	ccv_container_close(container);
+	container = ccv_container_open(filename);
+	REQUIRE(container != 0, "should open the container");
+	REQUIRE_EQ(3, ccv_container_count(container), "should have 3 matrices");
+	ccv_container_info_t info;
+	REQUIRE_EQ(0, ccv_container_info(container, 1, &info), "should have the second matrix");
+	REQUIRE_EQ(info.rows, 97, "should have the same rows");
+	REQUIRE_EQ(info.cols, 61, "should have the same cols");
+	REQUIRE_EQ(info.type, CCV_32F | CCV_C2, "should have the same type");
+	REQUIRE_EQ(info.tile_rows, 7, "should have the same tile rows");
+	ccv_dense_matrix_t* x = 0;
+	REQUIRE_EQ(CCV_IO_FINAL, ccv_container_read(container, 0, 0, 0, &x), "should read the whole image");
+	REQUIRE_MATRIX_EQ(x, image, "image read from container should be the same");
+	ccv_matrix_free(x);
+	x = 0;
+	REQUIRE_EQ(CCV_IO_FINAL, ccv_container_read(container, 2, 0, 0, &x), "should read the whole random matrix");
+	REQUIRE_MATRIX_EQ(x, b, "random matrix read from container should be the same");
+	ccv_matrix_free(x);
+	x = 0;
+	REQUIRE_EQ(CCV_IO_FINAL, ccv_container_read(container, 1, 12, 30, &x), "should read a band of rows");
+	ccv_dense_matrix_t* band = 0;
+	ccv_slice(a, (ccv_matrix_t**)&band, 0, 12, 0, 30, 61);
+	REQUIRE_MATRIX_EQ(x, band, "a band of rows read from container should be the same");
+	ccv_matrix_free(band);
+	ccv_matrix_free(x);
+	x = 0;
+	REQUIRE_EQ(CCV_IO_ERROR, ccv_container_read(container, 1, 90, 10, &x), "should fail to read beyond the matrix");
+	ccv_container_close(container);
+	FILE* rb = fopen(filename, "rb");
+	fseek(rb, 0, SEEK_END);
+	long size = ftell(rb);
+	fclose(rb);
+	REQUIRE(size < image->rows * image->step + a->rows * a->step + b->rows * b->step, "should be compressed");
+	unlink(filename);
+	ccv_matrix_free(b);
+	ccv_matrix_free(a);
+	ccv_matrix_free(image);
+}
+
+/* a container with one tile of data at offset 8, and an index of a single matrix with that tile */
+static void _ccv_write_container_index(const char* filename, int count, int type, int rows, int cols, int tile_rows, const void* data, uint32_t size)
+{
+	FILE* w = fopen(filename, "wb");
+	fwrite("CCVBINTC", 1, 8, w);
+	fwrite(data, 1, size, w);
+	uint64_t index_offset = 8 + size;
+	fwrite(&type, 1, 4, w);
+	fwrite(&rows, 1, 4, w);
+	fwrite(&cols, 1, 4, w);
+	fwrite(&tile_rows, 1, 4, w);
+	uint64_t offset = 8;
+	uint32_t flags = 0;
+	fwrite(&offset, 1, 8, w);
+	fwrite(&size, 1, 4, w);
+	fwrite(&flags, 1, 4, w);
+	fwrite(&index_offset, 1, 8, w);
+	fwrite(&count, 1, 4, w);
+	fclose(w);
+}
+
+TEST_CASE("open a container with a forged index safely")
+{
+	char filename[] = "/tmp/ccv-io-container-XXXXXX";
+	int fd = mkstemp(filename);
+	REQUIRE(fd >= 0, "should create a temporary file");
+	close(fd);
+	const unsigned char data[16] = { 1, 0, 0, 0, 2, 0, 0, 0, 3, 0, 0, 0, 4 }; // 4 rows, each row is padded to 4 bytes
+	_ccv_write_container_index(filename, -1, CCV_8U | CCV_C1, 4, 1, 1, data, 16);
+	REQUIRE(ccv_container_open(filename) == 0, "should reject a negative count");
+	_ccv_write_container_index(filename, 1, 0x7, 4, 1, 1, data, 16);
+	REQUIRE(ccv_container_open(filename) == 0, "should reject a type without data type");
+	_ccv_write_container_index(filename, 1, CCV_8U | CCV_32F | CCV_C1, 4, 1, 1, data, 16);
+	REQUIRE(ccv_container_open(filename) == 0, "should reject a type with two data types");
+	_ccv_write_container_index(filename, 1, CCV_8U, 4, 1, 1, data, 16);
+	REQUIRE(ccv_container_open(filename) == 0, "should reject a type without channel");
+	_ccv_write_container_index(filename, 1, CCV_32F | CCV_C4, 1, 1 << 28, 1, data, 16);
+	REQUIRE(ccv_container_open(filename) == 0, "should reject a row that doesn't fit in an int");
+	_ccv_write_container_index(filename, 1, CCV_32F | CCV_C1, 1 << 20, 1 << 24, 1 << 20, data, 16);
+	REQUIRE(ccv_container_open(filename) == 0, "should reject a tile that doesn't fit in an int");
+	// 1 << 30 rows per tile overflows the tile buffers if computed in int, it is bounded by the rows of the matrix instead
+	_ccv_write_container_index(filename, 1, CCV_8U | CCV_C1, 4, 1, 1 << 30, data, 16);
+	ccv_container_t* container = ccv_container_open(filename);
+	REQUIRE(container != 0, "should open the container");
+	ccv_container_info_t info;
+	REQUIRE_EQ(0, ccv_container_info(container, 0, &info), "should have the matrix");
+	REQUIRE_EQ(4, info.tile_rows, "should have the tile rows bounded by rows");
+	ccv_dense_matrix_t* x = 0;
+	REQUIRE_EQ(CCV_IO_FINAL, ccv_container_read(container, 0, 1, 3, &x), "should read the rows");
+	REQUIRE_EQ(3, x->rows, "should read 3 rows");
+	REQUIRE_EQ(2, x->data.u8[0], "should be the second row");
+	REQUIRE_EQ(4, x->data.u8[x->step * 2], "should be the last row");
+	ccv_matrix_free(x);
+	x = 0;
+	REQUIRE_EQ(CCV_IO_ERROR, ccv_container_read(container, 0, 3, 0x7fffffff, &x), "should fail if row + rows overflows");
+	REQUIRE_EQ(CCV_IO_ERROR, ccv_container_read(container, 0, 5, 0, &x), "should fail if row is beyond the matrix");
+	ccv_container_close(container);
+	unlink(filename);
+}
+
 TEST_CASE("read PNG from memory")
 {
 	ccv_dense_matrix_t* x = 0;
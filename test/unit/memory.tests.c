@@ -1,6 +1,9 @@
 #include "ccv.h"
 #include "ccv_internal.h"
 #include "case.h"
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
 
 uint64_t uniqid()
 {
@@ -71,6 +74,30 @@ TEST_CASE("random cache put/delete/get")
 	ccfree(sigs);
 }
 
+TEST_CASE("cache evicts least recently put objects within type limit")
+{
+	ccv_cache_t cache;
+	ccv_cache_init(&cache, 100, 2, ccfree, ccfree);
+	ccv_cache_set_type_limit(&cache, 1, 30);
+	int i;
+	for (i = 0; i < 5; i++)
+		ccv_cache_put(&cache, i + 1, ccmalloc(1), 10, 0);
+	for (i = 5; i < 10; i++)
+		ccv_cache_put(&cache, i + 1, ccmalloc(1), 10, 1);
+	REQUIRE_EQ(80, cache.size, "type 1 should be bounded by its own limit");
+	REQUIRE_EQ(30, cache.lru[1].size, "type 1 should be bounded by its own limit");
+	for (i = 5; i < 7; i++)
+		REQUIRE(ccv_cache_get(&cache, i + 1, 0) == 0, "the oldest objects of type 1 should be evicted");
+	for (i = 0; i < 5; i++)
+		REQUIRE(ccv_cache_get(&cache, i + 1, 0) != 0, "objects of type 0 should stay");
+	for (i = 10; i < 13; i++)
+		ccv_cache_put(&cache, i + 1, ccmalloc(1), 10, 0);
+	REQUIRE_EQ(100, cache.size, "cache should be bounded by its limit");
+	REQUIRE(ccv_cache_get(&cache, 1, 0) == 0, "the least recently put object should be evicted first");
+	REQUIRE(ccv_cache_get(&cache, 2, 0) != 0, "objects put later should stay");
+	ccv_cache_close(&cache);
+}
+
 TEST_CASE("garbage collector 95\% hit rate")
 {
 	int i;
@@ -173,4 +200,164 @@ TEST_CASE("multi-type garbage collector 92\% hit rate")
 	ccv_disable_cache();
 }
 
+TEST_CASE("cache statistics count hits, misses and evictions by source")
+{
+	int i;
+	size_t size = ccv_compute_dense_matrix_size(1, 1, CCV_32S | CCV_C1);
+	ccv_enable_cache(size * 10);
+	ccv_reset_cache_stats();
+	ccv_enable_cache_source_stats();
+	for (i = 0; i < 20; i++)
+	{
+		ccv_dense_matrix_t* dmt = ccv_dense_matrix_new(1, 1, CCV_32S | CCV_C1, 0, 0);
+		dmt->data.i32[0] = i;
+		dmt->sig = ccv_cache_generate_signature((const char*)&i, 4, CCV_EOF_SIGN);
+		dmt->type |= CCV_REUSABLE;
+		ccv_matrix_free(dmt);
+	}
+	ccv_cache_stats_t stats;
+	ccv_cache_stats(&stats);
+	REQUIRE_EQ(10, stats.evictions, "the first 10 matrices should be evicted");
+	REQUIRE_EQ(10, stats.rnum[0], "the last 10 matrices should be resident");
+	REQUIRE_EQ(size * 10, stats.size[0], "the cache should be full of matrices");
+	REQUIRE_EQ(0, stats.size[1], "there should be no array resident");
+	static const char source[] = "memory.tests";
+	for (i = 19; i >= 0; i--)
+	{
+		uint64_t sig = ccv_cache_generate_signature((const char*)&i, 4, CCV_EOF_SIGN);
+		ccv_set_cache_source(source);
+		ccv_dense_matrix_t* dmt = ccv_dense_matrix_new(1, 1, CCV_32S | CCV_C1, 0, sig);
+		ccv_matrix_free_immediately(dmt);
+	}
+	ccv_cache_stats(&stats);
+	REQUIRE_EQ(10, stats.hits, "the last 10 matrices should be returned from the cache");
+	REQUIRE_EQ(10, stats.misses, "the first 10 matrices should be missed");
+	REQUIRE_EQ(0, stats.size[0], "all matrices should be taken out");
+	REQUIRE(stats.lifetime > 0, "matrices should stay in the cache for a while");
+	ccv_cache_source_stats_t sources[4];
+	int rnum = ccv_cache_source_stats(sources, 4);
+	REQUIRE_EQ(1, rnum, "all lookups should come from one source");
+	REQUIRE(sources[0].source == source, "the lookups should be attributed to the source");
+	REQUIRE_EQ(10, sources[0].hits, "the source should have 10 hits");
+	REQUIRE_EQ(10, sources[0].misses, "the source should have 10 misses");
+	ccv_disable_cache_source_stats();
+	ccv_disable_cache();
+}
+
+TEST_CASE("content signature is stable for small and large matrices")
+{
+	int i;
+	ccv_dense_matrix_t* a = ccv_dense_matrix_new(16, 16, CCV_8U | CCV_C1, 0, 0);
+	for (i = 0; i < a->rows * a->step; i++)
+		a->data.u8[i] = i & 0xff;
+	ccv_make_matrix_immutable(a);
+	REQUIRE_EQ(0xa25fc4edc291b5a7ULL, a->sig, "small matrix should be signed by hashing its data directly");
+	ccv_matrix_free(a);
+	// large enough to be signed by a hash tree
+	ccv_dense_matrix_t* b = ccv_dense_matrix_new(1024, 1024 * 3 + 5, CCV_8U | CCV_C1, 0, 0);
+	for (i = 0; i < b->rows * b->step; i++)
+		b->data.u8[i] = (i * 7 + (i >> 11)) & 0xff;
+	ccv_make_matrix_immutable(b);
+	REQUIRE_EQ(0x3c069adfe7a6b998ULL, b->sig, "large matrix should be signed by the chunk digests");
+	ccv_matrix_free(b);
+}
+
+TEST_CASE("matrix pool recycles blocks by size class")
+{
+	ccv_enable_matrix_pool(CCV_DEFAULT_CACHE_SIZE);
+	ccv_matrix_pool_stats_t stats;
+	ccv_matrix_pool_stats(&stats);
+	ccv_dense_matrix_t* a = ccv_dense_matrix_new(101, 97, CCV_32F | CCV_C3, 0, 0);
+	REQUIRE_EQ(0, (uintptr_t)a & 63, "matrix from the pool should be 64-byte aligned");
+	REQUIRE_EQ(0, (uintptr_t)a->data.u8 & 63, "data section of matrix from the pool should be 64-byte aligned");
+	memset(a->data.u8, 0xff, a->rows * a->step);
+	ccv_dense_matrix_t* b = ccv_dense_matrix_new(10, 10, CCV_8U | CCV_C1, 0, 0);
+	ccv_matrix_free(a);
+	ccv_matrix_pool_stats_t after;
+	ccv_matrix_pool_stats(&after);
+	REQUIRE_EQ(stats.alloc_count + 2, after.alloc_count, "should allocate 2 matrices from the pool");
+	REQUIRE(after.pooled > stats.pooled, "the freed block should be kept in the pool");
+	REQUIRE(after.allocated_high_water_mark >= 101 * 97 * 3 * sizeof(float), "high-water mark should cover both matrices");
+	// a slightly smaller matrix falls into the same size class
+	ccv_dense_matrix_t* c = ccv_dense_matrix_new(100, 97, CCV_32F | CCV_C3, 0, 0);
+	REQUIRE(c == a, "should reuse the block freed earlier");
+	ccv_matrix_pool_stats(&after);
+	REQUIRE_EQ(stats.hit_count + 1, after.hit_count, "should have one allocation served by a recycled block");
+	ccv_disable_matrix_pool();
+	// matrices from the pool can still be freed after the pool is disabled
+	ccv_matrix_free(b);
+	ccv_matrix_free(c);
+	ccv_matrix_pool_stats(&after);
+	REQUIRE_EQ(stats.allocated, after.allocated, "all matrices from the pool should be freed");
+	REQUIRE_EQ(0, after.pooled, "no block should be held by a disabled pool");
+}
+
+TEST_CASE("matrices and arrays allocated in an arena")
+{
+	ccv_arena_t* arena = ccv_arena_new(4096);
+	ccv_arena_push(arena);
+	ccv_dense_matrix_t* a = ccv_dense_matrix_new(10, 10, CCV_32F | CCV_C1, 0, 0);
+	REQUIRE_EQ(0, (uintptr_t)a->data.u8 & 63, "data section of matrix in an arena should be 64-byte aligned");
+	ccv_dense_matrix_t* b = ccv_dense_matrix_new(100, 100, CCV_32F | CCV_C1, 0, 0); // too large for a chunk
+	int i;
+	for (i = 0; i < 100 * 100; i++)
+		b->data.f32[i] = i;
+	ccv_array_t* array = ccv_array_new(sizeof(int), 2, 0);
+	for (i = 0; i < 1000; i++)
+		ccv_array_push(array, &i);
+	for (i = 0; i < 1000; i++)
+		REQUIRE_EQ(i, *(int*)ccv_array_get(array, i), "array in an arena should grow with its content");
+	REQUIRE(arena->allocated >= 100 * 100 * sizeof(float) + 1000 * sizeof(int), "allocations should come from the arena");
+	ccv_matrix_free(a);
+	ccv_matrix_free(b);
+	ccv_array_free(array);
+	ccv_arena_pop();
+	ccv_dense_matrix_t* c = ccv_dense_matrix_new(10, 10, CCV_32F | CCV_C1, 0, 0);
+	REQUIRE((unsigned char*)c < (unsigned char*)arena->chunk || (unsigned char*)c >= arena->end, "matrix should not be allocated in a popped arena");
+	ccv_matrix_free(c);
+	ccv_arena_reset(arena);
+	REQUIRE_EQ(0, arena->allocated, "arena should be empty after reset");
+	ccv_arena_free(arena);
+}
+
+#ifdef HAVE_PTHREAD
+static void* recycle_matrices_on_thread(void* context)
+{
+	int i, start = *(int*)context;
+	for (i = start; i < start + 1000; i++)
+	{
+		ccv_dense_matrix_t* dmt = ccv_dense_matrix_new(1, 1, CCV_32S | CCV_C1, 0, 0);
+		dmt->data.i32[0] = i;
+		dmt->sig = ccv_cache_generate_signature((const char*)&i, 4, CCV_EOF_SIGN);
+		dmt->type |= CCV_REUSABLE;
+		ccv_matrix_free(dmt);
+	}
+	return 0;
+}
+
+TEST_CASE("shared cache reuses matrices recycled on other threads")
+{
+	ccv_enable_shared_cache(CCV_DEFAULT_CACHE_SIZE);
+	pthread_t threads[4];
+	int starts[4];
+	int i;
+	for (i = 0; i < 4; i++)
+	{
+		starts[i] = i * 1000;
+		pthread_create(threads + i, 0, recycle_matrices_on_thread, starts + i);
+	}
+	for (i = 0; i < 4; i++)
+		pthread_join(threads[i], 0);
+	for (i = 0; i < 4000; i++)
+	{
+		uint64_t sig = ccv_cache_generate_signature((const char*)&i, 4, CCV_EOF_SIGN);
+		ccv_dense_matrix_t* dmt = ccv_dense_matrix_new(1, 1, CCV_32S | CCV_C1, 0, sig);
+		REQUIRE(dmt->type & CCV_GARBAGE, "matrix %d should be retrieved from the shared cache", i);
+		REQUIRE_EQ(i, dmt->data.i32[0], "matrix %d should have the content recycled on the other thread", i);
+		ccv_matrix_free_immediately(dmt);
+	}
+	ccv_disable_cache();
+}
+#endif
+
 #include "case_main.h"
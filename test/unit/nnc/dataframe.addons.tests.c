@@ -128,6 +128,36 @@ TEST_CASE("read image and add random jitter")
 	ccv_cnnp_dataframe_free(dataframe);
 }
 
+TEST_CASE("read image and resize normalize into a tensor")
+{
+	ccv_dense_matrix_t* image = 0;
+	ccv_read("../../../samples/nature.png", &image, CCV_IO_RGB_COLOR | CCV_IO_ANY_FILE);
+	ccv_array_t* const array = ccv_array_new(sizeof(ccv_dense_matrix_t), 1, 0);
+	ccv_array_push(array, image);
+	ccv_cnnp_dataframe_t* const dataframe = ccv_cnnp_dataframe_from_array_new(array);
+	const float mean[] = { 123.68, 116.779, 103.939 };
+	const float std[] = { 58.393, 57.12, 57.375 };
+	const int im = ccv_cnnp_dataframe_image_resize_normalize(dataframe, 0, CCV_32F, CCV_TENSOR_FORMAT_NCHW, 224, 224, 3, mean, std);
+	ccv_cnnp_dataframe_iter_t* const iter = ccv_cnnp_dataframe_iter_new(dataframe, COLUMN_ID_LIST(im));
+	ccv_nnc_tensor_t* data;
+	ccv_cnnp_dataframe_iter_next(iter, (void**)&data, 1, 0);
+	REQUIRE(data->info.format == CCV_TENSOR_FORMAT_NCHW && data->info.dim[0] == 3 && data->info.dim[1] == 224 && data->info.dim[2] == 224, "should be a 3x224x224 tensor");
+	ccv_dense_matrix_t* x = 0;
+	ccv_resample(image, &x, CCV_32F | CCV_C3, 224, 224, CCV_INTER_AREA);
+	float* const gt = (float*)ccmalloc(sizeof(float) * 224 * 224 * 3);
+	int i, j;
+	for (i = 0; i < 224 * 224; i++)
+		for (j = 0; j < 3; j++)
+			gt[j * 224 * 224 + i] = (x->data.f32[i * 3 + j] - mean[j]) / std[j];
+	REQUIRE_ARRAY_EQ_WITH_TOLERANCE(float, data->data.f32, gt, 224 * 224 * 3, 1e-4, "should be the resampled and normalized image.");
+	ccfree(gt);
+	ccv_matrix_free(x);
+	ccv_matrix_free(image);
+	ccv_array_free(array);
+	ccv_cnnp_dataframe_iter_free(iter);
+	ccv_cnnp_dataframe_free(dataframe);
+}
+
 TEST_CASE("execute command from dataframe addons API")
 {
 	ccv_nnc_tensor_t* input = ccv_nnc_tensor_new(0, CPU_TENSOR_NCHW(32F, 1), 0);
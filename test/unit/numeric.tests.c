@@ -145,6 +145,54 @@ TEST_CASE("ccv_filter centre point for odd number window size, hint: (size - 1)
 	ccv_matrix_free(x);
 }
 
+TEST_CASE("ccv_filter_bank with kernels of different sizes is the same as ccv_filter with each kernel")
+{
+	dsfmt_t dsfmt;
+	dsfmt_init_gen_rand(&dsfmt, 0xbeef);
+	ccv_dense_matrix_t* kernels[5];
+	const int ksize[5] = { 5, 5, 7, 5, 3 };
+	int i, j, k;
+	for (k = 0; k < 5; k++)
+	{
+		kernels[k] = ccv_dense_matrix_new(ksize[k], ksize[k] + 2, CCV_32F | CCV_C3, 0, 0);
+		for (i = 0; i < ksize[k] * (ksize[k] + 2) * 3; i++)
+			kernels[k]->data.f32[i] = dsfmt_genrand_close_open(&dsfmt) - 0.5;
+	}
+	ccv_filter_bank_t* bank = ccv_filter_bank_new(kernels, 5);
+	// a large image spans many tiles, the small one fits in one
+	const int rows[2] = { 211, 17 };
+	const int cols[2] = { 163, 23 };
+	for (j = 0; j < 2; j++)
+	{
+		ccv_dense_matrix_t* a = ccv_dense_matrix_new(rows[j], cols[j], CCV_32F | CCV_C3, 0, 0);
+		for (i = 0; i < rows[j] * cols[j] * 3; i++)
+			a->data.f32[i] = dsfmt_genrand_close_open(&dsfmt) * 255;
+		ccv_dense_matrix_t* d[5] = { 0 };
+		ccv_dense_matrix_t* e[5] = { 0 };
+		// twice, the second time reuses the plans
+		ccv_filter_bank(a, bank, d, 0, CCV_NO_PADDING);
+		ccv_filter_bank(a, bank, e, CCV_64F, CCV_NO_PADDING);
+		ccv_filter_bank(a, bank, d, 0, CCV_NO_PADDING);
+		for (k = 0; k < 5; k++)
+		{
+			ccv_dense_matrix_t* x = 0;
+			ccv_filter(a, kernels[k], &x, 0, CCV_NO_PADDING);
+			REQUIRE_MATRIX_EQ(d[k], x, "filter bank response of kernel %d should be the same as ccv_filter", k);
+			ccv_matrix_free(x);
+			x = 0;
+			ccv_filter(a, kernels[k], &x, CCV_64F, CCV_NO_PADDING);
+			REQUIRE_MATRIX_EQ(e[k], x, "filter bank response of kernel %d should be the same as ccv_filter in 64F", k);
+			ccv_matrix_free(x);
+			ccv_matrix_free(d[k]);
+			ccv_matrix_free(e[k]);
+		}
+		ccv_matrix_free(a);
+	}
+	ccv_filter_bank_free(bank);
+	for (k = 0; k < 5; k++)
+		ccv_matrix_free(kernels[k]);
+}
+
 #include "ccv_internal.h"
 
 static void naive_ssd(ccv_dense_matrix_t* image, ccv_dense_matrix_t* template, ccv_dense_matrix_t* out)
@@ -398,4 +446,34 @@ TEST_CASE("ccv_distance_transform to compute max distance")
 	ccv_matrix_free(distance);
 }
 
+TEST_CASE("ccv_distance_transform x, y offsets point to where the distance comes from")
+{
+	ccv_dense_matrix_t* geometry = 0;
+	ccv_read("../../samples/geometry.png", &geometry, CCV_IO_GRAY | CCV_IO_ANY_FILE);
+	ccv_dense_matrix_t* distance = 0;
+	ccv_dense_matrix_t* x = 0;
+	ccv_dense_matrix_t* y = 0;
+	double dx = 0.5;
+	double dy = -0.5;
+	double dxx = 0.1;
+	double dyy = 0.2;
+	ccv_distance_transform(geometry, &distance, CCV_64F, &x, 0, &y, 0, dx, dy, dxx, dyy, CCV_NEGATIVE | CCV_GSEDT);
+	int i, j, k = 0;
+	for (i = 0; i < distance->rows; i++)
+		for (j = 0; j < distance->cols; j++)
+		{
+			// y offset is from the column pass, thus, x offset is the one of the row it comes from
+			const int oy = y->data.i32[i * y->cols + j];
+			const int ox = x->data.i32[(i - oy) * x->cols + j];
+			const double d = -geometry->data.u8[(i - oy) * geometry->step + j - ox] + dx * ox + dxx * ox * ox + dy * oy + dyy * oy * oy;
+			if (fabs(distance->data.f64[i * distance->cols + j] - d) > 1e-6)
+				++k;
+		}
+	REQUIRE_EQ(k, 0, "the distance should be the value at the offsets plus the cost of the offsets");
+	ccv_matrix_free(x);
+	ccv_matrix_free(y);
+	ccv_matrix_free(distance);
+	ccv_matrix_free(geometry);
+}
+
 #include "case_main.h"
@@ -24,4 +24,74 @@ TEST_CASE("matrix perspective transform")
 	ccv_matrix_free(b);
 }
 
+TEST_CASE("perspective warp of a slice is close to perspective transform then slice")
+{
+	ccv_dense_matrix_t* image = 0;
+	ccv_read("../../samples/chessbox.png", &image, CCV_IO_ANY_FILE);
+	ccv_dense_matrix_t* b = 0;
+	ccv_perspective_transform(image, &b, 0, cosf(CCV_PI / 6), 0, 0, 0, 1, 0, -sinf(CCV_PI / 6), 0, cosf(CCV_PI / 6));
+	ccv_dense_matrix_t* x = 0;
+	ccv_slice(b, (ccv_matrix_t**)&x, 0, 33, 41, 111, 91);
+	ccv_warp_t warp = ccv_perspective_warp(image, 0, 33, 41, 111, 91, cosf(CCV_PI / 6), 0, 0, 0, 1, 0, -sinf(CCV_PI / 6), 0, cosf(CCV_PI / 6));
+	ccv_warp(&warp, 1);
+	int i, j, k, count = 0;
+	const int ch = CCV_GET_CHANNEL(x->type);
+	for (i = 0; i < x->rows; i++)
+		for (j = 0; j < x->cols; j++)
+		{
+			// only where the warp samples at least 2 pixels inside the source, and there, every pixel is compared
+			const float z = warp.m[6] * j + warp.m[7] * i + warp.m[8];
+			const float sx = (warp.m[0] * j + warp.m[1] * i + warp.m[2]) / z;
+			const float sy = (warp.m[3] * j + warp.m[4] * i + warp.m[5]) / z;
+			if (sx < 2 || sx > image->cols - 3 || sy < 2 || sy > image->rows - 3)
+				continue;
+			for (k = 0; k < ch; k++)
+			{
+				const int v = x->data.u8[i * x->step + j * ch + k];
+				const int u = warp.b->data.u8[i * warp.b->step + j * ch + k];
+				// the remap table has 1/128 pixel precision, it should be within 2
+				REQUIRE(abs(u - v) <= 2, "warp at (%d, %d) should be close, %d != %d", i, j * ch + k, u, v);
+			}
+			++count;
+		}
+	REQUIRE(count >= x->rows * x->cols / 2, "most of the warp should be inside the source, only %d of %d pixels are", count, x->rows * x->cols);
+	ccv_matrix_free(warp.b);
+	ccv_matrix_free(x);
+	ccv_matrix_free(b);
+	ccv_matrix_free(image);
+}
+
+TEST_CASE("a batch of warps is the same as warps one by one")
+{
+	ccv_dense_matrix_t* image = 0;
+	ccv_read("../../samples/nature.png", &image, CCV_IO_RGB_COLOR | CCV_IO_ANY_FILE);
+	ccv_dense_matrix_t* fimage = 0;
+	ccv_shift(image, (ccv_matrix_t**)&fimage, CCV_32F, 0, 0);
+	ccv_warp_t warps[8];
+	int i;
+	for (i = 0; i < 8; i++)
+	{
+		warps[i] = ccv_perspective_warp(i % 2 ? fimage : image, 0, i * 20, i * 30, 50 + i * 30, 70 + i * 10, cosf(0.1 * i), sinf(0.1 * i), i, -sinf(0.1 * i), cosf(0.1 * i), -i, i % 3 ? 0 : 0.1, 0, 1);
+		// an affine one, with a different output type
+		if (i == 6)
+		{
+			const float m[9] = { 0.8, 0.1, 10.5, -0.1, 1.2, 5.25, 0, 0, 1 };
+			memcpy(warps[i].m, m, sizeof(m));
+			warps[i].type = CCV_32F;
+		}
+	}
+	ccv_warp(warps, 8);
+	for (i = 0; i < 8; i++)
+	{
+		ccv_warp_t warp = warps[i];
+		warp.b = 0;
+		ccv_warp(&warp, 1);
+		REQUIRE_MATRIX_EQ(warps[i].b, warp.b, "warp %d should be the same in a batch", i);
+		ccv_matrix_free(warp.b);
+		ccv_matrix_free(warps[i].b);
+	}
+	ccv_matrix_free(fimage);
+	ccv_matrix_free(image);
+}
+
 #include "case_main.h"